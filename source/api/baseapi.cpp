@@ -28,6 +28,7 @@
 #endif
 
 #include "baseapi.h"
+#include "renderer.h"
 
 #include "thresholder.h"
 #include "tesseractmain.h"
@@ -62,12 +63,6 @@ namespace tesseract {
 
 // Minimum sensible image size to be worth running tesseract.
 const int kMinRectSize = 10;
-// Character returned when Tesseract couldn't recognize as anything.
-const char kTesseractReject = '~';
-// Character used by UNLV error counter as a reject.
-const char kUNLVReject = '~';
-// Character used by UNLV as a suspect marker.
-const char kUNLVSuspect = '^';
 // Filename used for input image file, from which to derive a name to search
 // for a possible UNLV zone file, if none is specified by SetInputName.
 const char* kInputFile = "noname.tif";
@@ -245,6 +240,9 @@ PageSegMode TessBaseAPI::GetPageSegMode() const {
 // have an effect, depending on the implementation.
 // The mode is stored as an INT_VARIABLE so it can also be modified by
 // ReadConfigFile or SetVariable("tessedit_accuracyvspeed", mode as string).
+// For more speed than AVS_FASTEST, set the variable tord_fast_mode, which
+// skips chopping, pass 2, dangerous ambiguity checks and further adaptive
+// learning for words at least as confident as tord_fast_mode_certainty.
 void TessBaseAPI::SetAccuracyVSpeed(AccuracyVSpeed mode) {
   if (tesseract_ == NULL)
     tesseract_ = new Tesseract;
@@ -288,6 +286,48 @@ void TessBaseAPI::ClearAdaptiveClassifier() {
   tesseract_->ResetAdaptiveClassifier();
 }
 
+// Save a snapshot of the adaptive classifier to the given file.
+bool TessBaseAPI::SaveAdaptiveClassifier(const char* filename) {
+  if (tesseract_ == NULL)
+    return false;
+  FILE* fp = fopen(filename, "wb");
+  if (fp == NULL)
+    return false;
+  bool result = tesseract_->SaveAdaptiveClassifier(fp);
+  if (fclose(fp) != 0)
+    result = false;
+  return result;
+}
+
+// Replace the adaptive classifier with a snapshot from the given file.
+bool TessBaseAPI::LoadAdaptiveClassifier(const char* filename) {
+  if (tesseract_ == NULL)
+    return false;
+  FILE* fp = fopen(filename, "rb");
+  if (fp == NULL)
+    return false;
+  bool result = tesseract_->LoadAdaptiveClassifier(fp);
+  fclose(fp);
+  return result;
+}
+
+// Replace the adaptive classifier with a copy of that of source.
+bool TessBaseAPI::CopyAdaptiveClassifier(const TessBaseAPI& source) {
+  if (tesseract_ == NULL || source.tesseract_ == NULL ||
+      source.tesseract_ == tesseract_)
+    return false;
+  FILE* fp = tmpfile();
+  if (fp == NULL)
+    return false;
+  bool result = source.tesseract_->SaveAdaptiveClassifier(fp);
+  if (result) {
+    rewind(fp);
+    result = tesseract_->LoadAdaptiveClassifier(fp);
+  }
+  fclose(fp);
+  return result;
+}
+
 // Provide an image for Tesseract to recognize. Format is as
 // TesseractRect above. Does not copy the image buffer, or take
 // ownership. The source image may be destroyed after Recognize is called,
@@ -562,8 +602,21 @@ int TessBaseAPI::Recognize(struct ETEXT_STRUCT* monitor) {
   }
   if (page_res_ != NULL)
     ClearResults();
-  if (FindLines() != 0)
+  // Layout analysis, textord and the chopper find the monitor through
+  // global_monitor, so they can stop early when its deadline passes or it
+  // is cancelled.
+  global_monitor = monitor;
+  global_monitor_words = 0;
+  if (FindLines() != 0) {
+    global_monitor = NULL;
     return -1;
+  }
+  if (ocr_deadline_passed(monitor, global_monitor_words)) {
+    // Out of time already, so keep the blocks found without recognizing.
+    page_res_ = new PAGE_RES(block_list_);
+    global_monitor = NULL;
+    return 0;
+  }
   if (tesseract_->tessedit_resegment_from_boxes)
     tesseract_->apply_boxes(*input_file_, block_list_);
   tesseract_->SetBlackAndWhitelist();
@@ -579,6 +632,7 @@ int TessBaseAPI::Recognize(struct ETEXT_STRUCT* monitor) {
     delete page_res_;
     page_res_ = NULL;
 #endif
+    global_monitor = NULL;
     return -1;
 
   } else if (tesseract_->tessedit_train_from_boxes) {
@@ -596,6 +650,7 @@ int TessBaseAPI::Recognize(struct ETEXT_STRUCT* monitor) {
       tesseract_->recog_all_words(page_res_, monitor);
     }
   }
+  global_monitor = NULL;
   return result;
 }
 
@@ -609,11 +664,17 @@ int TessBaseAPI::RecognizeForChopTest(struct ETEXT_STRUCT* monitor) {
   }
   if (page_res_ != NULL)
     ClearResults();
-  if (FindLines() != 0)
+  global_monitor = monitor;
+  global_monitor_words = 0;
+  if (FindLines() != 0) {
+    global_monitor = NULL;
     return -1;
+  }
   // Additional conditions under which chopper test cannot be run
-  if (tesseract_->tessedit_train_from_boxes_word_level || interactive_mode)
+  if (tesseract_->tessedit_train_from_boxes_word_level || interactive_mode) {
+    global_monitor = NULL;
     return -1;
+  }
   ASSERT_HOST(tesseract_->inttemp_loaded_);
 
   page_res_ = new PAGE_RES(block_list_);
@@ -621,6 +682,7 @@ int TessBaseAPI::RecognizeForChopTest(struct ETEXT_STRUCT* monitor) {
   PAGE_RES_IT page_res_it(page_res_);
 
   tesseract_->tess_matcher = &Tesseract::tess_default_matcher;
+  tesseract_->tess_batch_matcher = &Tesseract::tess_default_batch_matcher;
   tesseract_->tess_tester = NULL;
   tesseract_->tess_trainer = NULL;
 
@@ -677,76 +739,66 @@ int TessBaseAPI::RecognizeForChopTest(struct ETEXT_STRUCT* monitor) {
     word_res->outword = make_ed_word(tessword, bln_word);
     page_res_it.forward();
   }
+  global_monitor = NULL;
   return 0;
 }
 
-// Make a text string from the internal data structures.
-char* TessBaseAPI::GetUTF8Text() {
+// Walks the recognition results of the page once, calling each of the
+// num_renderers renderers for every word, so any number of output formats
+// can be made from a single pass. Recognizes the page first if needed.
+// Returns false if there are no results.
+bool TessBaseAPI::RenderResults(ResultRenderer** renderers,
+                                int num_renderers) {
   if (tesseract_ == NULL ||
       (page_res_ == NULL && Recognize(NULL) < 0))
-    return NULL;
-  int total_length = TextLength(NULL);
-  PAGE_RES_IT   page_res_it(page_res_);
-  char* result = new char[total_length];
-  char* ptr = result;
+    return false;
+  RenderPage page;
+  page.tesseract = tesseract_;
+  page.input_file = input_file_ != NULL ? input_file_->string() : kInputFile;
+  page.rect_left = rect_left_;
+  page.rect_top = rect_top_;
+  page.rect_width = rect_width_;
+  page.rect_height = rect_height_;
+  page.image_width = image_width_;
+  page.image_height = image_height_;
+
+  int r;
+  for (r = 0; r < num_renderers; ++r)
+    renderers[r]->BeginPage(page);
+  PAGE_RES_IT page_res_it(page_res_);
   for (page_res_it.restart_page(); page_res_it.word () != NULL;
        page_res_it.forward()) {
-    WERD_RES *word = page_res_it.word();
-    WERD_CHOICE* choice = word->best_choice;
-    if (choice != NULL) {
-      strcpy(ptr, choice->unichar_string().string());
-      ptr += choice->unichar_string().length();
-      if (word->word->flag(W_EOL))
-        *ptr++ = '\n';
-      else
-        *ptr++ = ' ';
+    for (r = 0; r < num_renderers; ++r)
+      renderers[r]->AddWord(page, &page_res_it);
+    if (page_res_it.next_row() != page_res_it.row()) {
+      for (r = 0; r < num_renderers; ++r)
+        renderers[r]->EndRow(page);
     }
   }
-  *ptr++ = '\n';
-  *ptr = '\0';
+  for (r = 0; r < num_renderers; ++r)
+    renderers[r]->EndPage(page);
+  return true;
+}
+
+// Helper runs a single renderer over the page and returns the text it
+// added to output as a new [] string, or NULL if there are no results.
+static char* RenderToNewString(TessBaseAPI* api, ResultRenderer* renderer,
+                               const STRING& output) {
+  if (!api->RenderResults(&renderer, 1))
+    return NULL;
+  // STRING::string() is NULL when nothing was ever written to it.
+  const char* text = output.string();
+  int length = text != NULL ? strlen(text) : 0;
+  char* result = new char[length + 1];
+  memcpy(result, text != NULL ? text : "", length + 1);
   return result;
 }
 
-// Helper returns true if there is a paragraph break between bbox_cur,
-// and bbox_prev.
-// TODO(rays) improve and incorporate deeper into tesseract, so other
-// output methods get the benefit.
-static bool IsParagraphBreak(TBOX bbox_cur, TBOX bbox_prev,
-                             int right, int line_height) {
-  // Check if the distance between lines is larger than the normal leading,
-  if (fabs((float)(bbox_cur.bottom() - bbox_prev.bottom())) > line_height * 2)
-    return true;
-  
-  // Check if the distance between left bounds of the two lines is nearly the
-  // same as between their right bounds (if so, then both lines probably belong
-  // to the same paragraph, maybe a centered one).
-  if (fabs((float)((bbox_cur.left() - bbox_prev.left()) -
-           (bbox_prev.right() - bbox_cur.right()))) < line_height)
-    return false;
-  
-  // Check if there is a paragraph indent at this line (either -ve or +ve).
-  if (fabs((float)(bbox_cur.left() - bbox_prev.left())) > line_height)
-    return true;
-  
-  // Check if both current and previous line don't reach the right bound of the
-  // block, but the distance is different. This will cause all lines in a verse
-  // to be treated as separate paragraphs, but most probably will not split
-  // block-quotes to separate lines (at least if the text is justified).
-  if (fabs((float)(bbox_cur.right() - bbox_prev.right())) > line_height &&
-      right - bbox_cur.right() > line_height &&
-      right - bbox_prev.right() > line_height)
-    return true;
-    
-  return false;
-}
-
-// Helper to add the hOCR for a box to the given hocr_str.
-static void AddBoxTohOCR(const TBOX& box, int image_height, STRING* hocr_str) {
-  hocr_str->add_str_int("' title=\"bbox ", box.left());
-  hocr_str->add_str_int(" ", image_height - box.top());
-  hocr_str->add_str_int(" ", box.right());
-  hocr_str->add_str_int(" ", image_height - box.bottom());
-  *hocr_str += "\">";
+// Make a text string from the internal data structures.
+char* TessBaseAPI::GetUTF8Text() {
+  STRING text;
+  UTF8TextRenderer renderer(&text);
+  return RenderToNewString(this, &renderer, text);
 }
 
 // Make a HTML-formatted string with hOCR markup from the internal
@@ -754,308 +806,27 @@ static void AddBoxTohOCR(const TBOX& box, int image_height, STRING* hocr_str) {
 // STL removed from original patch submission and refactored by rays.
 // page_id is 1-based and will appear in the output.
 char* TessBaseAPI::GetHOCRText(int page_id) {
-  if (tesseract_ == NULL ||
-      (page_res_ == NULL && Recognize(NULL) < 0))
-    return NULL;
-  
-  PAGE_RES_IT page_res_it(page_res_);
-  ROW_RES *row = NULL;           // current row
-  ROW *real_row = NULL, *prev_row = NULL;
-  BLOCK_RES *block = NULL;       // current row
-  BLOCK *real_block = NULL;
-  int lcnt = 1, bcnt = 1, wcnt = 1;
-
-  STRING hocr_str;
-
-  hocr_str.add_str_int("<div class='ocr_page' id='page_", page_id);
-  hocr_str += "' title='image \"";
-  hocr_str += *input_file_;
-  hocr_str.add_str_int("\"; bbox ", rect_left_);
-  hocr_str.add_str_int(" ", rect_top_);
-  hocr_str.add_str_int(" ", rect_width_);
-  hocr_str.add_str_int(" ", rect_height_);
-  hocr_str += "'>\n";
-
-  for (page_res_it.restart_page(); page_res_it.word () != NULL;
-       page_res_it.forward()) {
-    if (block != page_res_it.block ()) {
-      
-      if (block != NULL) {
-        hocr_str += "</span>\n</p>\n</div>\n";
-      }
-      
-      block = page_res_it.block ();  // current row
-      real_block = block->block;
-      real_row = NULL;
-      row = NULL;
-      
-      hocr_str.add_str_int("<div class='ocr_carea' id='block_", page_id);
-      hocr_str.add_str_int("_", bcnt++);
-      AddBoxTohOCR(real_block->bounding_box(), image_height_, &hocr_str);
-      hocr_str += "\n<p class='ocr_par'>\n";
-    }
-    if (row != page_res_it.row ()) {
-      
-      if (row != NULL) {
-        hocr_str += "</span>\n";
-      }
-      prev_row = real_row;
-      
-      row = page_res_it.row ();  // current row
-      real_row = row->row;
-      
-      if (prev_row != NULL && 
-          IsParagraphBreak(real_row->bounding_box(), prev_row->bounding_box(),
-                           real_block->bounding_box().right(),
-                           real_row->x_height() + real_row->ascenders()))
-        hocr_str += "</p>\n<p class='ocr_par'>\n";
-      
-      hocr_str.add_str_int("<span class='ocr_line' id='line_", page_id);
-      hocr_str.add_str_int("_", lcnt++);
-      AddBoxTohOCR(real_row->bounding_box(), image_height_, &hocr_str);
-    }
-
-    WERD_RES *word = page_res_it.word();
-    WERD_CHOICE* choice = word->best_choice;
-    if (choice != NULL) {
-      hocr_str.add_str_int("<span class='ocr_word' id='word_", page_id);
-      hocr_str.add_str_int("_", wcnt);
-      AddBoxTohOCR(word->word->bounding_box(), image_height_, &hocr_str);
-      hocr_str.add_str_int("<span class='xocr_word' id='xword_", page_id);
-      hocr_str.add_str_int("_", wcnt++);
- 	    hocr_str.add_str_int("' title=\"x_wconf ", choice->certainty());
-      hocr_str += "\">";
-      if (word->bold > 0)
-        hocr_str += "<strong>";
-      if (word->italic > 0)
-        hocr_str += "<em>";
-      hocr_str += choice->unichar_string();
-      if (word->italic > 0)
-        hocr_str += "</em>";
-      if (word->bold > 0)
-        hocr_str += "</strong>";
-      hocr_str += "</span></span>";
-      if (!word->word->flag(W_EOL))
-        hocr_str += " ";
-    }
-  }
-  hocr_str += "</span>\n</p>\n";  
-  hocr_str += "</div>\n</div>\n";  
-  char *ret = new char[hocr_str.length() + 1];
-  strcpy(ret, hocr_str.string());
-  return ret;
-}
-
-static int ConvertWordToBoxText(WERD_RES *word,
-                                ROW_RES* row,
-                                int left,
-                                int bottom,
-                                int image_width,
-                                int image_height,
-                                int page_number,
-                                char* word_str) {
-  // Copy the output word and denormalize it back to image coords.
-  WERD copy_outword;
-  copy_outword = *(word->outword);
-  copy_outword.baseline_denormalise(&word->denorm);
-  PBLOB_IT blob_it;
-  blob_it.set_to_list(copy_outword.blob_list());
-  int length = copy_outword.blob_list()->length();
-  int output_size = 0;
-
-  if (length > 0) {
-    for (int index = 0, offset = 0; index < length;
-         offset += word->best_choice->unichar_lengths()[index++],
-         blob_it.forward()) {
-      PBLOB* blob = blob_it.data();
-      TBOX blob_box = blob->bounding_box();
-      if (word->tess_failed ||
-          blob_box.left() < 0 ||
-          blob_box.right() > image_width ||
-          blob_box.bottom() < 0 ||
-          blob_box.top() > image_height) {
-        // Bounding boxes can be illegal when tess fails on a word.
-        blob_box = word->word->bounding_box();  // Use original word as backup.
-        tprintf("Using substitute bounding box at (%d,%d)->(%d,%d)\n",
-                blob_box.left(), blob_box.bottom(),
-                blob_box.right(), blob_box.top());
-      }
-
-      // A single classification unit can be composed of several UTF-8
-      // characters. Append each of them to the result.
-      for (int sub = 0;
-           sub < word->best_choice->unichar_lengths()[index]; ++sub) {
-        char ch = word->best_choice->unichar_string()[offset + sub];
-        // Tesseract uses space for recognition failure. Fix to a reject
-        // character, kTesseractReject so we don't create illegal box files.
-        if (ch == ' ')
-          ch = kTesseractReject;
-        word_str[output_size++] = ch;
-      }
-      sprintf(word_str + output_size, " %d %d %d %d %d\n",
-              blob_box.left() + left, blob_box.bottom() + bottom,
-              blob_box.right() + left, blob_box.top() + bottom,
-              page_number);
-      output_size += strlen(word_str + output_size);
-    }
-  }
-  return output_size;
+  STRING text;
+  HOcrRenderer renderer(&text, page_id);
+  return RenderToNewString(this, &renderer, text);
 }
 
-// Multiplier for max expected textlength assumes typically 5 numbers @
-// (5 digits and a space) plus the newline = 5*(5+1)+1. Add to this the
-// orginal UTF8 characters, and one kMaxCharsPerChar.
-const int kCharsPerChar = 31;
-// A maximal single box could occupy 5 numbers at 20 digits (for 64 bit) and a
-// space plus the newline 5*(20+1)+1 and the maximum length of a UNICHAR.
-// Test against this on each iteration for safety.
-const int kMaxCharsPerChar = 106 + UNICHAR_LEN;
-
 // The recognized text is returned as a char* which is coded
 // as a UTF8 box file and must be freed with the delete [] operator.
 // page_number is a 0-base page index that will appear in the box file.
 char* TessBaseAPI::GetBoxText(int page_number) {
-  int bottom = image_height_ - (rect_top_ + rect_height_);
-  if (tesseract_ == NULL ||
-      (page_res_ == NULL && Recognize(NULL) < 0))
-    return NULL;
-  int blob_count;
-  int utf8_length = TextLength(&blob_count);
-  int total_length = blob_count*kCharsPerChar + utf8_length + kMaxCharsPerChar;
-  PAGE_RES_IT   page_res_it(page_res_);
-  char* result = new char[total_length];
-  char* ptr = result;
-  for (page_res_it.restart_page(); page_res_it.word () != NULL;
-       page_res_it.forward()) {
-    WERD_RES *word = page_res_it.word();
-    ptr += ConvertWordToBoxText(word, page_res_it.row(), rect_left_, bottom,
-                                image_width_, image_height_,
-                                page_number, ptr);
-    // Just in case...
-    if (ptr - result + kMaxCharsPerChar > total_length)
-      break;
-  }
-  *ptr = '\0';
-  return result;
+  STRING text;
+  BoxTextRenderer renderer(&text, page_number);
+  return RenderToNewString(this, &renderer, text);
 }
 
-// Conversion table for non-latin characters.
-// Maps characters out of the latin set into the latin set.
-// TODO(rays) incorporate this translation into unicharset.
-const int kUniChs[] = {
-  0x20ac, 0x201c, 0x201d, 0x2018, 0x2019, 0x2022, 0x2014, 0
-};
-// Latin chars corresponding to the unicode chars above.
-const int kLatinChs[] = {
-  0x00a2, 0x0022, 0x0022, 0x0027, 0x0027, 0x00b7, 0x002d, 0
-};
-
 // The recognized text is returned as a char* which is coded
 // as UNLV format Latin-1 with specific reject and suspect codes
 // and must be freed with the delete [] operator.
 char* TessBaseAPI::GetUNLVText() {
-  if (tesseract_ == NULL ||
-      (page_res_ == NULL && Recognize(NULL) < 0))
-    return NULL;
-  bool tilde_crunch_written = false;
-  bool last_char_was_newline = true;
-  bool last_char_was_tilde = false;
-
-  int total_length = TextLength(NULL);
-  PAGE_RES_IT   page_res_it(page_res_);
-  char* result = new char[total_length];
-  char* ptr = result;
-  for (page_res_it.restart_page(); page_res_it.word () != NULL;
-       page_res_it.forward()) {
-    WERD_RES *word = page_res_it.word();
-    // Process the current word.
-    if (word->unlv_crunch_mode != CR_NONE) {
-      if (word->unlv_crunch_mode != CR_DELETE &&
-          (!tilde_crunch_written ||
-           (word->unlv_crunch_mode == CR_KEEP_SPACE &&
-            word->word->space() > 0 &&
-            !word->word->flag(W_FUZZY_NON) &&
-            !word->word->flag(W_FUZZY_SP)))) {
-        if (!word->word->flag(W_BOL) &&
-            word->word->space() > 0 &&
-            !word->word->flag(W_FUZZY_NON) &&
-            !word->word->flag(W_FUZZY_SP)) {
-          /* Write a space to separate from preceeding good text */
-          *ptr++ = ' ';
-          last_char_was_tilde = false;
-        }
-        if (!last_char_was_tilde) {
-          // Write a reject char.
-          last_char_was_tilde = true;
-          *ptr++ = kUNLVReject;
-          tilde_crunch_written = true;
-          last_char_was_newline = false;
-        }
-      }
-    } else {
-      // NORMAL PROCESSING of non tilde crunched words.
-      tilde_crunch_written = false;
-
-      if (word->word->flag(W_REP_CHAR) && tessedit_consistent_reps)
-        ensure_rep_chars_are_consistent(word);
-
-      tesseract_->set_unlv_suspects(word);
-      const char* wordstr = word->best_choice->unichar_string().string();
-      const STRING& lengths = word->best_choice->unichar_lengths();
-      int length = lengths.length();
-      int i = 0;
-      int offset = 0;
-
-      if (last_char_was_tilde &&
-          word->word->space() == 0 && wordstr[offset] == ' ') {
-        // Prevent adjacent tilde across words - we know that adjacent tildes
-        // within words have been removed.
-        // Skip the first character.
-        offset = lengths[i++];
-      }
-      if (i < length && wordstr[offset] != 0) {
-        if (!last_char_was_newline)
-          *ptr++ = ' ';
-        else
-          last_char_was_newline = false;
-        for (; i < length; offset += lengths[i++]) {
-          if (wordstr[offset] == ' ' ||
-              wordstr[offset] == kTesseractReject) {
-            *ptr++ = kUNLVReject;
-            last_char_was_tilde = true;
-          } else {
-            if (word->reject_map[i].rejected())
-              *ptr++ = kUNLVSuspect;
-            UNICHAR ch(wordstr + offset, lengths[i]);
-            int uni_ch = ch.first_uni();
-            for (int j = 0; kUniChs[j] != 0; ++j) {
-              if (kUniChs[j] == uni_ch) {
-                uni_ch = kLatinChs[j];
-                break;
-              }
-            }
-            if (uni_ch <= 0xff) {
-              *ptr++ = static_cast<char>(uni_ch);
-              last_char_was_tilde = false;
-            } else {
-              *ptr++ = kUNLVReject;
-              last_char_was_tilde = true;
-            }
-          }
-        }
-      }
-    }
-    if (word->word->flag(W_EOL) && !last_char_was_newline) {
-      /* Add a new line output */
-      *ptr++ = '\n';
-      tilde_crunch_written = false;
-      last_char_was_newline = true;
-      last_char_was_tilde = false;
-    }
-  }
-  *ptr++ = '\n';
-  *ptr = '\0';
-  return result;
+  STRING text;
+  UNLVTextRenderer renderer(&text);
+  return RenderToNewString(this, &renderer, text);
 }
 
 // Returns the average word confidence for Tesseract page result.
@@ -1072,26 +843,15 @@ int TessBaseAPI::MeanTextConf() {
 
 // Returns an array of all word confidences, terminated by -1.
 int* TessBaseAPI::AllWordConfidences() {
-  if (tesseract_ == NULL ||
-      (page_res_ == NULL && Recognize(NULL) < 0))
+  GenericVector<int> confidences;
+  WordConfidenceRenderer renderer(&confidences);
+  ResultRenderer* renderers[] = { &renderer };
+  if (!RenderResults(renderers, 1))
     return NULL;
-  int n_word = 0;
-  PAGE_RES_IT res_it(page_res_);
-  for (res_it.restart_page(); res_it.word() != NULL; res_it.forward())
-    n_word++;
-
-  int* conf = new int[n_word+1];
-  n_word = 0;
-  for (res_it.restart_page(); res_it.word() != NULL; res_it.forward()) {
-    WERD_RES *word = res_it.word();
-    WERD_CHOICE* choice = word->best_choice;
-    int w_conf = static_cast<int>(100 + 5 * choice->certainty());
-                 // This is the eq for converting Tesseract confidence to 1..100
-    if (w_conf < 0) w_conf = 0;
-    if (w_conf > 100) w_conf = 100;
-    conf[n_word++] = w_conf;
-  }
-  conf[n_word] = -1;
+  int* conf = new int[confidences.size() + 1];
+  for (int i = 0; i < confidences.size(); ++i)
+    conf[i] = confidences[i];
+  conf[confidences.size()] = -1;
   return conf;
 }
 
@@ -1231,6 +991,9 @@ int TessBaseAPI::FindLines() {
 #endif
   if (!threshold_done_)
     Threshold(NULL);
+  // If the monitor is already out of time, return an empty page.
+  if (ocr_deadline_passed(global_monitor, global_monitor_words))
+    return 0;
 
   if (tesseract_->SegmentPage(input_file_, &page_image, block_list_) < 0)
     return -1;
@@ -1256,36 +1019,6 @@ void TessBaseAPI::ClearResults() {
     block_list_->clear();
 }
 
-// Return the length of the output text string, as UTF8, assuming
-// one newline per line and one per block, with a terminator,
-// and assuming a single character reject marker for each rejected character.
-// Also return the number of recognized blobs in blob_count.
-int TessBaseAPI::TextLength(int* blob_count) {
-  if (tesseract_ == NULL || page_res_ == NULL)
-    return 0;
-
-  PAGE_RES_IT   page_res_it(page_res_);
-  int total_length = 2;
-  int total_blobs = 0;
-  // Iterate over the data structures to extract the recognition result.
-  for (page_res_it.restart_page(); page_res_it.word () != NULL;
-       page_res_it.forward()) {
-    WERD_RES *word = page_res_it.word();
-    WERD_CHOICE* choice = word->best_choice;
-    if (choice != NULL) {
-      total_blobs += choice->length() + 1;
-      total_length += choice->unichar_string().length() + 1;
-      for (int i = 0; i < word->reject_map.length(); ++i) {
-        if (word->reject_map[i].rejected())
-          ++total_length;
-      }
-    }
-  }
-  if (blob_count != NULL)
-    *blob_count = total_blobs;
-  return total_length;
-}
-
 // Estimates the Orientation And Script of the image.
 // Returns true if the image was processed successfully.
 bool TessBaseAPI::DetectOS(OSResults* osr) {
@@ -1295,7 +1028,13 @@ bool TessBaseAPI::DetectOS(OSResults* osr) {
   Threshold(NULL);
   if (input_file_ == NULL)
     input_file_ = new STRING(kInputFile);
-  return orientation_and_script_detection(*input_file_, osr, tesseract_);
+  int width = page_image.get_xsize();
+  bool result = orientation_and_script_detection(*input_file_, osr, tesseract_);
+  // If detection reduced the thresholded image, threshold again before
+  // recognizing.
+  if (page_image.get_xsize() != width)
+    threshold_done_ = false;
+  return result;
 }
 
 // ____________________________________________________________________________
@@ -1725,6 +1464,22 @@ int TessBaseAPI::NumDawgs() const {
   return tesseract_ == NULL ? 0 : tesseract_->getDict().NumDawgs();
 }
 
+// Read the words listed in the given file into a new dawg.
+Dawg *TessBaseAPI::ReadUserWords(const char* filename) {
+  if (tesseract_ == NULL) return NULL;
+  return tesseract_->getDict().read_user_words(filename, USER_DAWG_PERM);
+}
+
+// Add the given dawg to the dictionaries searched during recognition.
+bool TessBaseAPI::AddUserDawg(const Dawg *dawg) {
+  return tesseract_ != NULL && tesseract_->getDict().add_user_dawg(dawg);
+}
+
+// Remove a dawg added with AddUserDawg().
+bool TessBaseAPI::RemoveUserDawg(const Dawg *dawg) {
+  return tesseract_ != NULL && tesseract_->getDict().remove_user_dawg(dawg);
+}
+
 // Return the language used in the last valid initialization.
 const char* TessBaseAPI::GetLastInitLanguage() const {
   return (tesseract_ == NULL || tesseract_->lang.string() == NULL) ?
@@ -58,6 +58,7 @@ class CubeRecoContext;
 class TesseractCubeCombiner;
 class CubeObject;
 class CubeLineObject;
+class ResultRenderer;
 class Dawg;
 
 typedef int (Dict::*DictFunc)(void* void_dawg_args, int char_index,
@@ -190,6 +191,9 @@ class TESSDLL_API TessBaseAPI {
    * have an effect, depending on the implementation.
    * The mode is stored as an INT_VARIABLE so it can also be modified by
    * ReadConfigFile or SetVariable("tessedit_accuracyvspeed", mode as string).
+   * For more speed than AVS_FASTEST, set the variable tord_fast_mode, which
+   * skips chopping, pass 2, dangerous ambiguity checks and further adaptive
+   * learning for words at least as confident as tord_fast_mode_certainty.
    */
   void SetAccuracyVSpeed(AccuracyVSpeed mode);
 
@@ -220,6 +224,26 @@ class TESSDLL_API TessBaseAPI {
    */
   void ClearAdaptiveClassifier();
 
+  /**
+   * Save a snapshot of the adaptive classifier to the given file in a
+   * compact binary format. Together with LoadAdaptiveClassifier, this
+   * lets a long run of similar pages or documents start each one with
+   * the adaptation learned so far, instead of from scratch after
+   * ClearAdaptiveClassifier. Returns false on failure.
+   */
+  bool SaveAdaptiveClassifier(const char* filename);
+  /**
+   * Replace the adaptive classifier with a snapshot written by
+   * SaveAdaptiveClassifier with the same language. Returns false (and
+   * leaves the classifier untouched) if the file cannot be used.
+   */
+  bool LoadAdaptiveClassifier(const char* filename);
+  /**
+   * Replace the adaptive classifier with a copy of that of source, which
+   * must have been initialized with the same language.
+   */
+  bool CopyAdaptiveClassifier(const TessBaseAPI& source);
+
   /**
    * @defgroup AdvancedAPI Advanced API
    * The following methods break TesseractRect into pieces, so you can
@@ -315,6 +339,11 @@ class TESSDLL_API TessBaseAPI {
    * internal structures. Returns 0 on success.
    * Optional. The Get*Text functions below will call Recognize if needed.
    * After Recognize, the output is kept internally until the next SetImage.
+   * If monitor is not NULL, its deadline and cancel function are checked
+   * through layout analysis and recognition, and Recognize returns early
+   * with the blocks and words found so far. The monitor is held in a
+   * process-wide pointer for the duration of the call, so, like the engine
+   * itself (see Init), only one instance may recognize at a time.
    */
   int Recognize(ETEXT_STRUCT* monitor);
 
@@ -326,6 +355,14 @@ class TESSDLL_API TessBaseAPI {
   /** Variant on Recognize used for testing chopper. */
   int RecognizeForChopTest(struct ETEXT_STRUCT* monitor);
 
+  /**
+   * Walks the recognition results once, in reading order, and feeds every
+   * word to each of the num_renderers renderers (see renderer.h), so that
+   * several output formats, eg. text, hOCR and box, can be made from a
+   * single pass. The renderers append to caller-supplied STRINGs or stream
+   * to files. Returns false if there are no results.
+   */
+  bool RenderResults(ResultRenderer** renderers, int num_renderers);
   /**
    * The recognized text is returned as a char* which is coded
    * as UTF8 and must be freed with the delete [] operator.
@@ -407,6 +444,26 @@ class TESSDLL_API TessBaseAPI {
   /** Return the number of dawgs loaded into tesseract_ object. */
   int NumDawgs() const;
 
+  /**
+   * Reads the words listed in the given file (one per line) into a new dawg
+   * that can be added to any TessBaseAPI initialized with the same language.
+   * The caller owns the returned dawg. Returns NULL on failure.
+   */
+  Dawg *ReadUserWords(const char* filename);
+
+  /**
+   * Adds the given dawg to the dictionaries searched during recognition
+   * without re-initializing. The dawg is not copied, so the same dawg can
+   * be shared by several TessBaseAPI instances, and it must be kept alive
+   * until it is removed with RemoveUserDawg() or until End()/Init().
+   * Returns false if the language model is not loaded or the dawg is
+   * already added.
+   */
+  bool AddUserDawg(const Dawg *dawg);
+
+  /** Removes a dawg added with AddUserDawg(). Returns false if not found. */
+  bool RemoveUserDawg(const Dawg *dawg);
+
   /** Return the language used in the last valid initialization. */
   const char* GetLastInitLanguage() const;
 
@@ -432,14 +489,6 @@ class TESSDLL_API TessBaseAPI {
   /** Delete the pageres and block list ready for a new page. */
   void ClearResults();
 
-  /**
-   * Return the length of the output text string, as UTF8, assuming
-   * one newline per line and one per block, with a terminator,
-   * and assuming a single character reject marker for each rejected character.
-   * Also return the number of recognized blobs in blob_count.
-   */
-  int TextLength(int* blob_count);
-
   /** @defgroup ocropusAddOns ocropus add-ons */
 
   /* @{ */
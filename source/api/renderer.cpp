@@ -0,0 +1,418 @@
+///////////////////////////////////////////////////////////////////////
+// File:        renderer.cpp
+// Description: Renderers that turn recognition results into output text.
+//
+// (C) Copyright 2010, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+// Include automatically generated configuration file if running autoconf.
+#ifdef HAVE_CONFIG_H
+#include "config_auto.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "renderer.h"
+#include "tesseractclass.h"
+#include "pageres.h"
+#include "output.h"
+#include "unichar.h"
+#include "tprintf.h"
+
+namespace tesseract {
+
+// Character returned when Tesseract couldn't recognize as anything.
+const char kTesseractReject = '~';
+// Character used by UNLV error counter as a reject.
+const char kUNLVReject = '~';
+// Character used by UNLV as a suspect marker.
+const char kUNLVSuspect = '^';
+
+TextResultRenderer::TextResultRenderer(STRING* output)
+  : output_(output), file_(NULL) {
+}
+
+TextResultRenderer::TextResultRenderer(FILE* output)
+  : output_(&buffer_), file_(output) {
+}
+
+TextResultRenderer::~TextResultRenderer() {
+  Flush();
+}
+
+void TextResultRenderer::EndRow(const RenderPage& page) {
+  Flush();
+}
+
+void TextResultRenderer::EndPage(const RenderPage& page) {
+  Flush();
+}
+
+// Writes any buffered text to the output file. Does nothing when
+// rendering to a STRING.
+void TextResultRenderer::Flush() {
+  if (file_ != NULL && buffer_.length() > 0) {
+    fwrite(buffer_.string(), 1, buffer_.length(), file_);
+    buffer_ = "";
+  }
+}
+
+void UTF8TextRenderer::AddWord(const RenderPage& page, PAGE_RES_IT* it) {
+  WERD_RES *word = it->word();
+  WERD_CHOICE* choice = word->best_choice;
+  if (choice != NULL) {
+    *out() += choice->unichar_string();
+    if (word->word->flag(W_EOL))
+      *out() += '\n';
+    else
+      *out() += ' ';
+  }
+}
+
+void UTF8TextRenderer::EndPage(const RenderPage& page) {
+  *out() += '\n';
+  TextResultRenderer::EndPage(page);
+}
+
+// Helper returns true if there is a paragraph break between bbox_cur,
+// and bbox_prev.
+// TODO(rays) improve and incorporate deeper into tesseract, so other
+// output methods get the benefit.
+static bool IsParagraphBreak(TBOX bbox_cur, TBOX bbox_prev,
+                             int right, int line_height) {
+  // Check if the distance between lines is larger than the normal leading,
+  if (fabs((float)(bbox_cur.bottom() - bbox_prev.bottom())) > line_height * 2)
+    return true;
+
+  // Check if the distance between left bounds of the two lines is nearly the
+  // same as between their right bounds (if so, then both lines probably belong
+  // to the same paragraph, maybe a centered one).
+  if (fabs((float)((bbox_cur.left() - bbox_prev.left()) -
+           (bbox_prev.right() - bbox_cur.right()))) < line_height)
+    return false;
+
+  // Check if there is a paragraph indent at this line (either -ve or +ve).
+  if (fabs((float)(bbox_cur.left() - bbox_prev.left())) > line_height)
+    return true;
+
+  // Check if both current and previous line don't reach the right bound of the
+  // block, but the distance is different. This will cause all lines in a verse
+  // to be treated as separate paragraphs, but most probably will not split
+  // block-quotes to separate lines (at least if the text is justified).
+  if (fabs((float)(bbox_cur.right() - bbox_prev.right())) > line_height &&
+      right - bbox_cur.right() > line_height &&
+      right - bbox_prev.right() > line_height)
+    return true;
+
+  return false;
+}
+
+// Helper to add the hOCR for a box to the given hocr_str.
+static void AddBoxTohOCR(const TBOX& box, int image_height, STRING* hocr_str) {
+  hocr_str->add_str_int("' title=\"bbox ", box.left());
+  hocr_str->add_str_int(" ", image_height - box.top());
+  hocr_str->add_str_int(" ", box.right());
+  hocr_str->add_str_int(" ", image_height - box.bottom());
+  *hocr_str += "\">";
+}
+
+HOcrRenderer::HOcrRenderer(STRING* output, int page_id)
+  : TextResultRenderer(output) {
+  Init(page_id);
+}
+
+HOcrRenderer::HOcrRenderer(FILE* output, int page_id)
+  : TextResultRenderer(output) {
+  Init(page_id);
+}
+
+void HOcrRenderer::Init(int page_id) {
+  page_id_ = page_id;
+  block_ = NULL;
+  row_ = NULL;
+  prev_row_ = NULL;
+  block_count_ = 1;
+  line_count_ = 1;
+  word_count_ = 1;
+}
+
+void HOcrRenderer::BeginPage(const RenderPage& page) {
+  Init(page_id_);
+  STRING* hocr_str = out();
+  hocr_str->add_str_int("<div class='ocr_page' id='page_", page_id_);
+  *hocr_str += "' title='image \"";
+  *hocr_str += page.input_file;
+  hocr_str->add_str_int("\"; bbox ", page.rect_left);
+  hocr_str->add_str_int(" ", page.rect_top);
+  hocr_str->add_str_int(" ", page.rect_width);
+  hocr_str->add_str_int(" ", page.rect_height);
+  *hocr_str += "'>\n";
+}
+
+void HOcrRenderer::AddWord(const RenderPage& page, PAGE_RES_IT* it) {
+  STRING* hocr_str = out();
+  if (block_ != it->block()) {
+    if (block_ != NULL)
+      *hocr_str += "</span>\n</p>\n</div>\n";
+    block_ = it->block();
+    row_ = NULL;
+    prev_row_ = NULL;
+    hocr_str->add_str_int("<div class='ocr_carea' id='block_", page_id_);
+    hocr_str->add_str_int("_", block_count_++);
+    AddBoxTohOCR(block_->block->bounding_box(), page.image_height, hocr_str);
+    *hocr_str += "\n<p class='ocr_par'>\n";
+  }
+  if (row_ != it->row()) {
+    if (row_ != NULL) {
+      *hocr_str += "</span>\n";
+      prev_row_ = row_->row;
+    }
+    row_ = it->row();
+    ROW* real_row = row_->row;
+    if (prev_row_ != NULL &&
+        IsParagraphBreak(real_row->bounding_box(), prev_row_->bounding_box(),
+                         block_->block->bounding_box().right(),
+                         real_row->x_height() + real_row->ascenders()))
+      *hocr_str += "</p>\n<p class='ocr_par'>\n";
+    hocr_str->add_str_int("<span class='ocr_line' id='line_", page_id_);
+    hocr_str->add_str_int("_", line_count_++);
+    AddBoxTohOCR(real_row->bounding_box(), page.image_height, hocr_str);
+  }
+
+  WERD_RES *word = it->word();
+  WERD_CHOICE* choice = word->best_choice;
+  if (choice != NULL) {
+    hocr_str->add_str_int("<span class='ocr_word' id='word_", page_id_);
+    hocr_str->add_str_int("_", word_count_);
+    AddBoxTohOCR(word->word->bounding_box(), page.image_height, hocr_str);
+    hocr_str->add_str_int("<span class='xocr_word' id='xword_", page_id_);
+    hocr_str->add_str_int("_", word_count_++);
+    hocr_str->add_str_int("' title=\"x_wconf ", choice->certainty());
+    *hocr_str += "\">";
+    if (word->bold > 0)
+      *hocr_str += "<strong>";
+    if (word->italic > 0)
+      *hocr_str += "<em>";
+    *hocr_str += choice->unichar_string();
+    if (word->italic > 0)
+      *hocr_str += "</em>";
+    if (word->bold > 0)
+      *hocr_str += "</strong>";
+    *hocr_str += "</span></span>";
+    if (!word->word->flag(W_EOL))
+      *hocr_str += " ";
+  }
+}
+
+void HOcrRenderer::EndPage(const RenderPage& page) {
+  *out() += "</span>\n</p>\n";
+  *out() += "</div>\n</div>\n";
+  TextResultRenderer::EndPage(page);
+}
+
+// A maximal single box could occupy 5 numbers at 20 digits (for 64 bit) and a
+// space plus the newline 5*(20+1)+1, and the terminator.
+const int kMaxBoxNumberChars = 107;
+
+void BoxTextRenderer::AddWord(const RenderPage& page, PAGE_RES_IT* it) {
+  WERD_RES *word = it->word();
+  if (word->best_choice == NULL)
+    return;  // Not recognized, eg. because the deadline passed.
+  int left = page.rect_left;
+  int bottom = page.image_height - (page.rect_top + page.rect_height);
+  // Copy the output word and denormalize it back to image coords.
+  WERD copy_outword;
+  copy_outword = *(word->outword);
+  copy_outword.baseline_denormalise(&word->denorm);
+  PBLOB_IT blob_it;
+  blob_it.set_to_list(copy_outword.blob_list());
+  int length = copy_outword.blob_list()->length();
+  char numbers[kMaxBoxNumberChars];
+
+  for (int index = 0, offset = 0; index < length;
+       offset += word->best_choice->unichar_lengths()[index++],
+       blob_it.forward()) {
+    PBLOB* blob = blob_it.data();
+    TBOX blob_box = blob->bounding_box();
+    if (word->tess_failed ||
+        blob_box.left() < 0 ||
+        blob_box.right() > page.image_width ||
+        blob_box.bottom() < 0 ||
+        blob_box.top() > page.image_height) {
+      // Bounding boxes can be illegal when tess fails on a word.
+      blob_box = word->word->bounding_box();  // Use original word as backup.
+      tprintf("Using substitute bounding box at (%d,%d)->(%d,%d)\n",
+              blob_box.left(), blob_box.bottom(),
+              blob_box.right(), blob_box.top());
+    }
+
+    // A single classification unit can be composed of several UTF-8
+    // characters. Append each of them to the result.
+    for (int sub = 0;
+         sub < word->best_choice->unichar_lengths()[index]; ++sub) {
+      char ch = word->best_choice->unichar_string()[offset + sub];
+      // Tesseract uses space for recognition failure. Fix to a reject
+      // character, kTesseractReject so we don't create illegal box files.
+      if (ch == ' ')
+        ch = kTesseractReject;
+      *out() += ch;
+    }
+    sprintf(numbers, " %d %d %d %d %d\n",
+            blob_box.left() + left, blob_box.bottom() + bottom,
+            blob_box.right() + left, blob_box.top() + bottom,
+            page_number_);
+    *out() += numbers;
+  }
+}
+
+// Conversion table for non-latin characters.
+// Maps characters out of the latin set into the latin set.
+// TODO(rays) incorporate this translation into unicharset.
+const int kUniChs[] = {
+  0x20ac, 0x201c, 0x201d, 0x2018, 0x2019, 0x2022, 0x2014, 0
+};
+// Latin chars corresponding to the unicode chars above.
+const int kLatinChs[] = {
+  0x00a2, 0x0022, 0x0022, 0x0027, 0x0027, 0x00b7, 0x002d, 0
+};
+
+UNLVTextRenderer::UNLVTextRenderer(STRING* output)
+  : TextResultRenderer(output) {
+  Reset();
+}
+
+UNLVTextRenderer::UNLVTextRenderer(FILE* output)
+  : TextResultRenderer(output) {
+  Reset();
+}
+
+void UNLVTextRenderer::Reset() {
+  tilde_crunch_written_ = false;
+  last_char_was_newline_ = true;
+  last_char_was_tilde_ = false;
+}
+
+void UNLVTextRenderer::BeginPage(const RenderPage& page) {
+  Reset();
+}
+
+void UNLVTextRenderer::AddWord(const RenderPage& page, PAGE_RES_IT* it) {
+  STRING* text = out();
+  WERD_RES *word = it->word();
+  if (word->best_choice == NULL)
+    return;  // Not recognized, eg. because the deadline passed.
+  // Process the current word.
+  if (word->unlv_crunch_mode != CR_NONE) {
+    if (word->unlv_crunch_mode != CR_DELETE &&
+        (!tilde_crunch_written_ ||
+         (word->unlv_crunch_mode == CR_KEEP_SPACE &&
+          word->word->space() > 0 &&
+          !word->word->flag(W_FUZZY_NON) &&
+          !word->word->flag(W_FUZZY_SP)))) {
+      if (!word->word->flag(W_BOL) &&
+          word->word->space() > 0 &&
+          !word->word->flag(W_FUZZY_NON) &&
+          !word->word->flag(W_FUZZY_SP)) {
+        /* Write a space to separate from preceeding good text */
+        *text += ' ';
+        last_char_was_tilde_ = false;
+      }
+      if (!last_char_was_tilde_) {
+        // Write a reject char.
+        last_char_was_tilde_ = true;
+        *text += kUNLVReject;
+        tilde_crunch_written_ = true;
+        last_char_was_newline_ = false;
+      }
+    }
+  } else {
+    // NORMAL PROCESSING of non tilde crunched words.
+    tilde_crunch_written_ = false;
+
+    if (word->word->flag(W_REP_CHAR) && tessedit_consistent_reps)
+      ensure_rep_chars_are_consistent(word);
+
+    page.tesseract->set_unlv_suspects(word);
+    const char* wordstr = word->best_choice->unichar_string().string();
+    const STRING& lengths = word->best_choice->unichar_lengths();
+    int length = lengths.length();
+    int i = 0;
+    int offset = 0;
+
+    if (last_char_was_tilde_ &&
+        word->word->space() == 0 && wordstr[offset] == ' ') {
+      // Prevent adjacent tilde across words - we know that adjacent tildes
+      // within words have been removed.
+      // Skip the first character.
+      offset = lengths[i++];
+    }
+    if (i < length && wordstr[offset] != 0) {
+      if (!last_char_was_newline_)
+        *text += ' ';
+      else
+        last_char_was_newline_ = false;
+      for (; i < length; offset += lengths[i++]) {
+        if (wordstr[offset] == ' ' ||
+            wordstr[offset] == kTesseractReject) {
+          *text += kUNLVReject;
+          last_char_was_tilde_ = true;
+        } else {
+          if (word->reject_map[i].rejected())
+            *text += kUNLVSuspect;
+          UNICHAR ch(wordstr + offset, lengths[i]);
+          int uni_ch = ch.first_uni();
+          for (int j = 0; kUniChs[j] != 0; ++j) {
+            if (kUniChs[j] == uni_ch) {
+              uni_ch = kLatinChs[j];
+              break;
+            }
+          }
+          if (uni_ch <= 0xff) {
+            *text += static_cast<char>(uni_ch);
+            last_char_was_tilde_ = false;
+          } else {
+            *text += kUNLVReject;
+            last_char_was_tilde_ = true;
+          }
+        }
+      }
+    }
+  }
+  if (word->word->flag(W_EOL) && !last_char_was_newline_) {
+    /* Add a new line output */
+    *text += '\n';
+    tilde_crunch_written_ = false;
+    last_char_was_newline_ = true;
+    last_char_was_tilde_ = false;
+  }
+}
+
+void UNLVTextRenderer::EndPage(const RenderPage& page) {
+  *out() += '\n';
+  TextResultRenderer::EndPage(page);
+}
+
+void WordConfidenceRenderer::AddWord(const RenderPage& page,
+                                     PAGE_RES_IT* it) {
+  WERD_CHOICE* choice = it->word()->best_choice;
+  if (choice == NULL)
+    return;
+  // This is the eq for converting Tesseract confidence to 1..100
+  int w_conf = static_cast<int>(100 + 5 * choice->certainty());
+  if (w_conf < 0) w_conf = 0;
+  if (w_conf > 100) w_conf = 100;
+  confidences_->push_back(w_conf);
+}
+
+}  // namespace tesseract.
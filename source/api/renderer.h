@@ -0,0 +1,178 @@
+///////////////////////////////////////////////////////////////////////
+// File:        renderer.h
+// Description: Renderers that turn recognition results into output text.
+//
+// (C) Copyright 2010, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_API_RENDERER_H__
+#define TESSERACT_API_RENDERER_H__
+
+#include <stdio.h>
+#include "strngs.h"
+#include "genericvector.h"
+
+class PAGE_RES_IT;
+class ROW;
+class ROW_RES;
+class BLOCK_RES;
+
+namespace tesseract {
+
+class Tesseract;
+
+// Information about the page being rendered, filled in by
+// TessBaseAPI::RenderResults and handed to every renderer.
+struct RenderPage {
+  Tesseract* tesseract;    // Owner of the results.
+  const char* input_file;  // Name of the image, for hOCR.
+  int rect_left;           // Rectangle of the image that was recognized.
+  int rect_top;
+  int rect_width;
+  int rect_height;
+  int image_width;         // Size of the whole image.
+  int image_height;
+};
+
+// Base class for a sink of recognition results.
+// TessBaseAPI::RenderResults walks the words of the page once, in reading
+// order, and calls every renderer given to it for each word, so any number
+// of output formats can be produced from a single pass over the results.
+class ResultRenderer {
+ public:
+  ResultRenderer() {}
+  virtual ~ResultRenderer() {}
+
+  // Called once before the first word of the page.
+  virtual void BeginPage(const RenderPage& page) {}
+  // Called for every word of the page. The iterator must not be moved.
+  virtual void AddWord(const RenderPage& page, PAGE_RES_IT* it) = 0;
+  // Called after the last word of every text line.
+  virtual void EndRow(const RenderPage& page) {}
+  // Called once after the last word of the page.
+  virtual void EndPage(const RenderPage& page) {}
+};
+
+// Base class for renderers that produce text.
+// The text is appended to a caller-supplied STRING, or, if a FILE is
+// given instead, streamed to the file a line at a time, so the whole
+// output never needs to be held in memory.
+class TextResultRenderer : public ResultRenderer {
+ public:
+  explicit TextResultRenderer(STRING* output);
+  explicit TextResultRenderer(FILE* output);
+  virtual ~TextResultRenderer();
+
+  virtual void EndRow(const RenderPage& page);
+  virtual void EndPage(const RenderPage& page);
+
+  // Writes any buffered text to the output file. Does nothing when
+  // rendering to a STRING.
+  void Flush();
+
+ protected:
+  // The string to add text to.
+  STRING* out() {
+    return output_;
+  }
+
+ private:
+  STRING* output_;  // Where the text goes.
+  STRING buffer_;   // Holds a line of text when streaming to file_.
+  FILE* file_;      // Output file, or NULL.
+};
+
+// Renders the plain UTF-8 text of the page, one line of text per line.
+class UTF8TextRenderer : public TextResultRenderer {
+ public:
+  explicit UTF8TextRenderer(STRING* output) : TextResultRenderer(output) {}
+  explicit UTF8TextRenderer(FILE* output) : TextResultRenderer(output) {}
+
+  virtual void AddWord(const RenderPage& page, PAGE_RES_IT* it);
+  virtual void EndPage(const RenderPage& page);
+};
+
+// Renders the page as hOCR html markup.
+// page_id is 1-based and will appear in the output.
+class HOcrRenderer : public TextResultRenderer {
+ public:
+  HOcrRenderer(STRING* output, int page_id);
+  HOcrRenderer(FILE* output, int page_id);
+
+  virtual void BeginPage(const RenderPage& page);
+  virtual void AddWord(const RenderPage& page, PAGE_RES_IT* it);
+  virtual void EndPage(const RenderPage& page);
+
+ private:
+  void Init(int page_id);
+
+  int page_id_;
+  BLOCK_RES* block_;  // Block of the last word.
+  ROW_RES* row_;      // Row of the last word.
+  ROW* prev_row_;     // Row before row_ in the same block.
+  int block_count_;   // Ids of the next block, line and word.
+  int line_count_;
+  int word_count_;
+};
+
+// Renders the page in the box file format used in training, with one
+// character and its bounding box in image coordinates per line.
+// page_number is a 0-based page index that will appear in the output.
+class BoxTextRenderer : public TextResultRenderer {
+ public:
+  BoxTextRenderer(STRING* output, int page_number)
+    : TextResultRenderer(output), page_number_(page_number) {}
+  BoxTextRenderer(FILE* output, int page_number)
+    : TextResultRenderer(output), page_number_(page_number) {}
+
+  virtual void AddWord(const RenderPage& page, PAGE_RES_IT* it);
+
+ private:
+  int page_number_;
+};
+
+// Renders the page as UNLV format Latin-1 text with specific reject and
+// suspect codes.
+class UNLVTextRenderer : public TextResultRenderer {
+ public:
+  explicit UNLVTextRenderer(STRING* output);
+  explicit UNLVTextRenderer(FILE* output);
+
+  virtual void BeginPage(const RenderPage& page);
+  virtual void AddWord(const RenderPage& page, PAGE_RES_IT* it);
+  virtual void EndPage(const RenderPage& page);
+
+ private:
+  void Reset();
+
+  bool tilde_crunch_written_;
+  bool last_char_was_newline_;
+  bool last_char_was_tilde_;
+};
+
+// Collects the confidence (between 0 and 100) of every word that has a
+// result, in the same order as the words of UTF8TextRenderer.
+class WordConfidenceRenderer : public ResultRenderer {
+ public:
+  explicit WordConfidenceRenderer(GenericVector<int>* confidences)
+    : confidences_(confidences) {}
+
+  virtual void AddWord(const RenderPage& page, PAGE_RES_IT* it);
+
+ private:
+  GenericVector<int>* confidences_;
+};
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_API_RENDERER_H__
@@ -23,6 +23,7 @@
 #include <vld.h>
 #endif
 #include <ctype.h>
+#include <time.h>
 #include "applybox.h"
 #include "control.h"
 #include "tessvars.h"
@@ -43,6 +44,7 @@
 #include "blread.h"
 #include "tfacep.h"
 #include "callnet.h"
+#include "tordvars.h"
 
 // Include automatically generated configuration file if running autoconf
 #ifdef HAVE_CONFIG_H
@@ -85,6 +87,38 @@ BOOL_VAR(tessedit_debug_to_screen, FALSE, "Dont use debug file");
 
 const int kMaxIntSize = 22;
 char szAppName[] = "Tessedit";   //app name
+// Set by giving -b in place of the outputbase: time each page with
+// tord_fast_mode off and on instead of writing any text.
+static bool benchmark_fast_mode = false;
+
+// Recognize the image already set in api once with tord_fast_mode 0 and once
+// with 1, clearing the adaptive classifier first so the runs are comparable,
+// and print the cpu time and the word confidences of each run to stdout.
+static void BenchmarkFastMode(tesseract::TessBaseAPI* api) {
+  const char* old_mode = tord_fast_mode ? "1" : "0";
+  for (int fast = 0; fast <= 1; ++fast) {
+    api->SetVariable("tord_fast_mode", fast ? "1" : "0");
+    api->ClearAdaptiveClassifier();
+    clock_t start = clock();
+    if (api->Recognize(NULL) < 0) {
+      fprintf(stderr, _("Error: recognition failed\n"));
+      break;
+    }
+    double seconds = static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+    int* confs = api->AllWordConfidences();
+    int num_words = 0;
+    while (confs != NULL && confs[num_words] >= 0)
+      ++num_words;
+    printf("tord_fast_mode %d: %.3f secs, %d words, mean conf %d\n",
+           fast, seconds, num_words, api->MeanTextConf());
+    printf("word confs:");
+    for (int i = 0; i < num_words; ++i)
+      printf(" %d", confs[i]);
+    printf("\n");
+    delete [] confs;
+  }
+  api->SetVariable("tord_fast_mode", old_mode);
+}
 
 // Recognize a single page, given by the (const) image, and output the text,
 // as controlled by global flag variables into the output text_out STRING:
@@ -128,6 +162,10 @@ void TesseractImage(const char* input_file, IMAGE* image, Pix* pix, int page_ind
 #ifdef HAVE_LIBLEPT
   }
 #endif
+  if (benchmark_fast_mode) {
+    BenchmarkFastMode(api);
+    return;
+  }
   if (tessedit_serial_unlv == 0) {
     char* text;
     if (tessedit_create_boxfile)
@@ -199,8 +237,10 @@ int main(int argc, char **argv) {
   }
 #endif
   if (argc < 3) {
-    fprintf(stderr, "Usage:%s imagename outputbase [-l lang]"
+    fprintf(stderr, "Usage:%s imagename outputbase|-b [-l lang]"
             " [configfile [[+|-]varfile]...]\n"
+            "  -b times each page with tord_fast_mode 0 and 1 and prints"
+            " the word\n  confidences instead of writing any output.\n"
 #if !defined(HAVE_LIBLEPT) && !defined(_TIFFIO_)
             "Warning - no liblept or libtiff - cannot read compressed"
             " tiff files.\n"
@@ -216,6 +256,8 @@ int main(int argc, char **argv) {
     arg = 5;
   }
 
+  benchmark_fast_mode = strcmp(argv[2], "-b") == 0;
+
   tesseract::TessBaseAPI  api;
 
   api.SetOutputName(argv[2]);
@@ -365,6 +407,8 @@ int main(int argc, char **argv) {
 
   //no longer using fp
   if (fp != NULL) fclose(fp);
+  if (benchmark_fast_mode)
+    return 0;
 
   bool output_hocr = tessedit_create_hocr;
   outfile = argv[2];
@@ -160,6 +160,7 @@ EXTERN double_VAR (test_pt_y, 99999.99, "ycoord");
 
 extern int display_ratings;
 extern int number_debug;
+extern int global_monitor_words;
 FILE *choice_file = NULL;        // Choice file ptr
 
 CLISTIZEH (PBLOB) CLISTIZE (PBLOB)
@@ -280,6 +281,7 @@ if (dopasses==0 || dopasses==1)
 {
 	page_res_it.page_res=page_res;
 	page_res_it.restart_page();
+  reset_page_budget();
 
   /* Pass 1 */
   word_count = 0;
@@ -301,6 +303,10 @@ if (dopasses==0 || dopasses==1)
     char_clusters.clear();
     chars_waiting.clear();
     dict_words = 0;
+    global_monitor_words = 0;
+    // Features are kept from pass 1 to pass 2 of the page, for the words
+    // whose blobs are unchanged.
+    ClearFeatureCache();
 	doc_blob_quality = 0;
 	doc_outline_errs = 0;
 	doc_char_quality = 0;
@@ -313,9 +319,7 @@ if (dopasses==0 || dopasses==1)
     if (monitor != NULL) {
       monitor->ocr_alive = TRUE;
       monitor->progress = 30 + 50 * word_index / word_count;
-      if ((monitor->end_time != 0 && clock() > monitor->end_time) ||
-          (monitor->cancel != NULL && (*monitor->cancel)(monitor->cancel_this,
-                                                         dict_words)))
+      if (ocr_deadline_passed(monitor, dict_words))
         return;
     }
     classify_word_pass1(page_res_it.word(), page_res_it.row()->row,
@@ -353,7 +357,7 @@ if (dopasses==0 || dopasses==1)
     }
     // Count dict words.
     if (page_res_it.word()->best_choice->permuter() == USER_DAWG_PERM)
-      ++dict_words;
+      global_monitor_words = ++dict_words;
     page_res_it.forward ();
   }
 
@@ -394,9 +398,7 @@ if (dopasses==1) return;
     if (monitor != NULL) {
       monitor->ocr_alive = TRUE;
       monitor->progress = 80 + 10 * word_index / word_count;
-      if ((monitor->end_time != 0 && clock() > monitor->end_time) ||
-          (monitor->cancel != NULL && (*monitor->cancel)(monitor->cancel_this,
-                                                         dict_words)))
+      if (ocr_deadline_passed(monitor, dict_words))
         return;
     }
 //changed by jetsoft
@@ -418,6 +420,8 @@ if (dopasses==1) return;
 
     classify_word_pass2(page_res_it.word(), page_res_it.block()->block,
                         page_res_it.row()->row);
+    if (monitor != NULL && monitor->word_done != NULL)
+      report_word_done(monitor, &page_res_it);
     if (tessedit_dump_choices) {
       word_dumper(NULL, page_res_it.row()->row, page_res_it.word()->word);
       tprintf("Pass2: %s [%s]\n",
@@ -436,6 +440,11 @@ if (dopasses==1) return;
         &char_clusters, &chars_waiting);
     page_res_it.forward ();
   }
+  ClearFeatureCache();
+
+  if (page_budget_words > 0)
+    tprintf("%d words ran out of their chopping/segmentation budget\n",
+            page_budget_words);
 
   /* Another pass */
   set_global_loc_code(LOC_FUZZY_SPACE);
@@ -591,6 +600,40 @@ if (dopasses==1) return;
 }
 
 
+/**
+ * report_word_done
+ *
+ * Give the pass 2 result of the current word to the word callback of the
+ * monitor, so the caller can use it before the whole page is done.
+ */
+void Tesseract::report_word_done(volatile ETEXT_DESC *monitor,
+                                 PAGE_RES_IT *page_res_it) {
+  WERD_RES *word = page_res_it->word();
+  if (word->best_choice == NULL)
+    return;
+  EWORD_DESC desc;
+  TBOX box = word->word->bounding_box();
+  desc.text = word->best_choice->unichar_string().string();
+  desc.font_name = NULL;
+  if (word->font1_count > 0 && word->font1 >= 0 &&
+      word->font1 < get_fontinfo_table().size())
+    desc.font_name = get_fontinfo_table().get(word->font1).name;
+  desc.left = box.left();
+  desc.right = box.right();
+  desc.top = box.top();
+  desc.bottom = box.bottom();
+  // Same conversion of the certainty to 0..100 as the api uses.
+  int conf = static_cast<int>(100 + 5 * word->best_choice->certainty());
+  if (conf < 0) conf = 0;
+  if (conf > 100) conf = 100;
+  desc.confidence = conf;
+  desc.bold = word->bold > 0;
+  desc.italic = word->italic > 0;
+  desc.end_of_line = word->word->flag(W_EOL) != 0;
+  (*monitor->word_done)(monitor->word_done_this, &desc);
+}
+
+
 /**
  * classify_word_pass1
  *
@@ -768,10 +811,14 @@ void Tesseract::classify_word_pass2(WERD_RES *word, BLOCK* block, ROW *row) {
   inT16 old_word_quality;
   inT16 new_word_quality;
   inT16 dummy;
+  // In fast mode, words that were confident in pass 1 keep that result.
+  BOOL8 confident = tord_fast_mode && !word->tess_failed &&
+      word->best_choice != NULL &&
+      word->best_choice->certainty() >= tord_fast_mode_certainty;
 
   set_global_subloc_code(SUBLOC_NORM);
   check_debug_pt(word, 30);
-  if (!word->done ||
+  if ((!word->done && !confident) ||
       tessedit_training_tess ||
       tessedit_training_wiseowl) {
     word->caps_height = 0.0;
@@ -789,7 +836,7 @@ void Tesseract::classify_word_pass2(WERD_RES *word, BLOCK* block, ROW *row) {
 
   if (!word->tess_failed && !word->word->flag (W_REP_CHAR)) {
     set_global_subloc_code(SUBLOC_FIX_XHT);
-    if ((tessedit_xht_fiddles_on_done_wds || !word->done) &&
+    if ((tessedit_xht_fiddles_on_done_wds || !word->done) && !confident &&
       (tessedit_xht_fiddles_on_no_rej_wds ||
     (word->reject_map.reject_count () > 0))) {
       if ((x_ht_check_word_occ >= 2) && word_occ_first)
@@ -18,6 +18,8 @@
 
 #include "osdetect.h"
 
+#include <math.h>
+
 #include "strngs.h"
 #include "blobbox.h"
 #include "blread.h"
@@ -29,11 +31,28 @@
 #include "expandblob.h"
 #include "tesseractclass.h"
 #include "qrsequence.h"
+#include "imgs.h"
+#include "tprintf.h"
+#include "varable.h"
 
 extern IMAGE page_image;
 
+BOOL_VAR(tessedit_osd_debug, false,
+         "Print orientation and script detection statistics");
+INT_VAR(tessedit_osd_min_reduce_res, 600,
+        "Min resolution at which OSD runs on a half resolution image,"
+        " 0 to never reduce");
+
 const int kMinCharactersToTry = 50;
 const int kMaxCharactersToTry = 5 * kMinCharactersToTry;
+// Min number of blobs to classify before stopping on a decisive result.
+const int kMinCharactersToStop = 10;
+// Min number of blobs classified in both of a pair of orientations before
+// one can be found to be decisively better than the other.
+const int kMinOrientationSamples = 8;
+// Min t statistic of the mean certainty difference between two
+// orientations for the difference to be decisive.
+const double kOrientationDecisiveScore = 3.0;
 
 const float kSizeRatioToReject = 2.0;
 
@@ -77,8 +96,28 @@ bool orientation_and_script_detection(STRING& filename,
   lastdot = strrchr (name.string (), '.');
   if (lastdot != NULL)
     name[lastdot-name.string()] = '\0';
-  if (!read_unlv_file(name, page_image.get_xsize(), page_image.get_ysize(),
-                     &blocks))
+  bool have_zones = read_unlv_file(name, page_image.get_xsize(),
+                                   page_image.get_ysize(), &blocks);
+  // The classifier normalizes the size of the blobs, so a high resolution
+  // page is detected just as well at half the resolution, and finding the
+  // components of the smaller image is much cheaper. The caller must
+  // threshold the page again before recognizing it.
+  if (!have_zones && tessedit_osd_min_reduce_res > 0 &&
+      page_image.get_res() >= tessedit_osd_min_reduce_res) {
+    IMAGE reduced;
+    reduced.create((page_image.get_xsize() + 1) / 2,
+                   (page_image.get_ysize() + 1) / 2, page_image.get_bpp());
+    fast_reduce_sub_image(&page_image, 0, 0, 0, 0, &reduced, 0, 0, 2, FALSE);
+    if (!page_image.white_high())
+      invert_image(&reduced);  // New images are always white high.
+    int res = page_image.get_res();
+    page_image.destroy();
+    page_image.create(reduced.get_xsize(), reduced.get_ysize(),
+                      reduced.get_bpp());
+    copy_sub_image(&reduced, 0, 0, 0, 0, &page_image, 0, 0, FALSE);
+    page_image.set_res(res / 2);
+  }
+  if (!have_zones)
     FullPageBlock(page_image.get_xsize(), page_image.get_ysize(), &blocks);
   find_components(&blocks, &land_blocks, &port_blocks, &page_box);
   return os_detect(&port_blocks, osr, tess);
@@ -130,13 +169,16 @@ bool os_detect(TO_BLOCK_LIST* port_blocks, OSResults* osr,
     filtered_it.move_to_first();
 
   int real_max = MIN(filtered_it.length(), kMaxCharactersToTry);
-   printf("Total blobs found = %d\n", blobs_total);
-   printf("Number of blobs post-filtering = %d\n", filtered_it.length());
-   printf("Number of blobs to try = %d\n", real_max);
+  if (tessedit_osd_debug) {
+    tprintf("Total blobs found = %d\n", blobs_total);
+    tprintf("Number of blobs post-filtering = %d\n", filtered_it.length());
+    tprintf("Number of blobs to try = %d\n", real_max);
+  }
 
   // If there are too few characters, skip this page entirely.
   if (real_max < kMinCharactersToTry / 2) {
-    printf("Too few characters. Skipping this page\n");
+    if (tessedit_osd_debug)
+      tprintf("Too few characters. Skipping this page\n");
     return false;
   }
 
@@ -147,13 +189,17 @@ bool os_detect(TO_BLOCK_LIST* port_blocks, OSResults* osr,
     blobs[number_of_blobs++] = (BLOBNBOX*)filtered_it.data();
   }
   QRSequenceGenerator sequence(number_of_blobs);
-  for (int i = 0; i < real_max; ++i) {
+  int num_tried = 0;
+  while (num_tried < real_max) {
+    ++num_tried;
     if (os_detect_blob(blobs[sequence.GetVal()], &o, &s, osr, tess)
-        && i > kMinCharactersToTry) {
+        && num_tried >= kMinCharactersToStop) {
       break;
     }
   }
   delete [] blobs;
+  if (tessedit_osd_debug)
+    tprintf("Number of blobs tried = %d\n", num_tried);
 
   // Make sure the best_result is up-to-date
   int orientation = o.get_orientation();
@@ -176,14 +222,14 @@ bool os_detect_blob(BLOBNBOX* bbox, OrientationDetector* o,
   PBLOB     pblob(blob, box.height());
 
   BLOB_CHOICE_LIST ratings[4];
-  // Test the 4 orientations
+  // Test the 4 orientations, skipping those already known to be wrong.
   for (int i = 0; i < 4; ++i) {
     // normalize the blob
     pblob.move(FCOORD(-x_mid, -box.bottom()));
     pblob.scale(static_cast<float>(bln_x_height) / box.height());
     pblob.move(FCOORD(0.0f, bln_baseline_offset));
 
-    {
+    if (o->is_candidate(i)) {
       // List of choices given by the classifier
       TBLOB *tessblob;               //converted blob
       TEXTROW tessrow;               //dummy row
@@ -228,58 +274,108 @@ bool os_detect_blob(BLOBNBOX* bbox, OrientationDetector* o,
 
 OrientationDetector::OrientationDetector(OSResults* osr) {
   osr_ = osr;
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      diff_counts_[i][j] = 0;
+      diff_sums_[i][j] = 0.0;
+      diff_sq_sums_[i][j] = 0.0;
+    }
+    score_sums_[i] = 0.0;
+    score_counts_[i] = 0;
+    rejected_[i] = false;
+  }
 }
 
 // Score the given blob and return true if it is now sure of the orientation
-// after adding this block.
+// after adding this blob.
+// The certainties of the blob in each pair of orientations are compared,
+// and as soon as an orientation is decisively worse than the best one it
+// is rejected, so later blobs need not be classified in it. The
+// orientation is sure once all the others are rejected.
+// A rejected orientation stops gaining score, so the score of each
+// orientation is its mean score per blob classified in it, times the
+// number of blobs classified in the best orientation. This keeps the
+// scores, and so the confidence, comparable.
 bool OrientationDetector::detect_blob(BLOB_CHOICE_LIST* scores) {
+  float certainties[4];
+  bool classified[4];
+  int num_blobs = 0;
   for (int i = 0; i < 4; ++i) {
     BLOB_CHOICE_IT choice_it;
     choice_it.set_to_list(scores + i);
 
-    if (!choice_it.empty()) {
-      osr_->orientations[i] += (100 + choice_it.data()->certainty());
+    classified[i] = !choice_it.empty();
+    if (classified[i]) {
+      certainties[i] = choice_it.data()->certainty();
+      score_sums_[i] += 100 + certainties[i];
+      ++score_counts_[i];
+    }
+    num_blobs = MAX(num_blobs, score_counts_[i]);
+  }
+  for (int i = 0; i < 4; ++i) {
+    if (score_counts_[i] > 0)
+      osr_->orientations[i] = score_sums_[i] * num_blobs / score_counts_[i];
+  }
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      if (i != j && classified[i] && classified[j]) {
+        double diff = certainties[i] - certainties[j];
+        ++diff_counts_[i][j];
+        diff_sums_[i][j] += diff;
+        diff_sq_sums_[i][j] += diff * diff;
+      }
     }
   }
 
-  float first = -1;
-  float second = -1;
-
-  int idx = -1;
+  int best = get_orientation();
+  bool sure = true;
   for (int i = 0; i < 4; ++i) {
-    if (osr_->orientations[i] > first) {
-      idx = i;
-      second = first;
-      first = osr_->orientations[i];
-    } else if (osr_->orientations[i] > second) {
-      second = osr_->orientations[i];
+    if (i != best && !rejected_[i]) {
+      if (decisively_better(best, i))
+        rejected_[i] = true;
+      else
+        sure = false;
     }
   }
+  return sure;
+}
 
-  return first / second > kOrientationAcceptRatio;
+// Returns true if the certainties of the blobs classified in both
+// orientations are decisively better in orientation best than in other,
+// using a paired t test of the mean certainty difference.
+bool OrientationDetector::decisively_better(int best, int other) const {
+  int n = diff_counts_[best][other];
+  if (n < kMinOrientationSamples)
+    return false;
+  double mean = diff_sums_[best][other] / n;
+  if (mean <= 0.0)
+    return false;
+  double variance = (diff_sq_sums_[best][other] - n * mean * mean) / (n - 1);
+  if (variance <= 0.0)
+    return true;
+  return mean * sqrt(n / variance) >= kOrientationDecisiveScore;
 }
 
+// The best orientation is never a rejected one, but the confidence is
+// measured against the second best of all the others.
 void OrientationDetector::update_best_orientation() {
-  float first = osr_->orientations[0];
-  float second = osr_->orientations[1];
-
-  if (first < second) {
-    second = first;
-    first = osr_->orientations[1];
-  }
+  float first = -1;
+  float second = -1;
 
   osr_->best_result.orientation = 0;
   osr_->best_result.oconfidence = 0;
 
   for (int i = 0; i < 4; ++i) {
-    if (osr_->orientations[i] > first) {
-      second = first;
+    if (!rejected_[i] && osr_->orientations[i] > first) {
       first = osr_->orientations[i];
       osr_->best_result.orientation = i;
-    } else if (osr_->orientations[i] > second) {
-      second = osr_->orientations[i];
     }
   }
+  for (int i = 0; i < 4; ++i) {
+    if (i != osr_->best_result.orientation &&
+        osr_->orientations[i] > second)
+      second = osr_->orientations[i];
+  }
 
   osr_->best_result.oconfidence =
       (first / second - 1.0) / (kOrientationAcceptRatio - 1.0);
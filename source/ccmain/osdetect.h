@@ -61,8 +61,28 @@ class OrientationDetector {
   bool detect_blob(BLOB_CHOICE_LIST* scores);
   void update_best_orientation();
   int get_orientation();
+  // Returns true if the orientation is still worth classifying blobs in,
+  // ie it has not yet been shown to be worse than the best one.
+  bool is_candidate(int orientation) const {
+    return !rejected_[orientation];
+  }
  private:
+  // Returns true if the certainties of the blobs classified in both
+  // orientations are decisively better in orientation best than in other.
+  bool decisively_better(int best, int other) const;
+
   OSResults* osr_;
+  // Statistics of the certainty differences between pairs of orientations,
+  // over the blobs that were classified in both.
+  int diff_counts_[4][4];
+  double diff_sums_[4][4];
+  double diff_sq_sums_[4][4];
+  // Sum of the scores of the blobs classified in each orientation, and
+  // the number of those blobs.
+  double score_sums_[4];
+  int score_counts_[4];
+  // Orientations that no longer need to be tried.
+  bool rejected_[4];
 };
 
 class ScriptDetector {
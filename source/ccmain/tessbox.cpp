@@ -309,6 +309,39 @@ void Tesseract::tess_default_matcher(PBLOB *pblob,
   AdaptiveClassifier (tessblob, NULL, &tessrow, ratings, NULL);
   free_blob(tessblob);
 }
+
+
+/**
+ * @name tess_default_batch_matcher
+ *
+ * Match several blobs of a word at once, giving the same results as
+ * calling tess_default_matcher on each of them.
+ * @param blobs blobs to match
+ * @param num_blobs number of blobs
+ * @param word word they came from
+ * @param denorm de-normaliser
+ * @param[out] ratings one list of results per blob
+ */
+
+void Tesseract::tess_default_batch_matcher(PBLOB **blobs,
+                                           int num_blobs,
+                                           WERD *word,
+                                           DENORM *denorm,
+                                           BLOB_CHOICE_LIST **ratings) {
+  assert(ratings != NULL);
+  TBLOB **tessblobs = new TBLOB *[num_blobs];
+  TEXTROW tessrow;               //dummy row
+
+  tess_bn_matching.set_value(false);      //turn it off
+  tess_cn_matching.set_value(false);
+  for (int i = 0; i < num_blobs; ++i)
+    tessblobs[i] = make_rotated_tess_blob(denorm, blobs[i], true);
+  make_tess_row(denorm, &tessrow);
+  AdaptiveClassifierBatch(tessblobs, num_blobs, &tessrow, ratings);
+  for (int i = 0; i < num_blobs; ++i)
+    free_blob(tessblobs[i]);
+  delete [] tessblobs;
+}
 }  // namespace tesseract
 
 
@@ -77,6 +77,7 @@
 EXTERN BOOL_EVAR (tessedit_write_vars, FALSE, "Write all vars to file");
 
 ETEXT_DESC *global_monitor = NULL;  // progress monitor
+int global_monitor_words = 0;       // user words found so far on the page
 
 namespace tesseract {
 
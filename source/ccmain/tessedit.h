@@ -27,5 +27,7 @@
 
                                  //progress monitor
 extern ETEXT_DESC *global_monitor;
+                                 //words for its cancel function
+extern int global_monitor_words;
 
 #endif
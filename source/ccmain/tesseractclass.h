@@ -106,6 +106,9 @@ class Tesseract : public Wordrec {
                                   TBOX *target_word_box=0L,
                                   inT16 dopasses=0
                                  );
+  // Passes the current word of page_res_it to the word callback of monitor.
+  void report_word_done(volatile ETEXT_DESC *monitor,
+                        PAGE_RES_IT *page_res_it);
   void classify_word_pass1(                 //recog one word
                            WERD_RES *word,  //word to do
                            ROW *row,
@@ -438,6 +441,13 @@ class Tesseract : public Wordrec {
                             BLOB_CHOICE_LIST *ratings,  //list of results
                             const char* script
                             );
+  void tess_default_batch_matcher(                       //call tess
+                                  PBLOB **blobs,         //blobs to match
+                                  int num_blobs,         //size of blobs
+                                  WERD *word,            //word they came from
+                                  DENORM *denorm,        //de-normaliser
+                                  BLOB_CHOICE_LIST **ratings  //results
+                                 );
   void tess_bn_matcher(                           //call tess
                        PBLOB *pblob,              //previous blob
                        PBLOB *blob,               //blob to match
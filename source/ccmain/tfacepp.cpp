@@ -149,6 +149,8 @@ Tesseract::recog_word_recursive(
   BLOB_CHOICE_LIST_C_IT blob_choices_it;  // iterator
 
   tess_matcher = matcher;           // install matcher
+  tess_batch_matcher = matcher == &Tesseract::tess_default_matcher
+                     ? &Tesseract::tess_default_batch_matcher : NULL;
   tess_tester = testing ? tester : NULL;
   tess_trainer = testing ? trainer : NULL;
   tess_denorm = denorm;
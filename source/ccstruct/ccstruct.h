@@ -43,6 +43,10 @@ class Tesseract;
 typedef void (tesseract::Tesseract::*POLY_MATCHER)
   (PBLOB *, PBLOB *, PBLOB *, WERD *,
    DENORM *, BLOB_CHOICE_LIST *, const char*);
+// Matches several blobs of one word at once. The blobs array and the
+// (empty) ratings lists are owned by the caller.
+typedef void (tesseract::Tesseract::*POLY_BATCH_MATCHER)
+  (PBLOB **, int, WERD *, DENORM *, BLOB_CHOICE_LIST **);
 /*
   typedef void (tesseract::Tesseract::*POLY_TESTER)
   (const STRING&, PBLOB *, DENORM *, BOOL8, char *,
@@ -37,6 +37,11 @@ EXTERN INT_VAR (lms_line_trials, 12, "Number of linew fits to do");
 #define SEED3       0x9abc
 #define LMS_MAX_FAILURES  3
 
+                                 //for nrand
+static uinT16 line_seeds[3] = { SEED1, SEED2, SEED3 };
+static uinT16 constrained_seeds[3] = { SEED1, SEED2, SEED3 };
+static uinT16 quadratic_seeds[3] = { SEED1, SEED2, SEED3 };
+
 #ifndef __UNIX__
 uinT32 nrand48(               //get random number
                uinT16 *seeds  //seeds to use
@@ -69,6 +74,12 @@ inT32 size                       //samplesize
   errors = (float *) alloc_mem (size * sizeof (float));
   line_error = 0.0f;
   fitted = FALSE;
+  line_trials = -1;
+  trial_m = NULL;
+  trial_c = NULL;
+  constrained_trials = -1;
+  trial_fixed_m = 0.0f;
+  trial_constrained_c = NULL;
 }
 
 
@@ -82,6 +93,12 @@ LMS::~LMS (                      //constructor
 ) {
   free_mem(samples);
   free_mem(errors);
+  if (trial_m != NULL) {
+    free_mem(trial_m);
+    free_mem(trial_c);
+  }
+  if (trial_constrained_c != NULL)
+    free_mem(trial_constrained_c);
 }
 
 
@@ -94,6 +111,8 @@ LMS::~LMS (                      //constructor
 void LMS::clear() {  //clear sample
   samplecount = 0;
   fitted = FALSE;
+  line_trials = -1;
+  constrained_trials = -1;
 }
 
 
@@ -110,6 +129,8 @@ void LMS::add(               //add sample
                                  //save it
     samples[samplecount++] = sample;
   fitted = FALSE;
+  line_trials = -1;              //picks are out of date
+  constrained_trials = -1;
 }
 
 
@@ -122,7 +143,6 @@ void LMS::add(               //add sample
 void LMS::fit(               //fit sample
               float &out_m,  //output line
               float &out_c) {
-  inT32 index;                   //of median
   inT32 trials;                  //no of medians
   float test_m, test_c;          //candidate line
   float test_error;              //error of test line
@@ -154,16 +174,15 @@ void LMS::fit(               //fit sample
       break;
 
     default:
-      pick_line(m, c);  //use pts at random
-      compute_errors(m, c);  //from given line
-      index = choose_nth_item (samplecount / 2, errors, samplecount);
-      line_error = errors[index];
-      for (trials = 1; trials < lms_line_trials; trials++) {
-                                 //random again
-        pick_line(test_m, test_c);
-        compute_errors(test_m, test_c);
-        index = choose_nth_item (samplecount / 2, errors, samplecount);
-        test_error = errors[index];
+      if (line_trials < 0)
+        pick_fit();              //use pts at random
+      m = trial_m[0];
+      c = trial_c[0];
+      line_error = median_error (m, c, MAX_FLOAT32);
+      for (trials = 1; trials < line_trials; trials++) {
+        test_m = trial_m[trials];
+        test_c = trial_c[trials];
+        test_error = median_error (test_m, test_c, line_error);
         if (test_error < line_error) {
                                  //find least median
           line_error = test_error;
@@ -230,11 +249,8 @@ void LMS::fit_quadratic(                          //fit sample
 void LMS::constrained_fit(                //fit sample
                           float fixed_m,  //forced gradient
                           float &out_c) {
-  inT32 index;                   //of median
   inT32 trials;                  //no of medians
   float test_c;                  //candidate line
-  static uinT16 seeds[3] = { SEED1, SEED2, SEED3 };
-  //for nrand
   float test_error;              //error of test line
 
   m = fixed_m;
@@ -258,19 +274,13 @@ void LMS::constrained_fit(                //fit sample
       break;
 
     default:
-      index = (inT32) nrand48 (seeds) % samplecount;
-                                 //compute line
-      c = samples[index].y () - m * samples[index].x ();
-      compute_errors(m, c);  //from given line
-      index = choose_nth_item (samplecount / 2, errors, samplecount);
-      line_error = errors[index];
-      for (trials = 1; trials < lms_line_trials; trials++) {
-        index = (inT32) nrand48 (seeds) % samplecount;
-        test_c = samples[index].y () - m * samples[index].x ();
-        //compute line
-        compute_errors(m, test_c);
-        index = choose_nth_item (samplecount / 2, errors, samplecount);
-        test_error = errors[index];
+      if (constrained_trials < 0 || trial_fixed_m != fixed_m)
+        pick_constrained_fit(fixed_m);
+      c = trial_constrained_c[0];
+      line_error = median_error (m, c, MAX_FLOAT32);
+      for (trials = 1; trials < constrained_trials; trials++) {
+        test_c = trial_constrained_c[trials];
+        test_error = median_error (m, test_c, line_error);
         if (test_error < line_error) {
                                  //find least median
           line_error = test_error;
@@ -284,6 +294,64 @@ void LMS::constrained_fit(                //fit sample
 }
 
 
+/**********************************************************************
+ * LMS::pick_fit
+ *
+ * Draw the random lines that fit will try, so that fit may be
+ * called later in any order.
+ **********************************************************************/
+
+void LMS::pick_fit() {  //draw trials
+  inT32 trials;                  //no of lines
+
+  if (samplecount < 3) {
+    line_trials = 0;             //fit needs no random lines
+    return;
+  }
+  if (trial_m != NULL) {
+    free_mem(trial_m);
+    free_mem(trial_c);
+  }
+  line_trials = lms_line_trials > 1 ? lms_line_trials : 1;
+  trial_m = (float *) alloc_mem (line_trials * sizeof (float));
+  trial_c = (float *) alloc_mem (line_trials * sizeof (float));
+  for (trials = 0; trials < line_trials; trials++)
+    pick_line (trial_m[trials], trial_c[trials]);
+}
+
+
+/**********************************************************************
+ * LMS::pick_constrained_fit
+ *
+ * Draw the random lines that constrained_fit will try with the given
+ * gradient, so that constrained_fit may be called later in any order.
+ **********************************************************************/
+
+void LMS::pick_constrained_fit(                //draw trials
+                               float fixed_m   //forced gradient
+                              ) {
+  inT32 trials;                  //no of lines
+  inT32 index;                   //picked point
+
+  trial_fixed_m = fixed_m;
+  if (samplecount < 3) {
+    constrained_trials = 0;      //constrained_fit needs none
+    return;
+  }
+  if (trial_constrained_c != NULL)
+    free_mem(trial_constrained_c);
+  constrained_trials = lms_line_trials > 1 ? lms_line_trials : 1;
+  trial_constrained_c =
+    (float *) alloc_mem (constrained_trials * sizeof (float));
+  for (trials = 0; trials < constrained_trials; trials++) {
+    index = (inT32) nrand48 (constrained_seeds) % samplecount;
+                                 //compute line
+    trial_constrained_c[trials] =
+      samples[index].y () - fixed_m * samples[index].x ();
+  }
+}
+
+
 /**********************************************************************
  * LMS::pick_line
  *
@@ -294,15 +362,13 @@ void LMS::pick_line(                //fit sample
                     float &line_m,  //output gradient
                     float &line_c) {
   inT16 trial_count;             //no of attempts
-  static uinT16 seeds[3] = { SEED1, SEED2, SEED3 };
-  //for nrand
   inT32 index1;                  //picked point
   inT32 index2;                  //picked point
 
   trial_count = 0;
   do {
-    index1 = (inT32) nrand48 (seeds) % samplecount;
-    index2 = (inT32) nrand48 (seeds) % samplecount;
+    index1 = (inT32) nrand48 (line_seeds) % samplecount;
+    index2 = (inT32) nrand48 (line_seeds) % samplecount;
     line_m = samples[index2].x () - samples[index1].x ();
     trial_count++;
   }
@@ -328,8 +394,6 @@ void LMS::pick_quadratic(                 //fit sample
                          float &line_m,   //output gradient
                          float &line_c) {
   inT16 trial_count;             //no of attempts
-  static uinT16 seeds[3] = { SEED1, SEED2, SEED3 };
-  //for nrand
   inT32 index1;                  //picked point
   inT32 index2;                  //picked point
   inT32 index3;
@@ -346,9 +410,9 @@ void LMS::pick_quadratic(                 //fit sample
       index3 = samplecount - 1;
     }
     else {
-      index1 = (inT32) nrand48 (seeds) % samplecount;
-      index2 = (inT32) nrand48 (seeds) % samplecount;
-      index3 = (inT32) nrand48 (seeds) % samplecount;
+      index1 = (inT32) nrand48 (quadratic_seeds) % samplecount;
+      index2 = (inT32) nrand48 (quadratic_seeds) % samplecount;
+      index3 = (inT32) nrand48 (quadratic_seeds) % samplecount;
     }
     x1x2 = samples[index2] - samples[index1];
     x1x3 = samples[index3] - samples[index1];
@@ -373,21 +437,91 @@ void LMS::pick_quadratic(                 //fit sample
 
 
 /**********************************************************************
- * LMS::compute_errors
+ * select_nth_error
  *
- * Compute the squared error from all the points.
+ * Return the value of the nth smallest of the given errors, reordering
+ * them. Unlike choose_nth_item it keeps no state, so LMS objects may be
+ * fitted on several threads at once.
+ **********************************************************************/
+
+static float select_nth_error(                 //quickselect
+                              inT32 n,         //index to choose
+                              float *values,   //values to search
+                              inT32 count      //no of values
+                             ) {
+  inT32 left;                    //current range
+  inT32 right;
+  inT32 lower;                   //partition scan
+  inT32 upper;
+  float pivot;                   //median of 3
+  float tmp;
+
+  left = 0;
+  right = count - 1;
+  while (right > left) {
+    lower = left + (right - left) / 2;
+    if (values[lower] < values[left]) {
+      tmp = values[lower]; values[lower] = values[left]; values[left] = tmp;
+    }
+    if (values[right] < values[left]) {
+      tmp = values[right]; values[right] = values[left]; values[left] = tmp;
+    }
+    if (values[right] < values[lower]) {
+      tmp = values[right]; values[right] = values[lower]; values[lower] = tmp;
+    }
+    pivot = values[lower];
+    lower = left;
+    upper = right;
+    while (lower <= upper) {
+      while (values[lower] < pivot)
+        lower++;
+      while (pivot < values[upper])
+        upper--;
+      if (lower <= upper) {
+        tmp = values[lower];
+        values[lower++] = values[upper];
+        values[upper--] = tmp;
+      }
+    }
+    if (n <= upper)
+      right = upper;             //in lower part
+    else if (n >= lower)
+      left = lower;              //in upper part
+    else
+      break;                     //equal to pivot
+  }
+  return values[n];
+}
+
+
+/**********************************************************************
+ * LMS::median_error
+ *
+ * Compute the median squared error from all the points.
+ * If the median is certain to be at least limit, limit is returned as
+ * soon as that is known, without finding the exact median.
  **********************************************************************/
 
-void LMS::compute_errors(               //fit sample
-                         float line_m,  //input gradient
-                         float line_c) {
+float LMS::median_error(               //fit sample
+                        float line_m,  //input gradient
+                        float line_c,
+                        float limit    //best so far
+                       ) {
   inT32 index;                   //picked point
+  inT32 max_over;                //over limit to reject
+  inT32 over_count;              //no over limit
+  float error;                   //of point
 
+  max_over = samplecount - samplecount / 2;
+  over_count = 0;
   for (index = 0; index < samplecount; index++) {
-    errors[index] =
-      line_m * samples[index].x () + line_c - samples[index].y ();
-    errors[index] *= errors[index];
+    error = line_m * samples[index].x () + line_c - samples[index].y ();
+    error *= error;
+    errors[index] = error;
+    if (error >= limit && ++over_count >= max_over)
+      return limit;              //median can't beat it
   }
+  return select_nth_error (samplecount / 2, errors, samplecount);
 }
 
 
@@ -40,6 +40,15 @@ class LMS
     void constrained_fit(                //fixed gradient
                          float fixed_m,  //forced gradient
                          float &out_c);  //output line
+    // The random choices of fit and constrained_fit are drawn from
+    // streams shared by all LMS objects, so the fits of many rows depend
+    // on the order they are done in. Calling pick_fit or
+    // pick_constrained_fit for each row in order draws the choices in
+    // advance, after which the fits may be done in any order, or on
+    // several threads, with the same results.
+    void pick_fit();  //draw trials for fit
+    void pick_constrained_fit(                 //draw for constrained_fit
+                              float fixed_m);  //forced gradient
     void fit_quadratic(                          //easy quadratic
                        float outlier_threshold,  //min outlier
                        double &a,                //x squared
@@ -51,6 +60,9 @@ class LMS
     float error() {  //get error
       return fitted ? line_error : -1;
     }
+    inT32 count() {  //no of samples
+      return samplecount;
+    }
 
   private:
 
@@ -61,9 +73,10 @@ class LMS
                         double &a,  //output curve
                         float &b,
                         float &c);
-    void compute_errors(          //find errors
-                        float m,  //from line
-                        float c);
+    float median_error(              //find errors
+                       float m,      //from line
+                       float c,
+                       float limit); //best so far
                                  //find errors
     float compute_quadratic_errors(float outlier_threshold,  //min outlier
                                    double a,                 //from curve
@@ -79,6 +92,12 @@ class LMS
     float m;                     //line gradient
     float c;
     float line_error;            //error of fit
+    inT32 line_trials;           //picked trials of fit or -1
+    float *trial_m;              //picked lines for fit
+    float *trial_c;
+    inT32 constrained_trials;    //picked trials of constrained_fit or -1
+    float trial_fixed_m;         //gradient they were picked for
+    float *trial_constrained_c;  //picked lines for constrained_fit
 };
 extern INT_VAR_H (lms_line_trials, 12, "Number of linew fits to do");
 #endif
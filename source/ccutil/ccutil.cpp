@@ -2,6 +2,7 @@
 // Author: scharron@google.com (Samuel Charron)
 
 #include "ccutil.h"
+#include "ndminx.h"
 
 namespace tesseract {
 CCUtil::CCUtil()
@@ -43,6 +44,81 @@ void CCUtilMutex::Unlock() {
 #endif
 }
 
+// Shared state of the threads run by RunJobsOnThreads.
+struct CCUtilJobPool {
+  CCUtilJobFunc func;
+  void *data;
+  int num_jobs;
+  int next_job;             // index of the next job to be started
+  int next_thread;          // index of the next thread to start
+  CCUtilMutex mutex;        // guards next_job and next_thread
+};
+
+// Runs jobs from the pool until there are none left.
+#ifdef WIN32
+static DWORD WINAPI RunPoolThread(LPVOID arg) {
+#else
+static void *RunPoolThread(void *arg) {
+#endif
+  CCUtilJobPool *pool = reinterpret_cast<CCUtilJobPool *>(arg);
+  pool->mutex.Lock();
+  int thread = pool->next_thread++;
+  while (pool->next_job < pool->num_jobs) {
+    int job = pool->next_job++;
+    pool->mutex.Unlock();
+    (*pool->func)(pool->data, job, thread);
+    pool->mutex.Lock();
+  }
+  pool->mutex.Unlock();
+  return 0;
+}
+
+int RunJobsOnThreads(CCUtilJobFunc func, void *data, int num_jobs,
+                     int max_threads) {
+  CCUtilJobPool pool;
+  pool.func = func;
+  pool.data = data;
+  pool.num_jobs = num_jobs;
+  pool.next_job = 0;
+  pool.next_thread = 0;
+  // The calling thread is one of the threads, so start one fewer.
+  int num_extra = MIN(max_threads, num_jobs) - 1;
+#ifdef WIN32
+  num_extra = MIN(num_extra, MAXIMUM_WAIT_OBJECTS);
+#endif
+  int num_started = 0;
+  if (num_extra > 0) {
+#ifdef WIN32
+    HANDLE *threads = new HANDLE[num_extra];
+    for (; num_started < num_extra; ++num_started) {
+      threads[num_started] = CreateThread(NULL, 0, RunPoolThread, &pool,
+                                          0, NULL);
+      if (threads[num_started] == NULL)
+        break;
+    }
+    RunPoolThread(&pool);
+    if (num_started > 0)
+      WaitForMultipleObjects(num_started, threads, TRUE, INFINITE);
+    for (int i = 0; i < num_started; ++i)
+      CloseHandle(threads[i]);
+#else
+    pthread_t *threads = new pthread_t[num_extra];
+    for (; num_started < num_extra; ++num_started) {
+      if (pthread_create(&threads[num_started], NULL, RunPoolThread,
+                         &pool) != 0)
+        break;
+    }
+    RunPoolThread(&pool);
+    for (int i = 0; i < num_started; ++i)
+      pthread_join(threads[i], NULL);
+#endif
+    delete [] threads;
+  } else {
+    RunPoolThread(&pool);
+  }
+  return num_started + 1;
+}
+
 
 CCUtilMutex tprintfMutex;
 } // namespace tesseract
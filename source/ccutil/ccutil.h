@@ -50,6 +50,19 @@ class CCUtilMutex {
 #endif
 };
 
+// Runs one job of a set. job is the index of the job, from 0, and thread
+// the index of the thread running it, from 0, so a job can use state kept
+// per thread.
+typedef void (*CCUtilJobFunc)(void *data, int job, int thread);
+
+// Runs func on jobs 0 to num_jobs - 1 using up to max_threads threads,
+// including the calling thread, and returns when all of them are done.
+// If only one thread is used, the jobs are done in order on the calling
+// thread. If a thread cannot be started, the others do its share of the
+// jobs. Returns the number of threads used.
+int RunJobsOnThreads(CCUtilJobFunc func, void *data, int num_jobs,
+                     int max_threads);
+
 
 class CCUtil {
  public:
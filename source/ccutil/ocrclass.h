@@ -289,9 +289,43 @@ typedef struct                   /*single character */
  * to 1 indicates that the OCR engine is dead.
  * If the cancel function is not null then it is called with the number of
  * user words found. If it returns true then operation is cancelled.
+ * If end_time is not 0 then operation stops once clock() passes it.
+ * clock() measures the CPU time of the whole process, not wall time, so
+ * when stages run on several threads (textord_row_threads > 1) the
+ * deadline is reached sooner in wall time than end_time suggests.
+ * If the word_done function is not null then it is called with each word
+ * as soon as it has been recognized (see EWORD_DESC).
  **********************************************************************/
 typedef bool (*CANCEL_FUNC)(void* cancel_this, int words);
 
+/**********************************************************************
+ * EWORD_DESC
+ * Description of a single recognized word, as handed to the word
+ * callback of ETEXT_DESC as soon as the second recognition pass has
+ * finished with it, so that the results of a page can be consumed
+ * before the whole page has been recognized.
+ * The result is provisional: the later passes (fuzzy spaces, quality
+ * rejection and font smoothing) may still change the final output.
+ * The text is only valid during the callback.
+ * The bounding box is relative to the bottom-left corner of the image
+ * (or rectangle) being recognized, with top > bottom.
+ **********************************************************************/
+typedef struct                   /*single word */
+{
+  const char *text;              /*UTF-8 text of the word */
+  const char *font_name;         /*most likely font, or NULL */
+  inT16 left;                    /*of word */
+  inT16 right;                   /*of word */
+  inT16 top;                     /*of word */
+  inT16 bottom;                  /*of word */
+  uinT8 confidence;              /*0=reject, 100=perfect */
+  inT8 bold;                     /*true if mostly bold */
+  inT8 italic;                   /*true if mostly italic */
+  inT8 end_of_line;              /*true if last word of a line */
+} EWORD_DESC;                    /*single word */
+
+typedef void (*WORD_FUNC)(void* word_this, const EWORD_DESC* word);
+
 typedef struct ETEXT_STRUCT      /*output header */
 {
   inT16 count;                   /*chars in this buffer(0) */
@@ -302,9 +336,26 @@ typedef struct ETEXT_STRUCT      /*output header */
   CANCEL_FUNC cancel;            /*returns true to cancel */
   void* cancel_this;             /*this or other data for cancel*/
   clock_t end_time;              /*time to stop if not 0*/
+  WORD_FUNC word_done;           /*called with each word if not NULL*/
+  void* word_done_this;          /*this or other data for word_done*/
   EANYCODE_CHAR text[1];         /*character data */
 } ETEXT_DESC;                    /*output header */
 
+/**********************************************************************
+ * ocr_deadline_passed
+ * Returns true if there is a monitor and either its end_time has passed
+ * (in process CPU time, see ETEXT_DESC) or its cancel function, called
+ * with the given number of words, asks for the operation to stop. Long
+ * running stages check this regularly and stop early with whatever result
+ * they have so far.
+ **********************************************************************/
+inline bool ocr_deadline_passed(volatile ETEXT_DESC *monitor, int words) {
+  return monitor != NULL &&
+         ((monitor->end_time != 0 && clock() > monitor->end_time) ||
+          (monitor->cancel != NULL &&
+           (*monitor->cancel)(monitor->cancel_this, words)));
+}
+
 #ifdef __MSW32__
 /**********************************************************************
  * ESHM_INFO
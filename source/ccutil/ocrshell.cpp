@@ -199,6 +199,7 @@ void ocr_error(                   /*send an error code */
       monitor->ocr_alive = TRUE; /*ocr sets to 1, hp 0 */
       monitor->err_code = -code; /*report error */
       monitor->cancel = FALSE;   /*0=continue, 1=cancel */
+      monitor->word_done = NULL; /*no word callback */
       release_ocr();  /*send ack */
       break;
     case OCS_RECOGNIZING:        /*OCR incomplete */
@@ -443,6 +444,7 @@ ETEXT_DESC *ocr_setup_monitor() {  /*setup monitor */
   monitor->ocr_alive = TRUE;     /*ocr sets to 1, hp 0 */
   monitor->err_code = 0;         /*used by ocr_error */
   monitor->cancel = FALSE;       /*0=continue, 1=cancel */
+  monitor->word_done = NULL;     /*no word callback */
 
 
 //by jetsoft
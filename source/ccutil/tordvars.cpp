@@ -64,3 +64,8 @@ INT_VAR(tord_display_ratings, 0, "Ratings display");
 BOOL_VAR(tord_display_text, 0, "Display Text");
 
 BOOL_VAR(tord_show_bold, 1, "Show Bold Text");
+
+BOOL_VAR(tord_fast_mode, 0, "Skip work on words that are already confident");
+
+double_VAR(tord_fast_mode_certainty, -2.5,
+           "Certainty of a word confident enough for fast mode");
@@ -63,4 +63,10 @@ extern BOOL_VAR_H(tord_display_text, 0, "Display Text");
 
 extern BOOL_VAR_H(tord_show_bold, 1, "Show Bold Text");
 
+extern BOOL_VAR_H(tord_fast_mode, 0,
+                  "Skip work on words that are already confident");
+
+extern double_VAR_H(tord_fast_mode_certainty, -2.5,
+                    "Certainty of a word confident enough for fast mode");
+
 #endif
@@ -374,13 +374,235 @@ ADAPT_TEMPLATES Classify::ReadAdaptedTemplates(FILE *File) {
 }  // namespace tesseract
 
 
+/*---------------------------------------------------------------------------*/
+namespace tesseract {
+/**
+ * Read a set of adapted templates written by
+ * WriteCompactAdaptedTemplates.  Classes which were not
+ * saved are left empty.
+ *
+ * @param File  open file to read adapted templates from
+ * @return Ptr to adapted templates read from File, or NULL if
+ * File does not hold compact templates for the current unicharset.
+ *
+ * @note Globals: none
+ * @note Exceptions: none
+ */
+ADAPT_TEMPLATES Classify::ReadCompactAdaptedTemplates(FILE *File) {
+  ADAPT_TEMPLATES Templates;
+  INT_TEMPLATES IntTemplates;
+  int Header[ADAPTED_TEMPLATES_HEADER_SIZE];
+  uinT32 NumWords;
+  uinT32 WordIndex;
+  int ClassId;
+  int i, j;
+
+  if (fread(Header, sizeof(Header[0]), ADAPTED_TEMPLATES_HEADER_SIZE, File)
+      != ADAPTED_TEMPLATES_HEADER_SIZE ||
+      Header[0] != ADAPTED_TEMPLATES_MAGIC ||
+      Header[1] != ADAPTED_TEMPLATES_VERSION) {
+    cprintf("Not a compact adapted templates file!\n");
+    return NULL;
+  }
+  if (Header[2] != unicharset.size()) {
+    cprintf("Adapted templates are for a unicharset of size %d, not %d!\n",
+            Header[2], unicharset.size());
+    return NULL;
+  }
+  Templates = NewAdaptedTemplates(true);
+  IntTemplates = Templates->Templates;
+  if (Header[3] != IntTemplates->NumClassPruners) {
+    cprintf("Bad read of adapted templates!\n");
+    free_adapted_templates(Templates);
+    return NULL;
+  }
+  Templates->NumNonEmptyClasses = Header[4];
+  Templates->NumPermClasses = Header[5];
+
+  /* the class pruners are stored as (index, word) pairs of non-zero words */
+  for (i = 0; i < IntTemplates->NumClassPruners; i++) {
+    uinT32 *Pruner = (uinT32 *) IntTemplates->ClassPruner[i];
+    if (fread(&NumWords, sizeof(NumWords), 1, File) != 1 ||
+        NumWords > WERDS_PER_CP) {
+      cprintf("Bad read of adapted templates!\n");
+      free_adapted_templates(Templates);
+      return NULL;
+    }
+    for (j = 0; j < (int) NumWords; j++) {
+      if (fread(&WordIndex, sizeof(WordIndex), 1, File) != 1 ||
+          WordIndex >= WERDS_PER_CP ||
+          fread(&Pruner[WordIndex], sizeof(uinT32), 1, File) != 1) {
+        cprintf("Bad read of adapted templates!\n");
+        free_adapted_templates(Templates);
+        return NULL;
+      }
+    }
+  }
+
+  /* then each saved class, terminated by -1 */
+  ClassId = 0;
+  while (fread(&ClassId, sizeof(ClassId), 1, File) == 1 && ClassId >= 0) {
+    INT_CLASS IntClass;
+    ADAPT_CLASS Class;
+    if (ClassId >= IntTemplates->NumClasses ||
+        (IntClass = ReadAdaptedIntClass(File)) == NULL) {
+      cprintf("Bad read of adapted templates!\n");
+      free_adapted_templates(Templates);
+      return NULL;
+    }
+    free_int_class(IntTemplates->Class[ClassId]);
+    IntTemplates->Class[ClassId] = IntClass;
+    Class = ReadCompactAdaptedClass(File, IntClass->NumConfigs);
+    if (Class == NULL) {
+      cprintf("Bad read of adapted templates!\n");
+      free_adapted_templates(Templates);
+      return NULL;
+    }
+    free_adapted_class(Templates->Class[ClassId]);
+    Templates->Class[ClassId] = Class;
+  }
+  if (ClassId >= 0) {
+    cprintf("Bad read of adapted templates!\n");
+    free_adapted_templates(Templates);
+    return NULL;
+  }
+  return (Templates);
+}                                /* ReadCompactAdaptedTemplates */
+}  // namespace tesseract
+
+
+/*---------------------------------------------------------------------------*/
+/**
+ * Read an adapted class written by WriteCompactAdaptedClass.
+ *
+ * @param File  open file to read the class from
+ * @param NumConfigs  number of configs in the class
+ * @return Ptr to new adapted class, or NULL if the class is malformed.
+ *
+ * @note Globals: none
+ * @note Exceptions: none
+ */
+ADAPT_CLASS ReadCompactAdaptedClass(FILE *File, int NumConfigs) {
+  ADAPT_CLASS Class;
+  TEMP_PROTO TempProto;
+  TEMP_CONFIG Config;
+  PROTO_ID MaxProtoId;
+  int NumTempProtos;
+  int i;
+
+  Class = NewAdaptedClass();
+  if (fread(&Class->NumPermConfigs, sizeof(Class->NumPermConfigs), 1, File)
+      != 1 ||
+      fread(Class->PermProtos, sizeof(uinT32),
+            WordsInVectorOfSize(MAX_NUM_PROTOS), File)
+      != WordsInVectorOfSize(MAX_NUM_PROTOS) ||
+      fread(Class->PermConfigs, sizeof(uinT32),
+            WordsInVectorOfSize(MAX_NUM_CONFIGS), File)
+      != WordsInVectorOfSize(MAX_NUM_CONFIGS) ||
+      fread(&NumTempProtos, sizeof(NumTempProtos), 1, File) != 1 ||
+      NumTempProtos < 0 || NumTempProtos > MAX_NUM_PROTOS) {
+    free_adapted_class(Class);
+    return NULL;
+  }
+
+  for (i = 0; i < NumTempProtos; i++) {
+    TempProto = NewTempProto();
+    Class->TempProtos = push_last(Class->TempProtos, TempProto);
+    if (fread(&TempProto->ProtoId, sizeof(TempProto->ProtoId), 1, File)
+        != 1 ||
+        fread(&TempProto->Proto, sizeof(TempProto->Proto), 1, File) != 1 ||
+        TempProto->ProtoId >= MAX_NUM_PROTOS) {
+      free_adapted_class(Class);
+      return NULL;
+    }
+  }
+
+  for (i = 0; i < NumConfigs; i++) {
+    if (ConfigIsPermanent(Class, i)) {
+      if ((PermConfigFor(Class, i) = ReadPermConfig(File)) == NULL) {
+        free_adapted_class(Class);
+        return NULL;
+      }
+    } else {
+      if (fread(&MaxProtoId, sizeof(MaxProtoId), 1, File) != 1 ||
+          MaxProtoId < 0 || MaxProtoId >= MAX_NUM_PROTOS) {
+        free_adapted_class(Class);
+        return NULL;
+      }
+      Config = NewTempConfig(MaxProtoId);
+      TempConfigFor(Class, i) = Config;
+      if (fread(&Config->NumTimesSeen, sizeof(Config->NumTimesSeen), 1, File)
+          != 1 ||
+          fread(Config->Protos, sizeof(uinT32), Config->ProtoVectorSize, File)
+          != (size_t) Config->ProtoVectorSize) {
+        free_adapted_class(Class);
+        return NULL;
+      }
+    }
+  }
+  return (Class);
+}                                /* ReadCompactAdaptedClass */
+
+
+/*---------------------------------------------------------------------------*/
+/**
+ * Read an integer class written by WriteAdaptedIntClass.
+ *
+ * @param File  open file to read the class from
+ * @return New integer class, or NULL if the class is malformed.
+ *
+ * @note Globals: none
+ * @note Exceptions: none
+ */
+INT_CLASS ReadAdaptedIntClass(FILE *File) {
+  INT_CLASS Class;
+  uinT16 NumProtos;
+  uinT8 NumProtoSets;
+  uinT8 NumConfigs;
+  int i;
+
+  if (fread(&NumProtos, sizeof(NumProtos), 1, File) != 1 ||
+      fread(&NumProtoSets, sizeof(NumProtoSets), 1, File) != 1 ||
+      fread(&NumConfigs, sizeof(NumConfigs), 1, File) != 1 ||
+      NumProtoSets > MAX_NUM_PROTO_SETS || NumConfigs > MAX_NUM_CONFIGS ||
+      NumProtos > NumProtoSets * PROTOS_PER_PROTO_SET)
+    return NULL;
+
+  Class = NewIntClass(NumProtoSets * PROTOS_PER_PROTO_SET, NumConfigs);
+  Class->NumProtos = NumProtos;
+  Class->NumConfigs = NumConfigs;
+  Class->font_set_id = -1;
+  if (MaxNumIntProtosIn(Class) == 0)
+    Class->ProtoLengths = NULL;
+  if (fread(Class->ConfigLengths, sizeof(uinT16), NumConfigs, File)
+      != NumConfigs) {
+    free_int_class(Class);
+    return NULL;
+  }
+  if (MaxNumIntProtosIn(Class) > 0 &&
+      fread(Class->ProtoLengths, sizeof(uinT8), MaxNumIntProtosIn(Class), File)
+      != (size_t) MaxNumIntProtosIn(Class)) {
+    free_int_class(Class);
+    return NULL;
+  }
+  for (i = 0; i < Class->NumProtoSets; i++) {
+    if (fread(Class->ProtoSets[i], sizeof(PROTO_SET_STRUCT), 1, File) != 1) {
+      free_int_class(Class);
+      return NULL;
+    }
+  }
+  return (Class);
+}                                /* ReadAdaptedIntClass */
+
+
 /*---------------------------------------------------------------------------*/
 /**
  * Read a permanent configuration description from File
  * and return a ptr to it.
  *
  * @param File  open file to read permanent config from
- * @return Ptr to new permanent configuration description.
+ * @return Ptr to new permanent configuration description, or NULL
+ * if File does not hold a complete one.
  *
  * @note Globals: none
  * @note Exceptions: none
@@ -390,9 +612,21 @@ PERM_CONFIG ReadPermConfig(FILE *File) {
   PERM_CONFIG Config;
   uinT8 NumAmbigs;
 
-  fread ((char *) &NumAmbigs, sizeof (uinT8), 1, File);
+  int i;
+
+  if (fread ((char *) &NumAmbigs, sizeof (uinT8), 1, File) != 1)
+    return NULL;
   Config = (PERM_CONFIG) Emalloc (sizeof (UNICHAR_ID) * (NumAmbigs + 1));
-  fread (Config, sizeof (UNICHAR_ID), NumAmbigs, File);
+  if (fread (Config, sizeof (UNICHAR_ID), NumAmbigs, File) != NumAmbigs) {
+    Efree(Config);
+    return NULL;
+  }
+  for (i = 0; i < NumAmbigs; i++) {
+    if (Config[i] < 0) {
+      Efree(Config);
+      return NULL;
+    }
+  }
   Config[NumAmbigs] = -1;
 
   return (Config);
@@ -506,6 +740,171 @@ void Classify::WriteAdaptedTemplates(FILE *File, ADAPT_TEMPLATES Templates) {
 }  // namespace tesseract
 
 
+/*---------------------------------------------------------------------------*/
+namespace tesseract {
+/**
+ * This routine saves Templates to File in a compact
+ * binary format (in native byte order) which can be read
+ * back by ReadCompactAdaptedTemplates into a classifier with
+ * the same unicharset.  Unlike WriteAdaptedTemplates, only
+ * the classes which have been adapted to are written, and the
+ * (mostly empty) class pruners are stored sparsely, so a
+ * snapshot is typically a few tens of kilobytes.
+ *
+ * @param File    open file to write Templates to
+ * @param Templates set of adapted templates to write to File
+ * @return false if any write to File fails.
+ *
+ * @note Globals: none
+ * @note Exceptions: none
+ */
+bool Classify::WriteCompactAdaptedTemplates(FILE *File,
+                                            ADAPT_TEMPLATES Templates) {
+  INT_TEMPLATES IntTemplates = Templates->Templates;
+  int Header[ADAPTED_TEMPLATES_HEADER_SIZE];
+  uinT32 NumWords;
+  uinT32 WordIndex;
+  int ClassId;
+  int i;
+
+  Header[0] = ADAPTED_TEMPLATES_MAGIC;
+  Header[1] = ADAPTED_TEMPLATES_VERSION;
+  Header[2] = unicharset.size();
+  Header[3] = IntTemplates->NumClassPruners;
+  Header[4] = Templates->NumNonEmptyClasses;
+  Header[5] = Templates->NumPermClasses;
+  if (fwrite(Header, sizeof(Header[0]), ADAPTED_TEMPLATES_HEADER_SIZE, File)
+      != ADAPTED_TEMPLATES_HEADER_SIZE)
+    return false;
+
+  for (i = 0; i < IntTemplates->NumClassPruners; i++) {
+    uinT32 *Pruner = (uinT32 *) IntTemplates->ClassPruner[i];
+    NumWords = 0;
+    for (WordIndex = 0; WordIndex < WERDS_PER_CP; WordIndex++)
+      if (Pruner[WordIndex] != 0)
+        NumWords++;
+    if (fwrite(&NumWords, sizeof(NumWords), 1, File) != 1)
+      return false;
+    for (WordIndex = 0; WordIndex < WERDS_PER_CP; WordIndex++) {
+      if (Pruner[WordIndex] != 0 &&
+          (fwrite(&WordIndex, sizeof(WordIndex), 1, File) != 1 ||
+           fwrite(&Pruner[WordIndex], sizeof(uinT32), 1, File) != 1))
+        return false;
+    }
+  }
+
+  for (ClassId = 0; ClassId < IntTemplates->NumClasses; ClassId++) {
+    INT_CLASS IntClass = IntTemplates->Class[ClassId];
+    if (IsEmptyAdaptedClass(Templates->Class[ClassId]) &&
+        IntClass->NumProtos == 0 && IntClass->NumConfigs == 0)
+      continue;
+    if (fwrite(&ClassId, sizeof(ClassId), 1, File) != 1 ||
+        !WriteAdaptedIntClass(File, IntClass) ||
+        !WriteCompactAdaptedClass(File, Templates->Class[ClassId],
+                                  IntClass->NumConfigs))
+      return false;
+  }
+  ClassId = -1;
+  return fwrite(&ClassId, sizeof(ClassId), 1, File) == 1;
+}                                /* WriteCompactAdaptedTemplates */
+}  // namespace tesseract
+
+
+/*---------------------------------------------------------------------------*/
+/**
+ * This routine writes the adaptive information of Class
+ * to File.  Unlike WriteAdaptedClass, no raw structures (and
+ * so no pointers) are written, so equal classes give equal
+ * bytes.
+ *
+ * @param File    open file to write Class to
+ * @param Class   adapted class to write to File
+ * @param NumConfigs  number of configs in Class
+ * @return false if any write to File fails.
+ *
+ * @note Globals: none
+ * @note Exceptions: none
+ */
+bool WriteCompactAdaptedClass(FILE *File, ADAPT_CLASS Class, int NumConfigs) {
+  TEMP_PROTO TempProto;
+  TEMP_CONFIG Config;
+  LIST TempProtos;
+  int NumTempProtos;
+  int i;
+
+  NumTempProtos = count(Class->TempProtos);
+  if (fwrite(&Class->NumPermConfigs, sizeof(Class->NumPermConfigs), 1, File)
+      != 1 ||
+      fwrite(Class->PermProtos, sizeof(uinT32),
+             WordsInVectorOfSize(MAX_NUM_PROTOS), File)
+      != WordsInVectorOfSize(MAX_NUM_PROTOS) ||
+      fwrite(Class->PermConfigs, sizeof(uinT32),
+             WordsInVectorOfSize(MAX_NUM_CONFIGS), File)
+      != WordsInVectorOfSize(MAX_NUM_CONFIGS) ||
+      fwrite(&NumTempProtos, sizeof(NumTempProtos), 1, File) != 1)
+    return false;
+  TempProtos = Class->TempProtos;
+  iterate(TempProtos) {
+    TempProto = (TEMP_PROTO) first_node(TempProtos);
+    if (fwrite(&TempProto->ProtoId, sizeof(TempProto->ProtoId), 1, File)
+        != 1 ||
+        fwrite(&TempProto->Proto, sizeof(TempProto->Proto), 1, File) != 1)
+      return false;
+  }
+
+  for (i = 0; i < NumConfigs; i++) {
+    if (ConfigIsPermanent(Class, i)) {
+      if (!WritePermConfig(File, PermConfigFor(Class, i)))
+        return false;
+    } else {
+      Config = TempConfigFor(Class, i);
+      if (fwrite(&Config->MaxProtoId, sizeof(Config->MaxProtoId), 1, File)
+          != 1 ||
+          fwrite(&Config->NumTimesSeen, sizeof(Config->NumTimesSeen), 1, File)
+          != 1 ||
+          fwrite(Config->Protos, sizeof(uinT32), Config->ProtoVectorSize,
+                 File) != Config->ProtoVectorSize)
+        return false;
+    }
+  }
+  return true;
+}                                /* WriteCompactAdaptedClass */
+
+
+/*---------------------------------------------------------------------------*/
+/**
+ * This routine writes the protos and config lengths of an
+ * adapted integer class to File.  Adapted classes have no
+ * font information, so none is written.
+ *
+ * @param File  open file to write Class to
+ * @param Class integer class to write to File
+ * @return false if any write to File fails.
+ *
+ * @note Globals: none
+ * @note Exceptions: none
+ */
+bool WriteAdaptedIntClass(FILE *File, INT_CLASS Class) {
+  int i;
+
+  if (fwrite(&Class->NumProtos, sizeof(Class->NumProtos), 1, File) != 1 ||
+      fwrite(&Class->NumProtoSets, sizeof(Class->NumProtoSets), 1, File)
+      != 1 ||
+      fwrite(&Class->NumConfigs, sizeof(Class->NumConfigs), 1, File) != 1 ||
+      fwrite(Class->ConfigLengths, sizeof(uinT16), Class->NumConfigs, File)
+      != Class->NumConfigs)
+    return false;
+  if (MaxNumIntProtosIn (Class) > 0 &&
+      fwrite(Class->ProtoLengths, sizeof(uinT8), MaxNumIntProtosIn(Class),
+             File) != MaxNumIntProtosIn(Class))
+    return false;
+  for (i = 0; i < Class->NumProtoSets; i++)
+    if (fwrite(Class->ProtoSets[i], sizeof(PROTO_SET_STRUCT), 1, File) != 1)
+      return false;
+  return true;
+}                                /* WriteAdaptedIntClass */
+
+
 /*---------------------------------------------------------------------------*/
 /**
  * This routine writes a binary representation of a
@@ -513,21 +912,21 @@ void Classify::WriteAdaptedTemplates(FILE *File, ADAPT_TEMPLATES Templates) {
  * 
  * @param File  open file to write Config to
  * @param Config  permanent config to write to File
+ * @return false if any write to File fails.
  *
  * @note Globals: none
  * @note Exceptions: none
  * @note History: Tue Mar 19 13:55:44 1991, DSJ, Created.
  */
-void WritePermConfig(FILE *File, PERM_CONFIG Config) {
+bool WritePermConfig(FILE *File, PERM_CONFIG Config) {
   uinT8 NumAmbigs = 0;
 
   assert (Config != NULL);
   while (Config[NumAmbigs] > 0)
     ++NumAmbigs;
 
-  fwrite ((char *) &NumAmbigs, sizeof (uinT8), 1, File);
-  fwrite (Config, sizeof (UNICHAR_ID), NumAmbigs, File);
-
+  return fwrite ((char *) &NumAmbigs, sizeof (uinT8), 1, File) == 1 &&
+         fwrite (Config, sizeof (UNICHAR_ID), NumAmbigs, File) == NumAmbigs;
 }                                /* WritePermConfig */
 
 
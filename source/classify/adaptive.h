@@ -75,6 +75,13 @@ typedef struct
 } ADAPT_TEMPLATES_STRUCT;
 typedef ADAPT_TEMPLATES_STRUCT *ADAPT_TEMPLATES;
 
+/* header of the compact adapted templates format: magic, version,
+   unicharset size, number of class pruners, number of non-empty
+   classes and number of permanent classes */
+#define ADAPTED_TEMPLATES_MAGIC         0x41445450
+#define ADAPTED_TEMPLATES_VERSION       1
+#define ADAPTED_TEMPLATES_HEADER_SIZE   6
+
 /*----------------------------------------------------------------------------
           Public Function Prototypes
 ----------------------------------------------------------------------------*/
@@ -121,13 +128,21 @@ TEMP_PROTO NewTempProto();
 
 ADAPT_CLASS ReadAdaptedClass(FILE *File);
 
+ADAPT_CLASS ReadCompactAdaptedClass(FILE *File, int NumConfigs);
+
+INT_CLASS ReadAdaptedIntClass(FILE *File);
+
 PERM_CONFIG ReadPermConfig(FILE *File);
 
 TEMP_CONFIG ReadTempConfig(FILE *File);
 
 void WriteAdaptedClass(FILE *File, ADAPT_CLASS Class, int NumConfigs);
 
-void WritePermConfig(FILE *File, PERM_CONFIG Config);
+bool WriteCompactAdaptedClass(FILE *File, ADAPT_CLASS Class, int NumConfigs);
+
+bool WriteAdaptedIntClass(FILE *File, INT_CLASS Class);
+
+bool WritePermConfig(FILE *File, PERM_CONFIG Config);
 
 void WriteTempConfig(FILE *File, TEMP_CONFIG Config);
 
@@ -49,6 +49,7 @@
 #include <ctype.h>
 #include <stdlib.h>
 #include <math.h>
+#include <time.h>
 #ifdef __UNIX__
 #include <assert.h>
 #endif
@@ -111,6 +112,17 @@ typedef struct
 
 PROTO_KEY;
 
+/* one integer matcher call of a PrefetchCharNormMatches batch */
+typedef struct
+{
+  CLASS_ID Class;
+  int Entry;
+  int Result;
+}
+
+
+IM_BATCH_ITEM;
+
 /*-----------------------------------------------------------------------------
           Private Macros
 -----------------------------------------------------------------------------*/
@@ -178,24 +190,6 @@ UNICHAR_ID *GetAmbiguities(TBLOB *Blob,
                            LINE_STATS *LineStats,
                            CLASS_ID CorrectClass);
 
-namespace tesseract {
-int GetBaselineFeatures(TBLOB *Blob,
-                        LINE_STATS *LineStats,
-                        INT_TEMPLATES Templates,
-                        INT_FEATURE_ARRAY IntFeatures,
-                        CLASS_NORMALIZATION_ARRAY CharNormArray,
-                        inT32 *BlobLength);
-
-
-int GetIntBaselineFeatures(TBLOB *Blob,
-                           LINE_STATS *LineStats,
-                           INT_TEMPLATES Templates,
-                           INT_FEATURE_ARRAY IntFeatures,
-                           CLASS_NORMALIZATION_ARRAY CharNormArray,
-                           inT32 *BlobLength);
-
-}  // namespace tesseract.
-
 void InitMatcherRatings(register FLOAT32 *Rating);
 
 PROTO_ID MakeNewTempProtos(FEATURE_SET Features,
@@ -212,6 +206,16 @@ void MakePermanent(ADAPT_TEMPLATES Templates,
 
 int MakeTempProtoPerm(void *item1, void *item2);
 
+CP_BATCH_ENTRY *FindCharNormPrefetch(INT_TEMPLATES Templates,
+                                     int NumFeatures,
+                                     INT_FEATURE_ARRAY IntFeatures,
+                                     CLASS_NORMALIZATION_ARRAY CharNormArray,
+                                     inT32 BlobLength);
+
+void FreeCharNormPrefetch();
+
+int CompareIMBatchItems(const void *arg1, const void *arg2);
+
 int NumBlobsIn(TWERD *Word);
 
 int NumOutlinesInBlob(TBLOB *Blob);
@@ -245,6 +249,11 @@ static int NumCharNormClassesTried = 0;
 static int NumAmbigClassesTried = 0;
 static int NumClassesOutput = 0;
 static int NumAdaptationsFailed = 0;
+static int NumBatchedBlobs = 0;
+static int NumBatchHits = 0;
+static int NumClassesEvicted = 0;
+static int NumProtosEvicted = 0;
+static clock_t BaselineMatchTime = 0;
 
 /* define globals used to hold onto extracted features.  This is used
 to map from the old scheme in which baseline features and char norm
@@ -256,6 +265,14 @@ static INT_FEATURE_ARRAY BaselineFeatures;
 static INT_FEATURE_ARRAY CharNormFeatures;
 static INT_FX_RESULT_STRUCT FXInfo;
 
+/* char norm matches computed ahead of time by AdaptiveClassifierBatch.
+CharNormClassifier takes its pruner and integer matcher results from here
+when the features of the blob are an exact match for an entry. */
+static INT_TEMPLATES CharNormPrefetchTemplates = NULL;
+static CP_BATCH_ENTRY *CharNormPrefetch = NULL;
+static int NumCharNormPrefetch = 0;
+static int NextCharNormPrefetch = 0;
+
 /** use a global variable to hold onto the current ratings so that the
 comparison function passes to qsort can get at them */
 static FLOAT32 *CurrentRatings;
@@ -311,6 +328,10 @@ double_VAR(tessedit_class_miss_scale, 0.00390625,
 BOOL_VAR(tess_cn_matching, 0, "Character Normalized Matching");
 BOOL_VAR(tess_bn_matching, 0, "Baseline Normalized Matching");
 
+INT_VAR(classify_adapt_max_protos, 0,
+        "Max # of protos in the adapted templates before least recently"
+        " used classes are evicted (0 = no limit)");
+
 /*-----------------------------------------------------------------------------
               Public Code
 -----------------------------------------------------------------------------*/
@@ -410,6 +431,43 @@ void Classify::AdaptiveClassifier(TBLOB *Blob,
 }                                /* AdaptiveClassifier */
 
 
+/*---------------------------------------------------------------------------*/
+/**
+ * This routine classifies several blobs from the same row
+ * at once.  When the char norm classifier is certain to be
+ * run on every blob, the class pruner and integer matcher
+ * work for all of the blobs is done up front by
+ * PrefetchCharNormMatches, which sweeps the pruner tables and
+ * the class templates once for the whole batch instead of once
+ * per blob.  Each blob is then finished by AdaptiveClassifier,
+ * so the choices are identical to classifying the blobs one
+ * at a time.
+ *
+ * @param Blobs    blobs to be classified
+ * @param NumBlobs number of blobs in Blobs
+ * @param Row      row of text that the blobs appear in
+ * @param[out] Choices  one (empty) choice list per blob to fill in
+ */
+void Classify::AdaptiveClassifierBatch(TBLOB **Blobs,
+                                       int NumBlobs,
+                                       TEXTROW *Row,
+                                       BLOB_CHOICE_LIST **Choices) {
+  LINE_STATS LineStats;
+
+  if (NumBlobs > 1 && PreTrainedTemplates != NULL &&
+      (AdaptedTemplates == NULL ||
+       AdaptedTemplates->NumPermClasses < matcher_permanent_classes_min ||
+       tess_cn_matching)) {
+    EnterClassifyMode;
+    GetLineStatsFromRow(Row, &LineStats);
+    PrefetchCharNormMatches(Blobs, NumBlobs, &LineStats);
+  }
+  for (int b = 0; b < NumBlobs; ++b)
+    AdaptiveClassifier(Blobs[b], NULL, Row, Choices[b], NULL);
+  FreeCharNormPrefetch();
+}                                /* AdaptiveClassifierBatch */
+
+
 /*---------------------------------------------------------------------------*/
 /**
  * This routine implements a preliminary
@@ -534,6 +592,8 @@ void Classify::AdaptToWord(TWERD *Word,
     }
     if (classify_learning_debug_level >= 1)
       cprintf ("\n");
+
+    LimitAdaptedTemplates(AdaptedTemplates);
   }
 }                                /* AdaptToWord */
 
@@ -585,6 +645,9 @@ void Classify::EndAdaptiveClassifier() {
   }
   getDict().EndDangerousAmbigs();
   FreeNormProtos();
+  if (classify_feature_cache_stats)
+    PrintIntFeatureCacheStats(&feature_cache_);
+  FreeIntFeatureCache(&feature_cache_);
   if (AllProtosOn != NULL) {
     FreeBitVector(AllProtosOn);
     FreeBitVector(PrunedProtos);
@@ -635,6 +698,7 @@ void Classify::InitAdaptiveClassifier() {
     } else {
       PreTrainedTemplates =
         ReadIntTemplates(tessdata_manager.GetDataFilePtr());
+      CompactIntTemplates(PreTrainedTemplates);
       if (global_tessdata_manager_debug_level) tprintf("Loaded inttemp\n");
 
       ASSERT_HOST(tessdata_manager.SeekToStart(TESSDATA_PFFMTABLE));
@@ -667,6 +731,7 @@ void Classify::InitAdaptiveClassifier() {
   set_all_bits(AllConfigsOn, WordsInVectorOfSize(MAX_NUM_CONFIGS));
   zero_all_bits(AllProtosOff, WordsInVectorOfSize(MAX_NUM_PROTOS));
   zero_all_bits(AllConfigsOff, WordsInVectorOfSize(MAX_NUM_CONFIGS));
+  ResetAdaptedClassUse();
 
   if (classify_use_pre_adapted_templates) {
     FILE *File;
@@ -702,6 +767,146 @@ void Classify::InitAdaptiveClassifier() {
 void Classify::ResetAdaptiveClassifier() {
   free_adapted_templates(AdaptedTemplates);
   AdaptedTemplates = NULL;
+  ResetAdaptedClassUse();
+}
+
+/**
+ * Forgets when each adapted class was last used, as for new templates.
+ *
+ * Globals:
+ * - #AdaptedClassLastUsed use clock of each adapted class
+ * - #AdaptedClassUseClock last use clock value given out
+ */
+void Classify::ResetAdaptedClassUse() {
+  memset(AdaptedClassLastUsed, 0, sizeof(AdaptedClassLastUsed));
+  AdaptedClassUseClock = 0;
+}
+
+/**
+ * Keeps the adapted templates within classify_adapt_max_protos protos,
+ * so that the cost of matching against them stays bounded over a long
+ * job.  When the limit is exceeded, whole classes are evicted, least
+ * recently used first, until the templates are back under 90% of the
+ * limit.  Classes that have no permanent configs yet are evicted before
+ * any class with permanent configs.  An evicted class is empty again
+ * and is re-learned from scratch the next time it is adapted to.
+ *
+ * @param Templates adapted templates to limit
+ *
+ * Globals:
+ * - #AdaptedClassLastUsed use clock of each adapted class
+ */
+void Classify::LimitAdaptedTemplates(ADAPT_TEMPLATES Templates) {
+  int NumProtos = 0;
+  int Target;
+  int ClassId;
+  int Victim;
+
+  if (classify_adapt_max_protos <= 0 || Templates == NULL)
+    return;
+  for (ClassId = 0; ClassId < Templates->Templates->NumClasses; ClassId++)
+    NumProtos += ClassForClassId(Templates->Templates, ClassId)->NumProtos;
+  if (NumProtos <= classify_adapt_max_protos)
+    return;
+
+  Target = classify_adapt_max_protos * 9 / 10;
+  while (NumProtos > Target) {
+    Victim = -1;
+    for (ClassId = 0; ClassId < Templates->Templates->NumClasses; ClassId++) {
+      if (IsEmptyAdaptedClass(Templates->Class[ClassId]))
+        continue;
+      if (Victim >= 0) {
+        bool IsTemp = Templates->Class[ClassId]->NumPermConfigs == 0;
+        bool VictimIsTemp = Templates->Class[Victim]->NumPermConfigs == 0;
+        if (IsTemp < VictimIsTemp ||
+            (IsTemp == VictimIsTemp &&
+             AdaptedClassLastUsed[ClassId] >= AdaptedClassLastUsed[Victim]))
+          continue;
+      }
+      Victim = ClassId;
+    }
+    if (Victim < 0)
+      break;
+    NumProtos -= ClassForClassId(Templates->Templates, Victim)->NumProtos;
+    EvictAdaptedClass(Templates, Victim);
+  }
+}                                /* LimitAdaptedTemplates */
+
+/**
+ * Removes everything learned about ClassId from Templates: its class
+ * pruner entries, its integer protos and configs, and its temporary
+ * and permanent adapted configs.  The class is left empty.
+ *
+ * @param Templates adapted templates containing the class
+ * @param ClassId class to evict
+ */
+void Classify::EvictAdaptedClass(ADAPT_TEMPLATES Templates,
+                                 CLASS_ID ClassId) {
+  ADAPT_CLASS Class = Templates->Class[ClassId];
+  INT_CLASS IClass = ClassForClassId(Templates->Templates, ClassId);
+
+  if (classify_learning_debug_level >= 1)
+    cprintf ("Evicting adapted class '%s' with %d protos.\n",
+             unicharset.id_to_unichar(ClassId), IClass->NumProtos);
+
+  NumClassesEvicted++;
+  NumProtosEvicted += IClass->NumProtos;
+
+  RemoveClassFromClassPruner(ClassId, Templates->Templates);
+  free_int_class(IClass);
+  ClassForClassId(Templates->Templates, ClassId) = NewIntClass(1, 1);
+
+  if (Class->NumPermConfigs > 0)
+    Templates->NumPermClasses--;
+  if (Templates->NumNonEmptyClasses > 0)
+    Templates->NumNonEmptyClasses--;
+  free_adapted_class(Class);
+  Templates->Class[ClassId] = NewAdaptedClass();
+  AdaptedClassLastUsed[ClassId] = 0;
+}                                /* EvictAdaptedClass */
+
+/**
+ * Writes a snapshot of the current adapted templates to File in the
+ * compact format of WriteCompactAdaptedTemplates.  The snapshot can be
+ * restored later with LoadAdaptiveClassifier, in this or any other
+ * classifier that uses the same unicharset.
+ *
+ * @param File open file to write the snapshot to
+ * @return false if there is nothing to save or a write fails.
+ */
+bool Classify::SaveAdaptiveClassifier(FILE *File) {
+  if (AdaptedTemplates == NULL)
+    return false;
+  return WriteCompactAdaptedTemplates(File, AdaptedTemplates);
+}
+
+/**
+ * Replaces the current adapted templates with a snapshot written by
+ * SaveAdaptiveClassifier, so that recognition starts with the
+ * adaptation of the earlier pages.  The use clock of the loaded classes
+ * starts again from zero.  On failure the current templates are left
+ * untouched.
+ *
+ * @param File open file to read the snapshot from
+ * @return false if File does not hold a snapshot for this unicharset.
+ *
+ * Globals:
+ * - BaselineCutoffs expected num features for each adapted class
+ * - #AdaptedClassLastUsed use clock of each adapted class
+ */
+bool Classify::LoadAdaptiveClassifier(FILE *File) {
+  if (!classify_enable_adaptive_matcher)
+    return false;
+  ADAPT_TEMPLATES Templates = ReadCompactAdaptedTemplates(File);
+  if (Templates == NULL)
+    return false;
+  free_adapted_templates(AdaptedTemplates);
+  AdaptedTemplates = Templates;
+  for (int i = 0; i < AdaptedTemplates->Templates->NumClasses; i++) {
+    BaselineCutoffs[i] = CharNormCutoffs[i];
+  }
+  ResetAdaptedClassUse();
+  return true;
 }
 }  // namespace tesseract
 
@@ -740,10 +945,26 @@ void Classify::PrintAdaptiveStatistics(FILE *File) {
     AmbigClassifierCalls,
     ((AmbigClassifierCalls == 0) ? (0.0) :
   ((float) NumAmbigClassesTried / AmbigClassifierCalls)));
+  fprintf (File, "\t\tBatched CharNorm:    %4d blobs (%4d used)\n",
+    NumBatchedBlobs, NumBatchHits);
+  fprintf (File, "\t\tBaseline match time: %4.2f sec\n",
+    (double) BaselineMatchTime / CLOCKS_PER_SEC);
 
   fprintf (File, "\nADAPTIVE LEARNER STATISTICS:\n");
   fprintf (File, "\tNumber of words adapted to: %d\n", NumWordsAdaptedTo);
   fprintf (File, "\tNumber of chars adapted to: %d\n", NumCharsAdaptedTo);
+  if (AdaptedTemplates != NULL) {
+    int NumProtos = 0;
+    int NumConfigs = 0;
+    for (int i = 0; i < AdaptedTemplates->Templates->NumClasses; i++) {
+      NumProtos += AdaptedTemplates->Templates->Class[i]->NumProtos;
+      NumConfigs += AdaptedTemplates->Templates->Class[i]->NumConfigs;
+    }
+    fprintf (File, "\tAdapted templates size:     %d protos, %d configs\n",
+      NumProtos, NumConfigs);
+  }
+  fprintf (File, "\tNumber of classes evicted:  %d (%d protos)\n",
+    NumClassesEvicted, NumProtosEvicted);
 
   PrintAdaptedTemplates(File, AdaptedTemplates);
   #endif
@@ -1004,9 +1225,13 @@ int Classify::AdaptableWord(TWERD *Word,
   NumCharsAdaptedTo++;
   if (!LegalClassId (ClassId))
     return;
+  AdaptedClassLastUsed[ClassId] = ++AdaptedClassUseClock;
 
   Class = AdaptedTemplates->Class[ClassId];
   assert(Class != NULL);
+  // In fast mode, stop learning a class once it has a permanent config.
+  if (tord_fast_mode && Class->NumPermConfigs > 0)
+    return;
   if (IsEmptyAdaptedClass(Class)) {
     InitAdaptedClass(Blob, LineStats, ClassId, Class, AdaptedTemplates);
   }
@@ -1263,6 +1488,8 @@ void Classify::AmbigClassifier(TBLOB *Blob,
 /*---------------------------------------------------------------------------*/
 /// Factored-out calls to IntegerMatcher based on class pruner results.
 /// Returns integer matcher results inside CLASS_PRUNER_RESULTS structure.
+/// If matched is true, results already holds the integer matcher results
+/// (computed by PrefetchCharNormMatches) and they are not recomputed.
 void Classify::MasterMatcher(INT_TEMPLATES templates,
                              inT16 num_features,
                              INT_FEATURE_ARRAY features,
@@ -1271,7 +1498,8 @@ void Classify::MasterMatcher(INT_TEMPLATES templates,
                              int debug,
                              int num_classes,
                              CLASS_PRUNER_RESULTS results,
-                             ADAPT_RESULTS* final_results) {
+                             ADAPT_RESULTS* final_results,
+                             bool matched) {
   for (int c = 0; c < num_classes; c++) {
     CLASS_ID class_id = results[c].Class;
     INT_RESULT_STRUCT& int_result = results[c].IMResult;
@@ -1280,10 +1508,11 @@ void Classify::MasterMatcher(INT_TEMPLATES templates,
     BIT_VECTOR configs = classes != NULL ? classes[class_id]->PermConfigs
                                          : AllConfigsOn;
 
-    IntegerMatcher(ClassForClassId(templates, class_id),
-                   protos, configs, final_results->BlobLength,
-                   num_features, features, norm_factors[class_id],
-                   &int_result, debug);
+    if (!matched)
+      IntegerMatcher(ClassForClassId(templates, class_id),
+                     protos, configs, final_results->BlobLength,
+                     num_features, features, norm_factors[class_id],
+                     &int_result, debug);
     // Compute class feature corrections.
     double miss_penalty = tessedit_class_miss_scale *
                           int_result.FeatureMisses;
@@ -1359,6 +1588,7 @@ UNICHAR_ID *Classify::BaselineClassifier(TBLOB *Blob,
   INT_FEATURE_ARRAY IntFeatures;
   CLASS_NORMALIZATION_ARRAY CharNormArray;
   CLASS_ID ClassId;
+  clock_t StartTime;
 
   BaselineClassifierCalls++;
 
@@ -1369,6 +1599,8 @@ UNICHAR_ID *Classify::BaselineClassifier(TBLOB *Blob,
   if (NumFeatures <= 0)
     return NULL;
 
+  StartTime = clock();
+
   NumClasses = ClassPruner (Templates->Templates, NumFeatures,
     IntFeatures, CharNormArray,
     BaselineCutoffs, Results->CPResults,
@@ -1382,13 +1614,17 @@ UNICHAR_ID *Classify::BaselineClassifier(TBLOB *Blob,
   SetBaseLineMatch();
   MasterMatcher(Templates->Templates, NumFeatures, IntFeatures, CharNormArray,
                 Templates->Class, matcher_debug_flags, NumClasses,
-                Results->CPResults, Results);
+                Results->CPResults, Results, false);
+  BaselineMatchTime += clock() - StartTime;
 
   ClassId = Results->BestClass;
   if (ClassId == NO_CLASS)
     return (NULL);
   /* this is a bug - maybe should return "" */
 
+  if (Templates == AdaptedTemplates)
+    AdaptedClassLastUsed[ClassId] = ++AdaptedClassUseClock;
+
   return (Templates->Class[ClassId]->Config[Results->BestConfig].Perm);
 }                                /* BaselineClassifier */
 
@@ -1421,6 +1657,7 @@ int Classify::CharNormClassifier(TBLOB *Blob,
   int NumClasses;
   INT_FEATURE_ARRAY IntFeatures;
   CLASS_NORMALIZATION_ARRAY CharNormArray;
+  CP_BATCH_ENTRY *Prefetched;
 
   CharNormClassifierCalls++;
 
@@ -1431,23 +1668,194 @@ int Classify::CharNormClassifier(TBLOB *Blob,
   if (NumFeatures <= 0)
     return 0;
 
-  NumClasses = ClassPruner(Templates, NumFeatures,
-                           IntFeatures, CharNormArray,
-                           CharNormCutoffs, Results->CPResults,
-                           matcher_debug_flags);
-
-  if (tessedit_single_match && NumClasses > 1)
-    NumClasses = 1;
+  Prefetched = FindCharNormPrefetch(Templates, NumFeatures, IntFeatures,
+                                    CharNormArray, Results->BlobLength);
+  if (Prefetched != NULL) {
+    NumBatchHits++;
+    NumClasses = Prefetched->NumClasses;
+    memcpy(Results->CPResults, Prefetched->Results,
+           NumClasses * sizeof(Results->CPResults[0]));
+  } else {
+    NumClasses = ClassPruner(Templates, NumFeatures,
+                             IntFeatures, CharNormArray,
+                             CharNormCutoffs, Results->CPResults,
+                             matcher_debug_flags);
+    if (tessedit_single_match && NumClasses > 1)
+      NumClasses = 1;
+  }
   NumCharNormClassesTried += NumClasses;
 
   SetCharNormMatch();
   MasterMatcher(Templates, NumFeatures, IntFeatures, CharNormArray,
                 NULL, matcher_debug_flags, NumClasses,
-                Results->CPResults, Results);
+                Results->CPResults, Results, Prefetched != NULL);
   return NumFeatures;
 }                                /* CharNormClassifier */
 
 
+/*---------------------------------------------------------------------------*/
+/**
+ * This routine extracts the char norm features of each
+ * blob and runs the class pruner (ClassPrunerBatch) and the
+ * integer matcher on all of them.  The integer matcher calls
+ * are grouped by class so that each class template is only
+ * brought into cache once per batch.  The results are kept
+ * until FreeCharNormPrefetch is called and are picked up by
+ * CharNormClassifier.
+ *
+ * @param Blobs    blobs to be classified
+ * @param NumBlobs number of blobs in Blobs
+ * @param LineStats statistics for text line the blobs are in
+ *
+ * Globals:
+ * - CharNormCutoffs expected num features for each class
+ * - CharNormPrefetch batch results
+ */
+void Classify::PrefetchCharNormMatches(TBLOB **Blobs,
+                                       int NumBlobs,
+                                       LINE_STATS *LineStats) {
+  IM_BATCH_ITEM *Items;
+  int NumItems;
+  int NumEntries;
+  int b, c, i;
+
+  FreeCharNormPrefetch();
+  CharNormPrefetch = (CP_BATCH_ENTRY *)
+    Emalloc(NumBlobs * sizeof(CP_BATCH_ENTRY));
+  NumEntries = 0;
+  for (b = 0; b < NumBlobs; ++b) {
+    CP_BATCH_ENTRY *Entry = &CharNormPrefetch[NumEntries];
+    InitIntFX();
+    Entry->NumFeatures = GetCharNormFeatures(Blobs[b], LineStats,
+                                             PreTrainedTemplates,
+                                             Entry->Features,
+                                             Entry->NormalizationFactors,
+                                             &Entry->BlobLength);
+    if (Entry->NumFeatures > 0)
+      ++NumEntries;
+  }
+  InitIntFX();
+  ClassPrunerBatch(PreTrainedTemplates, NumEntries, CharNormPrefetch,
+                   CharNormCutoffs, matcher_debug_flags);
+  CharNormPrefetchTemplates = PreTrainedTemplates;
+  NumCharNormPrefetch = NumEntries;
+  NextCharNormPrefetch = 0;
+  NumBatchedBlobs += NumEntries;
+
+  NumItems = 0;
+  for (b = 0; b < NumEntries; ++b) {
+    if (tessedit_single_match && CharNormPrefetch[b].NumClasses > 1)
+      CharNormPrefetch[b].NumClasses = 1;
+    NumItems += CharNormPrefetch[b].NumClasses;
+  }
+  Items = (IM_BATCH_ITEM *) Emalloc((NumItems + 1) * sizeof(IM_BATCH_ITEM));
+  i = 0;
+  for (b = 0; b < NumEntries; ++b) {
+    for (c = 0; c < CharNormPrefetch[b].NumClasses; ++c) {
+      Items[i].Class = CharNormPrefetch[b].Results[c].Class;
+      Items[i].Entry = b;
+      Items[i].Result = c;
+      ++i;
+    }
+  }
+  qsort(Items, NumItems, sizeof(IM_BATCH_ITEM), CompareIMBatchItems);
+
+  SetCharNormMatch();
+  for (i = 0; i < NumItems; ++i) {
+    CP_BATCH_ENTRY *Entry = &CharNormPrefetch[Items[i].Entry];
+    CLASS_ID ClassId = Items[i].Class;
+    IntegerMatcher(ClassForClassId(PreTrainedTemplates, ClassId),
+                   AllProtosOn, AllConfigsOn, Entry->BlobLength,
+                   Entry->NumFeatures, Entry->Features,
+                   Entry->NormalizationFactors[ClassId],
+                   &Entry->Results[Items[i].Result].IMResult,
+                   matcher_debug_flags);
+  }
+  Efree(Items);
+}                                /* PrefetchCharNormMatches */
+}  // namespace tesseract
+
+
+/*---------------------------------------------------------------------------*/
+/**
+ * This routine returns the prefetched char norm match for
+ * a blob with exactly the given features, or NULL if there
+ * is none.  Entries are normally consumed in order, so the
+ * search starts just after the previous hit.
+ *
+ * @param Templates templates the blob is being matched against
+ * @param NumFeatures number of features in IntFeatures
+ * @param IntFeatures char norm features of the blob
+ * @param CharNormArray char norm adjustments of the blob
+ * @param BlobLength length of the blob
+ *
+ * @return Matching prefetch entry or NULL.
+ */
+CP_BATCH_ENTRY *FindCharNormPrefetch(INT_TEMPLATES Templates,
+                                     int NumFeatures,
+                                     INT_FEATURE_ARRAY IntFeatures,
+                                     CLASS_NORMALIZATION_ARRAY CharNormArray,
+                                     inT32 BlobLength) {
+  int i, e;
+
+  if (Templates != CharNormPrefetchTemplates)
+    return NULL;
+  for (i = 0; i < NumCharNormPrefetch; ++i) {
+    e = (NextCharNormPrefetch + i) % NumCharNormPrefetch;
+    CP_BATCH_ENTRY *Entry = &CharNormPrefetch[e];
+    if (Entry->NumFeatures == NumFeatures &&
+        Entry->BlobLength == BlobLength &&
+        memcmp(Entry->Features, IntFeatures,
+               NumFeatures * sizeof(IntFeatures[0])) == 0 &&
+        memcmp(Entry->NormalizationFactors, CharNormArray,
+               Templates->NumClasses * sizeof(CharNormArray[0])) == 0) {
+      NextCharNormPrefetch = (e + 1) % NumCharNormPrefetch;
+      return Entry;
+    }
+  }
+  return NULL;
+}                                /* FindCharNormPrefetch */
+
+
+/*---------------------------------------------------------------------------*/
+/**
+ * This routine releases the results saved by
+ * PrefetchCharNormMatches.
+ *
+ * Globals:
+ * - CharNormPrefetch batch results
+ */
+void FreeCharNormPrefetch() {
+  for (int i = 0; i < NumCharNormPrefetch; ++i)
+    Efree(CharNormPrefetch[i].Results);
+  if (CharNormPrefetch != NULL)
+    Efree(CharNormPrefetch);
+  CharNormPrefetch = NULL;
+  CharNormPrefetchTemplates = NULL;
+  NumCharNormPrefetch = 0;
+  NextCharNormPrefetch = 0;
+}                                /* FreeCharNormPrefetch */
+
+
+/*---------------------------------------------------------------------------*/
+/**
+ * qsort comparison function which orders integer matcher
+ * batch items by class, then by position in the batch.
+ */
+int CompareIMBatchItems(const void *arg1, const void *arg2) {
+  const IM_BATCH_ITEM *Item1 = (const IM_BATCH_ITEM *) arg1;
+  const IM_BATCH_ITEM *Item2 = (const IM_BATCH_ITEM *) arg2;
+
+  if (Item1->Class != Item2->Class)
+    return Item1->Class - Item2->Class;
+  if (Item1->Entry != Item2->Entry)
+    return Item1->Entry - Item2->Entry;
+  return Item1->Result - Item2->Result;
+}                                /* CompareIMBatchItems */
+
+namespace tesseract {
+
+
 /*---------------------------------------------------------------------------*/
 /**
  * This routine computes a rating which reflects the
@@ -1844,12 +2252,12 @@ UNICHAR_ID *Classify::GetAmbiguities(TBLOB *Blob,
  * @note Exceptions: none
  * @note History: Tue Mar 12 17:55:18 1991, DSJ, Created.
  */
-int GetBaselineFeatures(TBLOB *Blob,
-                        LINE_STATS *LineStats,
-                        INT_TEMPLATES Templates,
-                        INT_FEATURE_ARRAY IntFeatures,
-                        CLASS_NORMALIZATION_ARRAY CharNormArray,
-                        inT32 *BlobLength) {
+int Classify::GetBaselineFeatures(TBLOB *Blob,
+                                  LINE_STATS *LineStats,
+                                  INT_TEMPLATES Templates,
+                                  INT_FEATURE_ARRAY IntFeatures,
+                                  CLASS_NORMALIZATION_ARRAY CharNormArray,
+                                  inT32 *BlobLength) {
   FEATURE_SET Features;
   int NumFeatures;
 
@@ -2004,17 +2412,17 @@ int Classify::GetCharNormFeatures(TBLOB *Blob,
  * @note Exceptions: none
  * @note History: Tue May 28 10:40:52 1991, DSJ, Created.
  */
-int GetIntBaselineFeatures(TBLOB *Blob,
-                           LINE_STATS *LineStats,
-                           INT_TEMPLATES Templates,
-                           INT_FEATURE_ARRAY IntFeatures,
-                           CLASS_NORMALIZATION_ARRAY CharNormArray,
-                           inT32 *BlobLength) {
+int Classify::GetIntBaselineFeatures(TBLOB *Blob,
+                                     LINE_STATS *LineStats,
+                                     INT_TEMPLATES Templates,
+                                     INT_FEATURE_ARRAY IntFeatures,
+                                     CLASS_NORMALIZATION_ARRAY CharNormArray,
+                                     inT32 *BlobLength) {
   register INT_FEATURE Src, Dest, End;
 
   if (!FeaturesHaveBeenExtracted) {
-    FeaturesOK = ExtractIntFeat (Blob, BaselineFeatures,
-                                 CharNormFeatures, &FXInfo);
+    FeaturesOK = ExtractIntFeatCached (Blob, BaselineFeatures,
+                                 CharNormFeatures, &FXInfo, &feature_cache_);
     FeaturesHaveBeenExtracted = TRUE;
   }
 
@@ -2072,8 +2480,8 @@ int Classify::GetIntCharNormFeatures(TBLOB *Blob,
   FLOAT32 Baseline, Scale;
 
   if (!FeaturesHaveBeenExtracted) {
-    FeaturesOK = ExtractIntFeat(Blob, BaselineFeatures,
-                                CharNormFeatures, &FXInfo);
+    FeaturesOK = ExtractIntFeatCached(Blob, BaselineFeatures,
+                                CharNormFeatures, &FXInfo, &feature_cache_);
     FeaturesHaveBeenExtracted = TRUE;
   }
 
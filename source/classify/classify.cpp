@@ -68,6 +68,7 @@ Classify::Classify()
   fontset_table_.set_clear_callback(
       NewPermanentCallback(delete_callback_fs));
   AdaptedTemplates = NULL;
+  ResetAdaptedClassUse();
   PreTrainedTemplates = NULL;
   inttemp_loaded_ = false;
   AllProtosOn = NULL;
@@ -77,6 +78,7 @@ Classify::Classify()
   AllConfigsOff = NULL;
   TempProtoMask = NULL;
   NormProtos = NULL;
+  InitIntFeatureCache(&feature_cache_);
 }
 
 Classify::~Classify() {
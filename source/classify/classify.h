@@ -24,6 +24,7 @@
 #include "classify.h"
 #include "dict.h"
 #include "fxdefs.h"
+#include "intfx.h"
 #include "intmatcher.h"
 #include "ratngs.h"
 #include "ocrfeatures.h"
@@ -50,11 +51,25 @@ class Classify : public CCStruct {
                             CLASS_CUTOFF_ARRAY ExpectedNumFeatures,
                             CLASS_PRUNER_RESULTS Results,
                             int Debug);
+  int ClassPrunerBatch(INT_TEMPLATES IntTemplates,
+                       int NumBlobs,
+                       CP_BATCH_ENTRY *Blobs,
+                       CLASS_CUTOFF_ARRAY ExpectedNumFeatures,
+                       int Debug);
+  int PruneClassCounts(INT_TEMPLATES IntTemplates,
+                       inT16 NumFeatures,
+                       INT_FEATURE_ARRAY Features,
+                       CLASS_NORMALIZATION_ARRAY NormalizationFactors,
+                       CLASS_CUTOFF_ARRAY ExpectedNumFeatures,
+                       int ClassCount[],
+                       CLASS_PRUNER_RESULTS Results);
   void ReadNewCutoffs(FILE *CutoffFile, inT64 end_offset,
                       CLASS_CUTOFF_ARRAY Cutoffs);
   void PrintAdaptedTemplates(FILE *File, ADAPT_TEMPLATES Templates);
   void WriteAdaptedTemplates(FILE *File, ADAPT_TEMPLATES Templates);
   ADAPT_TEMPLATES ReadAdaptedTemplates(FILE *File);
+  bool WriteCompactAdaptedTemplates(FILE *File, ADAPT_TEMPLATES Templates);
+  ADAPT_TEMPLATES ReadCompactAdaptedTemplates(FILE *File);
   /* normmatch.cpp ************************************************************/
   FLOAT32 ComputeNormMatch(CLASS_ID ClassId, FEATURE Feature, BOOL8 DebugMatch);
   void FreeNormProtos();
@@ -93,7 +108,8 @@ class Classify : public CCStruct {
                      int debug,
                      int num_classes,
                      CLASS_PRUNER_RESULTS results,
-                     ADAPT_RESULTS* final_results);
+                     ADAPT_RESULTS* final_results,
+                     bool matched);
   void ConvertMatchesToChoices(ADAPT_RESULTS *Results,
                                BLOB_CHOICE_LIST *Choices);
   void AddNewResult(ADAPT_RESULTS *Results,
@@ -137,6 +153,9 @@ class Classify : public CCStruct {
                          LINE_STATS *LineStats,
                          INT_TEMPLATES Templates,
                          ADAPT_RESULTS *Results);
+  void PrefetchCharNormMatches(TBLOB **Blobs,
+                               int NumBlobs,
+                               LINE_STATS *LineStats);
   UNICHAR_ID *GetAmbiguities(TBLOB *Blob,
                              LINE_STATS *LineStats,
                              CLASS_ID CorrectClass);
@@ -159,12 +178,36 @@ class Classify : public CCStruct {
                           TEXTROW *Row,
                           BLOB_CHOICE_LIST *Choices,
                           CLASS_PRUNER_RESULTS cp_results);
+  void AdaptiveClassifierBatch(TBLOB **Blobs,
+                               int NumBlobs,
+                               TEXTROW *Row,
+                               BLOB_CHOICE_LIST **Choices);
   void ClassifyAsNoise(ADAPT_RESULTS *Results);
   void ResetAdaptiveClassifier();
+  void ResetAdaptedClassUse();
+  void ClearFeatureCache() {
+    ClearIntFeatureCache(&feature_cache_);
+  }
+  void LimitAdaptedTemplates(ADAPT_TEMPLATES Templates);
+  void EvictAdaptedClass(ADAPT_TEMPLATES Templates, CLASS_ID ClassId);
+  bool SaveAdaptiveClassifier(FILE *File);
+  bool LoadAdaptiveClassifier(FILE *File);
 
   FLOAT32 GetBestRatingFor(TBLOB *Blob,
                            LINE_STATS *LineStats,
                            CLASS_ID ClassId);
+  int GetBaselineFeatures(TBLOB *Blob,
+                          LINE_STATS *LineStats,
+                          INT_TEMPLATES Templates,
+                          INT_FEATURE_ARRAY IntFeatures,
+                          CLASS_NORMALIZATION_ARRAY CharNormArray,
+                          inT32 *BlobLength);
+  int GetIntBaselineFeatures(TBLOB *Blob,
+                             LINE_STATS *LineStats,
+                             INT_TEMPLATES Templates,
+                             INT_FEATURE_ARRAY IntFeatures,
+                             CLASS_NORMALIZATION_ARRAY CharNormArray,
+                             inT32 *BlobLength);
   int GetCharNormFeatures(TBLOB *Blob,
                           LINE_STATS *LineStats,
                           INT_TEMPLATES Templates,
@@ -201,6 +244,10 @@ class Classify : public CCStruct {
      templates */
   INT_TEMPLATES PreTrainedTemplates;
   ADAPT_TEMPLATES AdaptedTemplates;
+  /* use clock of the adapted classes; a class is used when it is adapted
+     to or is the best match of the baseline classifier */
+  int AdaptedClassLastUsed[MAX_NUM_CLASSES];
+  int AdaptedClassUseClock;
   // Successful load of inttemp allows base tesseract classfier to be used.
   bool inttemp_loaded_;
 
@@ -219,6 +266,9 @@ class Classify : public CCStruct {
   bool EnableLearning;
   /* normmatch.cpp */
   NORM_PROTOS *NormProtos;
+  /* intfx.cpp: features of the blobs of the current page, kept from
+     pass 1 to pass 2. Emptied by ClearFeatureCache when the page is done. */
+  INT_FEATURE_CACHE_STRUCT feature_cache_;
   /* font detection ***********************************************************/
   UnicityTable<FontInfo> fontinfo_table_;
   UnicityTable<FontSet> fontset_table_;
@@ -22,6 +22,7 @@
 #include "tprintf.h"
 #include "danerror.h"
 #include "freelist.h"
+#include "ccutil.h"
 #include <math.h>
 
 #define HOTELLING 1  // If true use Hotelling's test to decide where to split.
@@ -211,13 +212,6 @@ typedef FLOAT64 (*SOLVEFUNC) (CHISTRUCT *, double);
 #define Abs(N) ( ( (N) < 0 ) ? ( -(N) ) : (N) )
 
 //--------------Global Data Definitions and Declarations----------------------
-/* the following variables are declared as global so that routines which
-are called from the kd-tree walker can get to them. */
-static HEAP *Heap;
-static TEMPCLUSTER *TempCluster;
-static KDTREE *Tree;
-static inT32 CurrentTemp;
-
 /* the following variables describe a discrete normal distribution
   which is used by NormalDensity() and NormalBucket().  The
   constant NORMALEXTENT determines how many standard
@@ -236,6 +230,10 @@ static FLOAT64 NormalMean = BUCKETTABLESIZE / 2;
 // keep a list of histogram buckets to minimize recomputing them
 static LIST OldBuckets[] = { NIL, NIL, NIL };
 
+/* guards OldBuckets and the cache of chi-squared values, so that
+  different clusterers can be used from different threads at once */
+static tesseract::CCUtilMutex CacheMutex;
+
 /* define lookup tables used to compute the number of histogram buckets
   that should be used for a given number of samples. */
 #define LOOKUPTABLESIZE   8
@@ -252,14 +250,25 @@ static uinT16 BucketsTable[LOOKUPTABLESIZE] = {
 /*-------------------------------------------------------------------------
           Private Function Prototypes
 --------------------------------------------------------------------------*/
-void CreateClusterTree(CLUSTERER *Clusterer);
+void CreateClusterTree(CLUSTERER *Clusterer, CLUSTERCONFIG *Config);
+
+CLUSTER **RebuildKDTree(CLUSTERER *Clusterer, inT32 *NumClusters);
 
-void MakePotentialClusters(CLUSTER *Cluster, VISIT Order, inT32 Level);
+void MakeClusterChains(CLUSTERER *Clusterer);
+
+void CollectSample(CLUSTER ***Next, CLUSTER *Cluster, VISIT Order,
+                   inT32 Level);
 
 CLUSTER *FindNearestNeighbor(KDTREE *Tree,
                              CLUSTER *Cluster,
                              FLOAT32 *Distance);
 
+CLUSTER *NearestOtherNeighbor(CLUSTER *Cluster,
+                              inT32 NumberOfNeighbors,
+                              CLUSTER *Neighbor[],
+                              FLOAT32 Dist[],
+                              FLOAT32 *Distance);
+
 CLUSTER *MakeNewCluster(CLUSTERER *Clusterer, TEMPCLUSTER *TempCluster);
 
 inT32 MergeClusters (inT16 N,
@@ -519,7 +528,7 @@ History:	5/29/89, DSJ, Created.
 LIST ClusterSamples(CLUSTERER *Clusterer, CLUSTERCONFIG *Config) {
   //only create cluster tree if samples have never been clustered before
   if (Clusterer->Root == NULL)
-    CreateClusterTree(Clusterer);
+    CreateClusterTree(Clusterer, Config);
 
   //deallocate the old prototype list if one exists
   FreeProtoList (&Clusterer->ProtoList);
@@ -693,10 +702,8 @@ FLOAT32 StandardDeviation(PROTOTYPE *Proto, uinT16 Dimension) {
 ----------------------------------------------------------------------------*/
 /** CreateClusterTree *******************************************************
 Parameters:	Clusterer	data structure holdings samples to be clustered
-Globals:	Tree		kd-tree holding samples
-      TempCluster	array of temporary clusters
-      CurrentTemp	index of next temp cluster to be used
-      Heap		heap used to hold temp clusters - "best" on top
+      Config		parameters which control the clustering
+Globals:	None
 Operation:	This routine performs a bottoms-up clustering on the samples
       held in the kd-tree of the Clusterer data structure.  The
       result is a cluster tree.  Each node in the tree represents
@@ -706,16 +713,52 @@ Operation:	This routine performs a bottoms-up clustering on the samples
       tree are the individual samples themselves; they have no
       sub-clusters.  The root node of the tree conceptually contains
       all of the samples.
+        Before clustering, the kd-tree is rebuilt balanced around
+      the samples, and the nearest neighbors of all the samples
+      are found in one batch.  The closest pair of clusters is
+      always merged first, unless Config asks for the nn_chain
+      style, in which case MakeClusterChains builds the tree.
 Return:		None (the Clusterer data structure is changed)
 Exceptions:	None
 History:	5/29/89, DSJ, Created.
 ******************************************************************************/
-void CreateClusterTree(CLUSTERER *Clusterer) {
+void CreateClusterTree(CLUSTERER *Clusterer, CLUSTERCONFIG *Config)
+#define MAXNEIGHBORS  2
+#define MAXDISTANCE   MAX_FLOAT32
+{
+  HEAP *Heap;
   HEAPENTRY HeapEntry;
+  TEMPCLUSTER *TempCluster;
   TEMPCLUSTER *PotentialCluster;
+  inT32 CurrentTemp;
+  inT32 NumSamples;
+  CLUSTER **Samples;
+  FLOAT32 **Keys;
+  CLUSTER **Neighbors;
+  FLOAT32 *Dist;
+  int *NumFound;
+  KDTREE *Tree;
+  inT32 i;
 
-  // save the kd-tree in a global variable so kd-tree walker can get at it
+  if (Config->ClusterStyle == nn_chain) {
+    MakeClusterChains(Clusterer);
+    return;
+  }
+
+  // replace the kd-tree with a balanced one holding the same samples
+  Samples = RebuildKDTree (Clusterer, &NumSamples);
   Tree = Clusterer->KDTree;
+  Keys = (FLOAT32 **) Emalloc (NumSamples * sizeof (FLOAT32 *));
+  for (i = 0; i < NumSamples; i++)
+    Keys[i] = Samples[i]->Mean;
+
+  // find the 2 nearest neighbors of every sample at once
+  Neighbors = (CLUSTER **)
+    Emalloc (NumSamples * MAXNEIGHBORS * sizeof (CLUSTER *));
+  Dist = (FLOAT32 *) Emalloc (NumSamples * MAXNEIGHBORS * sizeof (FLOAT32));
+  NumFound = (int *) Emalloc (NumSamples * sizeof (int));
+  KDNearestNeighborBatch (Tree, NumSamples, Keys, MAXNEIGHBORS, MAXDISTANCE,
+    Neighbors, Dist, NumFound);
 
   // allocate memory to to hold all of the "potential" clusters
   TempCluster = (TEMPCLUSTER *)
@@ -725,7 +768,23 @@ void CreateClusterTree(CLUSTERER *Clusterer) {
   // each sample and its nearest neighbor form a "potential" cluster
   // save these in a heap with the "best" potential clusters on top
   Heap = MakeHeap (Clusterer->NumberOfSamples);
-  KDWalk (Tree, (void_proc) MakePotentialClusters);
+  for (i = 0; i < NumSamples; i++) {
+    TempCluster[CurrentTemp].Cluster = Samples[i];
+    HeapEntry.Data = (char *) &(TempCluster[CurrentTemp]);
+    TempCluster[CurrentTemp].Neighbor =
+      NearestOtherNeighbor (Samples[i], NumFound[i],
+      Neighbors + i * MAXNEIGHBORS, Dist + i * MAXNEIGHBORS,
+      &(HeapEntry.Key));
+    if (TempCluster[CurrentTemp].Neighbor != NULL) {
+      HeapStore(Heap, &HeapEntry);
+      CurrentTemp++;
+    }
+  }
+  memfree(NumFound);
+  memfree(Dist);
+  memfree(Neighbors);
+  memfree(Keys);
+  memfree(Samples);
 
   // form potential clusters into actual clusters - always do "best" first
   while (GetTopOfHeap (Heap, &HeapEntry) != EMPTY) {
@@ -772,38 +831,150 @@ void CreateClusterTree(CLUSTERER *Clusterer) {
 }                                // CreateClusterTree
 
 
-/** MakePotentialClusters **************************************************
-Parameters:	Cluster	current cluster being visited in kd-tree walk
+/** RebuildKDTree ************************************************************
+Parameters:	Clusterer	data structure holding the clusters
+      NumClusters	ptr to variable to report the number of clusters
+Globals:	None
+Operation:	This routine replaces the kd-tree of Clusterer with a
+      balanced one which holds the same clusters.  The clusters
+      are returned in the order of a walk of the old kd-tree.
+Return:		Array of the clusters in the kd-tree (to be freed by caller)
+Exceptions:	None
+******************************************************************************/
+CLUSTER **RebuildKDTree(CLUSTERER *Clusterer, inT32 *NumClusters) {
+  CLUSTER **Clusters;
+  CLUSTER **NextCluster;
+  FLOAT32 **Keys;
+  KDTREE *Tree;
+  inT32 i;
+
+  Clusters = (CLUSTER **)
+    Emalloc (Clusterer->NumberOfSamples * sizeof (CLUSTER *));
+  NextCluster = Clusters;
+  KDWalk (Clusterer->KDTree, (void_proc) CollectSample, &NextCluster);
+  *NumClusters = NextCluster - Clusters;
+  Keys = (FLOAT32 **) Emalloc (*NumClusters * sizeof (FLOAT32 *));
+  for (i = 0; i < *NumClusters; i++)
+    Keys[i] = Clusters[i]->Mean;
+  Tree = MakeKDTreeFromKeys (Clusterer->SampleSize, Clusterer->ParamDesc,
+    *NumClusters, Keys, (void **) Clusters);
+  FreeKDTree (Clusterer->KDTree);
+  Clusterer->KDTree = Tree;
+  memfree(Keys);
+  return (Clusters);
+}                                // RebuildKDTree
+
+
+/** MakeClusterChains ********************************************************
+Parameters:	Clusterer	data structure holdings samples to be clustered
+Globals:	None
+Operation:	This routine builds the cluster tree with the nearest
+      neighbor chain algorithm.  A chain of clusters is grown,
+      each one the nearest neighbor of the one before it, until
+      the last two clusters are each other's nearest neighbors.
+      These two are then merged and the chain is continued from
+      the cluster before them.  Only reciprocal nearest neighbors
+      are ever merged, so the tree is much the same as the one
+      made by always merging the closest pair, but no heap of
+      potential clusters is needed and no search is wasted on
+      clusters which have since been merged.
+        Merged clusters are added to the kd-tree at its leaves,
+      so the kd-tree is rebuilt balanced each time the number of
+      clusters in it halves.
+Return:		None (the Clusterer data structure is changed)
+Exceptions:	None
+******************************************************************************/
+void MakeClusterChains(CLUSTERER *Clusterer) {
+  CLUSTER **Clusters;
+  CLUSTER **Chain;
+  FLOAT32 *ChainDist;
+  inT32 ChainLength;
+  inT32 NumClusters;
+  inT32 NextRebuild;
+  TEMPCLUSTER Pair;
+  CLUSTER *NewCluster;
+  CLUSTER *Neighbor;
+  FLOAT32 Distance;
+  inT32 i;
+
+  Clusters = RebuildKDTree (Clusterer, &NumClusters);
+  if (NumClusters == 0) {
+    memfree(Clusters);
+    return;
+  }
+  NextRebuild = NumClusters / 2;
+
+  // ChainDist[i] is the distance from Chain[i - 1] to Chain[i]
+  Chain = (CLUSTER **) Emalloc (NumClusters * sizeof (CLUSTER *));
+  ChainDist = (FLOAT32 *) Emalloc (NumClusters * sizeof (FLOAT32));
+  Chain[0] = Clusters[0];
+  ChainLength = 1;
+  memfree(Clusters);
+
+  while (NumClusters > 1) {
+    Neighbor = FindNearestNeighbor (Clusterer->KDTree,
+      Chain[ChainLength - 1], &Distance);
+
+    // prefer the cluster before in the chain when tied, so that
+    // the distances along the chain always decrease
+    if (ChainLength > 1 && ChainDist[ChainLength - 1] <= Distance)
+      Neighbor = Chain[ChainLength - 2];
+
+    if (ChainLength > 1 && Neighbor == Chain[ChainLength - 2]) {
+      // reciprocal nearest neighbors - merge them and carry on from
+      // the rest of the chain, or from the new cluster if none is left
+      Pair.Cluster = Chain[ChainLength - 1];
+      Pair.Neighbor = Neighbor;
+      NewCluster = MakeNewCluster(Clusterer, &Pair);
+      NumClusters--;
+      ChainLength -= 2;
+      if (ChainLength == 0)
+        Chain[ChainLength++] = NewCluster;
+      if (NumClusters <= NextRebuild) {
+        memfree (RebuildKDTree (Clusterer, &NumClusters));
+        NextRebuild = NumClusters / 2;
+      }
+    }
+    else {
+      // the nearest neighbor of a merged cluster may be further back
+      // in the chain; if so the chain is cut back to it
+      for (i = ChainLength - 3; i >= 0 && Chain[i] != Neighbor; i--);
+      if (i >= 0) {
+        ChainLength = i + 1;
+      }
+      else {
+        ChainDist[ChainLength] = Distance;
+        Chain[ChainLength++] = Neighbor;
+      }
+    }
+  }
+
+  // the root node in the cluster tree is now the only node in the kd-tree
+  Clusterer->Root = (CLUSTER *) RootOf (Clusterer->KDTree);
+  FreeKDTree(Clusterer->KDTree);
+  Clusterer->KDTree = NULL;
+  memfree(ChainDist);
+  memfree(Chain);
+}                                // MakeClusterChains
+
+
+/** CollectSample ************************************************************
+Parameters:	Next	ptr to the next free slot of an array of clusters
+      Cluster	current cluster being visited in kd-tree walk
       Order	order in which cluster is being visited
       Level	level of this cluster in the kd-tree
-Globals:	Tree		kd-tree to be searched for neighbors
-      TempCluster	array of temporary clusters
-      CurrentTemp	index of next temp cluster to be used
-      Heap		heap used to hold temp clusters - "best" on top
+Globals:	None
 Operation:	This routine is designed to be used in concert with the
-      KDWalk routine.  It will create a potential cluster for
-      each sample in the kd-tree that is being walked.  This
-      potential cluster will then be pushed on the heap.
+      KDWalk routine.  It appends each cluster in the kd-tree
+      that is being walked to the array that Next points into.
 Return:		none
 Exceptions: none
-History:	5/29/89, DSJ, Created.
-      7/13/89, DSJ, Removed visibility of kd-tree node data struct.
 ******************************************************************************/
-void MakePotentialClusters(CLUSTER *Cluster, VISIT Order, inT32 Level) {
-  HEAPENTRY HeapEntry;
-
-  if ((Order == preorder) || (Order == leaf)) {
-    TempCluster[CurrentTemp].Cluster = Cluster;
-    HeapEntry.Data = (char *) &(TempCluster[CurrentTemp]);
-    TempCluster[CurrentTemp].Neighbor =
-      FindNearestNeighbor (Tree, TempCluster[CurrentTemp].Cluster,
-      &(HeapEntry.Key));
-    if (TempCluster[CurrentTemp].Neighbor != NULL) {
-      HeapStore(Heap, &HeapEntry);
-      CurrentTemp++;
-    }
-  }
-}                                // MakePotentialClusters
+void CollectSample(CLUSTER ***Next, CLUSTER *Cluster, VISIT Order,
+                   inT32 Level) {
+  if ((Order == preorder) || (Order == leaf))
+    *(*Next)++ = Cluster;
+}                                // CollectSample
 
 
 /** FindNearestNeighbor *********************************************************
@@ -824,20 +995,40 @@ History:	5/29/89, DSJ, Created.
       7/13/89, DSJ, Removed visibility of kd-tree node data struct
 ********************************************************************************/
 CLUSTER *
-FindNearestNeighbor (KDTREE * Tree, CLUSTER * Cluster, FLOAT32 * Distance)
-#define MAXNEIGHBORS  2
-#define MAXDISTANCE   MAX_FLOAT32
-{
+FindNearestNeighbor (KDTREE * Tree, CLUSTER * Cluster, FLOAT32 * Distance) {
   CLUSTER *Neighbor[MAXNEIGHBORS];
   FLOAT32 Dist[MAXNEIGHBORS];
   inT32 NumberOfNeighbors;
-  inT32 i;
-  CLUSTER *BestNeighbor;
 
   // find the 2 nearest neighbors of the cluster
   NumberOfNeighbors = KDNearestNeighborSearch
     (Tree, Cluster->Mean, MAXNEIGHBORS, MAXDISTANCE, Neighbor, Dist);
 
+  return (NearestOtherNeighbor (Cluster, NumberOfNeighbors, Neighbor, Dist,
+    Distance));
+}                                // FindNearestNeighbor
+
+
+/** NearestOtherNeighbor *****************************************************
+Parameters:	Cluster		cluster whose nearest neighbor is wanted
+      NumberOfNeighbors	number of neighbors found for Cluster
+      Neighbor	neighbors found by a kd-tree search for Cluster
+      Dist		distances of the neighbors from Cluster
+      Distance	ptr to variable to report distance found
+Globals:	none
+Operation:	This routine picks the nearest of the neighbors found for
+      Cluster that is not Cluster itself.
+Return:		Pointer to the nearest neighbor of Cluster, or NULL
+Exceptions: none
+********************************************************************************/
+CLUSTER *NearestOtherNeighbor(CLUSTER *Cluster,
+                              inT32 NumberOfNeighbors,
+                              CLUSTER *Neighbor[],
+                              FLOAT32 Dist[],
+                              FLOAT32 *Distance) {
+  inT32 i;
+  CLUSTER *BestNeighbor;
+
   // search for the nearest neighbor that is not the cluster itself
   *Distance = MAXDISTANCE;
   BestNeighbor = NULL;
@@ -848,7 +1039,7 @@ FindNearestNeighbor (KDTREE * Tree, CLUSTER * Cluster, FLOAT32 * Distance)
     }
   }
   return (BestNeighbor);
-}                                // FindNearestNeighbor
+}                                // NearestOtherNeighbor
 
 
 /** MakeNewCluster *************************************************************
@@ -1759,13 +1950,17 @@ BUCKETS *GetBuckets(DISTRIBUTION Distribution,
 
   // search for an old bucket structure with the same number of buckets
   NumberOfBuckets = OptimumNumberOfBuckets (SampleCount);
+  CacheMutex.Lock();
   Buckets = (BUCKETS *) first_node (search (OldBuckets[(int) Distribution],
     &NumberOfBuckets, NumBucketsMatch));
 
   // if a matching bucket structure is found, delete it from the list
-  if (Buckets != NULL) {
+  if (Buckets != NULL)
     OldBuckets[(int) Distribution] =
       delete_d (OldBuckets[(int) Distribution], Buckets, ListEntryMatch);
+  CacheMutex.Unlock();
+
+  if (Buckets != NULL) {
     if (SampleCount != Buckets->SampleCount)
       AdjustBuckets(Buckets, SampleCount);
     if (Confidence != Buckets->Confidence) {
@@ -1972,16 +2167,20 @@ ComputeChiSquared (uinT16 DegreesOfFreedom, FLOAT64 Alpha)
      for the specified number of degrees of freedom.  Search the list for
      the desired chi-squared. */
   SearchKey.Alpha = Alpha;
+  CacheMutex.Lock();
   OldChiSquared = (CHISTRUCT *) first_node (search (ChiWith[DegreesOfFreedom],
     &SearchKey, AlphaMatch));
+  CacheMutex.Unlock();
 
   if (OldChiSquared == NULL) {
     OldChiSquared = NewChiStruct (DegreesOfFreedom, Alpha);
     OldChiSquared->ChiSquared = Solve (ChiArea, OldChiSquared,
       (FLOAT64) DegreesOfFreedom,
       (FLOAT64) CHIACCURACY);
+    CacheMutex.Lock();
     ChiWith[DegreesOfFreedom] = push (ChiWith[DegreesOfFreedom],
       OldChiSquared);
+    CacheMutex.Unlock();
   }
   else {
     // further optimization might move OldChiSquared to front of list
@@ -2336,7 +2535,9 @@ void FreeBuckets(BUCKETS *Buckets) {
 
   if (Buckets != NULL) {
     Dist = (int) Buckets->Distribution;
+    CacheMutex.Lock();
     OldBuckets[Dist] = (LIST) push (OldBuckets[Dist], Buckets);
+    CacheMutex.Unlock();
   }
 
 }                                // FreeBuckets
@@ -2690,8 +2891,7 @@ CLUSTER * Cluster, FLOAT32 MaxIllegal)
  */
 #define ILLEGAL_CHAR    2
 {
-  static BOOL8 *CharFlags = NULL;
-  static inT32 NumFlags = 0;
+  BOOL8 *CharFlags;
   int i;
   LIST SearchState;
   SAMPLE *Sample;
@@ -2704,14 +2904,8 @@ CLUSTER * Cluster, FLOAT32 MaxIllegal)
   NumCharInCluster = Cluster->SampleCount;
   NumIllegalInCluster = 0;
 
-  if (Clusterer->NumChar > NumFlags) {
-    if (CharFlags != NULL)
-      memfree(CharFlags);
-    NumFlags = Clusterer->NumChar;
-    CharFlags = (BOOL8 *) Emalloc (NumFlags * sizeof (BOOL8));
-  }
-
-  for (i = 0; i < NumFlags; i++)
+  CharFlags = (BOOL8 *) Emalloc (Clusterer->NumChar * sizeof (BOOL8));
+  for (i = 0; i < Clusterer->NumChar; i++)
     CharFlags[i] = FALSE;
 
   // find each sample in the cluster and check if we have seen it before
@@ -2728,10 +2922,13 @@ CLUSTER * Cluster, FLOAT32 MaxIllegal)
       }
       NumCharInCluster--;
       PercentIllegal = (FLOAT32) NumIllegalInCluster / NumCharInCluster;
-      if (PercentIllegal > MaxIllegal)
+      if (PercentIllegal > MaxIllegal) {
+        memfree(CharFlags);
         return (TRUE);
+      }
     }
   }
+  memfree(CharFlags);
   return (FALSE);
 
 }                                // MultipleCharSamples
@@ -47,6 +47,13 @@ typedef enum {
 
 PROTOSTYLE;
 
+typedef enum {
+  best_first, nn_chain
+}
+
+
+CLUSTERSTYLE;
+
 typedef struct                   // parameters to control clustering
 {
   PROTOSTYLE ProtoStyle;         // specifies types of protos to be made
@@ -56,6 +63,7 @@ typedef struct                   // parameters to control clustering
   FLOAT32 Independence;          // desired independence between dimensions
   FLOAT64 Confidence;            // desired confidence in prototypes created
   int MagicSamples;              // Ideal number of samples in a cluster.
+  CLUSTERSTYLE ClusterStyle;     // how the samples are formed into a tree
 }
 
 
@@ -21,6 +21,7 @@
 #include "intfx.h"
 #include "intmatcher.h"
 #include "const.h"
+#include "tprintf.h"
 #ifdef __UNIX__
 #endif
 
@@ -44,13 +45,44 @@ INT_VAR(classify_radius_gyr_max_man, 158,
 INT_VAR(classify_radius_gyr_max_exp, 8,
         "Maximum Radius of Gyration Exponent 0-255:        ");
 
+INT_VAR(classify_feature_cache_size, 256,
+        "Number of blobs whose integer features are kept for reuse"
+        " (0 disables the feature cache)");
+
+BOOL_VAR(classify_feature_cache_stats, 0,
+         "Print feature cache statistics at the end of the run");
+
 /**----------------------------------------------------------------------------
         Global Data Definitions and Declarations
 ----------------------------------------------------------------------------**/
 #define  ATAN_TABLE_SIZE    64
 
+/* Outline segment that produces baseline normalized features. */
+typedef struct
+{
+  inT16 StartX, StartY;          /* start of the segment (not normalized) */
+  inT32 DeltaX, DeltaY;
+  uinT16 NumFeatures;            /* number of features along the segment */
+  uinT8 Theta;
+} FX_SEGMENT;
+
 static uinT8 AtanTable[ATAN_TABLE_SIZE];
 
+/* Features extracted from one blob, kept by ExtractIntFeatCached. */
+struct FX_CACHE_ENTRY
+{
+  BOOL8 Valid;
+  uinT32 Hash;
+  GenericVector<FX_POINT> Points;
+  GenericVector<int> OutlineEnds;
+  int Result;
+  INT_FX_RESULT_STRUCT Results;
+  INT_FEATURE_ARRAY BLFeat;
+  INT_FEATURE_ARRAY CNFeat;
+};
+
+static void ResizeIntFeatureCache(INT_FEATURE_CACHE Cache, int Size);
+
 /**----------------------------------------------------------------------------
             Public Code
 ----------------------------------------------------------------------------**/
@@ -70,15 +102,231 @@ int ExtractIntFeat(TBLOB *Blob,
                    INT_FEATURE_ARRAY BLFeat,
                    INT_FEATURE_ARRAY CNFeat,
                    INT_FX_RESULT Results) {
+  GenericVector<FX_POINT> Points;
+  GenericVector<int> OutlineEnds;
+
+  memset(Results, 0, sizeof(*Results));
+  if (!CopyOutlines (Blob, &Points, &OutlineEnds))
+    return FALSE;
+  return ExtractPointFeat (Points, OutlineEnds, BLFeat, CNFeat, Results);
+}
+
+
+/*--------------------------------------------------------------------------*/
+static BOOL8 SameOutlines(const FX_CACHE_ENTRY *Entry,
+                          const GenericVector<FX_POINT> &Points,
+                          const GenericVector<int> &OutlineEnds) {
+  int i;
+
+  if (Entry->Points.size () != Points.size () ||
+    Entry->OutlineEnds.size () != OutlineEnds.size ())
+    return FALSE;
+  for (i = 0; i < OutlineEnds.size (); i++) {
+    if (Entry->OutlineEnds[i] != OutlineEnds[i])
+      return FALSE;
+  }
+  for (i = 0; i < Points.size (); i++) {
+    if (Entry->Points[i].X != Points[i].X ||
+      Entry->Points[i].Y != Points[i].Y ||
+      Entry->Points[i].Hidden != Points[i].Hidden)
+      return FALSE;
+  }
+  return TRUE;
+}
+
+
+/*--------------------------------------------------------------------------*/
+int ExtractIntFeatCached(TBLOB *Blob,
+                         INT_FEATURE_ARRAY BLFeat,
+                         INT_FEATURE_ARRAY CNFeat,
+                         INT_FX_RESULT Results,
+                         INT_FEATURE_CACHE Cache) {
+/*
+ ** Same as ExtractIntFeat, but the features of the last blobs are kept
+ ** in Cache, keyed on their outline points (which are already
+ ** normalized), so a blob that is classified several times while its
+ ** word is recognized (by the different classifiers, in the segmentation
+ ** search and by adaptation) only goes through the feature extractor
+ ** once. Entries are only reused when the outlines are identical, so
+ ** the cache can be kept for a whole page, letting pass 2 reuse the
+ ** features of pass 1. It is emptied by ClearIntFeatureCache.
+ */
+  GenericVector<FX_POINT> Points;
+  GenericVector<int> OutlineEnds;
+  uinT32 Hash;
+  int i, Result;
+  FX_CACHE_ENTRY *Entry;
+
+  memset(Results, 0, sizeof(*Results));
+  if (!CopyOutlines (Blob, &Points, &OutlineEnds))
+    return FALSE;
+
+  if (Cache == NULL)
+    return ExtractPointFeat (Points, OutlineEnds, BLFeat, CNFeat, Results);
+  if (Cache->Size != classify_feature_cache_size ||
+      Cache->RadiusLimits[0] != classify_radius_gyr_min_man ||
+      Cache->RadiusLimits[1] != classify_radius_gyr_min_exp ||
+      Cache->RadiusLimits[2] != classify_radius_gyr_max_man ||
+      Cache->RadiusLimits[3] != classify_radius_gyr_max_exp) {
+    ResizeIntFeatureCache(Cache, classify_feature_cache_size);
+  }
+  if (Cache->Size <= 0)
+    return ExtractPointFeat (Points, OutlineEnds, BLFeat, CNFeat, Results);
+
+  Hash = OutlineEnds.size ();
+  for (i = 0; i < Points.size (); i++) {
+    Hash = Hash * 31 + (uinT16) Points[i].X;
+    Hash = Hash * 31 + (uinT16) Points[i].Y;
+    Hash = Hash * 2 + Points[i].Hidden;
+  }
+  Entry = &Cache->Entries[Hash % Cache->Size];
+  Cache->Lookups++;
+  if (Entry->Valid && Entry->Hash == Hash &&
+      SameOutlines (Entry, Points, OutlineEnds)) {
+    Cache->Hits++;
+    *Results = Entry->Results;
+    memcpy (BLFeat, Entry->BLFeat,
+      Results->NumBL * sizeof (INT_FEATURE_STRUCT));
+    memcpy (CNFeat, Entry->CNFeat,
+      Results->NumCN * sizeof (INT_FEATURE_STRUCT));
+    return Entry->Result;
+  }
+
+  Result = ExtractPointFeat (Points, OutlineEnds, BLFeat, CNFeat, Results);
+  Entry->Valid = TRUE;
+  Entry->Hash = Hash;
+  Entry->Points.move (&Points);
+  Entry->OutlineEnds.move (&OutlineEnds);
+  Entry->Result = Result;
+  Entry->Results = *Results;
+  memcpy (Entry->BLFeat, BLFeat, Results->NumBL * sizeof (INT_FEATURE_STRUCT));
+  memcpy (Entry->CNFeat, CNFeat, Results->NumCN * sizeof (INT_FEATURE_STRUCT));
+  return Result;
+}
 
+
+/*--------------------------------------------------------------------------*/
+static void ResizeIntFeatureCache(INT_FEATURE_CACHE Cache, int Size) {
+/*
+ ** Empties Cache and makes room for Size blobs in it (Size = 0 frees
+ ** the entries).
+ */
+  delete[] Cache->Entries;
+  Cache->Entries = NULL;
+  Cache->Size = 0;
+  if (Size > 0) {
+    Cache->Entries = new FX_CACHE_ENTRY[Size];
+    for (int i = 0; i < Size; i++)
+      Cache->Entries[i].Valid = FALSE;
+    Cache->Size = Size;
+  }
+  Cache->RadiusLimits[0] = classify_radius_gyr_min_man;
+  Cache->RadiusLimits[1] = classify_radius_gyr_min_exp;
+  Cache->RadiusLimits[2] = classify_radius_gyr_max_man;
+  Cache->RadiusLimits[3] = classify_radius_gyr_max_exp;
+}
+
+
+/*--------------------------------------------------------------------------*/
+void InitIntFeatureCache(INT_FEATURE_CACHE Cache) {
+/*
+ ** Makes Cache empty. Its entries are allocated on first use.
+ */
+  Cache->Entries = NULL;
+  Cache->Size = 0;
+  Cache->Lookups = 0;
+  Cache->Hits = 0;
+  for (int i = 0; i < 4; i++)
+    Cache->RadiusLimits[i] = 0;
+}
+
+
+/*--------------------------------------------------------------------------*/
+void ClearIntFeatureCache(INT_FEATURE_CACHE Cache) {
+/*
+ ** Forgets the features of all the blobs in Cache, keeping its entries
+ ** and statistics, so none outlive the word they were extracted for.
+ */
+  for (int i = 0; i < Cache->Size; i++)
+    Cache->Entries[i].Valid = FALSE;
+}
+
+
+/*--------------------------------------------------------------------------*/
+void FreeIntFeatureCache(INT_FEATURE_CACHE Cache) {
+/*
+ ** Frees the entries of Cache and leaves it empty.
+ */
+  ResizeIntFeatureCache(Cache, 0);
+}
+
+
+/*--------------------------------------------------------------------------*/
+void PrintIntFeatureCacheStats(INT_FEATURE_CACHE Cache) {
+  tprintf("Feature cache: %d lookups, %d hits (%.1f%%)\n",
+          Cache->Lookups, Cache->Hits,
+          Cache->Lookups > 0 ?
+          100.0 * Cache->Hits / Cache->Lookups : 0.0);
+}
+
+
+/*--------------------------------------------------------------------------*/
+int CopyOutlines(TBLOB *Blob,
+                 GenericVector<FX_POINT> *Points,
+                 GenericVector<int> *OutlineEnds) {
+/*
+ ** Copies the points of the outlines of the blob into Points, each loop
+ ** is closed by repeating its first point. OutlineEnds receives the index
+ ** past the last point of each outline. Returns FALSE for bad loops.
+ */
   TESSLINE *OutLine;
-  EDGEPT *Loop, *LoopStart, *Segment;
+  EDGEPT *Loop, *LoopStart;
+  FX_POINT Point;
+
+  for (OutLine = Blob->outlines; OutLine != NULL; OutLine = OutLine->next) {
+    LoopStart = OutLine->loop;
+    Loop = LoopStart;
+    /* Check for bad loops */
+    if ((Loop == NULL) || (Loop->next == NULL) || (Loop->next == LoopStart))
+      return FALSE;
+    do {
+      Point.X = Loop->pos.x;
+      Point.Y = Loop->pos.y;
+      Point.Hidden = is_hidden_edge (Loop) != 0;
+      Points->push_back (Point);
+      Loop = Loop->next;
+    }
+    while (Loop != LoopStart);
+    Point.X = LoopStart->pos.x;
+    Point.Y = LoopStart->pos.y;
+    Point.Hidden = FALSE;
+    Points->push_back (Point);
+    OutlineEnds->push_back (Points->size ());
+  }
+  return TRUE;
+}
+
+
+/*--------------------------------------------------------------------------*/
+int ExtractPointFeat(const GenericVector<FX_POINT> &Points,
+                     const GenericVector<int> &OutlineEnds,
+                     INT_FEATURE_ARRAY BLFeat,
+                     INT_FEATURE_ARRAY CNFeat,
+                     INT_FX_RESULT Results) {
+/*
+ ** Extracts the features of the outline points copied by CopyOutlines.
+ ** The first pass over the points finds the mean and the segments that
+ ** produce baseline features (these do not depend on the mean, since the
+ ** baseline features are only translated by it), the second pass over the
+ ** segments extracts the baseline features and the 2nd moments, and the
+ ** last pass over the points extracts the character normalized features.
+ ** Results must be cleared by the caller.
+ */
   inT16 LastX, LastY, Xmean, Ymean;
   inT32 NormX, NormY, DeltaX, DeltaY;
   inT32 Xsum, Ysum;
   uinT32 Ix, Iy, LengthSum;
   uinT16 n;
-  uinT8 Theta;
   uinT16 NumBLFeatures, NumCNFeatures;
   uinT8 RxInv, RyInv;            /* x.xxxxxxx  *  2^Exp  */
   uinT8 RxExp, RyExp;
@@ -86,38 +334,24 @@ int ExtractIntFeat(TBLOB *Blob,
   register inT32 pfX, pfY, dX, dY;
   uinT16 Length;
   register int i;
+  int p, s, Start, End;
+  FX_SEGMENT Segment;
+  GenericVector<FX_SEGMENT> Segments;
 
-  Results->Length = 0;
-  Results->Xmean = 0;
-  Results->Ymean = 0;
-  Results->Rx = 0;
-  Results->Ry = 0;
-  Results->NumBL = 0;
-  Results->NumCN = 0;
-
-  /* find Xmean, Ymean */
-  NumBLFeatures = 0;
-  NumCNFeatures = 0;
-  OutLine = Blob->outlines;
+  /* find Xmean, Ymean and the segments that make baseline features */
   Xsum = 0;
   Ysum = 0;
   LengthSum = 0;
-  while (OutLine != NULL) {
-    LoopStart = OutLine->loop;
-    Loop = LoopStart;
-    LastX = Loop->pos.x;
-    LastY = Loop->pos.y;
-    /* Check for bad loops */
-    if ((Loop == NULL) || (Loop->next == NULL) || (Loop->next == LoopStart))
-      return FALSE;
-    do {
-      Segment = Loop;
-      Loop = Loop->next;
-      NormX = Loop->pos.x;
-      NormY = Loop->pos.y;
+  for (Start = 0, s = 0; s < OutlineEnds.size (); Start = OutlineEnds[s++]) {
+    End = OutlineEnds[s];
+    LastX = Points[Start].X;
+    LastY = Points[Start].Y;
+    for (p = Start; p + 1 < End; p++) {
+      NormX = Points[p + 1].X;
+      NormY = Points[p + 1].Y;
 
       n = 1;
-      if (!is_hidden_edge (Segment)) {
+      if (!Points[p].Hidden) {
         DeltaX = NormX - LastX;
         DeltaY = NormY - LastY;
         Length = MySqrt (DeltaX, DeltaY);
@@ -126,6 +360,13 @@ int ExtractIntFeat(TBLOB *Blob,
           Xsum += ((LastX << 1) + DeltaX) * (int) Length;
           Ysum += ((LastY << 1) + DeltaY) * (int) Length;
           LengthSum += Length;
+          Segment.StartX = LastX;
+          Segment.StartY = LastY;
+          Segment.DeltaX = DeltaX;
+          Segment.DeltaY = DeltaY;
+          Segment.NumFeatures = n;
+          Segment.Theta = TableLookup (DeltaY, DeltaX);
+          Segments.push_back (Segment);
         }
       }
       if (n != 0) {              /* Throw away a point that is too close */
@@ -133,8 +374,6 @@ int ExtractIntFeat(TBLOB *Blob,
         LastY = NormY;
       }
     }
-    while (Loop != LoopStart);
-    OutLine = OutLine->next;
   }
   if (LengthSum == 0)
     return FALSE;
@@ -150,60 +389,27 @@ int ExtractIntFeat(TBLOB *Blob,
   Ix = 0;
   Iy = 0;
   NumBLFeatures = 0;
-  OutLine = Blob->outlines;
-  while (OutLine != NULL) {
-    LoopStart = OutLine->loop;
-    Loop = LoopStart;
-    LastX = Loop->pos.x - Xmean;
-    LastY = Loop->pos.y;
-    /* Check for bad loops */
-    if ((Loop == NULL) || (Loop->next == NULL) || (Loop->next == LoopStart))
-      return FALSE;
-    do {
-      Segment = Loop;
-      Loop = Loop->next;
-      NormX = Loop->pos.x - Xmean;
-      NormY = Loop->pos.y;
-
-      n = 1;
-      if (!is_hidden_edge (Segment)) {
-        DeltaX = NormX - LastX;
-        DeltaY = NormY - LastY;
-        Length = MySqrt (DeltaX, DeltaY);
-        n = ((Length << 2) + Length + 32) >> 6;
-        if (n != 0) {
-          Theta = TableLookup (DeltaY, DeltaX);
-          dX = (DeltaX << 8) / n;
-          dY = (DeltaY << 8) / n;
-          pfX = (LastX << 8) + (dX >> 1);
-          pfY = (LastY << 8) + (dY >> 1);
-          Ix += ((pfY >> 8) - Ymean) * ((pfY >> 8) - Ymean);
-          Iy += (pfX >> 8) * (pfX >> 8);
-          if (SaveFeature (BLFeat, NumBLFeatures, (inT16) (pfX >> 8),
-            (inT16) ((pfY >> 8) - 128),
-            Theta) == FALSE)
-            return FALSE;
-          NumBLFeatures++;
-          for (i = 1; i < n; i++) {
-            pfX += dX;
-            pfY += dY;
-            Ix += ((pfY >> 8) - Ymean) * ((pfY >> 8) - Ymean);
-            Iy += (pfX >> 8) * (pfX >> 8);
-            if (SaveFeature
-              (BLFeat, NumBLFeatures, (inT16) (pfX >> 8),
-              (inT16) ((pfY >> 8) - 128), Theta) == FALSE)
-              return FALSE;
-            NumBLFeatures++;
-          }
-        }
-      }
-      if (n != 0) {              /* Throw away a point that is too close */
-        LastX = NormX;
-        LastY = NormY;
+  for (s = 0; s < Segments.size (); s++) {
+    const FX_SEGMENT &Seg = Segments[s];
+    n = Seg.NumFeatures;
+    LastX = Seg.StartX - Xmean;
+    dX = (Seg.DeltaX << 8) / n;
+    dY = (Seg.DeltaY << 8) / n;
+    pfX = (LastX << 8) + (dX >> 1);
+    pfY = (Seg.StartY << 8) + (dY >> 1);
+    for (i = 0; i < n; i++) {
+      if (i > 0) {
+        pfX += dX;
+        pfY += dY;
       }
+      Ix += ((pfY >> 8) - Ymean) * ((pfY >> 8) - Ymean);
+      Iy += (pfX >> 8) * (pfX >> 8);
+      if (SaveFeature (BLFeat, NumBLFeatures, (inT16) (pfX >> 8),
+        (inT16) ((pfY >> 8) - 128),
+        Seg.Theta) == FALSE)
+        return FALSE;
+      NumBLFeatures++;
     }
-    while (Loop != LoopStart);
-    OutLine = OutLine->next;
   }
   if (Ix == 0)
     Ix = 1;
@@ -226,33 +432,26 @@ int ExtractIntFeat(TBLOB *Blob,
 
   /* extract character normalized features */
   NumCNFeatures = 0;
-  OutLine = Blob->outlines;
-  while (OutLine != NULL) {
-    LoopStart = OutLine->loop;
-    Loop = LoopStart;
-    LastX = (Loop->pos.x - Xmean) * RyInv;
-    LastY = (Loop->pos.y - Ymean) * RxInv;
+  for (Start = 0, s = 0; s < OutlineEnds.size (); Start = OutlineEnds[s++]) {
+    End = OutlineEnds[s];
+    LastX = (Points[Start].X - Xmean) * RyInv;
+    LastY = (Points[Start].Y - Ymean) * RxInv;
     LastX >>= (inT8) RyExp;
     LastY >>= (inT8) RxExp;
-    /* Check for bad loops */
-    if ((Loop == NULL) || (Loop->next == NULL) || (Loop->next == LoopStart))
-      return FALSE;
-    do {
-      Segment = Loop;
-      Loop = Loop->next;
-      NormX = (Loop->pos.x - Xmean) * RyInv;
-      NormY = (Loop->pos.y - Ymean) * RxInv;
+    for (p = Start; p + 1 < End; p++) {
+      NormX = (Points[p + 1].X - Xmean) * RyInv;
+      NormY = (Points[p + 1].Y - Ymean) * RxInv;
       NormX >>= (inT8) RyExp;
       NormY >>= (inT8) RxExp;
 
       n = 1;
-      if (!is_hidden_edge (Segment)) {
+      if (!Points[p].Hidden) {
         DeltaX = NormX - LastX;
         DeltaY = NormY - LastY;
         Length = MySqrt (DeltaX, DeltaY);
         n = ((Length << 2) + Length + 32) >> 6;
         if (n != 0) {
-          Theta = TableLookup (DeltaY, DeltaX);
+          uinT8 Theta = TableLookup (DeltaY, DeltaX);
           dX = (DeltaX << 8) / n;
           dY = (DeltaY << 8) / n;
           pfX = (LastX << 8) + (dX >> 1);
@@ -277,8 +476,6 @@ int ExtractIntFeat(TBLOB *Blob,
         LastY = NormY;
       }
     }
-    while (Loop != LoopStart);
-    OutLine = OutLine->next;
   }
 
   Results->NumCN = NumCNFeatures;
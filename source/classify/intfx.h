@@ -24,6 +24,8 @@
 #include "tessclas.h"
 #include "hideedge.h"
 #include "intproto.h"
+#include "genericvector.h"
+#include "varable.h"
 #include <math.h>
 
 typedef struct
@@ -37,6 +39,33 @@ typedef struct
 
 INT_FX_RESULT_STRUCT, *INT_FX_RESULT;
 
+/* Outline point copied into contiguous memory by CopyOutlines. */
+typedef struct
+{
+  inT16 X, Y;
+  BOOL8 Hidden;                  /* edge to the next point is hidden */
+} FX_POINT;
+
+/* Features of recently extracted blobs, kept by ExtractIntFeatCached. */
+struct FX_CACHE_ENTRY;
+typedef struct
+{
+  FX_CACHE_ENTRY *Entries;
+  int Size;
+  int Lookups;
+  int Hits;
+  int RadiusLimits[4];           /* radius of gyration the entries used */
+} INT_FEATURE_CACHE_STRUCT, *INT_FEATURE_CACHE;
+
+/**----------------------------------------------------------------------------
+          Variables
+----------------------------------------------------------------------------**/
+extern INT_VAR_H(classify_feature_cache_size, 256,
+                 "Number of blobs whose integer features are kept for reuse"
+                 " (0 disables the feature cache)");
+extern BOOL_VAR_H(classify_feature_cache_stats, 0,
+                  "Print feature cache statistics at the end of the run");
+
 /**----------------------------------------------------------------------------
           Public Function Prototypes
 ----------------------------------------------------------------------------**/
@@ -47,6 +76,30 @@ int ExtractIntFeat(TBLOB *Blob,
                    INT_FEATURE_ARRAY CNFeat,
                    INT_FX_RESULT Results);
 
+int ExtractIntFeatCached(TBLOB *Blob,
+                         INT_FEATURE_ARRAY BLFeat,
+                         INT_FEATURE_ARRAY CNFeat,
+                         INT_FX_RESULT Results,
+                         INT_FEATURE_CACHE Cache);
+
+void InitIntFeatureCache(INT_FEATURE_CACHE Cache);
+
+void ClearIntFeatureCache(INT_FEATURE_CACHE Cache);
+
+void FreeIntFeatureCache(INT_FEATURE_CACHE Cache);
+
+void PrintIntFeatureCacheStats(INT_FEATURE_CACHE Cache);
+
+int CopyOutlines(TBLOB *Blob,
+                 GenericVector<FX_POINT> *Points,
+                 GenericVector<int> *OutlineEnds);
+
+int ExtractPointFeat(const GenericVector<FX_POINT> &Points,
+                     const GenericVector<int> &OutlineEnds,
+                     INT_FEATURE_ARRAY BLFeat,
+                     INT_FEATURE_ARRAY CNFeat,
+                     INT_FX_RESULT Results);
+
 uinT8 TableLookup(inT32 Y, inT32 X);
 
 int SaveFeature(INT_FEATURE_ARRAY FeatureArray,
@@ -21,6 +21,7 @@
 ----------------------------------------------------------------------------*/
 #include "intmatcher.h"
 #include "intproto.h"
+#include "emalloc.h"
 #include "tordvars.h"
 #include "callcpp.h"
 #include "scrollview.h"
@@ -189,6 +190,127 @@ int Classify::ClassPruner(INT_TEMPLATES IntTemplates,
  **      Return: Number of pruned classes.
  **      Exceptions: none
  **      History: Tue Feb 19 10:24:24 MST 1991, RWM, Created.
+ */
+  static int ClassCount[MAX_NUM_CLASSES];
+  int *ClassCountPtr;
+  CLASS_ID class_id;
+  int PrunerSet;
+
+  /* Clear Class Counts */
+  ClassCountPtr = &(ClassCount[0]);
+  for (class_id = 0; class_id < IntTemplates->NumClasses; class_id++) {
+    *ClassCountPtr++ = 0;
+  }
+
+  /* Update Class Counts */
+  for (PrunerSet = 0; PrunerSet < IntTemplates->NumClassPruners; PrunerSet++)
+    AddClassPrunerCounts(IntTemplates->ClassPruner[PrunerSet],
+                         NumFeatures, Features,
+                         ClassCount + PrunerSet * CLASSES_PER_CP);
+
+  return PruneClassCounts(IntTemplates, NumFeatures, Features,
+                          NormalizationFactors, ExpectedNumFeatures,
+                          ClassCount, Results);
+}
+
+
+/*---------------------------------------------------------------------------*/
+int Classify::ClassPrunerBatch(INT_TEMPLATES IntTemplates,
+                               int NumBlobs,
+                               CP_BATCH_ENTRY *Blobs,
+                               CLASS_CUTOFF_ARRAY ExpectedNumFeatures,
+                               int Debug) {
+/*
+ **      Parameters:
+ **              IntTemplates           Class pruner tables
+ **              NumBlobs               Number of entries in Blobs
+ **              Blobs                  Features, normalization factors
+ **                                     and (on return) pruned classes
+ **                                     of each blob
+ **              ExpectedNumFeatures    Array of expected number of features
+ **                                     for each class
+ **                                     (by CLASS_INDEX)
+ **              Debug                  Debugger flag: 1=debugger on
+ **      Operation:
+ **              Run the class pruner over several blobs at once.  The
+ **              pruner tables are swept one pruner set at a time and
+ **              each set is applied to the features of every blob
+ **              while it is still in cache, instead of streaming all
+ **              of the tables once per blob.  The results of each
+ **              blob are identical to those of ClassPruner and are
+ **              returned in a newly allocated Results array (owned
+ **              by the caller, free with Efree).
+ **      Return: Total number of pruned classes over all blobs.
+ **      Exceptions: none
+ */
+  static CLASS_PRUNER_RESULTS Results;
+  int CountsPerBlob;
+  int *ClassCounts;
+  int PrunerSet;
+  int Blob;
+  int TotalClasses;
+
+  if (NumBlobs <= 0)
+    return 0;
+  CountsPerBlob = IntTemplates->NumClassPruners * CLASSES_PER_CP;
+  ClassCounts = (int *) Emalloc(NumBlobs * CountsPerBlob * sizeof(int));
+  memset(ClassCounts, 0, NumBlobs * CountsPerBlob * sizeof(int));
+
+  /* Update Class Counts, one pruner set at a time */
+  for (PrunerSet = 0; PrunerSet < IntTemplates->NumClassPruners; PrunerSet++) {
+    for (Blob = 0; Blob < NumBlobs; Blob++)
+      AddClassPrunerCounts(IntTemplates->ClassPruner[PrunerSet],
+                           Blobs[Blob].NumFeatures, Blobs[Blob].Features,
+                           ClassCounts + Blob * CountsPerBlob +
+                           PrunerSet * CLASSES_PER_CP);
+  }
+
+  TotalClasses = 0;
+  for (Blob = 0; Blob < NumBlobs; Blob++) {
+    CP_BATCH_ENTRY *Entry = &Blobs[Blob];
+    Entry->NumClasses = PruneClassCounts(IntTemplates, Entry->NumFeatures,
+                                         Entry->Features,
+                                         Entry->NormalizationFactors,
+                                         ExpectedNumFeatures,
+                                         ClassCounts + Blob * CountsPerBlob,
+                                         Results);
+    Entry->Results = (CP_RESULT_STRUCT *)
+      Emalloc((Entry->NumClasses + 1) * sizeof(CP_RESULT_STRUCT));
+    memcpy(Entry->Results, Results,
+           Entry->NumClasses * sizeof(CP_RESULT_STRUCT));
+    TotalClasses += Entry->NumClasses;
+  }
+  Efree(ClassCounts);
+  return TotalClasses;
+}
+
+
+/*---------------------------------------------------------------------------*/
+int Classify::PruneClassCounts(INT_TEMPLATES IntTemplates,
+                               inT16 NumFeatures,
+                               INT_FEATURE_ARRAY Features,
+                               CLASS_NORMALIZATION_ARRAY NormalizationFactors,
+                               CLASS_CUTOFF_ARRAY ExpectedNumFeatures,
+                               int ClassCount[],
+                               CLASS_PRUNER_RESULTS Results) {
+/*
+ **      Parameters:
+ **              IntTemplates           Class pruner tables
+ **              NumFeatures            Number of features in blob
+ **              Features               Array of features (for debug)
+ **              NormalizationFactors   Array of fudge factors from blob
+ **                                     normalization process
+ **              ExpectedNumFeatures    Array of expected number of features
+ **                                     for each class
+ **              ClassCount             Raw pruner counts of each class,
+ **                                     adjusted in place
+ **              Results                Sorted Array of pruned classes
+ **      Operation:
+ **              Turn the raw class pruner counts of one blob into the
+ **              sorted list of pruned classes.  Shared by ClassPruner
+ **              and ClassPrunerBatch.
+ **      Return: Number of pruned classes.
+ **      Exceptions: none
  */
   uinT32 PrunerWord;
   inT32 class_index;             //index to class
@@ -201,7 +323,6 @@ int Classify::ClassPruner(INT_TEMPLATES IntTemplates,
   int NumPruners;
   inT32 feature_index;           //current feature
 
-  static int ClassCount[MAX_NUM_CLASSES];
   static int NormCount[MAX_NUM_CLASSES];
   static int SortKey[MAX_NUM_CLASSES + 1];
   static int SortIndex[MAX_NUM_CLASSES + 1];
@@ -210,77 +331,9 @@ int Classify::ClassPruner(INT_TEMPLATES IntTemplates,
   int MaxCount;
   int NumClasses;
   FLOAT32 max_rating;            //max allowed rating
-  int *ClassCountPtr;
   CLASS_ID class_id;
 
   MaxNumClasses = IntTemplates->NumClasses;
-
-  /* Clear Class Counts */
-  ClassCountPtr = &(ClassCount[0]);
-  for (class_id = 0; class_id < MaxNumClasses; class_id++) {
-    *ClassCountPtr++ = 0;
-  }
-
-  /* Update Class Counts */
-  NumPruners = IntTemplates->NumClassPruners;
-  for (feature_index = 0; feature_index < NumFeatures; feature_index++) {
-    feature = &Features[feature_index];
-    feature_address = (((feature->X * NUM_CP_BUCKETS >> 8) * NUM_CP_BUCKETS +
-                        (feature->Y * NUM_CP_BUCKETS >> 8)) * NUM_CP_BUCKETS +
-                       (feature->Theta * NUM_CP_BUCKETS >> 8)) << 1;
-    ClassPruner = IntTemplates->ClassPruner;
-    class_index = 0;
-
-    for (PrunerSet = 0; PrunerSet < NumPruners; PrunerSet++, ClassPruner++) {
-      BasePrunerAddress = (uinT32 *) (*ClassPruner) + feature_address;
-
-      for (Word = 0; Word < WERDS_PER_CP_VECTOR; Word++) {
-        PrunerWord = *BasePrunerAddress++;
-        // This inner loop is unrolled to speed up the ClassPruner.
-        // Currently gcc would not unroll it unless it is set to O3
-        // level of optimization or -funroll-loops is specified.
-        /*
-        uinT32 class_mask = (1 << NUM_BITS_PER_CLASS) - 1;
-        for (int bit = 0; bit < BITS_PER_WERD/NUM_BITS_PER_CLASS; bit++) {
-          ClassCount[class_index++] += PrunerWord & class_mask;
-          PrunerWord >>= NUM_BITS_PER_CLASS;
-        }
-        */
-        ClassCount[class_index++] += cp_maps[PrunerWord & 3];
-        PrunerWord >>= 2;
-        ClassCount[class_index++] += cp_maps[PrunerWord & 3];
-        PrunerWord >>= 2;
-        ClassCount[class_index++] += cp_maps[PrunerWord & 3];
-        PrunerWord >>= 2;
-        ClassCount[class_index++] += cp_maps[PrunerWord & 3];
-        PrunerWord >>= 2;
-        ClassCount[class_index++] += cp_maps[PrunerWord & 3];
-        PrunerWord >>= 2;
-        ClassCount[class_index++] += cp_maps[PrunerWord & 3];
-        PrunerWord >>= 2;
-        ClassCount[class_index++] += cp_maps[PrunerWord & 3];
-        PrunerWord >>= 2;
-        ClassCount[class_index++] += cp_maps[PrunerWord & 3];
-        PrunerWord >>= 2;
-        ClassCount[class_index++] += cp_maps[PrunerWord & 3];
-        PrunerWord >>= 2;
-        ClassCount[class_index++] += cp_maps[PrunerWord & 3];
-        PrunerWord >>= 2;
-        ClassCount[class_index++] += cp_maps[PrunerWord & 3];
-        PrunerWord >>= 2;
-        ClassCount[class_index++] += cp_maps[PrunerWord & 3];
-        PrunerWord >>= 2;
-        ClassCount[class_index++] += cp_maps[PrunerWord & 3];
-        PrunerWord >>= 2;
-        ClassCount[class_index++] += cp_maps[PrunerWord & 3];
-        PrunerWord >>= 2;
-        ClassCount[class_index++] += cp_maps[PrunerWord & 3];
-        PrunerWord >>= 2;
-        ClassCount[class_index++] += cp_maps[PrunerWord & 3];
-      }
-    }
-  }
-
   /* Adjust Class Counts for Number of Expected Features */
   for (class_id = 0; class_id < MaxNumClasses; class_id++) {
     if (NumFeatures < ExpectedNumFeatures[class_id]) {
@@ -402,6 +455,87 @@ int Classify::ClassPruner(INT_TEMPLATES IntTemplates,
 }
 }  // namespace tesseract
 
+/*---------------------------------------------------------------------------*/
+void AddClassPrunerCounts(CLASS_PRUNER ClassPruner,
+                          inT16 NumFeatures,
+                          INT_FEATURE_ARRAY Features,
+                          int ClassCount[]) {
+/*
+ **      Parameters:
+ **              ClassPruner    One pruner set (CLASSES_PER_CP classes)
+ **              NumFeatures    Number of features in blob
+ **              Features       Array of features
+ **              ClassCount     Counts of the classes of this pruner set
+ **      Operation:
+ **              Add the pruner evidence of every feature of a blob to
+ **              the counts of the classes covered by one pruner set.
+ **      Return: none
+ **      Exceptions: none
+ */
+  uinT32 PrunerWord;
+  int *ClassCountPtr;
+  int Word;
+  uinT32 *BasePrunerAddress;
+  uinT32 feature_address;        //current feature index
+  INT_FEATURE feature;           //current feature
+  inT32 feature_index;           //current feature
+
+  for (feature_index = 0; feature_index < NumFeatures; feature_index++) {
+    feature = &Features[feature_index];
+    feature_address = (((feature->X * NUM_CP_BUCKETS >> 8) * NUM_CP_BUCKETS +
+                        (feature->Y * NUM_CP_BUCKETS >> 8)) * NUM_CP_BUCKETS +
+                       (feature->Theta * NUM_CP_BUCKETS >> 8)) << 1;
+    BasePrunerAddress = (uinT32 *) ClassPruner + feature_address;
+    ClassCountPtr = ClassCount;
+
+    for (Word = 0; Word < WERDS_PER_CP_VECTOR; Word++) {
+      PrunerWord = *BasePrunerAddress++;
+      // This inner loop is unrolled to speed up the ClassPruner.
+      // Currently gcc would not unroll it unless it is set to O3
+      // level of optimization or -funroll-loops is specified.
+      /*
+      uinT32 class_mask = (1 << NUM_BITS_PER_CLASS) - 1;
+      for (int bit = 0; bit < BITS_PER_WERD/NUM_BITS_PER_CLASS; bit++) {
+        *ClassCountPtr++ += PrunerWord & class_mask;
+        PrunerWord >>= NUM_BITS_PER_CLASS;
+      }
+      */
+      *ClassCountPtr++ += cp_maps[PrunerWord & 3];
+      PrunerWord >>= 2;
+      *ClassCountPtr++ += cp_maps[PrunerWord & 3];
+      PrunerWord >>= 2;
+      *ClassCountPtr++ += cp_maps[PrunerWord & 3];
+      PrunerWord >>= 2;
+      *ClassCountPtr++ += cp_maps[PrunerWord & 3];
+      PrunerWord >>= 2;
+      *ClassCountPtr++ += cp_maps[PrunerWord & 3];
+      PrunerWord >>= 2;
+      *ClassCountPtr++ += cp_maps[PrunerWord & 3];
+      PrunerWord >>= 2;
+      *ClassCountPtr++ += cp_maps[PrunerWord & 3];
+      PrunerWord >>= 2;
+      *ClassCountPtr++ += cp_maps[PrunerWord & 3];
+      PrunerWord >>= 2;
+      *ClassCountPtr++ += cp_maps[PrunerWord & 3];
+      PrunerWord >>= 2;
+      *ClassCountPtr++ += cp_maps[PrunerWord & 3];
+      PrunerWord >>= 2;
+      *ClassCountPtr++ += cp_maps[PrunerWord & 3];
+      PrunerWord >>= 2;
+      *ClassCountPtr++ += cp_maps[PrunerWord & 3];
+      PrunerWord >>= 2;
+      *ClassCountPtr++ += cp_maps[PrunerWord & 3];
+      PrunerWord >>= 2;
+      *ClassCountPtr++ += cp_maps[PrunerWord & 3];
+      PrunerWord >>= 2;
+      *ClassCountPtr++ += cp_maps[PrunerWord & 3];
+      PrunerWord >>= 2;
+      *ClassCountPtr++ += cp_maps[PrunerWord & 3];
+    }
+  }
+}
+
+
 /*---------------------------------------------------------------------------*/
 void IntegerMatcher(INT_CLASS ClassTemplate,
                     BIT_VECTOR ProtoMask,
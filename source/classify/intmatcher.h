@@ -64,6 +64,22 @@ typedef CP_RESULT_STRUCT CLASS_PRUNER_RESULTS[MAX_NUM_CLASSES];
 
 typedef uinT8 CLASS_NORMALIZATION_ARRAY[MAX_NUM_CLASSES];
 
+/* One blob of a ClassPrunerBatch call.  The caller fills in the features,
+   normalization factors and blob length; the pruner fills in NumClasses
+   and allocates Results (free with Efree). */
+typedef struct
+{
+  inT16 NumFeatures;
+  inT32 BlobLength;
+  INT_FEATURE_ARRAY Features;
+  CLASS_NORMALIZATION_ARRAY NormalizationFactors;
+  int NumClasses;
+  CP_RESULT_STRUCT *Results;
+}
+
+
+CP_BATCH_ENTRY;
+
 /*----------------------------------------------------------------------------
             Variables
 -----------------------------------------------------------------------------*/
@@ -196,6 +212,11 @@ void IMDebugBestMatch(int BestMatch,
                       uinT8 NormalizationFactor);
 #endif
 
+void AddClassPrunerCounts(CLASS_PRUNER ClassPruner,
+                          inT16 NumFeatures,
+                          INT_FEATURE_ARRAY Features,
+                          int ClassCount[]);
+
 void HeapSort (int n, register int ra[], register int rb[]);
 
 /**----------------------------------------------------------------------------
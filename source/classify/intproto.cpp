@@ -35,6 +35,7 @@
 
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 #ifdef __UNIX__
 #include <unistd.h>
@@ -67,6 +68,9 @@
 /** define pad used to snap near horiz/vertical protos to horiz/vertical */
 #define HV_TOLERANCE  (0.0025)   /* approx 0.9 degrees */
 
+/** alignment of the pieces of compacted templates (one cache line) */
+#define TEMPLATE_ARENA_ALIGNMENT  64
+
 typedef enum
 { StartSwitch, EndSwitch, LastSwitch }
 SWITCH_TYPE;
@@ -121,6 +125,10 @@ FILL_SPEC;
 /** macro for mapping floats to ints without bounds checking */
 #define MapParam(P,O,N)   (floor (((P) + (O)) * (N)))
 
+/** macro for rounding a size up to a multiple of the arena alignment */
+#define TemplateArenaSize(S)  \
+  ((((int) (S)) + TEMPLATE_ARENA_ALIGNMENT - 1) & ~(TEMPLATE_ARENA_ALIGNMENT - 1))
+
 /*---------------------------------------------------------------------------
             Private Function Prototypes
 ----------------------------------------------------------------------------*/
@@ -367,6 +375,36 @@ void AddProtoToClassPruner (PROTO Proto, CLASS_ID ClassId,
 }                                /* AddProtoToClassPruner */
 
 
+/*---------------------------------------------------------------------------*/
+void RemoveClassFromClassPruner(CLASS_ID ClassId, INT_TEMPLATES Templates)
+/*
+ ** Parameters:
+ **   ClassId   class id whose entries are to be removed
+ **   Templates set of templates containing class pruner
+ ** Globals: none
+ ** Operation: This routine clears every class pruner entry for the
+ **   specified class in Templates, so that the class pruner no longer
+ **   votes for it.  It undoes all previous calls to
+ **   AddProtoToClassPruner for the class.
+ ** Return: none
+ ** Exceptions: none
+ */
+{
+  uinT32 *Word;
+  uinT32 *End;
+  uinT32 ClassMask;
+  uinT32 WordIndex;
+
+  Word = reinterpret_cast<uinT32*>(CPrunerFor (Templates, ClassId));
+  End = Word + WERDS_PER_CP;
+  WordIndex = CPrunerWordIndexFor (ClassId);
+  ClassMask = CPrunerMaskFor (MAX_LEVEL, ClassId);
+
+  for (Word += WordIndex; Word < End; Word += WERDS_PER_CP_VECTOR)
+    *Word &= ~ClassMask;
+}                                /* RemoveClassFromClassPruner */
+
+
 /*---------------------------------------------------------------------------*/
 void AddProtoToProtoPruner(PROTO Proto, int ProtoId, INT_CLASS Class) {
 /*
@@ -768,6 +806,8 @@ INT_TEMPLATES NewIntTemplates() {
   T = (INT_TEMPLATES) Emalloc (sizeof (INT_TEMPLATES_STRUCT));
   T->NumClasses = 0;
   T->NumClassPruners = 0;
+  T->Arena = NULL;
+  T->ArenaSize = 0;
 
   for (i = 0; i < MAX_NUM_CLASSES; i++)
     ClassForClassId (T, i) = NULL;
@@ -780,6 +820,11 @@ INT_TEMPLATES NewIntTemplates() {
 void free_int_templates(INT_TEMPLATES templates) {
   int i;
 
+  if (templates->Arena != NULL) {
+    Efree(templates->Arena);
+    Efree(templates);
+    return;
+  }
   for (i = 0; i < templates->NumClasses; i++)
     free_int_class(templates->Class[i]);
   for (i = 0; i < templates->NumClassPruners; i++)
@@ -788,6 +833,79 @@ void free_int_templates(INT_TEMPLATES templates) {
 }
 
 
+/*---------------------------------------------------------------------------*/
+void CompactIntTemplates(INT_TEMPLATES Templates) {
+/*
+ ** Parameters:
+ **   Templates  integer templates to be compacted
+ ** Globals: none
+ ** Operation: This routine moves all class pruners, classes, proto sets
+ **   and proto lengths of Templates into one block of memory that is
+ **   aligned on a cache line.  The class pruners come first, followed by
+ **   each class with its proto sets and proto lengths, so that the data
+ **   touched while matching a class is contiguous instead of scattered
+ **   over the heap.  The pointers in Templates are left pointing into the
+ **   block, so nothing else needs to know about it.  Since the pieces can
+ **   no longer be freed or grown one at a time, the templates must not be
+ **   changed afterwards (ie. no AddIntClass, AddIntProto, or
+ **   free_int_class on its classes); free_int_templates frees the block.
+ ** Return: none
+ ** Exceptions: none
+ */
+  INT_CLASS Class;
+  int ArenaSize;
+  char *Next;
+  int i, j;
+
+  if (Templates->Arena != NULL)
+    return;
+
+  ArenaSize = Templates->NumClassPruners *
+    TemplateArenaSize(sizeof(CLASS_PRUNER_STRUCT));
+  for (i = 0; i < Templates->NumClasses; i++) {
+    Class = Templates->Class[i];
+    if (Class == NULL)
+      continue;
+    ArenaSize += TemplateArenaSize(sizeof(INT_CLASS_STRUCT)) +
+      Class->NumProtoSets * TemplateArenaSize(sizeof(PROTO_SET_STRUCT));
+    if (Class->ProtoLengths != NULL)
+      ArenaSize += TemplateArenaSize(MaxNumIntProtosIn(Class));
+  }
+  Templates->Arena = (char *) Emalloc(ArenaSize + TEMPLATE_ARENA_ALIGNMENT);
+  Templates->ArenaSize = ArenaSize;
+  Next = Templates->Arena + TEMPLATE_ARENA_ALIGNMENT -
+    (size_t) Templates->Arena % TEMPLATE_ARENA_ALIGNMENT;
+
+  for (i = 0; i < Templates->NumClassPruners; i++) {
+    memcpy(Next, Templates->ClassPruner[i], sizeof(CLASS_PRUNER_STRUCT));
+    Efree(Templates->ClassPruner[i]);
+    Templates->ClassPruner[i] = (CLASS_PRUNER) Next;
+    Next += TemplateArenaSize(sizeof(CLASS_PRUNER_STRUCT));
+  }
+  for (i = 0; i < Templates->NumClasses; i++) {
+    Class = Templates->Class[i];
+    if (Class == NULL)
+      continue;
+    memcpy(Next, Class, sizeof(INT_CLASS_STRUCT));
+    Efree(Class);
+    Class = Templates->Class[i] = (INT_CLASS) Next;
+    Next += TemplateArenaSize(sizeof(INT_CLASS_STRUCT));
+    for (j = 0; j < Class->NumProtoSets; j++) {
+      memcpy(Next, Class->ProtoSets[j], sizeof(PROTO_SET_STRUCT));
+      Efree(Class->ProtoSets[j]);
+      Class->ProtoSets[j] = (PROTO_SET) Next;
+      Next += TemplateArenaSize(sizeof(PROTO_SET_STRUCT));
+    }
+    if (Class->ProtoLengths != NULL) {
+      memcpy(Next, Class->ProtoLengths, MaxNumIntProtosIn(Class));
+      Efree(Class->ProtoLengths);
+      Class->ProtoLengths = (uinT8 *) Next;
+      Next += TemplateArenaSize(MaxNumIntProtosIn(Class));
+    }
+  }
+}                                /* CompactIntTemplates */
+
+
 /*---------------------------------------------------------------------------*/
 // Code to read/write Classify::font*table structures.
 namespace {
@@ -148,6 +148,11 @@ typedef struct
   int NumClassPruners;
   INT_CLASS Class[MAX_NUM_CLASSES];
   CLASS_PRUNER ClassPruner[MAX_NUM_CLASS_PRUNERS];
+  /* When not NULL, all class pruners, classes, proto sets and proto
+     lengths live in this single block (see CompactIntTemplates) and the
+     templates must not be changed any more. */
+  char *Arena;
+  int ArenaSize;
 }
 
 
@@ -231,6 +236,8 @@ void AddProtoToClassPruner(PROTO Proto,
 
 void AddProtoToProtoPruner(PROTO Proto, int ProtoId, INT_CLASS Class);
 
+void RemoveClassFromClassPruner(CLASS_ID ClassId, INT_TEMPLATES Templates);
+
 int BucketFor(FLOAT32 Param, FLOAT32 Offset, int NumBuckets);
 
 int CircBucketFor(FLOAT32 Param, FLOAT32 Offset, int NumBuckets);
@@ -249,8 +256,12 @@ INT_CLASS NewIntClass(int MaxNumProtos, int MaxNumConfigs);
 
 INT_TEMPLATES NewIntTemplates();
 
+void free_int_class(INT_CLASS int_class);
+
 void free_int_templates(INT_TEMPLATES templates);
 
+void CompactIntTemplates(INT_TEMPLATES Templates);
+
 void ShowMatchDisplay();
 
 /*----------------------------------------------------------------------------*/
@@ -31,6 +31,7 @@
 
 #define Magnitude(X)    ((X) < 0 ? -(X) : (X))
 #define MIN(A,B)    ((A) < (B) ? (A) : (B))
+#define MAX(A,B)    ((A) > (B) ? (A) : (B))
 #define NodeFound(N,K,D)  (( (N)->Key == (K) ) && ( (N)->Data == (D) ))
 
 /*-----------------------------------------------------------------------------
@@ -39,67 +40,97 @@
 #define MINSEARCH -MAX_FLOAT32
 #define MAXSEARCH MAX_FLOAT32
 
-static int NumberOfNeighbors;
-static inT16 N;                  /* number of dimensions in the kd tree */
+/* the routines below keep no state between calls, all of it lives in the
+   tree or in the KDSEARCH of a single search, so different trees, and
+   different searches of the same tree, can be used from several threads
+   at once.  Storing into or deleting from a tree must not overlap with
+   any other use of that tree. */
 
-static FLOAT32 *QueryPoint;
-static int MaxNeighbors;
-static FLOAT32 Radius;
-static int Furthest;
-static char **Neighbor;
-static FLOAT32 *Distance;
-
-static int MaxDimension = 0;
-static FLOAT32 *SBMin;
-static FLOAT32 *SBMax;
-static FLOAT32 *LBMin;
-static FLOAT32 *LBMax;
-
-static PARAM_DESC *KeyDesc;
-
-static jmp_buf QuickExit;
-
-static void_proc WalkAction;
+/* nodes added one at a time are allocated in blocks of this many */
+#define MINNODEBLOCK  64
+#define MAXNODEBLOCK  4096
 
 // Helper function to find the next essential dimension in a cycle.
-static int NextLevel(int level) {
+static int NextLevel(KDTREE *tree, int level) {
   do {
     ++level;
-    if (level >= N)
+    if (level >= tree->KeySize)
       level = 0;
-  } while (KeyDesc[level].NonEssential);
+  } while (tree->KeyDesc[level].NonEssential);
   return level;
 }
 
 /// Helper function to find the previous essential dimension in a cycle.
-static int PrevLevel(int level) {
+static int PrevLevel(KDTREE *tree, int level) {
   do {
     --level;
     if (level < 0)
-      level = N - 1;
-  } while (KeyDesc[level].NonEssential);
+      level = tree->KeySize - 1;
+  } while (tree->KeyDesc[level].NonEssential);
   return level;
 }
 
+/// Helper function to add a block of NumNodes free nodes to tree.
+static void NewKDNodeBlock(KDTREE *tree, int NumNodes) {
+  KDNODEBLOCK *Block;
+
+  Block = (KDNODEBLOCK *) Emalloc (sizeof (KDNODEBLOCK) +
+    (NumNodes - 1) * sizeof (KDNODE));
+  Block->Next = tree->NodeBlocks;
+  Block->NumNodes = NumNodes;
+  Block->NumUsed = 0;
+  tree->NodeBlocks = Block;
+}
+
+/// Helper function to prepare State for searching tree.
+static void InitKDSearch(KDSEARCH *State, KDTREE *tree, FLOAT32 *Boxes) {
+  State->Tree = tree;
+  State->SBMin = Boxes;
+  State->SBMax = State->SBMin + tree->KeySize;
+  State->LBMin = State->SBMax + tree->KeySize;
+  State->LBMax = State->LBMin + tree->KeySize;
+}
+
+/// Helper function to run one search of State->Tree for Query.
+static int RunKDSearch(KDSEARCH *State, FLOAT32 Query[], int QuerySize,
+                       FLOAT32 MaxDistance, char **NBuffer,
+                       FLOAT32 DBuffer[]) {
+  KDTREE *tree = State->Tree;
+  int i;
+
+  State->NumberOfNeighbors = 0;
+  State->QueryPoint = Query;
+  State->MaxNeighbors = QuerySize;
+  State->Radius = MaxDistance;
+  State->Furthest = 0;
+  State->Neighbor = NBuffer;
+  State->Distance = DBuffer;
+
+  for (i = 0; i < tree->KeySize; i++) {
+    State->SBMin[i] = tree->KeyDesc[i].Min;
+    State->SBMax[i] = tree->KeyDesc[i].Max;
+    State->LBMin[i] = tree->KeyDesc[i].Min;
+    State->LBMax[i] = tree->KeyDesc[i].Max;
+  }
+
+  if (tree->Root.Left != NULL) {
+    if (setjmp (State->QuickExit) == 0)
+      Search (State, NextLevel(tree, -1), tree->Root.Left);
+  }
+  return (State->NumberOfNeighbors);
+}
+
 /*-----------------------------------------------------------------------------
               Public Code
 -----------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 /**
  * This routine allocates and returns a new K-D tree data
- * structure.  It also reallocates the small and large
- * search region boxes if they are not large enough to
- * accomodate the size of the new K-D tree.  KeyDesc is
- * an array of key descriptors that indicate which dimensions
- * are circular and, if they are circular, what the range is.
+ * structure.  KeyDesc is an array of key descriptors that
+ * indicate which dimensions are circular and, if they are
+ * circular, what the range is.
  *
- * Globals:
- * - MaxDimension	largest # of dimensions in any K-D tree
- * - SBMin		small search region box
- * - SBMax
- * - LBMin		large search region box
- * - LBMax
- * - Key		description of key dimensions
+ * Globals: none
  *
  * @param KeySize # of dimensions in the K-D tree
  * @param KeyDesc array of params to describe key dimensions
@@ -111,23 +142,8 @@ static int PrevLevel(int level) {
 KDTREE *
 MakeKDTree (inT16 KeySize, PARAM_DESC KeyDesc[]) {
   int i;
-  void *NewMemory;
   KDTREE *KDTree;
 
-  if (KeySize > MaxDimension) {
-    NewMemory = Emalloc (KeySize * 4 * sizeof (FLOAT32));
-    if (MaxDimension > 0) {
-      memfree ((char *) SBMin);
-      memfree ((char *) SBMax);
-      memfree ((char *) LBMin);
-      memfree ((char *) LBMax);
-    }
-    SBMin = (FLOAT32 *) NewMemory;
-    SBMax = SBMin + KeySize;
-    LBMin = SBMax + KeySize;
-    LBMax = LBMin + KeySize;
-  }
-
   KDTree =
     (KDTREE *) Emalloc (sizeof (KDTREE) +
     (KeySize - 1) * sizeof (PARAM_DESC));
@@ -149,10 +165,56 @@ MakeKDTree (inT16 KeySize, PARAM_DESC KeyDesc[]) {
   KDTree->KeySize = KeySize;
   KDTree->Root.Left = NULL;
   KDTree->Root.Right = NULL;
+  KDTree->NodeBlocks = NULL;
+  KDTree->FreeNodes = NULL;
   return (KDTree);
 }                                /* MakeKDTree */
 
 
+/*---------------------------------------------------------------------------*/
+/**
+ * This routine builds a balanced K-D tree holding NumKeys
+ * entries at once.  Each level of the tree splits its entries
+ * at their median along the dimension branched on at that
+ * level, so the tree has the minimum depth and is much faster
+ * to search than one built by storing the entries one at a time.
+ * All of the nodes are allocated in one contiguous block in the
+ * order in which a search visits them.  The resulting tree is
+ * an ordinary K-D tree, and entries can be stored into and
+ * deleted from it as usual.
+ *
+ * @param KeySize # of dimensions in the K-D tree
+ * @param KeyDesc array of params to describe key dimensions
+ * @param NumKeys number of entries to store in the tree
+ * @param Keys access key of each entry
+ * @param Data data contents of each entry
+ *
+ * @return Pointer to new K-D tree
+ * @note Exceptions: None
+ */
+KDTREE *
+MakeKDTreeFromKeys (inT16 KeySize, PARAM_DESC KeyDesc[],
+int NumKeys, FLOAT32 *Keys[], void *Data[]) {
+  KDTREE *KDTree;
+  int *Order;
+  int i;
+
+  KDTree = MakeKDTree (KeySize, KeyDesc);
+  if (NumKeys <= 0)
+    return (KDTree);
+
+  Order = (int *) Emalloc (NumKeys * sizeof (int));
+  for (i = 0; i < NumKeys; i++)
+    Order[i] = i;
+
+  NewKDNodeBlock(KDTree, NumKeys);
+  KDTree->Root.Left = BuildSubTree (KDTree, Keys, Data, Order, 0, NumKeys,
+    NextLevel(KDTree, -1));
+  memfree(Order);
+  return (KDTree);
+}                                /* MakeKDTreeFromKeys */
+
+
 /*---------------------------------------------------------------------------*/
 void KDStore(KDTREE *Tree, FLOAT32 *Key, void *Data) {
 /**
@@ -163,12 +225,7 @@ void KDStore(KDTREE *Tree, FLOAT32 *Key, void *Data) {
  * @param Key		ptr to key by which data can be retrieved
  * @param Data		ptr to data to be stored in the tree
  *
- * Globals:
- * - N		dimension of the K-D tree
- * - KeyDesc		descriptions of tree dimensions
- * - StoreCount	debug variables for performance tests
- * - StoreUniqueCount
- * - StoreProbeCount
+ * Globals: none
  *
  * @note Exceptions: none
  * @note History:	3/10/89, DSJ, Created.
@@ -178,11 +235,9 @@ void KDStore(KDTREE *Tree, FLOAT32 *Key, void *Data) {
   KDNODE *Node;
   KDNODE **PtrToNode;
 
-  N = Tree->KeySize;
-  KeyDesc = &(Tree->KeyDesc[0]);
   PtrToNode = &(Tree->Root.Left);
   Node = *PtrToNode;
-  Level = NextLevel(-1);
+  Level = NextLevel(Tree, -1);
   while (Node != NULL) {
     if (Key[Level] < Node->BranchPoint) {
       PtrToNode = &(Node->Left);
@@ -194,11 +249,11 @@ void KDStore(KDTREE *Tree, FLOAT32 *Key, void *Data) {
       if (Key[Level] < Node->RightBranch)
         Node->RightBranch = Key[Level];
     }
-    Level = NextLevel(Level);
+    Level = NextLevel(Tree, Level);
     Node = *PtrToNode;
   }
 
-  *PtrToNode = MakeKDNode (Key, (char *) Data, Level);
+  *PtrToNode = MakeKDNode (Tree, Key, (char *) Data, Level);
 }                                /* KDStore */
 
 
@@ -226,11 +281,7 @@ void KDStore(KDTREE *Tree, FLOAT32 *Key, void *Data) {
  * deleted.  If the node specified by Key and Data does not
  * exist in the tree, then nothing is done.
  *
- * Globals:
- * - N		dimension of the K-D tree
- * - KeyDesc		description of each dimension
- * - DeleteCount	debug variables for performance tests
- * - DeleteProbeCount
+ * Globals: none
  *
  * @param Tree K-D tree to delete node from
  * @param Key key of node to be deleted
@@ -250,11 +301,9 @@ KDDelete (KDTREE * Tree, FLOAT32 Key[], void *Data) {
   KDNODE *FatherReplacement;
 
   /* initialize search at root of tree */
-  N = Tree->KeySize;
-  KeyDesc = &(Tree->KeyDesc[0]);
   Father = &(Tree->Root);
   Current = Father->Left;
-  Level = NextLevel(-1);
+  Level = NextLevel(Tree, -1);
 
   /* search tree for node to be deleted */
   while ((Current != NULL) && (!NodeFound (Current, Key, Data))) {
@@ -264,7 +313,7 @@ KDDelete (KDTREE * Tree, FLOAT32 Key[], void *Data) {
     else
       Current = Current->Right;
 
-    Level = NextLevel(Level);
+    Level = NextLevel(Tree, Level);
   }
 
   if (Current != NULL) {         /* if node to be deleted was found */
@@ -284,20 +333,20 @@ KDDelete (KDTREE * Tree, FLOAT32 Key[], void *Data) {
       else
         break;
 
-      Level = NextLevel(Level);
+      Level = NextLevel(Tree, Level);
     }
 
     /* compute level of replacement node's father */
-    Level = PrevLevel(Level);
+    Level = PrevLevel(Tree, Level);
 
     /* disconnect replacement node from it's father */
     if (FatherReplacement->Left == Replacement) {
       FatherReplacement->Left = NULL;
-      FatherReplacement->LeftBranch = KeyDesc[Level].Min;
+      FatherReplacement->LeftBranch = Tree->KeyDesc[Level].Min;
     }
     else {
       FatherReplacement->Right = NULL;
-      FatherReplacement->RightBranch = KeyDesc[Level].Max;
+      FatherReplacement->RightBranch = Tree->KeyDesc[Level].Max;
     }
 
     /* replace deleted node with replacement (unless they are the same) */
@@ -313,7 +362,7 @@ KDDelete (KDTREE * Tree, FLOAT32 Key[], void *Data) {
       else
         Father->Right = Replacement;
     }
-    FreeKDNode(Current);
+    FreeKDNode(Tree, Current);
   }
 }                                /* KDDelete */
 
@@ -334,21 +383,7 @@ void *NBuffer, FLOAT32 DBuffer[]) {
  **		NBuffer		ptr to QuerySize buffer to hold nearest neighbors
  **		DBuffer		ptr to QuerySize buffer to hold distances
  **					from nearest neighbor to query point
- **	Globals:
- **		NumberOfNeighbors	# of neighbors found so far
- **		N			# of features in each key
- **		KeyDesc			description of tree dimensions
- **		QueryPoint		point in D-space to find neighbors of
- **		MaxNeighbors		maximum # of neighbors to find
- **		Radius			current distance of furthest neighbor
- **		Furthest		index of furthest neighbor
- **		Neighbor		buffer of current neighbors
- **		Distance		buffer of neighbor distances
- **		SBMin			lower extent of small search region
- **		SBMax			upper extent of small search region
- **		LBMin			lower extent of large search region
- **		LBMax			upper extent of large search region
- **		QuickExit		quick exit from recursive search
+ **	Globals: none
  **	Operation:
  **		This routine searches the K-D tree specified by Tree and
  **		finds the QuerySize nearest neighbors of Query.  All neighbors
@@ -362,44 +397,75 @@ void *NBuffer, FLOAT32 DBuffer[]) {
  **		3/10/89, DSJ, Created.
  **		7/13/89, DSJ, Return contents of node instead of node itself.
  */
-  int i;
+  KDSEARCH State;
+  FLOAT32 *Boxes;
+  int NumberOfNeighbors;
+
+  Boxes = (FLOAT32 *) Emalloc (Tree->KeySize * 4 * sizeof (FLOAT32));
+  InitKDSearch(&State, Tree, Boxes);
+  NumberOfNeighbors = RunKDSearch (&State, Query, QuerySize, MaxDistance,
+    (char **) NBuffer, DBuffer);
+  memfree(Boxes);
+  return (NumberOfNeighbors);
+}                                /* KDNearestNeighborSearch */
 
-  NumberOfNeighbors = 0;
-  N = Tree->KeySize;
-  KeyDesc = &(Tree->KeyDesc[0]);
-  QueryPoint = Query;
-  MaxNeighbors = QuerySize;
-  Radius = MaxDistance;
-  Furthest = 0;
-  Neighbor = (char **) NBuffer;
-  Distance = DBuffer;
-
-  for (i = 0; i < N; i++) {
-    SBMin[i] = KeyDesc[i].Min;
-    SBMax[i] = KeyDesc[i].Max;
-    LBMin[i] = KeyDesc[i].Min;
-    LBMax[i] = KeyDesc[i].Max;
-  }
 
-  if (Tree->Root.Left != NULL) {
-    if (setjmp (QuickExit) == 0)
-      Search (0, Tree->Root.Left);
+/*---------------------------------------------------------------------------*/
+void
+KDNearestNeighborBatch (KDTREE * Tree,
+int NumQueries,
+FLOAT32 *Queries[],
+int QuerySize,
+FLOAT32 MaxDistance,
+void *NBuffer, FLOAT32 DBuffer[], int NumFound[]) {
+/*
+ **	Parameters:
+ **		Tree		ptr to K-D tree to be searched
+ **		NumQueries	number of query keys
+ **		Queries		ptrs to the query keys
+ **		QuerySize	number of nearest neighbors to be found
+ **		MaxDistance	all neighbors must be within this distance
+ **		NBuffer		ptr to NumQueries * QuerySize buffer to hold
+ **					nearest neighbors
+ **		DBuffer		ptr to NumQueries * QuerySize buffer to hold
+ **					distances from neighbors to queries
+ **		NumFound	ptr to NumQueries buffer to hold the number
+ **					of neighbors found for each query
+ **	Globals: none
+ **	Operation:
+ **		This routine does a KDNearestNeighborSearch for each of
+ **		Queries.  The neighbors of query i are placed in NBuffer
+ **		and DBuffer starting at i * QuerySize.  The search state
+ **		is set up once for all of the queries.  Several batches
+ **		may search the same tree at once from different threads.
+ **	Return: none
+ **	Exceptions: none
+ */
+  KDSEARCH State;
+  FLOAT32 *Boxes;
+  char **Neighbors = (char **) NBuffer;
+  int i;
+
+  Boxes = (FLOAT32 *) Emalloc (Tree->KeySize * 4 * sizeof (FLOAT32));
+  InitKDSearch(&State, Tree, Boxes);
+  for (i = 0; i < NumQueries; i++) {
+    NumFound[i] = RunKDSearch (&State, Queries[i], QuerySize, MaxDistance,
+      Neighbors + i * QuerySize, DBuffer + i * QuerySize);
   }
-  return (NumberOfNeighbors);
-}                                /* KDNearestNeighborSearch */
+  memfree(Boxes);
+}                                /* KDNearestNeighborBatch */
 
 
 /*---------------------------------------------------------------------------*/
-void KDWalk(KDTREE *Tree, void_proc Action) {
+void KDWalk(KDTREE *Tree, void_proc Action, void *context) {
 /*
  **	Parameters:
  **		Tree	ptr to K-D tree to be walked
  **		Action	ptr to function to be executed at each node
- **	Globals:
- **		WalkAction	action to be performed at every node
+ **		context	passed on to Action at each node
+ **	Globals: none
  **	Operation:
- **		This routine stores the desired action in a global
- **		variable and starts a recursive walk of Tree.  The walk
+ **		This routine starts a recursive walk of Tree.  The walk
  **		is started at the root node.
  **	Return:
  **		None
@@ -408,9 +474,8 @@ void KDWalk(KDTREE *Tree, void_proc Action) {
  **	History:
  **		3/13/89, DSJ, Created.
  */
-  WalkAction = Action;
   if (Tree->Root.Left != NULL)
-    Walk (Tree->Root.Left, NextLevel(-1));
+    Walk (Tree, Action, context, Tree->Root.Left, NextLevel(Tree, -1));
 }                                /* KDWalk */
 
 
@@ -432,7 +497,13 @@ void FreeKDTree(KDTREE *Tree) {
  **	History:
  **		5/26/89, DSJ, Created.
  */
-  FreeSubTree (Tree->Root.Left);
+  KDNODEBLOCK *Block;
+
+  while (Tree->NodeBlocks != NULL) {
+    Block = Tree->NodeBlocks;
+    Tree->NodeBlocks = Block->Next;
+    memfree(Block);
+  }
   memfree(Tree);
 }                                /* FreeKDTree */
 
@@ -442,12 +513,12 @@ void FreeKDTree(KDTREE *Tree) {
 -----------------------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
 int
-Equal (FLOAT32 Key1[], FLOAT32 Key2[]) {
+Equal (int N, FLOAT32 Key1[], FLOAT32 Key2[]) {
 /*
  **	Parameters:
- **		Key1,Key2	search keys to be compared for equality
- **	Globals:
  **		N		number of parameters per key
+ **		Key1,Key2	search keys to be compared for equality
+ **	Globals: none
  **	Operation:
  **		This routine returns TRUE if Key1 = Key2.
  **	Return:
@@ -468,19 +539,20 @@ Equal (FLOAT32 Key1[], FLOAT32 Key2[]) {
 
 /*---------------------------------------------------------------------------*/
 KDNODE *
-MakeKDNode (FLOAT32 Key[], char *Data, int Index) {
+MakeKDNode (KDTREE *Tree, FLOAT32 Key[], char *Data, int Index) {
 /*
  **	Parameters:
+ **		Tree	K-D tree the new node will belong to
  **		Key	Access key for new node in KD tree
  **		Data	ptr to data to be stored in new node
  **		Index	index of Key to branch on
- **	Globals:
- **		KeyDesc	descriptions of key dimensions
+ **	Globals: none
  **	Operation:
- **		This routine allocates memory for a new K-D tree node
- **		and places the specified Key and Data into it.  The
- **		left and right subtree pointers for the node are
- **		initialized to empty subtrees.
+ **		This routine takes a new K-D tree node from the node
+ **		storage of Tree and places the specified Key and Data
+ **		into it.  Nodes freed by earlier deletes are reused
+ **		first.  The left and right subtree pointers for the
+ **		node are initialized to empty subtrees.
  **	Return:
  **		pointer to new K-D tree node
  **	Exceptions:
@@ -489,14 +561,32 @@ MakeKDNode (FLOAT32 Key[], char *Data, int Index) {
  **		3/11/89, DSJ, Created.
  */
   KDNODE *NewNode;
+  KDNODEBLOCK *Block;
+  int BlockSize;
 
-  NewNode = (KDNODE *) Emalloc (sizeof (KDNODE));
+  if (Tree->FreeNodes != NULL) {
+    NewNode = Tree->FreeNodes;
+    Tree->FreeNodes = NewNode->Left;
+  }
+  else {
+    Block = Tree->NodeBlocks;
+    if (Block == NULL || Block->NumUsed == Block->NumNodes) {
+      BlockSize = (Block == NULL) ? MINNODEBLOCK : Block->NumNodes * 2;
+      if (BlockSize < MINNODEBLOCK)
+        BlockSize = MINNODEBLOCK;
+      if (BlockSize > MAXNODEBLOCK)
+        BlockSize = MAXNODEBLOCK;
+      NewKDNodeBlock(Tree, BlockSize);
+      Block = Tree->NodeBlocks;
+    }
+    NewNode = &(Block->Nodes[Block->NumUsed++]);
+  }
 
   NewNode->Key = Key;
   NewNode->Data = Data;
   NewNode->BranchPoint = Key[Index];
-  NewNode->LeftBranch = KeyDesc[Index].Min;
-  NewNode->RightBranch = KeyDesc[Index].Max;
+  NewNode->LeftBranch = Tree->KeyDesc[Index].Min;
+  NewNode->RightBranch = Tree->KeyDesc[Index].Max;
   NewNode->Left = NULL;
   NewNode->Right = NULL;
 
@@ -505,14 +595,16 @@ MakeKDNode (FLOAT32 Key[], char *Data, int Index) {
 
 
 /*---------------------------------------------------------------------------*/
-void FreeKDNode(KDNODE *Node) {
+void FreeKDNode(KDTREE *Tree, KDNODE *Node) {
 /*
  **	Parameters:
+ **		Tree	K-D tree that Node belongs to
  **		Node	ptr to node data structure to be freed
  **	Globals:
  **		None
  **	Operation:
- **		This routine frees up the memory allocated to Node.
+ **		This routine returns Node to the node storage of Tree
+ **		so that it can be reused by a later store.
  **	Return:
  **		None
  **	Exceptions:
@@ -520,31 +612,117 @@ void FreeKDNode(KDNODE *Node) {
  **	History:
  **		3/13/89, DSJ, Created.
  */
-  memfree ((char *) Node);
+  Node->Left = Tree->FreeNodes;
+  Tree->FreeNodes = Node;
 }                                /* FreeKDNode */
 
 
 /*---------------------------------------------------------------------------*/
-void Search(int Level, KDNODE *SubTree) {
+KDNODE *
+BuildSubTree (KDTREE *Tree, FLOAT32 *Keys[], void *Data[],
+int Order[], int Lo, int Hi, int Level) {
+/*
+ **	Parameters:
+ **		Tree	K-D tree being built
+ **		Keys	access keys of all entries
+ **		Data	data contents of all entries
+ **		Order	indices of the entries, Order[Lo..Hi-1] are the
+ **				entries to go in this sub-tree
+ **		Lo,Hi	range of Order to build the sub-tree from
+ **		Level	dimension to branch on at the root of the sub-tree
+ **	Globals: none
+ **	Operation:
+ **		This routine builds a balanced sub-tree from the entries
+ **		in Order[Lo..Hi-1] and returns its root.  The root is the
+ **		median entry along Level.  Entries less than the median
+ **		along Level go in the left sub-tree, all others in the
+ **		right sub-tree, just as KDStore would place them.
+ **		Order[Lo..Hi-1] is rearranged in the process.
+ **	Return: root of the new sub-tree
+ **	Exceptions: none
+ */
+  KDNODE *Node;
+  FLOAT32 Branch;
+  FLOAT32 Value;
+  int Mid, Left, Right, Pivot;
+  int First, Last;
+  int Temp;
+  int i;
+
+  if (Lo >= Hi)
+    return (NULL);
+
+  /* select the median along Level, leaving smaller keys below it and
+     larger keys above it */
+  Mid = (Lo + Hi) / 2;
+  First = Lo;
+  Last = Hi - 1;
+  while (First < Last) {
+    Branch = Keys[Order[(First + Last) / 2]][Level];
+    Left = First;
+    Right = Last;
+    while (Left <= Right) {
+      while (Keys[Order[Left]][Level] < Branch)
+        Left++;
+      while (Keys[Order[Right]][Level] > Branch)
+        Right--;
+      if (Left <= Right) {
+        Temp = Order[Left];
+        Order[Left++] = Order[Right];
+        Order[Right--] = Temp;
+      }
+    }
+    if (Mid <= Right)
+      Last = Right;
+    else if (Mid >= Left)
+      First = Left;
+    else
+      break;
+  }
+  Branch = Keys[Order[Mid]][Level];
+
+  /* keys equal to the median must go right, so the node for the
+     sub-tree is the first of them */
+  Pivot = Lo;
+  for (i = Lo; i < Mid; i++) {
+    if (Keys[Order[i]][Level] < Branch) {
+      Temp = Order[i];
+      Order[i] = Order[Pivot];
+      Order[Pivot++] = Temp;
+    }
+  }
+  Temp = Order[Mid];
+  Order[Mid] = Order[Pivot];
+  Order[Pivot] = Temp;
+
+  Node = MakeKDNode (Tree, Keys[Order[Pivot]], (char *) Data[Order[Pivot]],
+    Level);
+  for (i = Lo; i < Pivot; i++) {
+    Value = Keys[Order[i]][Level];
+    if (Value > Node->LeftBranch)
+      Node->LeftBranch = Value;
+  }
+  for (i = Pivot + 1; i < Hi; i++) {
+    Value = Keys[Order[i]][Level];
+    if (Value < Node->RightBranch)
+      Node->RightBranch = Value;
+  }
+
+  Level = NextLevel(Tree, Level);
+  Node->Left = BuildSubTree (Tree, Keys, Data, Order, Lo, Pivot, Level);
+  Node->Right = BuildSubTree (Tree, Keys, Data, Order, Pivot + 1, Hi, Level);
+  return (Node);
+}                                /* BuildSubTree */
+
+
+/*---------------------------------------------------------------------------*/
+void Search(KDSEARCH *State, int Level, KDNODE *SubTree) {
 /*
  **	Parameters:
+ **		State		state of the search in progress
  **		Level		level in tree of sub-tree to be searched
  **		SubTree		sub-tree to be searched
- **	Globals:
- **		NumberOfNeighbors	# of neighbors found so far
- **		N			# of features in each key
- **		KeyDesc			description of key dimensions
- **		QueryPoint		point in D-space to find neighbors of
- **		MaxNeighbors		maximum # of neighbors to find
- **		Radius			current distance of furthest neighbor
- **		Furthest		index of furthest neighbor
- **		Neighbor		buffer of current neighbors
- **		Distance		buffer of neighbor distances
- **		SBMin			lower extent of small search region
- **		SBMax			upper extent of small search region
- **		LBMin			lower extent of large search region
- **		LBMax			upper extent of large search region
- **		QuickExit		quick exit from recursive search
+ **	Globals: none
  **	Operation:
  **		This routine searches SubTree for those entries which are
  **		possibly among the MaxNeighbors nearest neighbors of the
@@ -556,66 +734,72 @@ void Search(int Level, KDNODE *SubTree) {
  **		3/11/89, DSJ, Created.
  **		7/13/89, DSJ, Save node contents, not node, in neighbor buffer
  */
+  KDTREE *Tree = State->Tree;
+  FLOAT32 *SBMin = State->SBMin;
+  FLOAT32 *SBMax = State->SBMax;
+  FLOAT32 *LBMin = State->LBMin;
+  FLOAT32 *LBMax = State->LBMax;
   FLOAT32 d;
   FLOAT32 OldSBoxEdge;
   FLOAT32 OldLBoxEdge;
 
-  if (Level >= N)
+  if (Level >= Tree->KeySize)
     Level = 0;
 
-  d = ComputeDistance (N, KeyDesc, QueryPoint, SubTree->Key);
-  if (d < Radius) {
-    if (NumberOfNeighbors < MaxNeighbors) {
-      Neighbor[NumberOfNeighbors] = SubTree->Data;
-      Distance[NumberOfNeighbors] = d;
-      NumberOfNeighbors++;
-      if (NumberOfNeighbors == MaxNeighbors)
-        FindMaxDistance();
+  d = ComputeDistance (Tree->KeySize, Tree->KeyDesc, State->QueryPoint,
+    SubTree->Key);
+  if (d < State->Radius) {
+    if (State->NumberOfNeighbors < State->MaxNeighbors) {
+      State->Neighbor[State->NumberOfNeighbors] = SubTree->Data;
+      State->Distance[State->NumberOfNeighbors] = d;
+      State->NumberOfNeighbors++;
+      if (State->NumberOfNeighbors == State->MaxNeighbors)
+        FindMaxDistance(State);
     }
     else {
-      Neighbor[Furthest] = SubTree->Data;
-      Distance[Furthest] = d;
-      FindMaxDistance();
+      State->Neighbor[State->Furthest] = SubTree->Data;
+      State->Distance[State->Furthest] = d;
+      FindMaxDistance(State);
     }
   }
-  if (QueryPoint[Level] < SubTree->BranchPoint) {
+  if (State->QueryPoint[Level] < SubTree->BranchPoint) {
     OldSBoxEdge = SBMax[Level];
-    SBMax[Level] = SubTree->LeftBranch;
+    SBMax[Level] = MIN (SBMax[Level], SubTree->LeftBranch);
     OldLBoxEdge = LBMax[Level];
-    LBMax[Level] = SubTree->RightBranch;
+    LBMax[Level] = MIN (LBMax[Level], SubTree->RightBranch);
     if (SubTree->Left != NULL)
-      Search (NextLevel(Level), SubTree->Left);
+      Search (State, NextLevel(Tree, Level), SubTree->Left);
     SBMax[Level] = OldSBoxEdge;
     LBMax[Level] = OldLBoxEdge;
     OldSBoxEdge = SBMin[Level];
-    SBMin[Level] = SubTree->RightBranch;
+    SBMin[Level] = MAX (SBMin[Level], SubTree->RightBranch);
     OldLBoxEdge = LBMin[Level];
-    LBMin[Level] = SubTree->LeftBranch;
-    if ((SubTree->Right != NULL) && QueryIntersectsSearch ())
-      Search (NextLevel(Level), SubTree->Right);
+    LBMin[Level] = MAX (LBMin[Level], SubTree->LeftBranch);
+    if ((SubTree->Right != NULL) && QueryIntersectsSearch (State))
+      Search (State, NextLevel(Tree, Level), SubTree->Right);
     SBMin[Level] = OldSBoxEdge;
     LBMin[Level] = OldLBoxEdge;
   }
   else {
     OldSBoxEdge = SBMin[Level];
-    SBMin[Level] = SubTree->RightBranch;
+    SBMin[Level] = MAX (SBMin[Level], SubTree->RightBranch);
     OldLBoxEdge = LBMin[Level];
-    LBMin[Level] = SubTree->LeftBranch;
+    LBMin[Level] = MAX (LBMin[Level], SubTree->LeftBranch);
     if (SubTree->Right != NULL)
-      Search (NextLevel(Level), SubTree->Right);
+      Search (State, NextLevel(Tree, Level), SubTree->Right);
     SBMin[Level] = OldSBoxEdge;
     LBMin[Level] = OldLBoxEdge;
     OldSBoxEdge = SBMax[Level];
-    SBMax[Level] = SubTree->LeftBranch;
+    SBMax[Level] = MIN (SBMax[Level], SubTree->LeftBranch);
     OldLBoxEdge = LBMax[Level];
-    LBMax[Level] = SubTree->RightBranch;
-    if ((SubTree->Left != NULL) && QueryIntersectsSearch ())
-      Search (NextLevel(Level), SubTree->Left);
+    LBMax[Level] = MIN (LBMax[Level], SubTree->RightBranch);
+    if ((SubTree->Left != NULL) && QueryIntersectsSearch (State))
+      Search (State, NextLevel(Tree, Level), SubTree->Left);
     SBMax[Level] = OldSBoxEdge;
     LBMax[Level] = OldLBoxEdge;
   }
-  if (QueryInSearch ())
-    longjmp (QuickExit, 1);
+  if (QueryInSearch (State))
+    longjmp (State->QuickExit, 1);
 }                                /* Search */
 
 
@@ -666,15 +850,11 @@ register FLOAT32 p1[], register FLOAT32 p2[]) {
 
 
 /*---------------------------------------------------------------------------*/
-void FindMaxDistance() {
+void FindMaxDistance(KDSEARCH *State) {
 /*
  **	Parameters:
- **		None
- **	Globals:
- **		MaxNeighbors		maximum # of neighbors to find
- **		Radius			current distance of furthest neighbor
- **		Furthest		index of furthest neighbor
- **		Distance		buffer of neighbor distances
+ **		State		state of the search in progress
+ **	Globals: none
  **	Operation:
  **		This routine searches the Distance buffer for the maximum
  **		distance, places this distance in Radius, and places the
@@ -686,30 +866,25 @@ void FindMaxDistance() {
  **	History:
  **		3/11/89, DSJ, Created.
  */
+  FLOAT32 *Distance = State->Distance;
   int i;
 
-  Radius = Distance[Furthest];
-  for (i = 0; i < MaxNeighbors; i++) {
-    if (Distance[i] > Radius) {
-      Radius = Distance[i];
-      Furthest = i;
+  State->Radius = Distance[State->Furthest];
+  for (i = 0; i < State->MaxNeighbors; i++) {
+    if (Distance[i] > State->Radius) {
+      State->Radius = Distance[i];
+      State->Furthest = i;
     }
   }
 }                                /* FindMaxDistance */
 
 
 /*---------------------------------------------------------------------------*/
-int QueryIntersectsSearch() {
+int QueryIntersectsSearch(KDSEARCH *State) {
 /*
  **	Parameters:
- **		None
- **	Globals:
- **		N			# of features in each key
- **		KeyDesc			descriptions of each dimension
- **		QueryPoint		point in D-space to find neighbors of
- **		Radius			current distance of furthest neighbor
- **		SBMin			lower extent of small search region
- **		SBMax			upper extent of small search region
+ **		State		state of the search in progress
+ **	Globals: none
  **	Operation:
  **		This routine returns TRUE if the query region intersects
  **		the current smallest search region.  The query region is
@@ -736,13 +911,13 @@ int QueryIntersectsSearch() {
   register PARAM_DESC *Dim;
   register FLOAT32 WrapDistance;
 
-  RadiusSquared = Radius * Radius;
-  Query = QueryPoint;
-  Lower = SBMin;
-  Upper = SBMax;
+  RadiusSquared = State->Radius * State->Radius;
+  Query = State->QueryPoint;
+  Lower = State->SBMin;
+  Upper = State->SBMax;
   TotalDistance = 0.0;
-  Dim = KeyDesc;
-  for (i = N; i > 0; i--, Dim++, Query++, Lower++, Upper++) {
+  Dim = State->Tree->KeyDesc;
+  for (i = State->Tree->KeySize; i > 0; i--, Dim++, Query++, Lower++, Upper++) {
     if (Dim->NonEssential)
       continue;
 
@@ -774,17 +949,11 @@ int QueryIntersectsSearch() {
 
 
 /*---------------------------------------------------------------------------*/
-int QueryInSearch() {
+int QueryInSearch(KDSEARCH *State) {
 /*
  **	Parameters:
- **		None
- **	Globals:
- **		N			# of features in each key
- **		KeyDesc			descriptions of each dimension
- **		QueryPoint		point in D-space to find neighbors of
- **		Radius			current distance of furthest neighbor
- **		LBMin			lower extent of large search region
- **		LBMax			upper extent of large search region
+ **		State		state of the search in progress
+ **	Globals: none
  **	Operation:
  **		This routine returns TRUE if the current query region is
  **		totally contained in the current largest search region.
@@ -804,13 +973,16 @@ int QueryInSearch() {
   register FLOAT32 *Lower;
   register FLOAT32 *Upper;
   register PARAM_DESC *Dim;
+  register FLOAT32 Radius;
 
-  Query = QueryPoint;
-  Lower = LBMin;
-  Upper = LBMax;
-  Dim = KeyDesc;
+  Query = State->QueryPoint;
+  Lower = State->LBMin;
+  Upper = State->LBMax;
+  Dim = State->Tree->KeyDesc;
+  Radius = State->Radius;
 
-  for (i = N - 1; i >= 0; i--, Dim++, Query++, Lower++, Upper++) {
+  for (i = State->Tree->KeySize - 1; i >= 0;
+       i--, Dim++, Query++, Lower++, Upper++) {
     if (Dim->NonEssential)
       continue;
 
@@ -822,18 +994,21 @@ int QueryInSearch() {
 
 
 /*---------------------------------------------------------------------------*/
-void Walk(KDNODE *SubTree, inT32 Level) {
+void Walk(KDTREE *Tree, void_proc Action, void *context,
+          KDNODE *SubTree, inT32 Level) {
 /*
  **	Parameters:
+ **		Tree		K-D tree being walked
+ **		Action		action to be performed at every node
+ **		context		passed on to Action at every node
  **		SubTree		ptr to root of subtree to be walked
  **		Level		current level in the tree for this node
- **	Globals:
- **		WalkAction	action to be performed at every node
+ **	Globals: none
  **	Operation:
  **		This routine walks thru the specified SubTree and invokes
- **		WalkAction at each node.  WalkAction is invoked with three
+ **		Action at each node.  Action is invoked with four
  **		arguments as follows:
- **			WalkAction( NodeData, Order, Level )
+ **			Action( context, NodeData, Order, Level )
  **		Data is the data contents of the node being visited,
  **		Order is either preorder,
  **		postorder, endorder, or leaf depending on whether this is
@@ -847,35 +1022,14 @@ void Walk(KDNODE *SubTree, inT32 Level) {
  **		7/13/89, DSJ, Pass node contents, not node, to WalkAction().
  */
   if ((SubTree->Left == NULL) && (SubTree->Right == NULL))
-    (*WalkAction) (SubTree->Data, leaf, Level);
+    (*Action) (context, SubTree->Data, leaf, Level);
   else {
-    (*WalkAction) (SubTree->Data, preorder, Level);
+    (*Action) (context, SubTree->Data, preorder, Level);
     if (SubTree->Left != NULL)
-      Walk (SubTree->Left, NextLevel(Level));
-    (*WalkAction) (SubTree->Data, postorder, Level);
+      Walk (Tree, Action, context, SubTree->Left, NextLevel(Tree, Level));
+    (*Action) (context, SubTree->Data, postorder, Level);
     if (SubTree->Right != NULL)
-      Walk (SubTree->Right, NextLevel(Level));
-    (*WalkAction) (SubTree->Data, endorder, Level);
+      Walk (Tree, Action, context, SubTree->Right, NextLevel(Tree, Level));
+    (*Action) (context, SubTree->Data, endorder, Level);
   }
 }                                /* Walk */
-
-
-/*---------------------------------------------------------------------------*/
-void FreeSubTree(KDNODE *SubTree) {
-/*
- **	Parameters:
- **		SubTree		ptr to root node of sub-tree to be freed
- **	Globals: none
- **	Operation:
- **		This routine recursively frees the memory allocated to
- **		to the specified subtree.
- **	Return: none
- **	Exceptions: none
- **	History: 7/13/89, DSJ, Created.
- */
-  if (SubTree != NULL) {
-    FreeSubTree (SubTree->Left);
-    FreeSubTree (SubTree->Right);
-    memfree(SubTree);
-  }
-}                                /* FreeSubTree */
@@ -26,6 +26,8 @@
 #include "cutil.h"
 #include "ocrfeatures.h"
 
+#include <setjmp.h>
+
 /**
 NOTE:  All circular parameters of all keys must be in the range
 
@@ -50,10 +52,24 @@ typedef struct kdnode
 
 KDNODE;
 
+/** nodes of a tree are carved out of blocks of contiguous memory */
+typedef struct kdnodeblock
+{
+  struct kdnodeblock *Next;      /**< previously allocated block */
+  int NumNodes;                  /**< number of nodes in this block */
+  int NumUsed;                   /**< number of nodes handed out so far */
+  KDNODE Nodes[1];               /**< the nodes themselves */
+}
+
+
+KDNODEBLOCK;
+
 typedef struct
 {
   inT16 KeySize;                 /* number of dimensions in the tree */
   KDNODE Root;                   /* Root.Left points to actual root node */
+  KDNODEBLOCK *NodeBlocks;       /* storage for the nodes of the tree */
+  KDNODE *FreeNodes;             /* deleted nodes, linked thru Left */
   PARAM_DESC KeyDesc[1];         /* description of each dimension */
 }
 
@@ -68,6 +84,27 @@ typedef enum {
 
 VISIT;
 
+/** state of a single nearest neighbor search */
+typedef struct
+{
+  KDTREE *Tree;                  /**< tree being searched */
+  FLOAT32 *QueryPoint;           /**< point to find neighbors of */
+  int MaxNeighbors;              /**< maximum # of neighbors to find */
+  int NumberOfNeighbors;         /**< # of neighbors found so far */
+  FLOAT32 Radius;                /**< distance of furthest neighbor */
+  int Furthest;                  /**< index of furthest neighbor */
+  char **Neighbor;               /**< buffer of current neighbors */
+  FLOAT32 *Distance;             /**< buffer of neighbor distances */
+  FLOAT32 *SBMin;                /**< small search region box */
+  FLOAT32 *SBMax;
+  FLOAT32 *LBMin;                /**< large search region box */
+  FLOAT32 *LBMax;
+  jmp_buf QuickExit;             /**< quick exit from recursive search */
+}
+
+
+KDSEARCH;
+
 /*----------------------------------------------------------------------------
             Macros
 -----------------------------------------------------------------------------*/
@@ -78,6 +115,9 @@ VISIT;
 -----------------------------------------------------------------------------*/
 KDTREE *MakeKDTree (inT16 KeySize, PARAM_DESC KeyDesc[]);
 
+KDTREE *MakeKDTreeFromKeys (inT16 KeySize, PARAM_DESC KeyDesc[],
+int NumKeys, FLOAT32 *Keys[], void *Data[]);
+
 void KDStore(KDTREE *Tree, FLOAT32 *Key, void *Data);
 
 void KDDelete (KDTREE * Tree, FLOAT32 Key[], void *Data);
@@ -88,32 +128,41 @@ int QuerySize,
 FLOAT32 MaxDistance,
 void *NBuffer, FLOAT32 DBuffer[]);
 
-void KDWalk(KDTREE *Tree, void_proc Action);
+void KDNearestNeighborBatch (KDTREE * Tree,
+int NumQueries,
+FLOAT32 *Queries[],
+int QuerySize,
+FLOAT32 MaxDistance,
+void *NBuffer, FLOAT32 DBuffer[], int NumFound[]);
+
+void KDWalk(KDTREE *Tree, void_proc Action, void *context);
 
 void FreeKDTree(KDTREE *Tree);
 
 /*-----------------------------------------------------------------------------
           Private Function Prototypes
 -----------------------------------------------------------------------------*/
-int Equal (FLOAT32 Key1[], FLOAT32 Key2[]);
+int Equal (int N, FLOAT32 Key1[], FLOAT32 Key2[]);
 
-KDNODE *MakeKDNode (FLOAT32 Key[], char *Data, int Index);
+KDNODE *MakeKDNode (KDTREE *Tree, FLOAT32 Key[], char *Data, int Index);
 
-void FreeKDNode(KDNODE *Node);
+void FreeKDNode(KDTREE *Tree, KDNODE *Node);
 
-void Search(int Level, KDNODE *SubTree);
+KDNODE *BuildSubTree (KDTREE *Tree, FLOAT32 *Keys[], void *Data[],
+int Order[], int Lo, int Hi, int Level);
+
+void Search(KDSEARCH *State, int Level, KDNODE *SubTree);
 
 FLOAT32 ComputeDistance (register int N,
 register PARAM_DESC Dim[],
 register FLOAT32 p1[], register FLOAT32 p2[]);
 
-void FindMaxDistance();
-
-int QueryIntersectsSearch();
+void FindMaxDistance(KDSEARCH *State);
 
-int QueryInSearch();
+int QueryIntersectsSearch(KDSEARCH *State);
 
-void Walk(KDNODE *SubTree, inT32 Level);
+int QueryInSearch(KDSEARCH *State);
 
-void FreeSubTree(KDNODE *SubTree);
+void Walk(KDTREE *Tree, void_proc Action, void *context,
+          KDNODE *SubTree, inT32 Level);
 #endif
@@ -47,6 +47,17 @@
 INT_VAR(dawg_debug_level, 0, "Set to 1 for general debug info"
         ", to 2 for more details, to 3 to see all the debug messages");
 
+INT_VAR(dawg_edge_cache_size, 4096,
+        "Number of entries in the cache of dawg edge lookups made"
+        " while permuting a word (0 disables the cache)");
+
+BOOL_VAR(dawg_edge_cache_stats, 0,
+         "Print dawg edge cache statistics at the end of the run");
+
+BOOL_VAR(dawg_use_double_array, 0,
+         "Convert the dawgs loaded from the traineddata file into"
+         " double-array dawgs (faster lookups, more memory)");
+
 /*----------------------------------------------------------------------
               F u n c t i o n s   f o r   D a w g
 ----------------------------------------------------------------------*/
@@ -153,6 +164,27 @@ void Dawg::init(DawgType type, const STRING &lang,
 }
 
 
+/*----------------------------------------------------------------------
+         F u n c t i o n s   f o r   D a w g   E d g e   C a c h e
+----------------------------------------------------------------------*/
+
+void DawgEdgeCache::resize(int size) {
+  delete[] entries_;
+  entries_ = NULL;
+  size_ = 0;
+  generation_ = 1;
+  if (size <= 0) return;
+  for (size_ = 1; size_ < size; size_ <<= 1);
+  entries_ = new Entry[size_];
+}
+
+void DawgEdgeCache::print_stats() const {
+  tprintf("Dawg edge cache: " REFFORMAT " lookups, " REFFORMAT
+          " edge scans saved (%.1f%%)\n", num_lookups_, num_hits_,
+          num_lookups_ > 0 ? 100.0 * num_hits_ / num_lookups_ : 0.0);
+}
+
+
 /*----------------------------------------------------------------------
          F u n c t i o n s   f o r   S q u i s h e d    D a w g
 ----------------------------------------------------------------------*/
@@ -397,4 +429,166 @@ void SquishedDawg::write_squished_dawg(const char *filename) {
   fclose(file);
 }
 
+/*----------------------------------------------------------------------
+     F u n c t i o n s   f o r   D o u b l e   A r r a y   D a w g
+----------------------------------------------------------------------*/
+
+DoubleArrayDawg::DoubleArrayDawg(DawgType type, const STRING &lang,
+                                 PermuterType perm, int unicharset_size,
+                                 int num_nodes, int num_edges)
+    : check_(NULL), next_(NULL), num_nodes_(num_nodes), num_slots_(0),
+      num_reserved_slots_(0), first_free_slot_(0) {
+  init(type, lang, perm, unicharset_size);
+  base_ = new inT32[num_nodes];
+  children_start_ = new inT32[num_nodes + 1];
+  children_ = new UNICHAR_ID[num_edges > 0 ? num_edges : 1];
+}
+
+DoubleArrayDawg::~DoubleArrayDawg() {
+  delete[] base_;
+  delete[] check_;
+  delete[] next_;
+  delete[] children_start_;
+  delete[] children_;
+}
+
+DoubleArrayDawg *DoubleArrayDawg::FromSquishedDawg(const SquishedDawg &dawg) {
+  int num_edges = dawg.num_edges();
+  int n, c;
+  // Number the nodes in breadth-first order, so that the nodes close to
+  // the root (which are visited most often) end up close together.
+  inT32 *node_ids = new inT32[num_edges + 1];
+  for (n = 0; n <= num_edges; ++n) node_ids[n] = -1;
+  GenericVector<NODE_REF> node_refs;
+  node_refs.push_back(0);
+  node_ids[0] = 0;
+  NodeChildVector children;
+  for (n = 0; n < node_refs.size() && num_edges > 0; ++n) {
+    children.clear();
+    dawg.unichar_ids_of(node_refs[n], &children);
+    for (c = 0; c < children.size(); ++c) {
+      NODE_REF next = dawg.next_node(children[c].edge_ref);
+      if (next != 0 && node_ids[next] == -1) {
+        node_ids[next] = node_refs.size();
+        node_refs.push_back(next);
+      }
+    }
+  }
+
+  DoubleArrayDawg *da_dawg = new DoubleArrayDawg(
+      dawg.type(), dawg.lang(), dawg.permuter(), dawg.unicharset_size(),
+      node_refs.size(), num_edges);
+  inT32 num_children = 0;
+  inT32 max_base = 0;
+  for (n = 0; n < node_refs.size(); ++n) {
+    children.clear();
+    if (num_edges > 0) dawg.unichar_ids_of(node_refs[n], &children);
+    // Sort the edges by unichar id (insertion sort, since most nodes
+    // have very few edges) and reject duplicate unichar ids.
+    for (c = 1; c < children.size(); ++c) {
+      NodeChild child = children[c];
+      int i = c;
+      for (; i > 0 && children[i - 1].unichar_id > child.unichar_id; --i)
+        children[i] = children[i - 1];
+      children[i] = child;
+    }
+    for (c = 1; c < children.size(); ++c) {
+      if (children[c].unichar_id == children[c - 1].unichar_id) {
+        if (dawg_debug_level) {
+          tprintf("Duplicate unichar id %d in dawg node " REFFORMAT "\n",
+                  children[c].unichar_id, node_refs[n]);
+        }
+        delete[] node_ids;
+        delete da_dawg;
+        return NULL;
+      }
+    }
+    da_dawg->children_start_[n] = num_children;
+    da_dawg->base_[n] = 0;
+    if (children.empty()) continue;
+    inT32 base = da_dawg->find_base(children);
+    da_dawg->base_[n] = base;
+    if (base > max_base) max_base = base;
+    da_dawg->reserve_slots(base + children[children.size() - 1].unichar_id + 1);
+    for (c = 0; c < children.size(); ++c) {
+      inT32 slot = base + children[c].unichar_id;
+      NODE_REF next = dawg.next_node(children[c].edge_ref);
+      da_dawg->check_[slot] = n;
+      da_dawg->next_[slot] = (next == 0 ? 0 : node_ids[next] << 1) |
+        (dawg.end_of_word(children[c].edge_ref) ? 1 : 0);
+      da_dawg->children_[num_children++] = children[c].unichar_id;
+    }
+    while (da_dawg->first_free_slot_ < da_dawg->num_reserved_slots_ &&
+           da_dawg->check_[da_dawg->first_free_slot_] != -1) {
+      ++da_dawg->first_free_slot_;
+    }
+  }
+  da_dawg->children_start_[node_refs.size()] = num_children;
+  // Make base_[n] + unichar_id a valid slot index for any unichar id,
+  // so that edge_char_of() only needs to check the owner of the slot.
+  da_dawg->num_slots_ = max_base + da_dawg->unicharset_size_;
+  da_dawg->reserve_slots(da_dawg->num_slots_);
+  delete[] node_ids;
+  if (dawg_debug_level) {
+    tprintf("Built double-array dawg: %d nodes, %d edges, %d slots\n",
+            da_dawg->num_nodes_, num_children, da_dawg->num_slots_);
+  }
+  return da_dawg;
+}
+
+void DoubleArrayDawg::reserve_slots(int size) {
+  if (size <= num_reserved_slots_) return;
+  int new_size = MAX(size, 2 * num_reserved_slots_);
+  inT32 *new_check = new inT32[new_size];
+  inT32 *new_next = new inT32[new_size];
+  for (int i = 0; i < new_size; ++i) {
+    new_check[i] = (i < num_reserved_slots_) ? check_[i] : -1;
+    new_next[i] = (i < num_reserved_slots_) ? next_[i] : 0;
+  }
+  delete[] check_;
+  delete[] next_;
+  check_ = new_check;
+  next_ = new_next;
+  num_reserved_slots_ = new_size;
+}
+
+inT32 DoubleArrayDawg::find_base(const NodeChildVector &children) {
+  UNICHAR_ID first_unichar_id = children[0].unichar_id;
+  for (inT32 slot = first_free_slot_; ; ++slot) {
+    if (slot < num_reserved_slots_ && check_[slot] != -1) continue;
+    inT32 base = slot - first_unichar_id;
+    if (base < 0) continue;
+    int c;
+    for (c = 1; c < children.size(); ++c) {
+      inT32 other_slot = base + children[c].unichar_id;
+      if (other_slot < num_reserved_slots_ && check_[other_slot] != -1) break;
+    }
+    if (c == children.size()) return base;
+  }
+}
+
+void DoubleArrayDawg::unichar_ids_of(NODE_REF node,
+                                     NodeChildVector *vec) const {
+  if (node < 0 || node >= num_nodes_) return;
+  for (int i = children_start_[node]; i < children_start_[node + 1]; ++i) {
+    vec->push_back(NodeChild(children_[i], base_[node] + children_[i]));
+  }
+}
+
+void DoubleArrayDawg::print_node(NODE_REF node, int max_num_edges) const {
+  if (node < 0 || node >= num_nodes_) return;
+  int num_children = children_start_[node + 1] - children_start_[node];
+  if (num_children == 0) {
+    tprintf(REFFORMAT " : no edges in this node\n", node);
+    return;
+  }
+  for (int i = 0; i < num_children && i < max_num_edges; ++i) {
+    EDGE_REF slot = base_[node] + children_[children_start_[node] + i];
+    tprintf(REFFORMAT " : next = " REFFORMAT ", unichar_id = %d, %s\n",
+            slot, next_node(slot), edge_letter(slot),
+            end_of_word(slot) ? "EOW" : "");
+  }
+  tprintf("\n");
+}
+
 }  // namespace tesseract
@@ -42,6 +42,14 @@
 
 extern INT_VAR_H(dawg_debug_level, 0, "Set to 1 for general debug info, to"
                  " 2 for more details, to 3 to see all the debug messages");
+extern INT_VAR_H(dawg_edge_cache_size, 4096,
+                 "Number of entries in the cache of dawg edge lookups made"
+                 " while permuting a word (0 disables the cache)");
+extern BOOL_VAR_H(dawg_edge_cache_stats, 0,
+                  "Print dawg edge cache statistics at the end of the run");
+extern BOOL_VAR_H(dawg_use_double_array, 0,
+                  "Convert the dawgs loaded from the traineddata file into"
+                  " double-array dawgs (faster lookups, more memory)");
 
 #ifdef __MSW32__
 #define NO_EDGE                (inT64) 0xffffffffffffffffi64
@@ -139,6 +147,7 @@ class Dawg {
   inline DawgType type() const { return type_; }
   inline const STRING &lang() const { return lang_; }
   inline PermuterType permuter() const { return perm_; }
+  inline int unicharset_size() const { return unicharset_size_; }
 
   virtual ~Dawg() {};
 
@@ -334,6 +343,86 @@ class DawgInfoVector : public GenericVector<DawgInfo> {
   }
 };
 
+//
+/// Direct-mapped cache of the results of Dawg::edge_char_of() calls keyed
+/// on the dawg index, the node (which identifies the prefix matched so far),
+/// the unichar id and the word end flag. The permuters explore the same
+/// prefixes over and over again: in sibling branches of permute_choices(),
+/// in the successor dawgs checked by letter_is_okay() and in the multiple
+/// permute_all() calls made for each segmentation of a word. Each cached
+/// lookup saves a scan of the edges of the node.
+///
+/// The cache must be cleared whenever an edge is added to one of the dawgs
+/// (e.g. a document word to the document Trie), since this may change the
+/// EDGE_REFs of the edges in a Trie node.
+//
+class DawgEdgeCache {
+ public:
+  DawgEdgeCache() : entries_(NULL), size_(0), generation_(1),
+                    num_lookups_(0), num_hits_(0) {}
+  ~DawgEdgeCache() { delete[] entries_; }
+
+  /// Allocates space for the given number of entries (rounded up to a
+  /// power of 2) and clears the cache. A size of 0 disables caching.
+  void resize(int size);
+
+  /// Invalidates all the entries in constant time.
+  inline void clear() {
+    if (++generation_ == 0) {  // wrapped around: really clear the entries
+      for (int i = 0; i < size_; ++i) entries_[i].generation = 0;
+      generation_ = 1;
+    }
+  }
+
+  /// Returns dawg->edge_char_of(node, unichar_id, word_end), looking it up
+  /// in the cache first.
+  inline EDGE_REF edge_char_of(const Dawg *dawg, int dawg_index,
+                               NODE_REF node, UNICHAR_ID unichar_id,
+                               bool word_end) {
+    ++num_lookups_;
+    if (size_ == 0) return dawg->edge_char_of(node, unichar_id, word_end);
+    uinT32 hash = static_cast<uinT32>(node) * 2654435761U;
+    hash ^= (static_cast<uinT32>(unichar_id) << 1 | word_end) * 40503U;
+    hash ^= static_cast<uinT32>(dawg_index) * 97U;
+    Entry &entry = entries_[hash & (size_ - 1)];
+    if (entry.generation == generation_ && entry.node == node &&
+        entry.unichar_id == unichar_id && entry.dawg_index == dawg_index &&
+        entry.word_end == word_end) {
+      ++num_hits_;
+      return entry.edge;
+    }
+    entry.generation = generation_;
+    entry.node = node;
+    entry.unichar_id = unichar_id;
+    entry.dawg_index = dawg_index;
+    entry.word_end = word_end;
+    entry.edge = dawg->edge_char_of(node, unichar_id, word_end);
+    return entry.edge;
+  }
+
+  inline inT64 num_lookups() const { return num_lookups_; }
+  inline inT64 num_hits() const { return num_hits_; }
+  /// Prints the number of lookups and the number of edge scans saved.
+  void print_stats() const;
+
+ private:
+  struct Entry {
+    Entry() : generation(0) {}
+    NODE_REF node;
+    EDGE_REF edge;
+    UNICHAR_ID unichar_id;
+    inT16 dawg_index;
+    bool word_end;
+    uinT32 generation;
+  };
+
+  Entry *entries_;
+  int size_;
+  uinT32 generation_;  ///< entries from older generations are invalid
+  inT64 num_lookups_;
+  inT64 num_hits_;
+};
+
 //
 /// Concrete class that can operate on a compacted (squished) Dawg (read,
 /// search and write to file). This class is read-only in the sense that
@@ -408,6 +497,9 @@ class SquishedDawg : public Dawg {
   /// Writes the squished/reduced Dawg to a file.
   void write_squished_dawg(const char *filename);
 
+  /// Returns the number of edges in the EDGE_ARRAY.
+  int num_edges() const { return num_edges_; }
+
  private:
   /// Sets the next node link for this edge.
   inline void set_next_node(EDGE_REF edge_ref, EDGE_REF value) {
@@ -469,6 +561,87 @@ class SquishedDawg : public Dawg {
   int num_edges_;
   int num_forward_edges_in_node0;
 };
+
+//
+/// Read-only Dawg stored as a double-array. The edge with unichar id c out
+/// of node n is stored in slot base_[n] + c and is valid if check_[slot]
+/// is n, so following an edge takes a constant number of array accesses
+/// regardless of the number of edges in the node (SquishedDawg scans the
+/// EDGE_RECORDs of the node instead).
+///
+/// NODE_REFs are dense node indices and EDGE_REFs are slot indices. As in
+/// SquishedDawg, node 0 is the root and an edge with next node 0 ends a word
+/// that has no continuations.
+//
+class DoubleArrayDawg : public Dawg {
+ public:
+  /// Builds a double-array with the same contents as the given dawg.
+  /// Returns NULL if a node of the dawg has several edges with the same
+  /// unichar id, which the double-array can not represent.
+  static DoubleArrayDawg *FromSquishedDawg(const SquishedDawg &dawg);
+  ~DoubleArrayDawg();
+
+  /// Returns the edge that corresponds to the letter out of this node.
+  EDGE_REF edge_char_of(NODE_REF node, UNICHAR_ID unichar_id,
+                        bool word_end) const {
+    if (node < 0 || node >= num_nodes_ ||
+        unichar_id < 0 || unichar_id >= unicharset_size_) return NO_EDGE;
+    EDGE_REF slot = base_[node] + unichar_id;
+    if (check_[slot] != node || (word_end && !(next_[slot] & 1)))
+      return NO_EDGE;
+    return slot;
+  }
+
+  /// Fills the given NodeChildVector with all the unichar ids (and the
+  /// corresponding EDGE_REFs) for which there is an edge out of this node.
+  void unichar_ids_of(NODE_REF node, NodeChildVector *vec) const;
+
+  /// Returns the next node visited by following the edge
+  /// indicated by the given EDGE_REF.
+  NODE_REF next_node(EDGE_REF edge_ref) const {
+    return next_[edge_ref] >> 1;
+  }
+
+  /// Returns true if the edge indicated by the given EDGE_REF
+  /// marks the end of a word.
+  bool end_of_word(EDGE_REF edge_ref) const {
+    return (next_[edge_ref] & 1) != 0;
+  }
+
+  /// Returns UNICHAR_ID stored in the edge indicated by the given EDGE_REF.
+  UNICHAR_ID edge_letter(EDGE_REF edge_ref) const {
+    return edge_ref - base_[check_[edge_ref]];
+  }
+
+  /// Prints the contents of the node indicated by the given NODE_REF.
+  /// At most max_num_edges will be printed.
+  void print_node(NODE_REF node, int max_num_edges) const;
+
+  inline int num_nodes() const { return num_nodes_; }
+  inline int num_slots() const { return num_slots_; }
+
+ private:
+  DoubleArrayDawg(DawgType type, const STRING &lang, PermuterType perm,
+                  int unicharset_size, int num_nodes, int num_edges);
+
+  /// Grows check_ and next_ so that they have at least size slots.
+  void reserve_slots(int size);
+
+  /// Finds the smallest base at which all the given (sorted) unichar ids
+  /// fall into free slots.
+  inT32 find_base(const NodeChildVector &children);
+
+  // Member variables.
+  inT32 *base_;            ///< first slot of each node
+  inT32 *check_;           ///< node owning each slot (-1 if free)
+  inT32 *next_;            ///< next node << 1 | word end flag for each slot
+  inT32 *children_start_;  ///< index of the first child of each node
+  UNICHAR_ID *children_;   ///< unichar ids of the edges of all the nodes
+  int num_nodes_;
+  int num_slots_;
+  int num_reserved_slots_;
+  int first_free_slot_;
+};
 }  // namespace tesseract
 
 #endif
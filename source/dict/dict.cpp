@@ -110,7 +110,8 @@ int Dict::def_letter_is_okay(void* void_dawg_args, int word_index,
     }
     // Find the edge out of the node for the curent unichar_id.
     EDGE_REF edge = (node != NO_EDGE) ?
-      dawg->edge_char_of(node, unichar_id, word_end) : NO_EDGE;
+      edge_cache_.edge_char_of(dawg, info.dawg_index, node,
+                               unichar_id, word_end) : NO_EDGE;
 
     if (dawg_debug_level >= 3) {
       tprintf("Active dawg: [%d, " REFFORMAT "] edge=" REFFORMAT "\n",
@@ -132,7 +133,8 @@ int Dict::def_letter_is_okay(void* void_dawg_args, int word_index,
       // This constraint will be applied later when this dawg is found among
       // successor dawgs as well potentially at the end of the word.
       if (dawg->type() == DAWG_TYPE_PUNCTUATION) {
-        edge = dawg->edge_char_of(node, Dawg::kPatternUnicharID, word_end);
+        edge = edge_cache_.edge_char_of(dawg, info.dawg_index, node,
+                                        Dawg::kPatternUnicharID, word_end);
         if (edge != NO_EDGE) {
           dawg_args->updated_constraints->add_unique(
               DawgInfo(info.dawg_index, edge), "Recording constraint: ");
@@ -186,8 +188,8 @@ int Dict::def_letter_is_okay(void* void_dawg_args, int word_index,
           }
         }
         // Look for the letter in this successor dawg.
-        EDGE_REF sedge = sdawg->edge_char_of(
-            snode, word->unichar_id(word_index), word_end);
+        EDGE_REF sedge = edge_cache_.edge_char_of(
+            sdawg, sdawg_index, snode, word->unichar_id(word_index), word_end);
         // If we found the letter append sdawg to the active_dawgs list.
         if (sedge != NO_EDGE &&
             ConstraintsOk(*(dawg_args->updated_constraints), word_end,
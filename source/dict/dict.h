@@ -165,6 +165,12 @@ class Dict {
       int char_choice_index, const CHAR_FRAGMENT_INFO *prev_char_frag_info,
       bool word_ending, WERD_CHOICE *word, float certainties[],
       float *limit, WERD_CHOICE *best_choice, void *void_more_args);
+  /// Returns true if the unichar at word_index in the given word is allowed
+  /// by the dawgs in light of the state in dawg_args (the unigrams of an
+  /// ngram are checked separately first). The updated state is left in
+  /// dawg_args->updated_active_dawgs and dawg_args->updated_constraints.
+  bool dawg_letter_okay(DawgArgs *dawg_args, int word_index,
+                        WERD_CHOICE *word, bool word_ending);
 
   /* permute.cpp *************************************************************/
   void add_document_word(const WERD_CHOICE &best_choice);
@@ -193,7 +199,31 @@ class Dict {
   WERD_CHOICE *permute_all(const BLOB_CHOICE_LIST_VECTOR &char_choices,
                            float rating_limit,
                            WERD_CHOICE *raw_choice);
+  /// Explores dictionary words and character fragment combinations in
+  /// char_choices with a single beam search that keeps at most
+  /// permute_beam_width partial words per position. Used by permute_all()
+  /// in place of dawg_permute_and_select() and
+  /// top_fragments_permute_and_select() when permute_beam_width > 0.
+  WERD_CHOICE *beam_permute_and_select(
+      const BLOB_CHOICE_LIST_VECTOR &char_choices,
+      float rating_limit, float top_choice_rating_limit,
+      bool explore_dawgs, bool explore_fragments);
   void end_permute();
+  /// Adds the given dawg to the dawgs searched when permuting words,
+  /// without reloading the language model. The dawg is not owned by the
+  /// Dict, so one pre-built dawg can be shared by many instances; it must
+  /// outlive its use here (see remove_user_dawg()). User dawgs are dropped
+  /// by end_permute(). Returns false if the dawgs are not loaded yet or
+  /// the dawg was already added.
+  bool add_user_dawg(const Dawg *dawg);
+  /// Stops searching the given dawg added by add_user_dawg().
+  /// Returns false if the dawg was not added.
+  bool remove_user_dawg(const Dawg *dawg);
+  /// Returns a new dawg with the words listed in the given file (one word
+  /// per line) that can be passed to add_user_dawg() of any Dict with the
+  /// same unicharset. The caller owns the returned dawg.
+  /// Returns NULL if the file can not be read.
+  Dawg *read_user_words(const char *filename, PermuterType perm);
   void adjust_non_word(WERD_CHOICE *word, float *adjust_factor);
   void permute_subword(const BLOB_CHOICE_LIST_VECTOR &char_choices,
                        float rating_limit,
@@ -401,6 +431,13 @@ class Dict {
                          const void* word, bool word_end);
   int (Dict::*letter_is_okay_)(void* void_dawg_args, int word_index,
                                const void *word, bool word_end);
+  /// Forgets the dawg edges looked up so far. Called at the start of each
+  /// word and whenever a word is added to one of the dawgs.
+  inline void reset_dawg_edge_cache() { edge_cache_.clear(); }
+  /// Returns the cache of dawg edges (e.g. to report its statistics).
+  inline const DawgEdgeCache &dawg_edge_cache() const { return edge_cache_; }
+  /// Fills successors_ from the types of the dawgs in dawgs_.
+  void init_successors();
   /** Return the number of dawgs in the dawgs_ vector. */
   inline const int NumDawgs() const { return dawgs_.size(); }
   /** Return i-th dawg pointer recorded in the dawgs_ vector. */
@@ -479,8 +516,12 @@ class Dict {
   // Dawgs.
   DawgVector dawgs_;
   SuccessorListsVector successors_;
+  /// Dawgs added by add_user_dawg() (also in dawgs_, but not owned).
+  DawgVector user_dawgs_;
   Dawg *freq_dawg_;
   Trie *pending_words_;
+  /// Results of edge_char_of() calls made by def_letter_is_okay().
+  DawgEdgeCache edge_cache_;
   /// The following pointers are only cached for convenience.
   /// The dawgs will be deleted when dawgs_ vector is destroyed.
   // TODO(daria): need to support multiple languages in the future,
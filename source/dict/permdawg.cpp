@@ -171,74 +171,9 @@ void Dict::go_deeper_dawg_fxn(
                     *(more_args->constraints));
     update_best_choice(*word, best_choice);
   } else {  // Look up char in DAWG
-    // TODO(daria): update the rest of the code that specifies alternative
-    // letter_is_okay_ functions (e.g. TessCharNgram class) to work with
-    // multi-byte unichars and/or unichar ids.
-
-    // If the current unichar is an ngram first try calling
-    // letter_is_okay() for each unigram it contains separately.
-    UNICHAR_ID orig_uch_id = word->unichar_id(word_index);
-    bool checked_unigrams = false;
-    if (getUnicharset().get_isngram(orig_uch_id)) {
-      if (segment_dawg_debug) {
-        tprintf("checking unigrams in an ngram %s\n",
-                getUnicharset().debug_str(orig_uch_id).string());
-      }
-      int orig_num_fragments = word->fragment_length(word_index);
-      int num_unigrams = 0;
-      word->remove_last_unichar_id();
-      const char *ngram_str = getUnicharset().id_to_unichar(orig_uch_id);
-      const char *ngram_str_end = ngram_str + strlen(ngram_str);
-      const char *ngram_ptr = ngram_str;
-      bool unigrams_ok = true;
-      // Construct DawgArgs that reflect the current state.
-      DawgInfoVector unigram_active_dawgs = *(more_args->active_dawgs);
-      DawgInfoVector unigram_constraints = *(more_args->constraints);
-      DawgInfoVector unigram_updated_active_dawgs;
-      DawgInfoVector unigram_updated_constraints;
-      DawgArgs unigram_dawg_args(&unigram_active_dawgs, &unigram_constraints,
-                                 &unigram_updated_active_dawgs,
-                                 &unigram_updated_constraints, 0.0);
-      unigram_dawg_args.permuter = more_args->permuter;
-      // Check unigrams in the ngram with letter_is_okay().
-      while (unigrams_ok && ngram_ptr < ngram_str_end) {
-        int step = getUnicharset().step(ngram_ptr);
-        UNICHAR_ID uch_id = (step <= 0) ? INVALID_UNICHAR_ID :
-            getUnicharset().unichar_to_id(ngram_ptr, step);
-        ngram_ptr += step;
-        ++num_unigrams;
-        word->append_unichar_id(uch_id, 1, 0.0, 0.0);
-        unigrams_ok = unigrams_ok && (this->*letter_is_okay_)(
-            &unigram_dawg_args, word_index+num_unigrams-1, word,
-            word_ending && (ngram_ptr == ngram_str_end));
-        (*unigram_dawg_args.active_dawgs) =
-          *(unigram_dawg_args.updated_active_dawgs);
-        (*unigram_dawg_args.constraints) =
-          *(unigram_dawg_args.updated_constraints);
-        if (segment_dawg_debug) {
-          tprintf("unigram %s is %s\n",
-                  getUnicharset().debug_str(uch_id).string(),
-                  unigrams_ok ? "OK" : "not OK");
-        }
-      }
-      // Restore the word and copy the updated dawg state if needed.
-      while (num_unigrams-- > 0) word->remove_last_unichar_id();
-      word->append_unichar_id_space_allocated(
-          orig_uch_id, orig_num_fragments, 0.0, 0.0);
-      if (unigrams_ok) {
-        checked_unigrams = true;
-        more_args->permuter = unigram_dawg_args.permuter;
-        *(more_args->updated_active_dawgs) =
-          *(unigram_dawg_args.updated_active_dawgs);
-        *(more_args->updated_constraints) =
-          *(unigram_dawg_args.updated_constraints);
-      }
-    }
-
     // Check which dawgs from dawgs_ vector contain the word
     // up to and including the current unichar.
-    if (checked_unigrams ||
-        (this->*letter_is_okay_)(more_args, word_index, word, word_ending)) {
+    if (dawg_letter_okay(more_args, word_index, word, word_ending)) {
       // Add a new word choice
       if (word_ending) {
         if (segment_dawg_debug) {
@@ -283,6 +218,84 @@ void Dict::go_deeper_dawg_fxn(
   }
 }
 
+/**
+ * @name dawg_letter_okay
+ *
+ * Returns true if the unichar at word_index in the given word is allowed
+ * by at least one of the dawgs in light of the state recorded in dawg_args.
+ * If the unichar is an ngram, each of the unigrams it contains is checked
+ * separately first. The updated dawg state is left in
+ * dawg_args->updated_active_dawgs and dawg_args->updated_constraints.
+ */
+bool Dict::dawg_letter_okay(DawgArgs *dawg_args, int word_index,
+                            WERD_CHOICE *word, bool word_ending) {
+  // TODO(daria): update the rest of the code that specifies alternative
+  // letter_is_okay_ functions (e.g. TessCharNgram class) to work with
+  // multi-byte unichars and/or unichar ids.
+
+  // If the current unichar is an ngram first try calling
+  // letter_is_okay() for each unigram it contains separately.
+  UNICHAR_ID orig_uch_id = word->unichar_id(word_index);
+  bool checked_unigrams = false;
+  if (getUnicharset().get_isngram(orig_uch_id)) {
+    if (segment_dawg_debug) {
+      tprintf("checking unigrams in an ngram %s\n",
+              getUnicharset().debug_str(orig_uch_id).string());
+    }
+    int orig_num_fragments = word->fragment_length(word_index);
+    int num_unigrams = 0;
+    word->remove_last_unichar_id();
+    const char *ngram_str = getUnicharset().id_to_unichar(orig_uch_id);
+    const char *ngram_str_end = ngram_str + strlen(ngram_str);
+    const char *ngram_ptr = ngram_str;
+    bool unigrams_ok = true;
+    // Construct DawgArgs that reflect the current state.
+    DawgInfoVector unigram_active_dawgs = *(dawg_args->active_dawgs);
+    DawgInfoVector unigram_constraints = *(dawg_args->constraints);
+    DawgInfoVector unigram_updated_active_dawgs;
+    DawgInfoVector unigram_updated_constraints;
+    DawgArgs unigram_dawg_args(&unigram_active_dawgs, &unigram_constraints,
+                               &unigram_updated_active_dawgs,
+                               &unigram_updated_constraints, 0.0);
+    unigram_dawg_args.permuter = dawg_args->permuter;
+    // Check unigrams in the ngram with letter_is_okay().
+    while (unigrams_ok && ngram_ptr < ngram_str_end) {
+      int step = getUnicharset().step(ngram_ptr);
+      UNICHAR_ID uch_id = (step <= 0) ? INVALID_UNICHAR_ID :
+          getUnicharset().unichar_to_id(ngram_ptr, step);
+      ngram_ptr += step;
+      ++num_unigrams;
+      word->append_unichar_id(uch_id, 1, 0.0, 0.0);
+      unigrams_ok = unigrams_ok && (this->*letter_is_okay_)(
+          &unigram_dawg_args, word_index+num_unigrams-1, word,
+          word_ending && (ngram_ptr == ngram_str_end));
+      (*unigram_dawg_args.active_dawgs) =
+        *(unigram_dawg_args.updated_active_dawgs);
+      (*unigram_dawg_args.constraints) =
+        *(unigram_dawg_args.updated_constraints);
+      if (segment_dawg_debug) {
+        tprintf("unigram %s is %s\n",
+                getUnicharset().debug_str(uch_id).string(),
+                unigrams_ok ? "OK" : "not OK");
+      }
+    }
+    // Restore the word and copy the updated dawg state if needed.
+    while (num_unigrams-- > 0) word->remove_last_unichar_id();
+    word->append_unichar_id_space_allocated(
+        orig_uch_id, orig_num_fragments, 0.0, 0.0);
+    if (unigrams_ok) {
+      checked_unigrams = true;
+      dawg_args->permuter = unigram_dawg_args.permuter;
+      *(dawg_args->updated_active_dawgs) =
+        *(unigram_dawg_args.updated_active_dawgs);
+      *(dawg_args->updated_constraints) =
+        *(unigram_dawg_args.updated_constraints);
+    }
+  }
+  return (checked_unigrams ||
+          (this->*letter_is_okay_)(dawg_args, word_index, word, word_ending));
+}
+
 /**
  * dawg_permute_and_select
  *
@@ -86,6 +86,10 @@ BOOL_VAR(permute_debug, 0, "Debug char permutation process");
 double_VAR(bestrate_pruning_factor, 2.0,
            "Multiplying factor of current best rate to prune other hypotheses");
 
+INT_VAR(permute_beam_width, 0,
+        "Maximum number of partial words kept for each position by the "
+        "beam permuter (0 selects the exhaustive permuters)");
+
 BOOL_VAR(permute_script_word, 0,
          "Turn on word script consistency permuter");
 
@@ -222,6 +226,8 @@ void Dict::add_document_word(const WERD_CHOICE &best_choice) {
     fclose(doc_word_file);
   }
   document_words_->add_word_to_dawg(best_choice);
+  // Edge refs cached for the document dawg may have changed.
+  reset_dawg_edge_cache();
 }
 
 
@@ -258,6 +264,23 @@ void Dict::adjust_non_word(WERD_CHOICE *word, float *adjust_factor) {
 }
 
 
+/**
+ * read_squished_dawg
+ *
+ * Read a SquishedDawg from the given file. If dawg_use_double_array is
+ * set, the dawg is converted into a DoubleArrayDawg (unless it contains
+ * nodes that the double-array can not represent).
+ */
+static Dawg *read_squished_dawg(FILE *file, DawgType type,
+                                const STRING &lang, PermuterType perm) {
+  SquishedDawg *squished_dawg = new SquishedDawg(file, type, lang, perm);
+  if (!dawg_use_double_array) return squished_dawg;
+  DoubleArrayDawg *da_dawg = DoubleArrayDawg::FromSquishedDawg(*squished_dawg);
+  if (da_dawg == NULL) return squished_dawg;
+  delete squished_dawg;
+  return da_dawg;
+}
+
 /**
  * init_permute
  *
@@ -277,19 +300,18 @@ void Dict::init_permute() {
   // Load dawgs_.
   if (global_load_punc_dawg &&
       tessdata_manager.SeekToStart(TESSDATA_PUNC_DAWG)) {
-    dawgs_ += new SquishedDawg(tessdata_manager.GetDataFilePtr(),
-                               DAWG_TYPE_PUNCTUATION, lang, PUNC_PERM);
+    dawgs_ += read_squished_dawg(tessdata_manager.GetDataFilePtr(),
+                                 DAWG_TYPE_PUNCTUATION, lang, PUNC_PERM);
   }
   if (global_load_system_dawg &&
       tessdata_manager.SeekToStart(TESSDATA_SYSTEM_DAWG)) {
-    dawgs_ += new SquishedDawg(tessdata_manager.GetDataFilePtr(),
-                               DAWG_TYPE_WORD, lang, SYSTEM_DAWG_PERM);
+    dawgs_ += read_squished_dawg(tessdata_manager.GetDataFilePtr(),
+                                 DAWG_TYPE_WORD, lang, SYSTEM_DAWG_PERM);
   }
   if (global_load_number_dawg &&
       tessdata_manager.SeekToStart(TESSDATA_NUMBER_DAWG)) {
-    dawgs_ +=
-      new SquishedDawg(tessdata_manager.GetDataFilePtr(),
-                       DAWG_TYPE_NUMBER, lang, NUMBER_PERM);
+    dawgs_ += read_squished_dawg(tessdata_manager.GetDataFilePtr(),
+                                 DAWG_TYPE_NUMBER, lang, NUMBER_PERM);
   }
   if (((STRING &)global_user_words_suffix).length() > 0) {
     name = getImage()->getCCUtil()->language_data_path_prefix;
@@ -315,13 +337,24 @@ void Dict::init_permute() {
   // The frequent words dawg is only searched when a word
   // is found in any of the other dawgs.
   if (tessdata_manager.SeekToStart(TESSDATA_FREQ_DAWG)) {
-    freq_dawg_ = new SquishedDawg(tessdata_manager.GetDataFilePtr(),
-                                  DAWG_TYPE_WORD, lang, FREQ_DAWG_PERM);
+    freq_dawg_ = read_squished_dawg(tessdata_manager.GetDataFilePtr(),
+                                    DAWG_TYPE_WORD, lang, FREQ_DAWG_PERM);
   }
 
-  // Construct a list of corresponding successors for each dawg. Each entry i
-  // in the successors_ vector is a vector of integers that represent the
-  // indices into the dawgs_ vector of the successors for dawg i.
+  edge_cache_.resize(dawg_edge_cache_size);
+  init_successors();
+}
+
+/**
+ * init_successors
+ *
+ * Construct a list of corresponding successors for each dawg. Each entry i
+ * in the successors_ vector is a vector of integers that represent the
+ * indices into the dawgs_ vector of the successors for dawg i.
+ */
+void Dict::init_successors() {
+  successors_.delete_data_pointers();
+  successors_.clear();
   successors_.reserve(dawgs_.length());
   for (int i = 0; i < dawgs_.length(); ++i) {
     const Dawg *dawg = dawgs_[i];
@@ -335,9 +368,95 @@ void Dict::init_permute() {
   }
 }
 
+/**
+ * add_user_dawg
+ *
+ * Append the given dawg to dawgs_. The dawgs already in dawgs_ keep
+ * their indices, so the search state of the current word stays valid.
+ */
+bool Dict::add_user_dawg(const Dawg *dawg) {
+  if (dawgs_.length() == 0 || dawg == NULL) return false;
+  for (int i = 0; i < dawgs_.length(); ++i) {
+    if (dawgs_[i] == dawg) return false;
+  }
+  // User dawgs are only read through the Dawg interface.
+  Dawg *user_dawg = const_cast<Dawg *>(dawg);
+  dawgs_ += user_dawg;
+  user_dawgs_ += user_dawg;
+  init_successors();
+  return true;
+}
+
+/**
+ * remove_user_dawg
+ *
+ * Remove the given dawg from dawgs_. The dawgs that follow it move down
+ * by one, so the dawg indices kept for a hyphenated word are updated.
+ */
+bool Dict::remove_user_dawg(const Dawg *dawg) {
+  int u, i;
+  for (u = 0; u < user_dawgs_.length() && user_dawgs_[u] != dawg; ++u);
+  if (u == user_dawgs_.length()) return false;
+  user_dawgs_.remove(u);
+  int index = 0;
+  while (dawgs_[index] != dawg) ++index;
+  dawgs_.remove(index);
+  DawgInfoVector *hyphen_vectors[] = {
+    &hyphen_active_dawgs_, &hyphen_constraints_ };
+  for (int v = 0; v < 2; ++v) {
+    DawgInfoVector *vec = hyphen_vectors[v];
+    for (i = vec->size() - 1; i >= 0; --i) {
+      if ((*vec)[i].dawg_index == index) {
+        vec->GenericVector<DawgInfo>::remove(i);
+      } else if ((*vec)[i].dawg_index > index) {
+        --((*vec)[i].dawg_index);
+      }
+    }
+  }
+  reset_dawg_edge_cache();
+  init_successors();
+  return true;
+}
+
+/**
+ * read_user_words
+ *
+ * Build a dawg from a word list, directly if the list is sorted and
+ * through a Trie otherwise.
+ */
+Dawg *Dict::read_user_words(const char *filename, PermuterType perm) {
+  if (!exists_file(filename)) return NULL;
+  const UNICHARSET &unicharset = getUnicharset();
+  Trie trie(DAWG_TYPE_WORD, getImage()->getCCUtil()->lang, perm,
+            MAX_USER_EDGES, unicharset.size());
+  SquishedDawg *squished_dawg =
+    trie.sorted_word_list_to_dawg(filename, unicharset);
+  if (squished_dawg == NULL) {
+    if (!trie.read_word_list(filename, unicharset)) return NULL;
+    squished_dawg = trie.trie_to_dawg();
+  }
+  if (!dawg_use_double_array) return squished_dawg;
+  DoubleArrayDawg *da_dawg = DoubleArrayDawg::FromSquishedDawg(*squished_dawg);
+  if (da_dawg == NULL) return squished_dawg;
+  delete squished_dawg;
+  return da_dawg;
+}
+
 void Dict::end_permute() {
   if (dawgs_.length() == 0)
     return;  // Not safe to call twice.
+  if (dawg_edge_cache_stats) edge_cache_.print_stats();
+  edge_cache_.resize(0);
+  // User dawgs are owned by the caller of add_user_dawg().
+  for (int i = 0; i < user_dawgs_.length(); ++i) {
+    for (int j = 0; j < dawgs_.length(); ++j) {
+      if (dawgs_[j] == user_dawgs_[i]) {
+        dawgs_.remove(j);
+        break;
+      }
+    }
+  }
+  user_dawgs_.clear();
   dawgs_.delete_data_pointers();
   successors_.delete_data_pointers();
   dawgs_.clear();
@@ -385,8 +504,14 @@ WERD_CHOICE *Dict::permute_all(const BLOB_CHOICE_LIST_VECTOR &char_choices,
     result1 = get_best_delete_other(result1, result2);
   }
 
-  // Permute character fragments if necessary.
-  if (result1 == NULL || result1->fragment_mark()) {
+  if (permute_beam_width > 0) {
+    // Explore dictionary words and character fragments in a single pass.
+    result2 = beam_permute_and_select(
+        char_choices, rating_limit, top_choice_rating_limit,
+        !permute_only_top, result1 == NULL || result1->fragment_mark());
+    result1 = get_best_delete_other(result1, result2);
+  } else if (result1 == NULL || result1->fragment_mark()) {
+    // Permute character fragments if necessary.
     result2 = top_fragments_permute_and_select(char_choices,
                                                top_choice_rating_limit);
     result1 = get_best_delete_other(result1, result2);
@@ -406,8 +531,10 @@ WERD_CHOICE *Dict::permute_all(const BLOB_CHOICE_LIST_VECTOR &char_choices,
   if (permute_only_top)
     return result1;
 
-  result2 = dawg_permute_and_select(char_choices, rating_limit);
-  result1 = get_best_delete_other(result1, result2);
+  if (permute_beam_width <= 0) {
+    result2 = dawg_permute_and_select(char_choices, rating_limit);
+    result1 = get_best_delete_other(result1, result2);
+  }
 
   result2 = permute_compound_words(char_choices, rating_limit);
   result1 = get_best_delete_other(result1, result2);
@@ -415,6 +542,293 @@ WERD_CHOICE *Dict::permute_all(const BLOB_CHOICE_LIST_VECTOR &char_choices,
   return (result1);
 }
 
+/**
+ * Partial word kept by beam_permute_and_select(). The entries of all the
+ * beam columns form a tree: each entry records the unichar (if any) that
+ * was completed at its position and the index of its parent entry in the
+ * previous column, so the words are only built for the surviving leaves.
+ */
+struct PermuteBeamEntry {
+  PermuteBeamEntry() : parent(-1), unichar_id(INVALID_UNICHAR_ID),
+      num_fragments(0), char_rating(0.0), char_certainty(0.0),
+      rating(0.0), score(0.0), in_dawgs(false), top_path(false),
+      hyphen_end(false), permuter(NO_PERM) {
+    frag_info.unichar_id = INVALID_UNICHAR_ID;
+    frag_info.fragment = NULL;
+    frag_info.num_fragments = 0;
+    frag_info.rating = 0.0;
+    frag_info.certainty = 0.0;
+  }
+
+  int parent;                    // index of the parent in previous column
+  UNICHAR_ID unichar_id;         // unichar completed here (or INVALID)
+  int num_fragments;             // number of pieces in unichar_id
+  float char_rating;             // rating of unichar_id
+  float char_certainty;          // certainty of unichar_id
+  float rating;                  // sum of the ratings of completed unichars
+  float score;                   // rating adjusted for ranking in the beam
+  CHAR_FRAGMENT_INFO frag_info;  // state of an unfinished fragment
+  bool in_dawgs;                 // the word so far is a valid dawg prefix
+  bool top_path;                 // only fragments and top non-fragments
+  bool hyphen_end;               // dawg word split by a hyphen at line end
+  PermuterType permuter;         // permuter of the dawgs matched so far
+  DawgInfoVector active_dawgs;
+  DawgInfoVector constraints;
+};
+
+typedef GenericVector<PermuteBeamEntry *> PermuteBeam;
+
+/** qsort comparator ordering beam entries by increasing score. */
+static int compare_beam_entries(const void *e1, const void *e2) {
+  float s1 = (*reinterpret_cast<PermuteBeamEntry * const *>(e1))->score;
+  float s2 = (*reinterpret_cast<PermuteBeamEntry * const *>(e2))->score;
+  return (s1 < s2) ? -1 : (s1 > s2) ? 1 : 0;
+}
+
+/**
+ * Appends to word the unichars on the path from the root of the beam to
+ * the entry at the given index of the given column. Also fills in the
+ * certainty of each unichar appended if certainties is not NULL.
+ */
+static void append_beam_path(const PermuteBeam *beams, int column, int index,
+                             WERD_CHOICE *word, float certainties[]) {
+  GenericVector<const PermuteBeamEntry *> path;
+  for (; column > 0; --column) {
+    const PermuteBeamEntry *entry = beams[column][index];
+    if (entry->unichar_id != INVALID_UNICHAR_ID) path.push_back(entry);
+    index = entry->parent;
+  }
+  for (int i = path.size() - 1; i >= 0; --i) {
+    if (certainties != NULL)
+      certainties[path.size() - 1 - i] = path[i]->char_certainty;
+    word->append_unichar_id_space_allocated(
+        path[i]->unichar_id, path[i]->num_fragments,
+        path[i]->char_rating, path[i]->char_certainty);
+  }
+}
+
+/**
+ * beam_permute_and_select
+ *
+ * Explores the combinations of the choices in char_choices one position
+ * at a time, keeping at most permute_beam_width partial words in each
+ * position. Each partial word carries its own dawg state, which is
+ * extended by one letter_is_okay() call per appended unichar, so the
+ * dictionary words (explored exhaustively by dawg_permute_and_select())
+ * and the combinations of character fragments (explored by
+ * top_fragments_permute_and_select()) are found in the same pass.
+ * With a wide enough beam the search considers every word considered by
+ * those two permuters.
+ *
+ * Returns the best word found, a bad choice if no word was found, or NULL
+ * if there was nothing to explore.
+ */
+WERD_CHOICE *Dict::beam_permute_and_select(
+    const BLOB_CHOICE_LIST_VECTOR &char_choices,
+    float rating_limit, float top_choice_rating_limit,
+    bool explore_dawgs, bool explore_fragments) {
+  int num_positions = char_choices.length();
+  int hyphen_size = hyphen_base_size();
+  int x;
+  BLOB_CHOICE_IT blob_choice_it;
+  if (num_positions == 0) return NULL;
+  if (hyphen_size + num_positions > MAX_WERD_LENGTH)
+    explore_dawgs = false;
+  // Fragments are only permuted when top_fragments_permute_and_select()
+  // would have run.
+  if (num_positions <= 1 || num_positions > MAX_PERM_LENGTH)
+    explore_fragments = false;
+  if (explore_fragments) {
+    float min_rating = 0.0;
+    for (x = 0; x < num_positions && explore_fragments; ++x) {
+      blob_choice_it.set_to_list(char_choices.get(x));
+      if (blob_choice_it.data()) min_rating += blob_choice_it.data()->rating();
+      if (min_rating >= top_choice_rating_limit) explore_fragments = false;
+    }
+  }
+  if (!explore_dawgs && !explore_fragments) return NULL;
+
+  const char *debug = permute_debug ? "beam_permute" : NULL;
+  int beam_width = permute_beam_width;
+  PermuteBeam *beams = new PermuteBeam[num_positions + 1];
+  PermuteBeamEntry *root = new PermuteBeamEntry();
+  root->in_dawgs = explore_dawgs;
+  root->top_path = explore_fragments;
+  if (explore_dawgs) {
+    init_active_dawgs(&(root->active_dawgs));
+    init_constraints(&(root->constraints));
+  }
+  beams[0].push_back(root);
+
+  WERD_CHOICE word(hyphen_size + num_positions + 1);
+  PermuteBeam candidates;
+  for (x = 0; x < num_positions; ++x) {
+    bool word_ending = (x == num_positions - 1);
+    // The fragment permuter only considers the fragments and the best
+    // non-fragment choice in each position.
+    BLOB_CHOICE *top_nonfrag_choice = NULL;
+    blob_choice_it.set_to_list(char_choices.get(x));
+    for (blob_choice_it.mark_cycle_pt(); !blob_choice_it.cycled_list();
+         blob_choice_it.forward()) {
+      if (!getUnicharset().get_fragment(blob_choice_it.data()->unichar_id())) {
+        top_nonfrag_choice = blob_choice_it.data();
+        break;
+      }
+    }
+    for (int p = 0; p < beams[x].size(); ++p) {
+      const PermuteBeamEntry *entry = beams[x][p];
+      // Rebuild the word once for each parent; each choice is appended
+      // to it and removed after the dawgs have been checked.
+      word.make_bad();
+      word.set_rating(0.0);
+      copy_hyphen_info(&word);
+      append_beam_path(beams, x, p, &word, NULL);
+      for (blob_choice_it.mark_cycle_pt(); !blob_choice_it.cycled_list();
+           blob_choice_it.forward()) {
+        BLOB_CHOICE *blob_choice = blob_choice_it.data();
+        bool top_path = entry->top_path &&
+          (blob_choice == top_nonfrag_choice ||
+           getUnicharset().get_fragment(blob_choice->unichar_id()));
+        if (!entry->in_dawgs && !top_path) continue;
+        CHAR_FRAGMENT_INFO char_frag_info;
+        if (!fragment_state_okay(blob_choice->unichar_id(),
+                                 blob_choice->rating(),
+                                 blob_choice->certainty(),
+                                 &(entry->frag_info), debug, word_ending,
+                                 &char_frag_info)) continue;
+        PermuteBeamEntry *child = new PermuteBeamEntry();
+        child->parent = p;
+        child->rating = entry->rating;
+        child->permuter = entry->permuter;
+        if (char_frag_info.unichar_id == INVALID_UNICHAR_ID) {
+          // Unfinished fragment: carry the dawg state over unchanged.
+          child->frag_info = char_frag_info;
+          child->in_dawgs = entry->in_dawgs;
+          child->top_path = top_path;
+          if (child->in_dawgs) {
+            child->active_dawgs = entry->active_dawgs;
+            child->constraints = entry->constraints;
+          }
+        } else {
+          child->unichar_id = char_frag_info.unichar_id;
+          child->num_fragments = char_frag_info.num_fragments;
+          child->char_rating = char_frag_info.rating;
+          child->char_certainty = char_frag_info.certainty;
+          child->rating += char_frag_info.rating;
+          child->top_path = top_path &&
+            child->rating < top_choice_rating_limit;
+          if (entry->in_dawgs && child->rating < rating_limit) {
+            word.append_unichar_id_space_allocated(
+                child->unichar_id, child->num_fragments, 0.0, 0.0);
+            if (word_ending && has_hyphen_end(word)) {
+              // The word is completed on the next line; keep the dawg
+              // state from before the hyphen for set_hyphen_word().
+              child->in_dawgs = true;
+              child->hyphen_end = true;
+              child->active_dawgs = entry->active_dawgs;
+              child->constraints = entry->constraints;
+            } else {
+              DawgInfoVector active_dawgs = entry->active_dawgs;
+              DawgInfoVector constraints = entry->constraints;
+              DawgArgs dawg_args(&active_dawgs, &constraints,
+                                 &(child->active_dawgs),
+                                 &(child->constraints), 0.0);
+              dawg_args.permuter = entry->permuter;
+              child->in_dawgs = dawg_letter_okay(&dawg_args, word.length() - 1,
+                                                 &word, word_ending);
+              child->permuter = dawg_args.permuter;
+            }
+            word.remove_last_unichar_id();
+          }
+        }
+        if (!child->in_dawgs && !child->top_path) {
+          delete child;
+          continue;
+        }
+        // Rank dawg prefixes and non-words by the rating they would have
+        // after adjust_word() and adjust_non_word() respectively.
+        child->score = (child->rating + child->frag_info.rating +
+                        RATING_PAD) *
+          (child->in_dawgs ? segment_penalty_dict_case_ok
+                           : segment_penalty_dict_nonword) - RATING_PAD;
+        candidates.push_back(child);
+      }
+    }
+    // Keep the beam_width best partial words.
+    if (candidates.size() > beam_width) {
+      qsort(&candidates[0], candidates.size(), sizeof(candidates[0]),
+            compare_beam_entries);
+    }
+    for (int c = 0; c < candidates.size(); ++c) {
+      if (c < beam_width) {
+        beams[x + 1].push_back(candidates[c]);
+      } else {
+        delete candidates[c];
+      }
+    }
+    if (permute_debug) {
+      tprintf("beam_permute: position %d kept %d of %d partial words\n",
+              x, beams[x + 1].size(), candidates.size());
+    }
+    candidates.clear();
+    if (beams[x + 1].empty()) break;
+  }
+
+  // Evaluate the complete words in the last column. As in permute_all()
+  // a dawg word wins over a non-word with the same rating.
+  WERD_CHOICE *best_fragment_choice = new WERD_CHOICE();
+  best_fragment_choice->make_bad();
+  WERD_CHOICE *best_dawg_choice = new WERD_CHOICE();
+  best_dawg_choice->make_bad();
+  best_dawg_choice->set_rating(rating_limit);
+  const PermuteBeamEntry *best_hyphen_entry = NULL;
+  float certainties[MAX_PERM_LENGTH + 1];
+  float adjust_factor;
+  const PermuteBeam &last_beam = beams[num_positions];
+  for (int e = 0; e < last_beam.size(); ++e) {
+    const PermuteBeamEntry *entry = last_beam[e];
+    if (entry->frag_info.fragment != NULL) continue;
+    if (entry->top_path) {
+      WERD_CHOICE fragment_word(num_positions + 1);
+      append_beam_path(beams, num_positions, e, &fragment_word, certainties);
+      fragment_word.set_permuter(TOP_CHOICE_PERM);
+      adjust_non_word(&fragment_word, &adjust_factor);
+      LogNewChoice(fragment_word, adjust_factor, certainties, false);
+      update_best_choice(fragment_word, best_fragment_choice);
+    }
+    if (entry->in_dawgs) {
+      WERD_CHOICE dawg_word(hyphen_size + num_positions + 1);
+      if (entry->hyphen_end) copy_hyphen_info(&dawg_word);
+      dawg_word.set_rating(0.0);
+      dawg_word.set_certainty(0.0);
+      int offset = dawg_word.length();
+      append_beam_path(beams, num_positions, e, &dawg_word,
+                       &certainties[offset]);
+      for (int i = 0; i < offset; ++i) certainties[i] = 0.0;
+      dawg_word.set_permuter(entry->permuter);
+      adjust_word(&dawg_word, certainties);
+      if (dawg_word.rating() < best_dawg_choice->rating()) {
+        *best_dawg_choice = dawg_word;
+        best_hyphen_entry = entry->hyphen_end ? entry : NULL;
+      }
+    }
+  }
+  if (best_hyphen_entry != NULL) {
+    set_hyphen_word(*best_dawg_choice, best_hyphen_entry->active_dawgs,
+                    best_hyphen_entry->constraints);
+  }
+  for (x = 0; x <= num_positions; ++x) beams[x].delete_data_pointers();
+  delete[] beams;
+
+  if (best_dawg_choice->length() > 0 &&
+      best_dawg_choice->rating() <= best_fragment_choice->rating()) {
+    delete best_fragment_choice;
+    return best_dawg_choice;
+  }
+  delete best_dawg_choice;
+  return best_fragment_choice;
+}
+
 /** Returns the top choice char id.  A helper function to make code cleaner. */
 UNICHAR_ID get_top_choice_uid(BLOB_CHOICE_LIST *blob_list) {
   BLOB_CHOICE_IT blob_choice_it;
@@ -46,6 +46,10 @@ extern INT_VAR_H(fragments_debug, 0, "Debug character fragments");
 extern BOOL_VAR_H(segment_debug, 0, "Debug the whole segmentation process");
 extern BOOL_VAR_H(permute_debug, 0, "char permutation debug");
 
+extern INT_VAR_H(permute_beam_width, 0,
+                 "Maximum number of partial words kept for each position by "
+                 "the beam permuter (0 selects the exhaustive permuters)");
+
 extern BOOL_VAR_H(permute_script_word, 0,
                   "Turn on word script consistency permuter");
 
@@ -36,6 +36,7 @@
 #include "ccutil.h"
 #include "ratngs.h"
 #include "ambigs.h"
+#include "tordvars.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -724,7 +725,14 @@ int Dict::NoDangerousAmbig(WERD_CHOICE *best_choice,
   //
   // Note that during the execution of the for loop (on the first pass)
   // if replacements are made the length of best_choice might change.
-  for (int pass = 0; pass < 2; ++pass) {
+  //
+  // In fast mode the search for dangerous ambiguities, which needs a
+  // dictionary permutation, is skipped for words that are confident.
+  int num_passes = 2;
+  if (tord_fast_mode &&
+      best_choice->certainty() >= tord_fast_mode_certainty)
+    num_passes = 1;
+  for (int pass = 0; pass < num_passes; ++pass) {
     bool replace = (pass == 0);
     const UnicharAmbigsVector &table = replace ?
       getUnicharAmbigs().replace_ambigs() : getUnicharAmbigs().dang_ambigs();
@@ -314,6 +314,200 @@ SquishedDawg *Trie::trie_to_dawg() {
                           type_, lang_, perm_, unicharset_size_);
 }
 
+// Returns the last edge of the given node.
+static inline EDGE_RECORD &last_edge(EDGE_VECTOR *node) {
+  return (*node)[node->size() - 1];
+}
+
+// Returns a hash of the node that starts at the given EDGE_RECORD and ends
+// with the first edge that has the last flag set.
+static uinT64 hash_sorted_node(const EDGE_RECORD *edges, EDGE_RECORD last_flag) {
+  uinT64 hash = 0;
+  do {
+    hash = hash * 1000003 + *edges;
+  } while ((*edges++ & last_flag) == 0);
+  return hash ^ (hash >> 29);
+}
+
+NODE_REF Trie::freeze_sorted_node(EDGE_VECTOR *node,
+                                  EDGE_VECTOR *frozen_edges,
+                                  GenericVector<inT32> *node_table,
+                                  int *num_frozen_nodes) {
+  int num_edges = node->size();
+  if (num_edges == 0) return 0;
+  // Sort the edges by unichar id (the words need not be sorted by unichar
+  // id, only grouped by prefix) and mark the last one.
+  int i, j;
+  for (i = 1; i < num_edges; ++i) {
+    EDGE_RECORD edge = (*node)[i];
+    UNICHAR_ID unichar_id = unichar_id_from_edge_rec(edge);
+    for (j = i; j > 0 &&
+         unichar_id_from_edge_rec((*node)[j - 1]) > unichar_id; --j) {
+      (*node)[j] = (*node)[j - 1];
+    }
+    (*node)[j] = edge;
+  }
+  set_last_flag_in_edge_rec(&((*node)[num_edges - 1]));
+  EDGE_RECORD last_flag = LAST_FLAG << flag_start_bit_;
+
+  // Look for an identical node among the ones already frozen.
+  int table_mask = node_table->size() - 1;
+  int slot = hash_sorted_node(&((*node)[0]), last_flag) & table_mask;
+  for (; (*node_table)[slot] >= 0; slot = (slot + 1) & table_mask) {
+    const EDGE_RECORD *frozen_node = &((*frozen_edges)[(*node_table)[slot]]);
+    for (i = 0; i < num_edges; ++i) {
+      if (frozen_node[i] != (*node)[i]) break;
+    }
+    if (i == num_edges) return (*node_table)[slot] + 1;
+  }
+
+  // Append the node and register it in node_table.
+  inT32 start = frozen_edges->size();
+  for (i = 0; i < num_edges; ++i) frozen_edges->push_back((*node)[i]);
+  (*node_table)[slot] = start;
+  if (++(*num_frozen_nodes) * 2 > node_table->size()) {
+    // Keep the table at most half full.
+    GenericVector<inT32> old_table;
+    old_table.move(node_table);
+    for (i = 0; i < old_table.size() * 2; ++i) node_table->push_back(-1);
+    table_mask = node_table->size() - 1;
+    for (i = 0; i < old_table.size(); ++i) {
+      if (old_table[i] < 0) continue;
+      slot = hash_sorted_node(&((*frozen_edges)[old_table[i]]), last_flag) &
+        table_mask;
+      while ((*node_table)[slot] >= 0) slot = (slot + 1) & table_mask;
+      (*node_table)[slot] = old_table[i];
+    }
+  }
+  return start + 1;
+}
+
+SquishedDawg *Trie::sorted_word_list_to_dawg(const char *filename,
+                                             const UNICHARSET &unicharset) {
+  FILE *word_file;
+  char string[CHARS_PER_LINE];
+  int word_count = 0;
+  int num_frozen_nodes = 0;
+  int prev_length = 0;
+  int i, d;
+  // Nodes on the path of the previous word (path[0] is the root).
+  // The last edge of each node leads to the next node on the path,
+  // its next node link is filled in when that node gets frozen.
+  GenericVector<EDGE_VECTOR *> path;
+  path.push_back(new EDGE_VECTOR());
+  EDGE_VECTOR frozen_edges;
+  GenericVector<inT32> node_table;
+  for (i = 0; i < 1024; ++i) node_table.push_back(-1);
+  bool sorted = true;
+
+  word_file = open_file(filename, "r");
+  while (sorted && fgets(string, CHARS_PER_LINE, word_file) != NULL) {
+    chomp_string(string);  // remove newline
+    WERD_CHOICE word(string, unicharset);
+    ++word_count;
+    if (dawg_debug_level && word_count % 10000 == 0)
+      tprintf("Read %d words so far\n", word_count);
+    if (word.length() == 0 || word.contains_unichar_id(INVALID_UNICHAR_ID)) {
+      if (dawg_debug_level) {
+        tprintf("Skipping invalid word %s\n", string);
+        if (dawg_debug_level >= 3) word.print();
+      }
+      continue;
+    }
+    // Find the length of the prefix shared with the previous word.
+    int prefix = 0;
+    while (prefix < prev_length && prefix < word.length() &&
+           unichar_id_from_edge_rec(last_edge(path[prefix])) ==
+           word.unichar_id(prefix)) {
+      ++prefix;
+    }
+    if (prefix == prev_length && prefix == word.length()) continue;
+    // The nodes below the shared prefix will not change any more.
+    for (d = prev_length; d > prefix; --d) {
+      set_next_node_in_edge_rec(
+          &(last_edge(path[d - 1])),
+          freeze_sorted_node(path[d], &frozen_edges, &node_table,
+                             &num_frozen_nodes));
+      path[d]->clear();
+    }
+    prev_length = prefix;
+    if (prefix == word.length()) {
+      // The word is a prefix of the previous one.
+      EDGE_RECORD *edge = &(last_edge(path[prefix - 1]));
+      *edge |= (WERD_END_FLAG << flag_start_bit_);
+      continue;
+    }
+    // If the next letter was already seen in this node, the words that
+    // went through it have already been frozen: the list is not sorted.
+    for (i = 0; i < path[prefix]->size(); ++i) {
+      if (unichar_id_from_edge_rec((*path[prefix])[i]) ==
+          word.unichar_id(prefix)) {
+        if (dawg_debug_level)
+          tprintf("Word list is not sorted at word '%s',"
+                  " building it through the trie\n", string);
+        sorted = false;
+        break;
+      }
+    }
+    if (!sorted) break;
+    for (d = prefix; d < word.length(); ++d) {
+      EDGE_RECORD edge;
+      link_edge(&edge, 0, FORWARD_EDGE, d == word.length() - 1,
+                word.unichar_id(d));
+      path[d]->push_back(edge);
+      if (d + 1 == path.size()) path.push_back(new EDGE_VECTOR());
+    }
+    prev_length = word.length();
+  }
+  fclose(word_file);
+  if (dawg_debug_level)
+    tprintf("Read %d words total.\n", word_count);
+
+  SquishedDawg *dawg = NULL;
+  if (sorted) {
+    for (d = prev_length; d > 0; --d) {
+      set_next_node_in_edge_rec(
+          &(last_edge(path[d - 1])),
+          freeze_sorted_node(path[d], &frozen_edges, &node_table,
+                             &num_frozen_nodes));
+    }
+    // The root goes first in the EDGE_ARRAY, so the references to the
+    // frozen nodes are shifted by the number of edges in the root.
+    EDGE_VECTOR *root = path[0];
+    int num_root_edges = root->size();
+    for (i = 1; i < num_root_edges; ++i) {
+      EDGE_RECORD edge = (*root)[i];
+      UNICHAR_ID unichar_id = unichar_id_from_edge_rec(edge);
+      for (d = i; d > 0 &&
+           unichar_id_from_edge_rec((*root)[d - 1]) > unichar_id; --d) {
+        (*root)[d] = (*root)[d - 1];
+      }
+      (*root)[d] = edge;
+    }
+    if (num_root_edges > 0) set_last_flag_in_edge_rec(&(last_edge(root)));
+    int num_edges = num_root_edges + frozen_edges.size();
+    EDGE_ARRAY edge_array =
+      (EDGE_ARRAY)memalloc(MAX(num_edges, 1) * sizeof(EDGE_RECORD));
+    for (i = 0; i < num_edges; ++i) {
+      EDGE_RECORD *edge = &(edge_array[i]);
+      *edge = (i < num_root_edges) ? (*root)[i]
+                                   : frozen_edges[i - num_root_edges];
+      NODE_REF node_ref = next_node_from_edge_rec(*edge);
+      if (node_ref != 0) {
+        set_next_node_in_edge_rec(edge, node_ref - 1 + num_root_edges);
+      }
+    }
+    if (dawg_debug_level) {
+      tprintf("Built dawg with %d nodes and %d edges\n",
+              num_frozen_nodes + 1, num_edges);
+    }
+    dawg = new SquishedDawg(edge_array, num_edges,
+                            type_, lang_, perm_, unicharset_size_);
+  }
+  path.delete_data_pointers();
+  return dawg;
+}
+
 bool Trie::eliminate_redundant_edges(NODE_REF node,
                                      const EDGE_RECORD &edge1,
                                      const EDGE_RECORD &edge2) {
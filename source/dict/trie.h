@@ -129,6 +129,18 @@ class Trie : public Dawg {
   bool read_word_list(const char *filename,
                       const UNICHARSET &unicharset);
 
+  // Builds a minimal SquishedDawg directly from the list of words in the
+  // given file (incremental construction from sorted data, Daciuk et al.).
+  // The words must be sorted, so that all the words sharing a prefix are
+  // adjacent in the list. Nodes are minimized as soon as the words that
+  // go through them have been read, so the memory used is proportional
+  // to the size of the resulting dawg. The Trie itself is not modified.
+  // Returns NULL if the word list is not sorted.
+  // Note: the caller is responsible for deallocating memory associated
+  // with the returned SquishedDawg pointer.
+  SquishedDawg *sorted_word_list_to_dawg(const char *filename,
+                                         const UNICHARSET &unicharset);
+
   // Adds a word to the Trie (creates the necessary nodes and edges).
   void add_word_to_dawg(const WERD_CHOICE &word);
 
@@ -228,6 +240,16 @@ class Trie : public Dawg {
   // Allocates space for a new node in the Trie.
   NODE_REF new_dawg_node();
 
+  // Sorts the edges of the given node of the word list being converted by
+  // sorted_word_list_to_dawg() and appends them to frozen_edges, unless an
+  // identical node is already there. node_table is a hash table of the
+  // starts of the nodes in frozen_edges (-1 for empty entries).
+  // Returns the index of the node in frozen_edges plus one (0 if the node
+  // has no edges, which is how the end of a word is marked in SquishedDawg).
+  NODE_REF freeze_sorted_node(EDGE_VECTOR *node, EDGE_VECTOR *frozen_edges,
+                              GenericVector<inT32> *node_table,
+                              int *num_frozen_nodes);
+
   // Removes a single edge linkage to between node1 and node2 in the
   // direction indicated by direction argument.
   void remove_edge_linkage(NODE_REF node1, NODE_REF node2, int direction,
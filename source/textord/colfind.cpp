@@ -26,6 +26,7 @@
 #include "colpartition.h"
 #include "colpartitionset.h"
 #include "linefind.h"
+#include "ocrclass.h"
 #include "strokewidth.h"
 #include "blobbox.h"
 #include "scrollview.h"
@@ -38,6 +39,9 @@
 #include "config_auto.h"
 #endif
 
+extern ETEXT_DESC *global_monitor;  // progress monitor
+extern int global_monitor_words;     // user words found so far
+
 namespace tesseract {
 
 // Minimum width to be considered when making columns.
@@ -66,6 +70,12 @@ BOOL_VAR(textord_tabfind_show_blocks, false, "Show final block bounds");
 
 ScrollView* ColumnFinder::blocks_win_ = NULL;
 
+// Returns true if the monitor of the page has run out of time or been
+// cancelled.
+bool ColumnFinder::DeadlinePassed() {
+  return ocr_deadline_passed(global_monitor, global_monitor_words);
+}
+
 // Gridsize is an estimate of the text size in the image. A suitable value
 // is in TO_BLOCK::line_size after find_components has been used to make
 // the blobs.
@@ -1138,7 +1148,7 @@ void ColumnFinder::GridSplitPartitions() {
   gsearch.StartFullSearch();
   ColPartition* dont_repeat = NULL;
   ColPartition* part;
-  while ((part = gsearch.NextFullSearch()) != NULL) {
+  while ((part = gsearch.NextFullSearch()) != NULL && !DeadlinePassed()) {
     if (part->blob_type() < BRT_UNKNOWN || part == dont_repeat)
       continue;  // Only applies to text partitions.
     ColPartitionSet* column_set = best_columns_[gsearch.GridY()];
@@ -1227,7 +1237,7 @@ void ColumnFinder::GridMergePartitions() {
     gsearch(&part_grid_);
   gsearch.StartFullSearch();
   ColPartition* part;
-  while ((part = gsearch.NextFullSearch()) != NULL) {
+  while ((part = gsearch.NextFullSearch()) != NULL && !DeadlinePassed()) {
     // Set up a rectangle search x-bounded by the column and y by the part.
     ColPartitionSet* columns = best_columns_[gsearch.GridY()];
     TBOX box = part->bounding_box();
@@ -1601,7 +1611,7 @@ void ColumnFinder::FindPartitionPartners() {
     gsearch(&part_grid_);
   gsearch.StartFullSearch();
   ColPartition* part;
-  while ((part = gsearch.NextFullSearch()) != NULL) {
+  while ((part = gsearch.NextFullSearch()) != NULL && !DeadlinePassed()) {
     FindPartitionPartners(true, part);
     FindPartitionPartners(false, part);
   }
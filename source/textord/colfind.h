@@ -76,6 +76,11 @@ class ColumnFinder : public TabFind {
                  BLOCK_LIST* blocks, TO_BLOCK_LIST* to_blocks);
 
  private:
+  // Returns true if the monitor of the page has run out of time or been
+  // cancelled. The per-partition loops then stop early, leaving the
+  // partitions as they are, so the blocks can still be made from them.
+  static bool DeadlinePassed();
+
   // Displays the blob and block bounding boxes in a window called Blocks.
   void DisplayBlocks(BLOCK_LIST* blocks);
   // Displays the column edges at each grid y coordinate defined by
@@ -252,6 +257,14 @@ class ColumnFinder : public TabFind {
   // High level function to perform table detection
   void LocateTables();
 
+  // Cheap test of whether the page can contain a table at all. Sets
+  // num_candidates to the number of possible table cells counted.
+  bool MayContainTables(int* num_candidates);
+
+  // Count the partitions marked as table partitions, and set
+  // table_parts_box to the box around them.
+  int CountTablePartitions(TBOX* table_parts_box);
+
   // Get Column segments from best_columns_
   void GetColumnBlocks(ColSegment_LIST *col_segments);
 
@@ -302,8 +315,10 @@ class ColumnFinder : public TabFind {
   // Merge Column Blocks that were split due to the presence of a table
   void GridMergeColumnBlocks();
 
-  // Merge table cells into table columns
-  void GetTableColumns(ColSegment_LIST *table_columns);
+  // Merge table cells into table columns. All the table partitions
+  // must lie within table_parts_box.
+  void GetTableColumns(const TBOX& table_parts_box,
+                       ColSegment_LIST *table_columns);
 
   // Get Column segments from best_columns_
   void GetTableRegions(ColSegment_LIST *table_columns,
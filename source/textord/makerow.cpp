@@ -106,6 +106,20 @@ double_VAR(textord_xheight_error_margin, 0.1, "Accepted variation");
 
 #define MAX_HEIGHT_MODES  12
 
+// The LMS fits of the rows of a block, made by a pick job in row order
+// and used by a fit job on any thread.
+struct LMS_ROW_FITS
+{
+  LMS **fits;                    //fit of each row
+  float gradient;                //forced gradient
+};
+
+static inT32 add_row_samples(LMS *lms, TO_ROW *row, BOOL8 skip_joined);
+static void pick_lms_line_job(TO_ROW_JOB *job);
+static void fit_lms_line_job(TO_ROW_JOB *job);
+static void pick_parallel_lms_job(TO_ROW_JOB *job);
+static void fit_parallel_lms_job(TO_ROW_JOB *job);
+
 /**
  * @name make_single_row
  *
@@ -136,8 +150,7 @@ float make_single_row(ICOORD page_tr, TO_BLOCK* block, TO_BLOCK_LIST* blocks,
     }
   }
   // Fit an LMS line to the row.
-  for (row_it.mark_cycle_pt(); !row_it.cycled_list(); row_it.forward())
-    fit_lms_line(row_it.data());
+  fit_lms_lines(block);
   float gradient;
   float fit_error;
   // Compute the skew based on the fitted line.
@@ -228,8 +241,7 @@ void make_initial_textrows(                  //find lines
                                  //guess skew
   assign_blobs_to_rows (block, NULL, 0, TRUE, TRUE, textord_show_initial_rows && testing_on);
   row_it.move_to_first ();
-  for (row_it.mark_cycle_pt (); !row_it.cycled_list (); row_it.forward ())
-    fit_lms_line (row_it.data ());
+  fit_lms_lines(block);
 #ifndef GRAPHICS_DISABLED
   if (textord_show_initial_rows && testing_on) {
     colour = ScrollView::RED;
@@ -245,25 +257,92 @@ void make_initial_textrows(                  //find lines
 
 
 /**
- * @name fit_lms_line
+ * @name fit_lms_lines
  *
- * Fit an LMS line to a row.
+ * Fit an LMS line to every row of the block.
+ * The random trials are drawn for each row in order, so the lines
+ * are the same as fitting the rows one by one, and the fits are then
+ * done on textord_row_threads threads.
  */
-void fit_lms_line(             //sort function
-                  TO_ROW *row  //row to fit
-                 ) {
-  float m, c;                    //fitted line
+void fit_lms_lines(                 //fit all rows
+                   TO_BLOCK *block  //block to do
+                  ) {
+  LMS_ROW_FITS row_fits;         //fits of rows
+  inT32 row_count;               //rows in block
+
+  row_count = block->get_rows ()->length ();
+  if (row_count == 0)
+    return;
+  row_fits.fits = new LMS *[row_count];
+  row_fits.gradient = 0.0f;
+  run_row_jobs(block, 0, FALSE, TRUE, pick_lms_line_job, &row_fits);
+  run_row_jobs(block, 0, FALSE, FALSE, fit_lms_line_job, &row_fits);
+  delete [] row_fits.fits;
+}
+
+
+/**
+ * @name add_row_samples
+ *
+ * Add the bottom centre of each blob of the row to the LMS, leaving
+ * out blobs joined to the previous one if skip_joined is set.
+ * Returns the number of samples added.
+ */
+static inT32 add_row_samples(                    //fill lms
+                             LMS *lms,           //fit to add to
+                             TO_ROW *row,        //row to add
+                             BOOL8 skip_joined   //ignore joined blobs
+                            ) {
+  inT32 blobcount;               //no of blobs
   TBOX box;                       //blob box
-  LMS lms (row->blob_list ()->length ());
                                  //blobs
   BLOBNBOX_IT blob_it = row->blob_list ();
 
+  blobcount = 0;
   for (blob_it.mark_cycle_pt (); !blob_it.cycled_list (); blob_it.forward ()) {
-    box = blob_it.data ()->bounding_box ();
-    lms.add (FCOORD ((box.left () + box.right ()) / 2.0, box.bottom ()));
+    if (!skip_joined || !blob_it.data ()->joined_to_prev ()) {
+      box = blob_it.data ()->bounding_box ();
+      lms->add (FCOORD ((box.left () + box.right ()) / 2.0, box.bottom ()));
+      blobcount++;
+    }
   }
-  lms.fit (m, c);
-  row->set_line (m, c, lms.error ());
+  return blobcount;
+}
+
+
+/**
+ * @name pick_lms_line_job
+ *
+ * Make the LMS of a row and draw its trials. The first job of
+ * fit_lms_lines, run in row order.
+ */
+static void pick_lms_line_job(                 //start row fit
+                              TO_ROW_JOB *job  //row to do
+                             ) {
+  LMS_ROW_FITS *row_fits = (LMS_ROW_FITS *) job->arg;
+  LMS *lms = new LMS (job->row->blob_list ()->length ());
+
+  add_row_samples(lms, job->row, FALSE);
+  lms->pick_fit ();
+  row_fits->fits[job->row_index - 1] = lms;
+}
+
+
+/**
+ * @name fit_lms_line_job
+ *
+ * Fit the picked LMS line to a row. The second job of fit_lms_lines.
+ */
+static void fit_lms_line_job(                 //finish row fit
+                             TO_ROW_JOB *job  //row to do
+                            ) {
+  LMS_ROW_FITS *row_fits = (LMS_ROW_FITS *) job->arg;
+  LMS *lms = row_fits->fits[job->row_index - 1];
+  float m, c;                    //fitted line
+
+  lms->fit (m, c);
+  job->row->set_line (m, c, lms->error ());
+  delete lms;
 }
 
 
@@ -2030,13 +2109,23 @@ void fit_parallel_rows(                   //find lines
   ScrollView::Color colour;                 //of row
 #endif
   TO_ROW_IT row_it = block->get_rows ();
+  LMS_ROW_FITS row_fits;         //fits of rows
+  inT32 row_count;               //rows in block
 
   row_it.move_to_first ();
   for (row_it.mark_cycle_pt (); !row_it.cycled_list (); row_it.forward ()) {
     if (row_it.data ()->blob_list ()->empty ())
       delete row_it.extract ();  //nothing in it
-    else
-      fit_parallel_lms (gradient, row_it.data ());
+  }
+  row_count = row_it.length ();
+  if (row_count > 0) {
+    row_fits.fits = new LMS *[row_count];
+    row_fits.gradient = gradient;
+    run_row_jobs(block, 0, testing_on, TRUE,
+                 pick_parallel_lms_job, &row_fits);
+    run_row_jobs(block, 0, testing_on, FALSE,
+                 fit_parallel_lms_job, &row_fits);
+    delete [] row_fits.fits;
   }
 #ifndef GRAPHICS_DISABLED
   if (testing_on) {
@@ -2055,39 +2144,49 @@ void fit_parallel_rows(                   //find lines
 
 
 /**
- * @name fit_parallel_lms
+ * @name pick_parallel_lms_job
  *
- * Fit an LMS line to a row.
- * Make the fit parallel to the given gradient and set the
- * row accordingly.
+ * Make the LMS of a row and draw its trials. The first job of
+ * fit_parallel_rows, run in row order.
  */
-void fit_parallel_lms(                 //sort function
-                      float gradient,  //forced gradient
-                      TO_ROW *row      //row to fit
-                     ) {
-  float c;                       //fitted line
+static void pick_parallel_lms_job(                 //start row fit
+                                  TO_ROW_JOB *job  //row to do
+                                 ) {
+  LMS_ROW_FITS *row_fits = (LMS_ROW_FITS *) job->arg;
+  LMS *lms = new LMS (job->row->blob_list ()->length ());
   int blobcount;                 //no of blobs
-  TBOX box;                       //blob box
-  LMS lms (row->blob_list ()->length ());
-                                 //blobs
-  BLOBNBOX_IT blob_it = row->blob_list ();
 
-  blobcount = 0;
-  for (blob_it.mark_cycle_pt (); !blob_it.cycled_list (); blob_it.forward ()) {
-    if (!blob_it.data ()->joined_to_prev ()) {
-      box = blob_it.data ()->bounding_box ();
-      lms.
-        add (FCOORD ((box.left () + box.right ()) / 2.0, box.bottom ()));
-      blobcount++;
-    }
-  }
-  lms.constrained_fit (gradient, c);
-  row->set_parallel_line (gradient, c, lms.error ());
-  if (textord_straight_baselines && blobcount > lms_line_trials) {
-    lms.fit (gradient, c);
+  blobcount = add_row_samples(lms, job->row, TRUE);
+  lms->pick_constrained_fit (row_fits->gradient);
+  if (textord_straight_baselines && blobcount > lms_line_trials)
+    lms->pick_fit ();
+  row_fits->fits[job->row_index - 1] = lms;
+}
+
+
+/**
+ * @name fit_parallel_lms_job
+ *
+ * Fit the picked LMS line parallel to the block gradient to a row
+ * and set the row accordingly. The second job of fit_parallel_rows.
+ */
+static void fit_parallel_lms_job(                 //finish row fit
+                                 TO_ROW_JOB *job  //row to do
+                                ) {
+  LMS_ROW_FITS *row_fits = (LMS_ROW_FITS *) job->arg;
+  LMS *lms = row_fits->fits[job->row_index - 1];
+  float gradient;                //fitted line
+  float c;
+
+  gradient = row_fits->gradient;
+  lms->constrained_fit (gradient, c);
+  job->row->set_parallel_line (gradient, c, lms->error ());
+  if (textord_straight_baselines && lms->count () > lms_line_trials) {
+    lms->fit (gradient, c);
   }
                                  //set the other too
-  row->set_line (gradient, c, lms.error ());
+  job->row->set_line (gradient, c, lms->error ());
+  delete lms;
 }
 
 
@@ -151,9 +151,9 @@ void make_initial_textrows(                  //find lines
                            FCOORD rotation,  //for drawing
                            BOOL8 testing_on  //correct orientation
                           );
-void fit_lms_line(             //sort function
-                  TO_ROW *row  //row to fit
-                 );
+void fit_lms_lines(                 //fit all rows
+                   TO_BLOCK *block  //block to do
+                  );
 void compute_page_skew(                        //get average gradient
                        TO_BLOCK_LIST *blocks,  //list of blocks
                        float &page_m,          //average gradient
@@ -279,10 +279,6 @@ void fit_parallel_rows(                   //find lines
                        inT32 block_edge,  //edge of block
                        BOOL8 testing_on   //correct orientation
                       );
-void fit_parallel_lms(                 //sort function
-                      float gradient,  //forced gradient
-                      TO_ROW *row      //row to fit
-                     );
 void make_spline_rows(                   //find lines
                       TO_BLOCK *block,   //block to do
                       float gradient,    //gradient to fit
@@ -46,10 +46,14 @@
 #include "blread.h"
 #include "wordseg.h"
 #include "makerow.h"
+#include "ocrclass.h"
 #include "baseapi.h"
 #include "tordmain.h"
 #include "tessvars.h"
 
+extern ETEXT_DESC *global_monitor;  // progress monitor
+extern int global_monitor_words;     // user words found so far
+
 namespace tesseract {
 
 /// Minimum believable resolution.
@@ -122,6 +126,9 @@ int Tesseract::SegmentPage(const STRING* input_file,
     tprintf("Empty page\n");
     return 0;  // AutoPageSeg found an empty page.
   }
+  // If layout analysis used up the time, keep its blocks, without rows.
+  if (ocr_deadline_passed(global_monitor, global_monitor_words))
+    return 0;
 
   if (port_blocks.empty()) {
     // AutoPageSeg was not used, so we need to find_components first.
@@ -107,10 +107,10 @@ void FPCUTPT::assign(                         //constructor
                      float projection_scale,  //scaling
                      inT16 zero_count,        //official zero
                      inT16 pitch,             //proposed pitch
-                     inT16 pitch_error        //allowed tolerance
+                     inT16 pitch_error,       //allowed tolerance
+                     const FPCUTPT_BUFFER *lattice  //occupancy of projection
                     ) {
   int index;                     //test index
-  int balance_index;             //for balance factor
   inT16 balance_count;           //ding factor
   inT16 r_index;                 //test cut number
   FPCUTPT *segpt;                //segment point
@@ -160,16 +160,8 @@ void FPCUTPT::assign(                         //constructor
               lead_flag &= lead_flag - 1;
             }
           }
-          else {
-            for (balance_index = 0;
-              index + balance_index < x - balance_index;
-              balance_index++)
-            balance_count +=
-                (projection->pile_count (index + balance_index) <=
-                zero_count) ^ (projection->pile_count (x -
-                balance_index)
-                <= zero_count);
-          }
+          else
+            balance_count = lattice->balance_count (index, x);
           balance_count =
             (inT16) (balance_count * textord_balance_factor /
             projection_scale);
@@ -288,6 +280,88 @@ void FPCUTPT::assign_cheap(                         //constructor
 }
 
 
+/**********************************************************************
+ * FPCUTPT_BUFFER::FPCUTPT_BUFFER
+ *
+ * Make an empty buffer. Nothing is allocated until it is used.
+ **********************************************************************/
+
+FPCUTPT_BUFFER::FPCUTPT_BUFFER()
+  : cutpts_(NULL), occupied_(NULL), mirrored_(NULL), capacity_(0),
+    size_(0), origin_(0), mins_(NULL), mins_capacity_(0) {
+}
+
+
+/**********************************************************************
+ * FPCUTPT_BUFFER::~FPCUTPT_BUFFER
+ **********************************************************************/
+
+FPCUTPT_BUFFER::~FPCUTPT_BUFFER() {
+  if (cutpts_ != NULL) {
+    free_mem(cutpts_);
+    free_mem(occupied_);
+    free_mem(mirrored_);
+  }
+  if (mins_ != NULL)
+    free_mem(mins_);
+}
+
+
+/**********************************************************************
+ * FPCUTPT_BUFFER::setup
+ *
+ * Make room for a lattice of size cut points starting at x=origin, and
+ * record which columns of the projection are occupied, for balance_count.
+ **********************************************************************/
+
+FPCUTPT *FPCUTPT_BUFFER::setup(                     //get lattice
+                               STATS *projection,   //vertical occupation
+                               inT16 zero_count,    //official zero
+                               inT16 origin,        //x of first point
+                               inT32 size           //no of points
+                              ) {
+  inT32 index;                   //column index
+
+  if (size > capacity_) {
+    if (cutpts_ != NULL) {
+      free_mem(cutpts_);
+      free_mem(occupied_);
+      free_mem(mirrored_);
+    }
+    capacity_ = size > capacity_ * 2 ? size : capacity_ * 2;
+    cutpts_ = (FPCUTPT *) alloc_mem (capacity_ * sizeof (FPCUTPT));
+    occupied_ = (uinT8 *) alloc_mem (capacity_ * sizeof (uinT8));
+    mirrored_ = (uinT8 *) alloc_mem (capacity_ * sizeof (uinT8));
+  }
+  size_ = size;
+  origin_ = origin;
+  for (index = 0; index < size; index++) {
+    occupied_[index] = projection->pile_count (origin + index) > zero_count;
+    mirrored_[size - 1 - index] = occupied_[index];
+  }
+  return cutpts_;
+}
+
+
+/**********************************************************************
+ * FPCUTPT_BUFFER::mins
+ *
+ * Return an array of at least size flags for local minima.
+ **********************************************************************/
+
+BOOL8 *FPCUTPT_BUFFER::mins(             //get flags
+                            inT32 size   //no of flags
+                           ) {
+  if (size > mins_capacity_) {
+    if (mins_ != NULL)
+      free_mem(mins_);
+    mins_ = (BOOL8 *) alloc_mem (size * sizeof (BOOL8));
+    mins_capacity_ = size;
+  }
+  return mins_;
+}
+
+
 /**********************************************************************
  * check_pitch_sync
  *
@@ -308,7 +382,8 @@ double check_pitch_sync2(                          //find segmentation
                          inT16 &occupation_count,  //no of occupied cells
                          FPSEGPT_LIST *seg_list,   //output list
                          inT16 start,              //start of good range
-                         inT16 end                 //end of good range
+                         inT16 end,                //end of good range
+                         FPCUTPT_BUFFER *buffer    //reusable storage
                         ) {
   BOOL8 faking;                  //illegal cut pt
   BOOL8 mid_cut;                 //cheap cut pt.
@@ -332,6 +407,7 @@ double check_pitch_sync2(                          //find segmentation
   inT16 best_count;              //no of cuts
   BLOBNBOX_IT this_it;           //copy iterator
   FPSEGPT_IT seg_it = seg_list;  //output iterator
+  FPCUTPT_BUFFER local_buffer;   //if none given
 
   //      tprintf("Computing sync on word of %d blobs with pitch %d\n",
   //              blob_count, pitch);
@@ -361,10 +437,12 @@ double check_pitch_sync2(                          //find segmentation
     return check_pitch_sync3 (projection_left, projection_right, zero_count,
       pitch, pitch_error, projection,
       projection_scale, occupation_count, seg_list,
-      start, end);
+      start, end, buffer);
+  if (buffer == NULL)
+    buffer = &local_buffer;
   array_origin = left_edge - pitch;
-  cutpts = (FPCUTPT *) alloc_mem ((right_edge - left_edge + pitch * 2 + 1)
-    * sizeof (FPCUTPT));
+  cutpts = buffer->setup (projection, zero_count, array_origin,
+    right_edge - left_edge + pitch * 2 + 1);
   for (x = array_origin; x < left_edge; x++)
                                  //free cuts
     cutpts[x - array_origin].setup (cutpts, array_origin, projection, zero_count, pitch, x, 0);
@@ -411,7 +489,7 @@ double check_pitch_sync2(                          //find segmentation
     cutpts[x - array_origin].assign (cutpts, array_origin, x,
       faking, mid_cut, offset, projection,
       projection_scale, zero_count, pitch,
-      pitch_error);
+      pitch_error, buffer);
     x++;
   }
 
@@ -423,7 +501,7 @@ double check_pitch_sync2(                          //find segmentation
     cutpts[x - array_origin].assign (cutpts, array_origin, x,
       FALSE, FALSE, offset, projection,
       projection_scale, zero_count, pitch,
-      pitch_error);
+      pitch_error, buffer);
     cutpts[x - array_origin].terminal = TRUE;
     if (cutpts[x - array_origin].index () +
     cutpts[x - array_origin].fake_count <= best_count + best_fake) {
@@ -477,7 +555,6 @@ double check_pitch_sync2(                          //find segmentation
   if (seg_it.data ()->squares () - mean_sum < 0)
     tprintf ("Impossible sqsum=%g, mean=%g, total=%d\n",
       seg_it.data ()->squares (), seg_it.data ()->sum (), best_count);
-  free_mem(cutpts);
   //      tprintf("blob_count=%d, pitch=%d, sync=%g, occ=%d\n",
   //              blob_count,pitch,seg_it.data()->squares()-mean_sum,
   //              occupation_count);
@@ -504,7 +581,8 @@ double check_pitch_sync3(                          //find segmentation
                          inT16 &occupation_count,  //no of occupied cells
                          FPSEGPT_LIST *seg_list,   //output list
                          inT16 start,              //start of good range
-                         inT16 end                 //end of good range
+                         inT16 end,                //end of good range
+                         FPCUTPT_BUFFER *buffer    //reusable storage
                         ) {
   BOOL8 faking;                  //illegal cut pt
   BOOL8 mid_cut;                 //cheap cut pt.
@@ -530,6 +608,7 @@ double check_pitch_sync3(                          //find segmentation
   inT16 best_fake;               //best fake level
   inT16 best_count;              //no of cuts
   FPSEGPT_IT seg_it = seg_list;  //output iterator
+  FPCUTPT_BUFFER local_buffer;   //if none given
 
   end = (end - start) % pitch;
   if (pitch < 3)
@@ -542,10 +621,12 @@ double check_pitch_sync3(                          //find segmentation
     && left_edge < projection_right; left_edge++);
   for (right_edge = projection_right; projection->pile_count (right_edge) == 0
     && right_edge > left_edge; right_edge--);
+  if (buffer == NULL)
+    buffer = &local_buffer;
   array_origin = left_edge - pitch;
-  cutpts = (FPCUTPT *) alloc_mem ((right_edge - left_edge + pitch * 2 + 1)
-    * sizeof (FPCUTPT));
-  mins = (BOOL8 *) alloc_mem ((pitch_error * 2 + 1) * sizeof (BOOL8));
+  cutpts = buffer->setup (projection, zero_count, array_origin,
+    right_edge - left_edge + pitch * 2 + 1);
+  mins = buffer->mins (pitch_error * 2 + 1);
   for (x = array_origin; x < left_edge; x++)
                                  //free cuts
     cutpts[x - array_origin].setup (cutpts, array_origin, projection, zero_count, pitch, x, 0);
@@ -616,7 +697,7 @@ double check_pitch_sync3(                          //find segmentation
       cutpts[x - array_origin].assign (cutpts, array_origin, x,
         faking, mid_cut, offset, projection,
         projection_scale, zero_count, pitch,
-        pitch_error);
+        pitch_error, buffer);
     else
       cutpts[x - array_origin].assign_cheap (cutpts, array_origin, x,
         faking, mid_cut, offset,
@@ -638,7 +719,7 @@ double check_pitch_sync3(                          //find segmentation
     cutpts[x - array_origin].assign (cutpts, array_origin, x,
       FALSE, FALSE, offset, projection,
       projection_scale, zero_count, pitch,
-      pitch_error);
+      pitch_error, buffer);
     cutpts[x - array_origin].terminal = TRUE;
     if (cutpts[x - array_origin].index () +
     cutpts[x - array_origin].fake_count <= best_count + best_fake) {
@@ -690,7 +771,5 @@ double check_pitch_sync3(                          //find segmentation
   if (seg_it.data ()->squares () - mean_sum < 0)
     tprintf ("Impossible sqsum=%g, mean=%g, total=%d\n",
       seg_it.data ()->squares (), seg_it.data ()->sum (), best_count);
-  free_mem(mins);
-  free_mem(cutpts);
   return seg_it.data ()->squares () - mean_sum;
 }
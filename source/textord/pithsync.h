@@ -26,6 +26,7 @@
 #include          "notdll.h"
 
 class FPSEGPT_LIST;
+class FPCUTPT_BUFFER;
 
 class FPCUTPT
 {
@@ -52,7 +53,8 @@ class FPCUTPT
       float projection_scale,    //scaling
       inT16 zero_count,          //official zero
       inT16 pitch,               //proposed pitch
-      inT16 pitch_error);        //allowed tolerance
+      inT16 pitch_error,         //allowed tolerance
+      const FPCUTPT_BUFFER *lattice);  //occupancy of projection
 
     void assign_cheap (          //evaluate cut
       FPCUTPT cutpts[],          //predecessors
@@ -104,6 +106,51 @@ class FPCUTPT
     double sq_sum;               //summed distsances
     double cost;                 //cost function
 };
+
+// Reusable storage for the lattice of cut points built by
+// check_pitch_sync2/3. The arrays only ever grow, so a buffer kept for
+// all the rows done by one thread saves an allocation for every word and
+// every trial pitch. The buffer also holds a byte per column of the
+// projection, saying whether it is occupied, forwards and mirrored, so
+// the balance of a character cell is a straight loop over two arrays.
+// A buffer must not be used by two threads at once.
+class FPCUTPT_BUFFER
+{
+  public:
+    FPCUTPT_BUFFER();
+    ~FPCUTPT_BUFFER();
+
+    // Returns an array of size cut points covering origin onwards, and
+    // caches which of those columns of projection exceed zero_count.
+    FPCUTPT *setup(STATS *projection, inT16 zero_count,
+                   inT16 origin, inT32 size);
+    // Returns an array of at least size flags.
+    BOOL8 *mins(inT32 size);
+
+    // Returns the number of columns from index to half way to x whose
+    // occupancy differs from that of the column at the same distance
+    // back from x. Both index and x must be inside the last setup.
+    inT16 balance_count(inT16 index, inT16 x) const {
+      const uinT8 *fwd = occupied_ + (index - origin_);
+      const uinT8 *back = mirrored_ + (size_ - 1 - (x - origin_));
+      inT32 count = (x - index + 1) / 2;
+      inT32 result = 0;
+      for (inT32 i = 0; i < count; ++i)
+        result += fwd[i] ^ back[i];
+      return (inT16) result;
+    }
+
+  private:
+    FPCUTPT *cutpts_;            //lattice
+    uinT8 *occupied_;            //1 where projection is occupied
+    uinT8 *mirrored_;            //occupied_ back to front
+    inT32 capacity_;             //allocated size of the above
+    inT32 size_;                 //size in use
+    inT16 origin_;               //x coord of element 0
+    BOOL8 *mins_;                //local minima
+    inT32 mins_capacity_;        //allocated size of mins_
+};
+
 double check_pitch_sync2(                          //find segmentation
                          BLOBNBOX_IT *blob_it,     //blobs to do
                          inT16 blob_count,         //no of blobs
@@ -116,7 +163,8 @@ double check_pitch_sync2(                          //find segmentation
                          inT16 &occupation_count,  //no of occupied cells
                          FPSEGPT_LIST *seg_list,   //output list
                          inT16 start,              //start of good range
-                         inT16 end                 //end of good range
+                         inT16 end,                //end of good range
+                         FPCUTPT_BUFFER *buffer = NULL  //reusable storage
                         );
 double check_pitch_sync3(                          //find segmentation
                          inT16 projection_left,    //edges //to be considered 0
@@ -129,6 +177,7 @@ double check_pitch_sync3(                          //find segmentation
                          inT16 &occupation_count,  //no of occupied cells
                          FPSEGPT_LIST *seg_list,   //output list
                          inT16 start,              //start of good range
-                         inT16 end                 //end of good range
+                         inT16 end,                //end of good range
+                         FPCUTPT_BUFFER *buffer = NULL  //reusable storage
                         );
 #endif
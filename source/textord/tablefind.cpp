@@ -23,6 +23,7 @@
 
 #include "colfind.h"
 #include <math.h>
+#include <time.h>
 #ifdef HAVE_CONFIG_H
 #include "config_auto.h"
 #endif
@@ -82,8 +83,15 @@ const double kProjectionThreshold = 0.35;
 // Minmimum number of rows in a table
 const int kMinRowsInTable = 3;
 
+// Minimum number of table partitions needed to make a table column
+const int kMinTablePartitions = 2;
+
 BOOL_VAR(textord_dump_table_images, false, "Paint table detection output");
 BOOL_VAR(textord_show_tables, false, "Show table regions");
+BOOL_VAR(textord_tablefind_fast_path, true,
+         "Skip table detection on pages that cannot hold a table");
+BOOL_VAR(textord_tablefind_show_timing, false,
+         "Print the time taken by table detection on each page");
 
 ELISTIZE(ColSegment)
 CLISTIZE(ColSegment)
@@ -157,18 +165,57 @@ void ColumnFinder::GetCleanPartitions(TO_BLOCK* block) {
 
 // High level function to perform table detection
 void ColumnFinder::LocateTables() {
+  clock_t start_time = clock();
+  // The fast path changes nothing but the debug output.
+  bool fast_path = textord_tablefind_fast_path &&
+                   !textord_show_tables && !textord_dump_table_images;
+  int num_candidates = 0;
+  // Most pages have no tables, so first check cheaply if any partitions
+  // could become table cells before doing the full search.
+  if (fast_path && !MayContainTables(&num_candidates)) {
+    if (textord_tablefind_show_timing)
+      tprintf("Table detection: %d candidate partitions, skipped in %.3fms\n",
+              num_candidates,
+              (clock() - start_time) * 1000.0 / CLOCKS_PER_SEC);
+    return;
+  }
+  clock_t check_time = clock();
+
   // Make single-column blocks from good_columns_ partitions. col_segments are
   // moved to a grid later which takes the ownership
   ColSegment_LIST column_blocks;
   GetColumnBlocks(&column_blocks);
 
   SetPartitionSpacings();
+  clock_t spacing_time = clock();
 
   // Mark ColPartitions as being candidate table partition depending on
   // the inter-word spacing
   GridMarkTablePartitions();
   FilterFalseAlarms();
   SmoothTablePartitionRuns();
+  clock_t mark_time = clock();
+  // Tables are optional, so give up on them if the page is out of time.
+  // Nothing outside the clean partitions has been changed yet.
+  if (DeadlinePassed())
+    return;
+
+  // A table column needs at least two table partitions, so without them
+  // there can be no table regions to find.
+  TBOX table_parts_box;
+  int num_table_parts = CountTablePartitions(&table_parts_box);
+  if (fast_path && num_table_parts < kMinTablePartitions) {
+    if (textord_tablefind_show_timing)
+      tprintf("Table detection: %d candidate partitions, %d table partitions,"
+              " check %.3fms, spacing %.3fms, marking %.3fms,"
+              " total %.3fms\n",
+              num_candidates, num_table_parts,
+              (check_time - start_time) * 1000.0 / CLOCKS_PER_SEC,
+              (spacing_time - check_time) * 1000.0 / CLOCKS_PER_SEC,
+              (mark_time - spacing_time) * 1000.0 / CLOCKS_PER_SEC,
+              (clock() - start_time) * 1000.0 / CLOCKS_PER_SEC);
+    return;
+  }
 
   // Set the ratio of candidate table partitions in each column
   SetColumnsType(&column_blocks);
@@ -183,7 +230,7 @@ void ColumnFinder::LocateTables() {
   // Group horizontally overlapping table partitions into table columns.
   // table_columns created here get deleted at the end of this method.
   ColSegment_LIST table_columns;
-  GetTableColumns(&table_columns);
+  GetTableColumns(table_parts_box, &table_columns);
 
   // Within each column, mark the range table regions occupy based on the
   // table columns detected. table_regions are moved to a grid later which
@@ -195,6 +242,8 @@ void ColumnFinder::LocateTables() {
   // columns
   MoveColSegmentsToGrid(&table_regions, &table_grid_);
   GridMergeTableRegions();
+  if (DeadlinePassed())
+    return;
 
   // Adjust table boundaries by including nearby horizontal lines and left
   // out column headers
@@ -215,10 +264,101 @@ void ColumnFinder::LocateTables() {
   if (textord_dump_table_images)
     WriteToPix();
 
+  clock_t region_time = clock();
+  // Only MakeTableBlocks changes the partitions of the page.
+  if (DeadlinePassed())
+    return;
+
   // Merge all colpartitions in table regions to make them a single
   // colpartition and revert types of isolated table cells not
   // assigned to any table to their original types.
   MakeTableBlocks();
+  if (textord_tablefind_show_timing) {
+    int num_tables = 0;
+    GridSearch<ColSegment, ColSegment_CLIST, ColSegment_C_IT>
+        table_search(&table_grid_);
+    table_search.StartFullSearch();
+    while (table_search.NextFullSearch() != NULL)
+      ++num_tables;
+    tprintf("Table detection: %d candidate partitions, %d table partitions,"
+            " %d tables, check %.3fms, spacing %.3fms, marking %.3fms,"
+            " regions %.3fms, blocks %.3fms, total %.3fms\n",
+            num_candidates, num_table_parts, num_tables,
+            (check_time - start_time) * 1000.0 / CLOCKS_PER_SEC,
+            (spacing_time - check_time) * 1000.0 / CLOCKS_PER_SEC,
+            (mark_time - spacing_time) * 1000.0 / CLOCKS_PER_SEC,
+            (region_time - mark_time) * 1000.0 / CLOCKS_PER_SEC,
+            (clock() - region_time) * 1000.0 / CLOCKS_PER_SEC,
+            (clock() - start_time) * 1000.0 / CLOCKS_PER_SEC);
+  }
+}
+
+// Cheap test of whether LocateTables can find any table on the page,
+// using only the sizes and inter-word gaps of the partitions. A table is
+// made from a column of at least kMinTablePartitions partitions marked by
+// GridMarkTablePartitions, other than the top-most and bottom-most text
+// partitions, which FilterFalseAlarms always clears. SmoothTablePartitionRuns
+// only marks partitions between two marked ones, so if there are fewer such
+// candidates, no table can be found. Stops counting at kMinTablePartitions.
+bool ColumnFinder::MayContainTables(int* num_candidates) {
+  STATS xheight_stats(0, kMaxVerticalSpacing + 1);
+  ColPartition* header = NULL;
+  ColPartition* footer = NULL;
+  int max_top = -MAX_INT32;
+  int min_bottom = MAX_INT32;
+  // Find the global x-height, header and footer as SetGlobalSpacings and
+  // FilterFalseAlarms will.
+  GridSearch<ColPartition, ColPartition_CLIST, ColPartition_C_IT>
+    gsearch(&clean_part_grid_);
+  gsearch.StartFullSearch();
+  ColPartition* part;
+  while ((part = gsearch.NextFullSearch()) != NULL) {
+    if (!part->IsTextType())
+      continue;
+    xheight_stats.add(part->median_size(), 1);
+    int top = part->bounding_box().top();
+    int bottom = part->bounding_box().bottom();
+    if (top > max_top) {
+      max_top = top;
+      header = part;
+    }
+    if (bottom < min_bottom) {
+      min_bottom = bottom;
+      footer = part;
+    }
+  }
+  int median_xheight = static_cast<int>(xheight_stats.median() + 0.5);
+  *num_candidates = 0;
+  gsearch.StartFullSearch();
+  while ((part = gsearch.NextFullSearch()) != NULL) {
+    if (!part->IsTextType() || part == header || part == footer)
+      continue;
+    // Same test as GridMarkTablePartitions.
+    if (part->median_size() > kMaxTableCellXheight * median_xheight)
+      continue;
+    if (HasWideOrNoInterWordGap(part) &&
+        ++*num_candidates >= kMinTablePartitions)
+      return true;
+  }
+  return false;
+}
+
+// Count the partitions of clean_part_grid_ marked as table partitions,
+// and find the box around them.
+int ColumnFinder::CountTablePartitions(TBOX* table_parts_box) {
+  int num_table_parts = 0;
+  *table_parts_box = TBOX();
+  GridSearch<ColPartition, ColPartition_CLIST, ColPartition_C_IT>
+    gsearch(&clean_part_grid_);
+  gsearch.StartFullSearch();
+  ColPartition* part;
+  while ((part = gsearch.NextFullSearch()) != NULL) {
+    if (part->type() == PT_TABLE) {
+      ++num_table_parts;
+      *table_parts_box += part->bounding_box();
+    }
+  }
+  return num_table_parts;
 }
 
 // Make single-column blocks from good_columns_ partitions.
@@ -387,7 +527,7 @@ void ColumnFinder::GridMarkTablePartitions() {
     gsearch(&clean_part_grid_);
   gsearch.StartFullSearch();
   ColPartition* part;
-  while ((part = gsearch.NextFullSearch()) != NULL) {
+  while ((part = gsearch.NextFullSearch()) != NULL && !DeadlinePassed()) {
     if (!part->IsTextType())  // Only consider text partitions
       continue;
     // Only consider partitions in dominant font size or smaller
@@ -704,16 +844,27 @@ void ColumnFinder::GridMergeColumnBlocks() {
 //     column below/above it
 //  4- cells from two vertically adjacent tables merge together to make a
 //     single column resulting in merging of the two tables
-void ColumnFinder::GetTableColumns(ColSegment_LIST *table_columns) {
+void ColumnFinder::GetTableColumns(const TBOX& table_parts_box,
+                                   ColSegment_LIST *table_columns) {
   ColSegment_IT it(table_columns);
-  // Iterate the ColPartitions in the grid.
+  if (table_parts_box.null_box())
+    return;
+  // Iterate the ColPartitions in the part of the grid that holds the table
+  // partitions. Each is taken in the grid cell of its bottom-left corner,
+  // as a full search would, so they come in the same order.
   GridSearch<ColPartition, ColPartition_CLIST, ColPartition_C_IT>
     gsearch(&clean_part_grid_);
-  gsearch.StartFullSearch();
+  gsearch.StartRectSearch(table_parts_box);
   ColPartition* part;
-  while ((part = gsearch.NextFullSearch()) != NULL) {
+  while ((part = gsearch.NextRectSearch()) != NULL && !DeadlinePassed()) {
     if (part->inside_table_column() || part->type() != PT_TABLE)
       continue;  // prevent a partition to be assigned to multiple columns
+    int grid_x, grid_y;
+    clean_part_grid_.GridCoords(part->bounding_box().left(),
+                                part->bounding_box().bottom(),
+                                &grid_x, &grid_y);
+    if (grid_x != gsearch.GridX() || grid_y != gsearch.GridY())
+      continue;  // not the cell a full search would return it in
     TBOX box = part->bounding_box();
     ColSegment* col = new ColSegment();
     col->InsertBox(box);
@@ -769,8 +920,13 @@ void ColumnFinder::GetTableRegions(ColSegment_LIST* table_columns,
   bool* table_region = new bool[page_height];
   while ((part = gsearch.NextFullSearch()) != NULL) {
     TBOX part_box = part->bounding_box();
+    // Only the y-range of the column block can be marked, so only that
+    // range, and one entry either side of it, needs to be reset and
+    // scanned for runs.
+    int first_y = MAX(part_box.bottom() - bleft().y(), 1);
+    int last_y = MIN(part_box.top() - bleft().y(), page_height - 1);
     // reset the projection array
-    for (int i = 0; i < page_height; i++) {
+    for (int i = first_y - 1; i <= last_y; i++) {
       table_region[i] = false;
     }
     // iterate through all table columns to find regions in the current
@@ -791,7 +947,7 @@ void ColumnFinder::GetTableRegions(ColSegment_LIST* table_columns,
     current_table_box.set_right(part_box.right());
     // go through the y-axis projection to find runs of table
     // regions. Each run makes one table region.
-    for (int i = 1; i < page_height; i++) {
+    for (int i = first_y; i <= last_y; i++) {
       // detect start of a table region
       if (!table_region[i - 1] && table_region[i]) {
         current_table_box.set_bottom(i + bleft().y());
@@ -822,7 +978,7 @@ void ColumnFinder::GridMergeTableRegions() {
       gsearch(&table_grid_);
   gsearch.StartFullSearch();
   ColSegment* seg;
-  while ((seg = gsearch.NextFullSearch()) != NULL) {
+  while ((seg = gsearch.NextFullSearch()) != NULL && !DeadlinePassed()) {
     bool neighbor_found = false;
     bool modified = false;  // Modified at least once
     do {
@@ -34,6 +34,7 @@
 #include          "wordseg.h"
 #include          "topitch.h"
 #include          "secname.h"
+#include          "tordmain.h"
 #include          "tesseractclass.h"
 
 // Include automatically generated configuration file if running autoconf.
@@ -66,6 +67,9 @@ EXTERN double_VAR (textord_balance_factor, 1.0,
 #define BLOCK_STATS_CLUSTERS  10
 #define MAX_ALLOWED_PITCH 100    //max pixel pitch.
 
+static void compute_row_pitch(TO_ROW_JOB *job);
+static void try_row_fixed(TO_ROW_JOB *job);
+
 /**********************************************************************
  * compute_fixed_pitch
  *
@@ -361,36 +365,46 @@ BOOL8 compute_rows_pitch(                    //find line stats
                          inT32 block_index,  //block number
                          BOOL8 testing_on    //correct orientation
                         ) {
+  run_row_jobs(block, block_index, testing_on,
+               testing_on || textord_debug_pitch_metric
+               || textord_show_fixed_cuts,
+               compute_row_pitch, NULL);
+  return FALSE;
+}
+
+
+/**********************************************************************
+ * compute_row_pitch
+ *
+ * Decide whether a single row is fixed pitch. The job of
+ * compute_rows_pitch for each row.
+ **********************************************************************/
+
+static void compute_row_pitch(                   //find line stats
+                              TO_ROW_JOB *job    //row to do
+                             ) {
   inT32 maxwidth;                //of spaces
-  TO_ROW *row;                   //current row
-  inT32 row_index;               //row number.
+  TO_ROW *row = job->row;        //current row
   float lower, upper;            //cluster thresholds
-  TO_ROW_IT row_it = block->get_rows ();
 
-  row_index = 1;
-  for (row_it.mark_cycle_pt (); !row_it.cycled_list (); row_it.forward ()) {
-    row = row_it.data ();
-    ASSERT_HOST (row->xheight > 0);
-    row->compute_vertical_projection ();
-    maxwidth = (inT32) ceil (row->xheight * textord_words_maxspace);
-    if (row_pitch_stats (row, maxwidth, testing_on)
-      && find_row_pitch (row, maxwidth,
-      textord_dotmatrix_gap + 1, block, block_index,
-    row_index, testing_on)) {
-      if (row->fixed_pitch == 0) {
-        lower = row->pr_nonsp;
-        upper = row->pr_space;
-        row->space_size = upper;
-        row->kern_size = lower;
-      }
-    }
-    else {
-      row->fixed_pitch = 0.0f;   //insufficient data
-      row->pitch_decision = PITCH_DUNNO;
+  ASSERT_HOST (row->xheight > 0);
+  row->compute_vertical_projection ();
+  maxwidth = (inT32) ceil (row->xheight * textord_words_maxspace);
+  if (row_pitch_stats (row, maxwidth, job->testing_on)
+    && find_row_pitch (row, maxwidth,
+    textord_dotmatrix_gap + 1, job->block, job->block_index,
+  job->row_index, job->testing_on)) {
+    if (row->fixed_pitch == 0) {
+      lower = row->pr_nonsp;
+      upper = row->pr_space;
+      row->space_size = upper;
+      row->kern_size = lower;
     }
-    row_index++;
   }
-  return FALSE;
+  else {
+    row->fixed_pitch = 0.0f;     //insufficient data
+    row->pitch_decision = PITCH_DUNNO;
+  }
 }
 
 
@@ -559,9 +573,6 @@ BOOL8 try_rows_fixed(                    //find line stats
                      inT32 block_index,  //block number
                      BOOL8 testing_on    //correct orientation
                     ) {
-  inT32 maxwidth;                //of spaces
-  TO_ROW *row;                   //current row
-  inT32 row_index;               //row number.
   inT32 def_fixed = 0;           //counters
   inT32 def_prop = 0;
   inT32 maybe_fixed = 0;
@@ -569,24 +580,15 @@ BOOL8 try_rows_fixed(                    //find line stats
   inT32 dunno = 0;
   inT32 corr_fixed = 0;
   inT32 corr_prop = 0;
-  float lower, upper;            //cluster thresholds
-  TO_ROW_IT row_it = block->get_rows ();
-
-  row_index = 1;
-  for (row_it.mark_cycle_pt (); !row_it.cycled_list (); row_it.forward ()) {
-    row = row_it.data ();
-    ASSERT_HOST (row->xheight > 0);
-    maxwidth = (inT32) ceil (row->xheight * textord_words_maxspace);
-    if (row->fixed_pitch > 0 && fixed_pitch_row (row, block_index)) {
-      if (row->fixed_pitch == 0) {
-        lower = row->pr_nonsp;
-        upper = row->pr_space;
-        row->space_size = upper;
-        row->kern_size = lower;
-      }
-    }
-    row_index++;
-  }
+                                 //lattice for each thread
+  FPCUTPT_BUFFER *buffers = new FPCUTPT_BUFFER[MAX (textord_row_threads, 1)];
+
+  run_row_jobs(block, block_index, testing_on,
+               testing_on || textord_debug_pitch_metric
+               || textord_show_fixed_cuts
+               || block_index == textord_debug_block,
+               try_row_fixed, buffers);
+  delete [] buffers;
   count_block_votes(block,
                     def_fixed,
                     def_prop,
@@ -617,6 +619,34 @@ BOOL8 try_rows_fixed(                    //find line stats
 }
 
 
+/**********************************************************************
+ * try_row_fixed
+ *
+ * Decide whether a single row is fixed pitch. The job of try_rows_fixed
+ * for each row.
+ **********************************************************************/
+
+static void try_row_fixed(                   //find line stats
+                          TO_ROW_JOB *job    //row to do
+                         ) {
+  TO_ROW *row = job->row;        //current row
+  float lower, upper;            //cluster thresholds
+                                 //lattice of this thread
+  FPCUTPT_BUFFER *buffer = (FPCUTPT_BUFFER *) job->arg + job->thread;
+
+  ASSERT_HOST (row->xheight > 0);
+  if (row->fixed_pitch > 0
+  && fixed_pitch_row (row, job->block_index, buffer)) {
+    if (row->fixed_pitch == 0) {
+      lower = row->pr_nonsp;
+      upper = row->pr_space;
+      row->space_size = upper;
+      row->kern_size = lower;
+    }
+  }
+}
+
+
 /**********************************************************************
  * print_block_counts
  *
@@ -980,9 +1010,10 @@ BOOL8 find_row_pitch(                    //find lines
  * The larger threshold is the word gap threshold.
  **********************************************************************/
 
-BOOL8 fixed_pitch_row(                   //find lines
-                      TO_ROW *row,       //row to do
-                      inT32 block_index  //block_number
+BOOL8 fixed_pitch_row(                         //find lines
+                      TO_ROW *row,             //row to do
+                      inT32 block_index,       //block_number
+                      FPCUTPT_BUFFER *buffer   //lattice to reuse
                      ) {
   const char *res_string;        //pitch result
   inT16 mid_cuts;                //no of cheap cuts
@@ -1003,7 +1034,8 @@ BOOL8 fixed_pitch_row(                   //find lines
                                (row->fixed_pitch + non_space * 3) / 4,
                                row->fixed_pitch, sp_sd, mid_cuts,
                                &row->char_cells,
-                               block_index == textord_debug_block);
+                               block_index == textord_debug_block,
+                               buffer);
     if (pitch_sd < textord_words_pitchsd_threshold * row->fixed_pitch
       && ((pitsync_linear_version & 3) < 3
       || ((pitsync_linear_version & 3) >= 3 && (row->used_dm_model
@@ -1160,7 +1192,8 @@ float tune_row_pitch(                             //find fp cells
                      float &best_sp_sd,           //space sd
                      inT16 &best_mid_cuts,        //no of cheap cuts
                      ICOORDELT_LIST *best_cells,  //row cells
-                     BOOL8 testing_on             //inidividual words
+                     BOOL8 testing_on,            //inidividual words
+                     FPCUTPT_BUFFER *buffer       //lattice to reuse
                     ) {
   int pitch_delta;               //offset pitch
   inT16 mid_cuts;                //cheap cuts
@@ -1171,17 +1204,20 @@ float tune_row_pitch(                             //find fp cells
   float sp_sd;                   //space sd
   ICOORDELT_LIST test_cells;     //row cells
   ICOORDELT_IT best_it;          //start of best list
+  FPCUTPT_BUFFER local_buffer;   //if none given
 
   if (textord_fast_pitch_test)
     return tune_row_pitch2 (row, projection, projection_left,
       projection_right, space_size, initial_pitch,
       best_sp_sd,
     //space sd
-      best_mid_cuts, best_cells, testing_on);
+      best_mid_cuts, best_cells, testing_on, buffer);
   if (textord_disable_pitch_test) {
     best_sp_sd = initial_pitch;
     return initial_pitch;
   }
+  if (buffer == NULL)
+    buffer = &local_buffer;
   initial_sd =
     compute_pitch_sd(row,
                      projection,
@@ -1192,7 +1228,10 @@ float tune_row_pitch(                             //find fp cells
                      best_sp_sd,
                      best_mid_cuts,
                      best_cells,
-                     testing_on);
+                     testing_on,
+                     0,
+                     0,
+                     buffer);
   best_sd = initial_sd;
   best_pitch = initial_pitch;
   if (testing_on)
@@ -1201,7 +1240,7 @@ float tune_row_pitch(                             //find fp cells
     pitch_sd =
       compute_pitch_sd (row, projection, projection_left, projection_right,
       space_size, initial_pitch + pitch_delta, sp_sd,
-      mid_cuts, &test_cells, testing_on);
+      mid_cuts, &test_cells, testing_on, 0, 0, buffer);
     if (testing_on)
       tprintf ("testing pitch at %g, sd=%g\n", initial_pitch + pitch_delta,
         pitch_sd);
@@ -1223,7 +1262,7 @@ float tune_row_pitch(                             //find fp cells
     pitch_sd =
       compute_pitch_sd (row, projection, projection_left, projection_right,
       space_size, initial_pitch - pitch_delta, sp_sd,
-      mid_cuts, &test_cells, testing_on);
+      mid_cuts, &test_cells, testing_on, 0, 0, buffer);
     if (testing_on)
       tprintf ("testing pitch at %g, sd=%g\n", initial_pitch - pitch_delta,
         pitch_sd);
@@ -1272,7 +1311,8 @@ float tune_row_pitch2(                             //find fp cells
                       float &best_sp_sd,           //space sd
                       inT16 &best_mid_cuts,        //no of cheap cuts
                       ICOORDELT_LIST *best_cells,  //row cells
-                      BOOL8 testing_on             //inidividual words
+                      BOOL8 testing_on,            //inidividual words
+                      FPCUTPT_BUFFER *buffer       //lattice to reuse
                      ) {
   int pitch_delta;               //offset pitch
   inT16 pixel;                   //pixel coord
@@ -1353,7 +1393,8 @@ float tune_row_pitch2(                             //find fp cells
                      best_cells,
                      testing_on,
                      start,
-                     end);
+                     end,
+                     buffer);
   if (testing_on)
     tprintf ("tune_row_pitch:output pitch=%g, sd=%g\n", initial_pitch,
       best_sd);
@@ -1391,7 +1432,8 @@ float compute_pitch_sd(                            //find fp cells
                        ICOORDELT_LIST *row_cells,  //list of chop pts
                        BOOL8 testing_on,           //inidividual words
                        inT16 start,                //start of good range
-                       inT16 end                   //end of good range
+                       inT16 end,                  //end of good range
+                       FPCUTPT_BUFFER *buffer      //lattice to reuse
                       ) {
   inT16 occupation;              //no of cells in word.
                                  //blobs
@@ -1421,7 +1463,7 @@ float compute_pitch_sd(                            //find fp cells
     word_sync = compute_pitch_sd2 (row, projection, projection_left,
       projection_right, initial_pitch,
       occupation, mid_cuts, row_cells,
-      testing_on, start, end);
+      testing_on, start, end, buffer);
     sp_sd = occupation;
     return word_sync;
   }
@@ -1461,7 +1503,7 @@ float compute_pitch_sd(                            //find fp cells
         check_pitch_sync2 (&start_it, blob_count, (inT16) initial_pitch, 2,
         projection, projection_left, projection_right,
         row->xheight * textord_projection_scale,
-        occupation, &seg_list, start, end);
+        occupation, &seg_list, start, end, buffer);
     else
       word_sync =
         check_pitch_sync (&start_it, blob_count, (inT16) initial_pitch, 2,
@@ -1553,7 +1595,8 @@ float compute_pitch_sd2(                            //find fp cells
                         ICOORDELT_LIST *row_cells,  //list of chop pts
                         BOOL8 testing_on,           //inidividual words
                         inT16 start,                //start of good range
-                        inT16 end                   //end of good range
+                        inT16 end,                  //end of good range
+                        FPCUTPT_BUFFER *buffer      //lattice to reuse
                        ) {
                                  //blobs
   BLOBNBOX_IT blob_it = row->blob_list ();
@@ -1592,7 +1635,7 @@ float compute_pitch_sd2(                            //find fp cells
     2, projection, projection_left,
     projection_right,
     row->xheight * textord_projection_scale,
-    occupation, &seg_list, start, end);
+    occupation, &seg_list, start, end, buffer);
   if (testing_on) {
     tprintf ("Row ending at (%d,%d), len=%d, sync rating=%g, ",
       blob_box.right (), blob_box.top (),
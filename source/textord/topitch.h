@@ -26,6 +26,8 @@
 namespace tesseract {
 class Tesseract;
 }
+class FPCUTPT_BUFFER;
+
 extern BOOL_VAR_H (textord_debug_pitch_test, FALSE,
 "Debug on fixed pitch test");
 extern BOOL_VAR_H (textord_debug_pitch_metric, FALSE,
@@ -111,9 +113,10 @@ BOOL8 find_row_pitch(                    //find lines
                      inT32 row_index,    //number of row
                      BOOL8 testing_on    //correct orientation
                     );
-BOOL8 fixed_pitch_row(                   //find lines
-                      TO_ROW *row,       //row to do
-                      inT32 block_index  //block_number
+BOOL8 fixed_pitch_row(                         //find lines
+                      TO_ROW *row,             //row to do
+                      inT32 block_index,       //block_number
+                      FPCUTPT_BUFFER *buffer = NULL  //lattice to reuse
                      );
 BOOL8 count_pitch_stats(                       //find lines
                         TO_ROW *row,           //row to do
@@ -135,7 +138,8 @@ float tune_row_pitch(                             //find fp cells
                      float &best_sp_sd,           //space sd
                      inT16 &best_mid_cuts,        //no of cheap cuts
                      ICOORDELT_LIST *best_cells,  //row cells
-                     BOOL8 testing_on             //inidividual words
+                     BOOL8 testing_on,            //inidividual words
+                     FPCUTPT_BUFFER *buffer = NULL  //lattice to reuse
                     );
 float tune_row_pitch2(                             //find fp cells
                       TO_ROW *row,                 //row to do
@@ -147,7 +151,8 @@ float tune_row_pitch2(                             //find fp cells
                       float &best_sp_sd,           //space sd
                       inT16 &best_mid_cuts,        //no of cheap cuts
                       ICOORDELT_LIST *best_cells,  //row cells
-                      BOOL8 testing_on             //inidividual words
+                      BOOL8 testing_on,            //inidividual words
+                      FPCUTPT_BUFFER *buffer = NULL  //lattice to reuse
                      );
 float compute_pitch_sd (         //find fp cells
 TO_ROW * row,                    //row to do
@@ -161,7 +166,8 @@ inT16 & mid_cuts,                //no of free cuts
 ICOORDELT_LIST * row_cells,      //list of chop pts
 BOOL8 testing_on,                //inidividual words
 inT16 start = 0,                 //start of good range
-inT16 end = 0                    //end of good range
+inT16 end = 0,                   //end of good range
+FPCUTPT_BUFFER * buffer = NULL   //lattice to reuse
 );
 float compute_pitch_sd2 (        //find fp cells
 TO_ROW * row,                    //row to do
@@ -174,7 +180,8 @@ inT16 & mid_cuts,                //no of free cuts
 ICOORDELT_LIST * row_cells,      //list of chop pts
 BOOL8 testing_on,                //inidividual words
 inT16 start = 0,                 //start of good range
-inT16 end = 0                    //end of good range
+inT16 end = 0,                   //end of good range
+FPCUTPT_BUFFER * buffer = NULL   //lattice to reuse
 );
 void print_pitch_sd(                        //find fp cells
                     TO_ROW *row,            //row to do
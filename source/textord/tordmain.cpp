@@ -34,6 +34,7 @@
 #include "imgs.h"
 #include "tordmain.h"
 #include "secname.h"
+#include "ccutil.h"
 #include "tesseractclass.h"
 
 // Include automatically generated configuration file if running autoconf.
@@ -96,6 +97,8 @@ EXTERN double_VAR (textord_blshift_maxshift, 0.00, "Max baseline shift");
 EXTERN double_VAR (textord_blshift_xfraction, 9.99,
 "Min size of baseline shift");
 EXTERN STRING_EVAR (tessedit_image_ext, ".tif", "Externsion for image file");
+EXTERN INT_VAR (textord_row_threads, 1,
+"Threads to run the per-row textord jobs on");
 
 #ifndef EMBEDDED
 EXTERN clock_t previous_cpu;
@@ -110,6 +113,14 @@ extern BOOL_VAR_H (polygon_tess_approximation, TRUE,
 extern IMAGE page_image;         //must be defined somewhere
 extern BOOL_VAR_H (interactive_mode, TRUE, "Run interactively?");
 extern /*"C" */ ETEXT_DESC *global_monitor;     //progress monitor
+extern int global_monitor_words;                 //user words found so far
+
+// The rows of a block, as run by run_row_jobs.
+struct TO_ROW_POOL
+{
+  TO_ROW_JOB *jobs;              //one per row
+  TO_ROW_FUNC func;              //job for each row
+};
 
 /**********************************************************************
  * find_components
@@ -152,6 +163,8 @@ void find_components(
 
   for (block_it.mark_cycle_pt(); !block_it.cycled_list();
        block_it.forward()) {
+    if (ocr_deadline_passed(global_monitor, global_monitor_words))
+      break;  // Out of time: leave the remaining blocks empty.
     block = block_it.data();
     if (block->poly_block() == NULL ||
         block->poly_block()->IsText()) {
@@ -557,7 +570,9 @@ void textord_page(                             //make rows & words
     global_monitor->progress = 20;
   }
   set_global_loc_code(LOC_TEXT_ORD_WORDS);
-  make_words(page_tr, gradient, blocks, land_blocks, port_blocks, tess);
+  // Out of time: skip making words, so the blocks are left empty.
+  if (!ocr_deadline_passed(global_monitor, global_monitor_words))
+    make_words(page_tr, gradient, blocks, land_blocks, port_blocks, tess);
   if (global_monitor != NULL) {
     global_monitor->ocr_alive = TRUE;
     global_monitor->progress = 30;
@@ -1013,3 +1028,66 @@ inT32 blob_y_order(              //sort function
   }
 }
 
+
+
+/**********************************************************************
+ * run_row_job
+ *
+ * Run the job of a single row on the given thread.
+ **********************************************************************/
+
+static void run_row_job(                 //do one row
+                        void *data,      //TO_ROW_POOL
+                        int job,         //row index, from 0
+                        int thread       //thread index, from 0
+                       ) {
+  TO_ROW_POOL *pool = (TO_ROW_POOL *) data;
+
+  pool->jobs[job].thread = thread;
+  (*pool->func) (&pool->jobs[job]);
+}
+
+
+/**********************************************************************
+ * run_row_jobs
+ *
+ * Run func on every row of the block, using up to textord_row_threads
+ * threads, and return when all the rows are done. func may only change
+ * its own row, so the results are the same for any number of threads.
+ * If in_order is set, the rows are done one at a time in list order,
+ * as needed for debug output and drawing. job->thread is always less
+ * than MAX (textord_row_threads, 1), so arg may point to an array of
+ * state kept per thread.
+ **********************************************************************/
+
+void run_row_jobs(                      //do all rows
+                  TO_BLOCK *block,      //block to do
+                  inT32 block_index,    //block number
+                  BOOL8 testing_on,     //debug this block
+                  BOOL8 in_order,       //one thread only
+                  TO_ROW_FUNC func,     //job for each row
+                  void *arg             //passed to every job
+                 ) {
+  TO_ROW_POOL pool;              //shared state
+  TO_ROW_IT row_it = block->get_rows ();
+  inT32 num_jobs;                //rows to do
+  inT32 i;
+
+  num_jobs = row_it.length ();
+  if (num_jobs == 0)
+    return;
+  pool.jobs = new TO_ROW_JOB[num_jobs];
+  pool.func = func;
+  for (i = 0, row_it.mark_cycle_pt (); !row_it.cycled_list ();
+  row_it.forward (), i++) {
+    pool.jobs[i].row = row_it.data ();
+    pool.jobs[i].block = block;
+    pool.jobs[i].block_index = block_index;
+    pool.jobs[i].row_index = i + 1;
+    pool.jobs[i].testing_on = testing_on;
+    pool.jobs[i].arg = arg;
+  }
+  tesseract::RunJobsOnThreads (run_row_job, &pool, num_jobs,
+                               in_order ? 1 : textord_row_threads);
+  delete [] pool.jobs;
+}
@@ -70,7 +70,25 @@ extern double_VAR_H (textord_blshift_xfraction, 9.99,
 "Min size of baseline shift");
                                  //xiaofan
 extern STRING_EVAR_H (tessedit_image_ext, ".tif", "Externsion for image file");
+extern INT_VAR_H (textord_row_threads, 1,
+"Threads to run the per-row textord jobs on");
 extern clock_t previous_cpu;
+
+// One row of a block, to be processed by run_row_jobs.
+struct TO_ROW_JOB
+{
+  TO_ROW *row;                   //row to do
+  TO_BLOCK *block;               //block of row
+  inT32 block_index;             //block number
+  inT32 row_index;               //row number, from 1
+  BOOL8 testing_on;              //debug this block
+  inT32 thread;                  //thread doing the row, from 0
+  void *arg;                     //shared by all the rows
+};
+
+// Processes a single row. Must not touch any other row or shared state.
+typedef void (*TO_ROW_FUNC) (TO_ROW_JOB *job);
+
 void make_blocks_from_blobs(                       //convert & textord
                             TBLOB *tessblobs,      //tess style input
                             const char *filename,  //blob file
@@ -131,4 +149,12 @@ void tweak_row_baseline(          //remove empties
 inT32 blob_y_order(              //sort function
                    void *item1,  //items to compare
                    void *item2);
+void run_row_jobs(                      //do all rows
+                  TO_BLOCK *block,      //block to do
+                  inT32 block_index,    //block number
+                  BOOL8 testing_on,     //debug this block
+                  BOOL8 in_order,       //one thread only
+                  TO_ROW_FUNC func,     //job for each row
+                  void *arg             //passed to every job
+                 );
 #endif
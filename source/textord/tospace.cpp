@@ -4,6 +4,7 @@
 #include "tospace.h"
 #include "ndminx.h"
 #include "statistc.h"
+#include "tordmain.h"
 
 // Include automatically generated configuration file if running autoconf.
 #ifdef HAVE_CONFIG_H
@@ -40,6 +41,8 @@ BOOL_VAR(tosp_rule_9_test_punct, FALSE,
 BOOL_VAR(tosp_flip_fuzz_kn_to_sp, TRUE, "Default flip");
 BOOL_VAR(tosp_flip_fuzz_sp_to_kn, TRUE, "Default flip");
 BOOL_VAR(tosp_improve_thresh, FALSE, "Enable improvement heuristic");
+BOOL_VAR(tosp_show_timing, FALSE,
+"Print the time taken to find the spacing of each row");
 INT_VAR(tosp_debug_level, 0, "Debug data");
 INT_VAR(tosp_enough_space_samples_for_median, 3,
 "or should we use mean");
@@ -104,6 +107,27 @@ double_VAR(tosp_pass_wide_fuzz_sp_to_context, 0.75,
 "How wide fuzzies need context");
 
 #define MAXSPACING      128      /*max expected spacing in pix */
+
+// Everything the row jobs of to_spacing need from their block.
+struct TO_SPACING_BLOCK
+{
+  GAPMAP *gapmap;                //map of big vert gaps in blk
+  ROW_GAPS *row_gaps;            //gaps of each row
+  inT16 block_space_gap_width;   //Estimated width of real spaces
+  inT16 block_non_space_gap_width;
+  BOOL8 old_text_ord_proportional;
+};
+
+static void find_row_gaps_job(TO_ROW_JOB *job);
+static void row_spacing_job(TO_ROW_JOB *job);
+static void find_cblob_xht_limits(C_BLOB *blob,
+                                  float above_xht,
+                                  float baseline,
+                                  float xht_line,
+                                  float &left_above_xht,
+                                  float &left_above_base,
+                                  float &right_below_xht);
+
 /**********************************************************************
  * to_spacing
  *
@@ -114,6 +138,8 @@ double_VAR(tosp_pass_wide_fuzz_sp_to_context, 0.75,
  *							kern_size
  *							space_size     for each row.
  * ONLY FOR PROPORTIONAL BLOCKS - FIXED PITCH IS ASSUMED ALREADY DONE
+ * The gaps of each row are found once and the rows of each block are
+ * done on textord_row_threads threads.
  **********************************************************************/
 
 void to_spacing(                       //set spacing
@@ -122,60 +148,198 @@ void to_spacing(                       //set spacing
                ) {
   TO_BLOCK_IT block_it;          //iterator
   TO_BLOCK *block;               //current block;
-  TO_ROW_IT row_it;              //row iterator
-  TO_ROW *row;                   //current row
   int block_index;               //block number
   int row_index;                 //row number
-  inT16 block_space_gap_width;   //Estimated width of    real spaces for whole block
-                                 //Estimate width ofnon space gaps for whole block
-  inT16 block_non_space_gap_width;
-                                 //Old fixed/prop result
-  BOOL8 old_text_ord_proportional;
-  GAPMAP *gapmap = NULL;         //map of big vert gaps in blk
+  int row_count;                 //rows in block
+  BOOL8 in_order;                //debug output wanted
+  TO_SPACING_BLOCK spacing;      //shared by row jobs
+  clock_t block_start;           //timing
+  clock_t page_time = 0;
 
+  in_order = tosp_debug_level > 0 || textord_show_initial_words;
   block_it.set_to_list (blocks);
   block_index = 1;
   for (block_it.mark_cycle_pt (); !block_it.cycled_list ();
   block_it.forward ()) {
     block = block_it.data ();
-    gapmap = new GAPMAP (block);
+    block_start = clock ();
+    row_count = block->get_rows ()->length ();
+    spacing.gapmap = new GAPMAP (block);
+    spacing.row_gaps = new ROW_GAPS[row_count > 0 ? row_count : 1];
+    run_row_jobs(block, block_index, FALSE, in_order,
+                 find_row_gaps_job, &spacing);
     block_spacing_stats(block,
-                        gapmap,
-                        old_text_ord_proportional,
-                        block_space_gap_width,
-                        block_non_space_gap_width);
-    row_it.set_to_list (block->get_rows ());
-    row_index = 1;
-    for (row_it.mark_cycle_pt (); !row_it.cycled_list (); row_it.forward ()) {
-      row = row_it.data ();
-      if ((row->pitch_decision == PITCH_DEF_PROP) ||
-      (row->pitch_decision == PITCH_CORR_PROP)) {
-        if ((tosp_debug_level > 0) && !old_text_ord_proportional)
-          tprintf ("Block %d Row %d: Now Proportional\n",
-            block_index, row_index);
-        row_spacing_stats(row,
-                          gapmap,
-                          block_index,
-                          row_index,
-                          block_space_gap_width,
-                          block_non_space_gap_width);
-      }
-      else {
-        if ((tosp_debug_level > 0) && old_text_ord_proportional)
-          tprintf
-            ("Block %d Row %d: Now Fixed Pitch Decision:%d fp flag:%f\n",
-            block_index, row_index, row->pitch_decision,
-            row->fixed_pitch);
-      }
+                        spacing.row_gaps,
+                        spacing.old_text_ord_proportional,
+                        spacing.block_space_gap_width,
+                        spacing.block_non_space_gap_width);
+    run_row_jobs(block, block_index, FALSE, in_order,
+                 row_spacing_job, &spacing);
+    if (tosp_show_timing) {
+      for (row_index = 0; row_index < row_count; row_index++)
+        tprintf ("Block %d Row %d: %d gaps, gaps %.3fms, stats %.3fms\n",
+          block_index, row_index + 1,
+          spacing.row_gaps[row_index].widths.size (),
+          spacing.row_gaps[row_index].gap_time * 1000.0 / CLOCKS_PER_SEC,
+          spacing.row_gaps[row_index].stats_time * 1000.0 / CLOCKS_PER_SEC);
+      tprintf ("Block %d: %d rows in %.3fms\n", block_index, row_count,
+        (clock () - block_start) * 1000.0 / CLOCKS_PER_SEC);
+      page_time += clock () - block_start;
+    }
+    delete [] spacing.row_gaps;
+    delete spacing.gapmap;
+    block_index++;
+  }
+  if (tosp_show_timing)
+    tprintf ("Spacing of page: %.3fms\n",
+      page_time * 1000.0 / CLOCKS_PER_SEC);
+}
+
+
+/**********************************************************************
+ * find_row_gaps_job
+ *
+ * Find the gaps of a single row if they are wanted by the block or
+ * row stats. The first job of to_spacing.
+ **********************************************************************/
+
+static void find_row_gaps_job(                  //find gaps of a row
+                              TO_ROW_JOB *job   //row to do
+                             ) {
+  TO_SPACING_BLOCK *spacing = (TO_SPACING_BLOCK *) job->arg;
+  TO_ROW *row = job->row;        //current row
+
+  if (!row->blob_list ()->empty () &&
+    (!tosp_only_use_prop_rows ||
+    (row->pitch_decision == PITCH_DEF_PROP) ||
+  (row->pitch_decision == PITCH_CORR_PROP)))
+    find_row_gaps (row, spacing->gapmap,
+      &spacing->row_gaps[job->row_index - 1]);
+}
+
+
+/**********************************************************************
+ * row_spacing_job
+ *
+ * Set the spacing of a single proportional row from its gaps and the
+ * block estimates. The second job of to_spacing.
+ **********************************************************************/
+
+static void row_spacing_job(                  //set spacing of a row
+                            TO_ROW_JOB *job   //row to do
+                           ) {
+  TO_SPACING_BLOCK *spacing = (TO_SPACING_BLOCK *) job->arg;
+  TO_ROW *row = job->row;        //current row
+  ROW_GAPS *gaps = &spacing->row_gaps[job->row_index - 1];
+  clock_t start;                 //timing
+
+  if ((row->pitch_decision == PITCH_DEF_PROP) ||
+  (row->pitch_decision == PITCH_CORR_PROP)) {
+    if ((tosp_debug_level > 0) && !spacing->old_text_ord_proportional)
+      tprintf ("Block %d Row %d: Now Proportional\n",
+        job->block_index, job->row_index);
+    start = clock ();
+    row_spacing_stats(row,
+                      gaps,
+                      job->block_index,
+                      job->row_index,
+                      spacing->block_space_gap_width,
+                      spacing->block_non_space_gap_width);
+    gaps->stats_time = clock () - start;
+  }
+  else {
+    if ((tosp_debug_level > 0) && spacing->old_text_ord_proportional)
+      tprintf
+        ("Block %d Row %d: Now Fixed Pitch Decision:%d fp flag:%f\n",
+        job->block_index, job->row_index, row->pitch_decision,
+        row->fixed_pitch);
+  }
 #ifndef GRAPHICS_DISABLED
-      if (textord_show_initial_words)
-        plot_word_decisions (to_win, (inT16) row->fixed_pitch, row);
+  if (textord_show_initial_words)
+    plot_word_decisions (to_win, (inT16) row->fixed_pitch, row);
 #endif
-      row_index++;
+}
+
+
+/*************************************************************************
+ * find_row_gaps()
+ * Walk the blobs of the row once, recording the width and centre to
+ * centre distance of every gap, whether ignore_big_gap rejects it and
+ * whether it would count as an obvious space.
+ * Only the blobs of this row are touched, so rows may be done in parallel.
+ *************************************************************************/
+
+void find_row_gaps(                  //get gaps of row
+                   TO_ROW *row,      //row to do
+                   GAPMAP *gapmap,   //map of big vert gaps in blk
+                   ROW_GAPS *gaps    //output gaps
+                  ) {
+  BLOBNBOX_IT blob_it = row->blob_list ();
+  TBOX blob_box;
+  TBOX prev_blob_box;
+  BOOL8 narrow;                  //current blob is narrow
+  BOOL8 prev_narrow;
+  BOOL8 wide;                    //current blob is wide
+  BOOL8 prev_wide;
+  inT16 gap_width;
+  inT32 end_of_row;
+  uinT8 flags;                   //of gap
+  clock_t start = clock ();      //timing
+
+  blob_it.mark_cycle_pt ();
+  end_of_row = blob_it.data_relative (-1)->bounding_box ().right ();
+  if (tosp_use_pre_chopping)
+    blob_box = box_next_pre_chopped (&blob_it);
+  else if (tosp_stats_use_xht_gaps)
+    blob_box = reduced_box_next (row, &blob_it);
+  else
+    blob_box = box_next (&blob_it);
+  gaps->row_length = end_of_row - blob_box.left ();
+  gaps->min_blob_width = blob_box.width ();
+  prev_blob_box = blob_box;
+  prev_narrow = narrow_blob (row, blob_box);
+  prev_wide = wide_blob (row, blob_box);
+  while (!blob_it.cycled_list ()) {
+    if (tosp_use_pre_chopping)
+      blob_box = box_next_pre_chopped (&blob_it);
+    else if (tosp_stats_use_xht_gaps)
+      blob_box = reduced_box_next (row, &blob_it);
+    else
+      blob_box = box_next (&blob_it);
+    if (blob_box.width () < gaps->min_blob_width)
+      gaps->min_blob_width = blob_box.width ();
+    narrow = narrow_blob (row, blob_box);
+    wide = wide_blob (row, blob_box);
+    gap_width = blob_box.left () - prev_blob_box.right ();
+    flags = 0;
+    if (ignore_big_gap (row, gaps->row_length, gapmap,
+      prev_blob_box.right (), blob_box.left ()))
+      flags |= GAP_IGNORED;
+    /*
+    The block stats always passed the negated row length, which only
+    matters when the row length is used at all.
+    */
+    if (tosp_ignore_big_gaps == 0) {
+      if (ignore_big_gap (row, -gaps->row_length, gapmap,
+        prev_blob_box.right (), blob_box.left ()))
+        flags |= GAP_IGNORED_BLOCK;
     }
-    delete gapmap;
-    block_index++;
+    else if (flags & GAP_IGNORED)
+      flags |= GAP_IGNORED_BLOCK;
+    if ((gap_width > tosp_fuzzy_space_factor2 * row->xheight) ||
+      ((gap_width > tosp_fuzzy_space_factor1 * row->xheight) &&
+      (!tosp_narrow_blobs_not_cert || (!prev_narrow && !narrow))) ||
+      (prev_wide && wide))
+      flags |= GAP_CERT_SPACE;
+    gaps->widths.push_back (gap_width);
+    gaps->centres.push_back ((blob_box.left () + blob_box.right () -
+      (prev_blob_box.left () + prev_blob_box.right ())) / 2);
+    gaps->flags.push_back (flags);
+    prev_blob_box = blob_box;
+    prev_narrow = narrow;
+    prev_wide = wide;
   }
+  gaps->gap_time = clock () - start;
 }
 
 
@@ -185,72 +349,43 @@ void to_spacing(                       //set spacing
 
 void block_spacing_stats(                                  //DEBUG USE ONLY
                          TO_BLOCK *block,
-                         GAPMAP *gapmap,
+                         ROW_GAPS *row_gaps,
                          BOOL8 &old_text_ord_proportional,
                          inT16 &block_space_gap_width,     //resulting estimate
                          inT16 &block_non_space_gap_width  //resulting estimate
                         ) {
   TO_ROW_IT row_it;              //row iterator
   TO_ROW *row;                   //current row
-  BLOBNBOX_IT blob_it;           //iterator
+  ROW_GAPS *gaps;                //gaps of row
 
   STATS centre_to_centre_stats (0, MAXSPACING);
   //DEBUG USE ONLY
   STATS all_gap_stats (0, MAXSPACING);
   STATS space_gap_stats (0, MAXSPACING);
   inT16 minwidth = MAX_INT16;    //narrowest blob
-  TBOX blob_box;
-  TBOX prev_blob_box;
-  inT16 centre_to_centre;
   inT16 gap_width;
+  int index;                     //of gap
   float real_space_threshold;
   float iqr_centre_to_centre;    //DEBUG USE ONLY
   float iqr_all_gap_stats;       //DEBUG USE ONLY
-  inT32 end_of_row;
-  inT32 row_length;
 
   row_it.set_to_list (block->get_rows ());
-  for (row_it.mark_cycle_pt (); !row_it.cycled_list (); row_it.forward ()) {
+  for (gaps = row_gaps, row_it.mark_cycle_pt (); !row_it.cycled_list ();
+  row_it.forward (), gaps++) {
     row = row_it.data ();
     if (!row->blob_list ()->empty () &&
       (!tosp_only_use_prop_rows ||
       (row->pitch_decision == PITCH_DEF_PROP) ||
     (row->pitch_decision == PITCH_CORR_PROP))) {
-      blob_it.set_to_list (row->blob_list ());
-      blob_it.mark_cycle_pt ();
-      end_of_row = blob_it.data_relative (-1)->bounding_box ().right ();
-      if (tosp_use_pre_chopping)
-        blob_box = box_next_pre_chopped (&blob_it);
-      else if (tosp_stats_use_xht_gaps)
-        blob_box = reduced_box_next (row, &blob_it);
-      else
-        blob_box = box_next (&blob_it);
-      row_length = end_of_row - blob_box.left ();
-      if (blob_box.width () < minwidth)
-        minwidth = blob_box.width ();
-      prev_blob_box = blob_box;
-      while (!blob_it.cycled_list ()) {
-        if (tosp_use_pre_chopping)
-          blob_box = box_next_pre_chopped (&blob_it);
-        else if (tosp_stats_use_xht_gaps)
-          blob_box = reduced_box_next (row, &blob_it);
-        else
-          blob_box = box_next (&blob_it);
-        if (blob_box.width () < minwidth)
-          minwidth = blob_box.width ();
-        gap_width = blob_box.left () - prev_blob_box.right ();
-        if (!ignore_big_gap (row, row_length, gapmap,
-        prev_blob_box.right (), blob_box.left ())) {
-          all_gap_stats.add (gap_width, 1);
-
-          centre_to_centre = (blob_box.left () + blob_box.right () -
-            (prev_blob_box.left () +
-            prev_blob_box.right ())) / 2;
+      if (gaps->min_blob_width < minwidth)
+        minwidth = gaps->min_blob_width;
+      for (index = 0; index < gaps->widths.size (); index++) {
+        if (!(gaps->flags[index] & GAP_IGNORED)) {
+          all_gap_stats.add (gaps->widths[index], 1);
           //DEBUG
-          centre_to_centre_stats.add (centre_to_centre, 1);
+          centre_to_centre_stats.add (gaps->centres[index], 1);
           // DEBUG
         }
-        prev_blob_box = blob_box;
       }
     }
   }
@@ -284,7 +419,8 @@ void block_spacing_stats(                                  //DEBUG USE ONLY
     // median gap
 
     row_it.set_to_list (block->get_rows ());
-    for (row_it.mark_cycle_pt (); !row_it.cycled_list (); row_it.forward ()) {
+    for (gaps = row_gaps, row_it.mark_cycle_pt (); !row_it.cycled_list ();
+    row_it.forward (), gaps++) {
       row = row_it.data ();
       if (!row->blob_list ()->empty () &&
         (!tosp_only_use_prop_rows ||
@@ -293,30 +429,10 @@ void block_spacing_stats(                                  //DEBUG USE ONLY
         real_space_threshold =
           MAX (tosp_init_guess_kn_mult * block_non_space_gap_width,
           tosp_init_guess_xht_mult * row->xheight);
-        blob_it.set_to_list (row->blob_list ());
-        blob_it.mark_cycle_pt ();
-        end_of_row =
-          blob_it.data_relative (-1)->bounding_box ().right ();
-        if (tosp_use_pre_chopping)
-          blob_box = box_next_pre_chopped (&blob_it);
-        else if (tosp_stats_use_xht_gaps)
-          blob_box = reduced_box_next (row, &blob_it);
-        else
-          blob_box = box_next (&blob_it);
-        row_length = blob_box.left () - end_of_row;
-        prev_blob_box = blob_box;
-        while (!blob_it.cycled_list ()) {
-          if (tosp_use_pre_chopping)
-            blob_box = box_next_pre_chopped (&blob_it);
-          else if (tosp_stats_use_xht_gaps)
-            blob_box = reduced_box_next (row, &blob_it);
-          else
-            blob_box = box_next (&blob_it);
-          gap_width = blob_box.left () - prev_blob_box.right ();
+        for (index = 0; index < gaps->widths.size (); index++) {
+          gap_width = gaps->widths[index];
           if ((gap_width > real_space_threshold) &&
-            !ignore_big_gap (row, row_length, gapmap,
-            prev_blob_box.right (),
-          blob_box.left ())) {
+          !(gaps->flags[index] & GAP_IGNORED_BLOCK)) {
             /*
             If tosp_use_cert_spaces is enabled, the estimate of the space gap is
             restricted to obvious spaces - those wider than half the xht or those
@@ -324,19 +440,9 @@ void block_spacing_stats(                                  //DEBUG USE ONLY
             punctiation that is sometimes widely spaced.
             */
             if (!tosp_block_use_cert_spaces ||
-              (gap_width >
-              tosp_fuzzy_space_factor2 * row->xheight)
-              ||
-              ((gap_width >
-              tosp_fuzzy_space_factor1 * row->xheight)
-              && (!tosp_narrow_blobs_not_cert
-              || (!narrow_blob (row, prev_blob_box)
-              && !narrow_blob (row, blob_box))))
-              || (wide_blob (row, prev_blob_box)
-              && wide_blob (row, blob_box)))
+              (gaps->flags[index] & GAP_CERT_SPACE))
               space_gap_stats.add (gap_width, 1);
           }
-          prev_blob_box = blob_box;
         }
       }
     }
@@ -359,21 +465,18 @@ void block_spacing_stats(                                  //DEBUG USE ONLY
 
 void row_spacing_stats(                                 //estimate for block
                        TO_ROW *row,
-                       GAPMAP *gapmap,
+                       ROW_GAPS *gaps,
                        inT16 block_idx,
                        inT16 row_idx,
                        inT16 block_space_gap_width,
                        inT16 block_non_space_gap_width  //estimate for block
                       ) {
-                                 //iterator
-  BLOBNBOX_IT blob_it = row->blob_list ();
   STATS all_gap_stats (0, MAXSPACING);
   STATS cert_space_gap_stats (0, MAXSPACING);
   STATS all_space_gap_stats (0, MAXSPACING);
   STATS small_gap_stats (0, MAXSPACING);
-  TBOX blob_box;
-  TBOX prev_blob_box;
   inT16 gap_width;
+  int gap_index;                 //of gap
   inT16 real_space_threshold = 0;
   inT16 max = 0;
   inT16 index;
@@ -381,7 +484,6 @@ void row_spacing_stats(                                 //estimate for block
   BOOL8 suspected_table;
   inT32 max_max_nonspace;        //upper bound
   BOOL8 good_block_space_estimate = block_space_gap_width > 0;
-  inT32 end_of_row;
   inT32 row_length = 0;
   float sane_space;
   inT32 sane_threshold;
@@ -400,38 +502,15 @@ void row_spacing_stats(                                 //estimate for block
     else
       real_space_threshold =     //Old TO method
         (block_space_gap_width + block_non_space_gap_width) / 2;
-    blob_it.set_to_list (row->blob_list ());
-    blob_it.mark_cycle_pt ();
-    end_of_row = blob_it.data_relative (-1)->bounding_box ().right ();
-    if (tosp_use_pre_chopping)
-      blob_box = box_next_pre_chopped (&blob_it);
-    else if (tosp_stats_use_xht_gaps)
-      blob_box = reduced_box_next (row, &blob_it);
-    else
-      blob_box = box_next (&blob_it);
-    row_length = end_of_row - blob_box.left ();
-    prev_blob_box = blob_box;
-    while (!blob_it.cycled_list ()) {
-      if (tosp_use_pre_chopping)
-        blob_box = box_next_pre_chopped (&blob_it);
-      else if (tosp_stats_use_xht_gaps)
-        blob_box = reduced_box_next (row, &blob_it);
-      else
-        blob_box = box_next (&blob_it);
-      gap_width = blob_box.left () - prev_blob_box.right ();
-      if (ignore_big_gap (row, row_length, gapmap,
-        prev_blob_box.right (), blob_box.left ()))
+    row_length = gaps->row_length;
+    for (gap_index = 0; gap_index < gaps->widths.size (); gap_index++) {
+      gap_width = gaps->widths[gap_index];
+      if (gaps->flags[gap_index] & GAP_IGNORED)
         large_gap_count++;
       else {
         if (gap_width >= real_space_threshold) {
           if (!tosp_row_use_cert_spaces ||
-            (gap_width > tosp_fuzzy_space_factor2 * row->xheight) ||
-            ((gap_width > tosp_fuzzy_space_factor1 * row->xheight)
-            && (!tosp_narrow_blobs_not_cert
-            || (!narrow_blob (row, prev_blob_box)
-            && !narrow_blob (row, blob_box))))
-            || (wide_blob (row, prev_blob_box)
-            && wide_blob (row, blob_box)))
+            (gaps->flags[gap_index] & GAP_CERT_SPACE))
             cert_space_gap_stats.add (gap_width, 1);
           all_space_gap_stats.add (gap_width, 1);
         }
@@ -439,7 +518,6 @@ void row_spacing_stats(                                 //estimate for block
           small_gap_stats.add (gap_width, 1);
         all_gap_stats.add (gap_width, 1);
       }
-      prev_blob_box = blob_box;
     }
   }
   suspected_table = (large_gap_count > 1) ||
@@ -461,7 +539,7 @@ void row_spacing_stats(                                 //estimate for block
                   block_non_space_gap_width);
   else {
     if (!tosp_recovery_isolated_row_stats ||
-      !isolated_row_stats (row, gapmap, &all_gap_stats, suspected_table,
+      !isolated_row_stats (row, gaps, &all_gap_stats, suspected_table,
     block_idx, row_idx)) {
       if (tosp_row_use_cert_spaces && (tosp_debug_level > 5))
         tprintf ("B:%d R:%d -- Inadequate certain spaces.\n",
@@ -722,7 +800,7 @@ void old_to_method(                                 //estimate for block
  *************************************************************************/
 
 BOOL8 isolated_row_stats(TO_ROW *row,
-                         GAPMAP *gapmap,
+                         ROW_GAPS *gaps,
                          STATS *all_gap_stats,
                          BOOL8 suspected_table,
                          inT16 block_idx,
@@ -731,16 +809,11 @@ BOOL8 isolated_row_stats(TO_ROW *row,
   float crude_threshold_estimate;
   inT16 small_gaps_count;
   inT16 total;
-                                 //iterator
-  BLOBNBOX_IT blob_it = row->blob_list ();
   STATS cert_space_gap_stats (0, MAXSPACING);
   STATS all_space_gap_stats (0, MAXSPACING);
   STATS small_gap_stats (0, MAXSPACING);
-  TBOX blob_box;
-  TBOX prev_blob_box;
   inT16 gap_width;
-  inT32 end_of_row;
-  inT32 row_length;
+  int index;                     //of gap
 
   kern_estimate = all_gap_stats->median ();
   crude_threshold_estimate = MAX (tosp_init_guess_kn_mult * kern_estimate,
@@ -758,41 +831,16 @@ BOOL8 isolated_row_stats(TO_ROW *row,
         block_idx, row_idx);
     return FALSE;
   }
-  blob_it.set_to_list (row->blob_list ());
-  blob_it.mark_cycle_pt ();
-  end_of_row = blob_it.data_relative (-1)->bounding_box ().right ();
-  if (tosp_use_pre_chopping)
-    blob_box = box_next_pre_chopped (&blob_it);
-  else if (tosp_stats_use_xht_gaps)
-    blob_box = reduced_box_next (row, &blob_it);
-  else
-    blob_box = box_next (&blob_it);
-  row_length = end_of_row - blob_box.left ();
-  prev_blob_box = blob_box;
-  while (!blob_it.cycled_list ()) {
-    if (tosp_use_pre_chopping)
-      blob_box = box_next_pre_chopped (&blob_it);
-    else if (tosp_stats_use_xht_gaps)
-      blob_box = reduced_box_next (row, &blob_it);
-    else
-      blob_box = box_next (&blob_it);
-    gap_width = blob_box.left () - prev_blob_box.right ();
-    if (!ignore_big_gap (row, row_length, gapmap,
-      prev_blob_box.right (), blob_box.left ()) &&
+  for (index = 0; index < gaps->widths.size (); index++) {
+    gap_width = gaps->widths[index];
+    if (!(gaps->flags[index] & GAP_IGNORED) &&
     (gap_width > crude_threshold_estimate)) {
-      if ((gap_width > tosp_fuzzy_space_factor2 * row->xheight) ||
-        ((gap_width > tosp_fuzzy_space_factor1 * row->xheight) &&
-        (!tosp_narrow_blobs_not_cert ||
-        (!narrow_blob (row, prev_blob_box) &&
-        !narrow_blob (row, blob_box)))) ||
-        (wide_blob (row, prev_blob_box) && wide_blob (row, blob_box)))
+      if (gaps->flags[index] & GAP_CERT_SPACE)
         cert_space_gap_stats.add (gap_width, 1);
       all_space_gap_stats.add (gap_width, 1);
     }
     if (gap_width < crude_threshold_estimate)
       small_gap_stats.add (gap_width, 1);
-
-    prev_blob_box = blob_box;
   }
   if (cert_space_gap_stats.get_total () >=
     tosp_enough_space_samples_for_median)
@@ -1966,6 +2014,20 @@ TBOX reduced_box_for_blob(BLOBNBOX *blob, TO_ROW *row, inT16 *left_above_xht) {
   Find LH limit of blob ABOVE the xht. This is so that we can detect certain
   caps ht chars which should NOT have their box reduced: T, Y, V, W etc
   */
+  if (blob->blob () == NULL) {
+                                 //all 3 limits in 1 pass
+    find_cblob_xht_limits (blob->cblob (),
+      baseline + 1.1 * row->xheight, baseline, baseline + row->xheight,
+      left_limit, junk, right_limit);
+    if (left_limit == (float) MAX_INT32)
+      *left_above_xht = MAX_INT16; //No area above xht
+    else
+      *left_above_xht = (inT16) floor (left_limit);
+    if (junk == (float) MAX_INT32 || right_limit == (float) -MAX_INT32)
+      return TBOX ();             //no area within xht so return empty box
+    return TBOX (ICOORD ((inT16) floor (junk), blob_box.bottom ()),
+      ICOORD ((inT16) ceil (right_limit), blob_box.top ()));
+  }
   left_limit = (float) MAX_INT32;
   junk = (float) -MAX_INT32;
   if (blob->blob () != NULL)
@@ -2039,3 +2101,46 @@ TBOX reduced_box_for_blob(BLOBNBOX *blob, TO_ROW *row, inT16 *left_above_xht) {
     ICOORD ((inT16) ceil (right_limit), blob_box.top ()));
 }
 
+
+/*************************************************************************
+ * find_cblob_xht_limits()
+ * The three limits of reduced_box_for_blob for a C_BLOB in a single walk
+ * round its outlines: the left of the part above above_xht, the left of the
+ * part above baseline and the right of the part below xht_line.
+ * A limit is left at +/-MAX_INT32 if there is no such part.
+ * Gives the same limits as three calls of find_cblob_hlimits.
+ *************************************************************************/
+
+static void find_cblob_xht_limits(                        //get x limits
+                                  C_BLOB *blob,           //blob to search
+                                  float above_xht,        //y limits
+                                  float baseline,
+                                  float xht_line,
+                                  float &left_above_xht,  //output x limits
+                                  float &left_above_base,
+                                  float &right_below_xht) {
+  inT16 stepindex;               //current point
+  ICOORD pos;                    //current coords
+  C_OUTLINE *outline;            //current outline
+                                 //outlines
+  C_OUTLINE_IT out_it = blob->out_list ();
+
+  left_above_xht = (float) MAX_INT32;
+  left_above_base = (float) MAX_INT32;
+  right_below_xht = (float) -MAX_INT32;
+  for (out_it.mark_cycle_pt (); !out_it.cycled_list (); out_it.forward ()) {
+    outline = out_it.data ();
+    pos = outline->start_pos (); //get coords
+    for (stepindex = 0; stepindex < outline->pathlength (); stepindex++) {
+      if (pos.y () >= baseline) {
+        if (pos.x () < left_above_base)
+          left_above_base = pos.x ();
+        if (pos.y () >= above_xht && pos.x () < left_above_xht)
+          left_above_xht = pos.x ();
+      }
+      if (pos.y () <= xht_line && pos.x () > right_below_xht)
+        right_below_xht = pos.x ();
+      pos += outline->step (stepindex);
+    }
+  }
+}
@@ -7,9 +7,11 @@
 #ifndef           TOSPACE_H
 #define           TOSPACE_H
 
+#include          <time.h>
 #include          "blobbox.h"
 #include          "gap_map.h"
 #include          "statistc.h"
+#include          "genericvector.h"
 #include          "notdll.h"
 
 extern BOOL_VAR_H(tosp_old_to_method, FALSE, "Space stats use prechopping?");
@@ -47,6 +49,8 @@ extern BOOL_VAR_H(tosp_flip_fuzz_kn_to_sp, TRUE, "Default flip");
 extern BOOL_VAR_H(tosp_flip_fuzz_sp_to_kn, TRUE, "Default flip");
 extern BOOL_VAR_H(tosp_improve_thresh, FALSE,
 "Enable improvement heuristic");
+extern BOOL_VAR_H(tosp_show_timing, FALSE,
+"Print the time taken to find the spacing of each row");
 extern INT_VAR_H(tosp_debug_level, 0, "Debug data");
 extern INT_VAR_H(tosp_enough_space_samples_for_median, 3,
 "or should we use mean");
@@ -115,20 +119,50 @@ extern double_VAR_H(tosp_silly_kn_sp_gap, 0.2,
 extern double_VAR_H(tosp_pass_wide_fuzz_sp_to_context, 0.75,
 "How wide fuzzies need context");
 
+// Flags of each gap in ROW_GAPS.
+#define GAP_IGNORED       1      //ignore_big_gap says to ignore it
+#define GAP_IGNORED_BLOCK 2      //ditto with the negated row length
+                                 //used by block_spacing_stats
+#define GAP_CERT_SPACE    4      //obvious space if over the threshold
+
+// The gaps between the blobs of a row, found in a single pass along the
+// row by find_row_gaps. All the block and row space estimates are made
+// from these arrays instead of walking the blobs again.
+struct ROW_GAPS
+{
+  ROW_GAPS() {                   //empty row
+    min_blob_width = MAX_INT16;
+    row_length = 0;
+    gap_time = 0;
+    stats_time = 0;
+  }
+
+  GenericVector<inT16> widths;   //width of each gap
+  GenericVector<inT16> centres;  //centre to centre dist of each gap
+  GenericVector<uinT8> flags;    //GAP_* flags of each gap
+  inT16 min_blob_width;          //narrowest blob
+  inT32 row_length;              //from left of first blob to end
+  clock_t gap_time;              //time taken by find_row_gaps
+  clock_t stats_time;            //time taken by row_spacing_stats
+};
+
 void to_spacing(                       //set spacing
                 ICOORD page_tr,        //topright of page
                 TO_BLOCK_LIST *blocks  //blocks on page
                );
+void find_row_gaps(TO_ROW *row,
+                   GAPMAP *gapmap,
+                   ROW_GAPS *gaps);
                                  //DEBUG USE ONLY
 void block_spacing_stats(TO_BLOCK *block,
-                         GAPMAP *gapmap,
+                         ROW_GAPS *row_gaps,
                          BOOL8 &old_text_ord_proportional,
                          inT16 &block_space_gap_width,     //resulting estimate
                          inT16 &block_non_space_gap_width  //resulting estimate
                         );
                                  //estimate for block
 void row_spacing_stats(TO_ROW *row,
-                       GAPMAP *gapmap,
+                       ROW_GAPS *gaps,
                        inT16 block_idx,
                        inT16 row_idx,
                        inT16 block_space_gap_width,
@@ -143,7 +177,7 @@ void old_to_method(TO_ROW *row,
                    inT16 block_non_space_gap_width  //estimate for block
                   );
 BOOL8 isolated_row_stats(TO_ROW *row,
-                         GAPMAP *gapmap,
+                         ROW_GAPS *gaps,
                          STATS *all_gap_stats,
                          BOOL8 suspected_table,
                          inT16 block_idx,
@@ -49,6 +49,7 @@ EXTERN BOOL_VAR (textord_force_make_prop_words, FALSE,
 EXTERN BOOL_VAR (textord_chopper_test, FALSE,
                  "Chopper is being tested.");
 extern /*"C" */ ETEXT_DESC *global_monitor;     //progress monitor
+extern int global_monitor_words;                 //user words found so far
 
 #define FIXED_WIDTH_MULTIPLE  5
 #define BLOCK_STATS_CLUSTERS  10
@@ -122,6 +123,8 @@ void make_words(                             //make words
   block_it.set_to_list (port_blocks);
   for (block_it.mark_cycle_pt (); !block_it.cycled_list ();
   block_it.forward ()) {
+    if (ocr_deadline_passed(global_monitor, global_monitor_words))
+      break;  // Out of time: leave the remaining blocks without words.
     block = block_it.data ();
     //              set_row_spaces(block,FCOORD(1,0),!(BOOL8)textord_test_landscape);
                                  //make proper classes
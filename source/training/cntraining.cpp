@@ -37,6 +37,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <math.h>
+#include <time.h>
 #include "unichar.h"
 #include "commontraining.h"
 
@@ -59,6 +60,10 @@ void ReadTrainingSamples (
      FILE	*File,
 	 LIST* TrainingSamples);
 
+void ClusterChar(CLUSTER_JOB *Job);
+
+void BenchmarkClusterTrees(LIST CharList);
+
 void WriteNormProtos (
      char	*Directory,
      LIST	LabeledProtoList,
@@ -84,13 +89,99 @@ void WriteProtos(
 //-M 0.025   -B 0.05   -I 0.8   -C 1e-3
 CLUSTERCONFIG	Config =
 {
-  elliptical, 0.025, 0.05, 0.8, 1e-3, 0
+  elliptical, 0.025, 0.05, 0.8, 1e-3, 0, best_first
 };
 
 
 /**----------------------------------------------------------------------------
 							Public Code
 ----------------------------------------------------------------------------**/
+/*---------------------------------------------------------------------------*/
+void ClusterChar(CLUSTER_JOB *Job)
+/*
+**	Parameters:
+**		Job	clustering job for one char
+**	Operation:
+**		This routine clusters the samples of one char, retrying
+**		with smaller MinSamples until at least one significant
+**		proto is found.  The clusterer and its protos are left in
+**		the job.  It only touches the job, so it can run on any
+**		thread.
+**	Return: none
+**	Exceptions: none
+*/
+{
+  Job->Clusterer = SetUpForClustering(Job->CharSample, PROGRAM_FEATURE_TYPE);
+  Job->Config.MagicSamples = Job->CharSample->SampleCount;
+  while (Job->Config.MinSamples > 0.001) {
+    Job->ProtoList = ClusterSamples(Job->Clusterer, &Job->Config);
+    if (NumberOfProtos(Job->ProtoList, 1, 0) > 0)
+      break;
+    else {
+      Job->Config.MinSamples *= 0.95;
+      printf("0 significant protos for %s."
+             " Retrying clustering with MinSamples = %f%%\n",
+             Job->CharSample->Label, Job->Config.MinSamples);
+    }
+  }
+}	// ClusterChar
+
+/*---------------------------------------------------------------------------*/
+void BenchmarkClusterTrees(LIST CharList)
+/*
+**	Parameters:
+**		CharList	samples of each char read from the training pages
+**	Operation:
+**		This routine clusters the samples of every char once with
+**		each cluster tree style, on a single thread and with the
+**		current clustering parameters, and prints the CPU time each
+**		style took and the number of significant protos it found.
+**		Nothing is written.
+**	Return: none
+**	Exceptions: none
+*/
+{
+  static const CLUSTERSTYLE Styles[] = { best_first, nn_chain };
+  static const char *StyleNames[] = { "best_first", "nn_chain" };
+  const int NumStyles = sizeof(Styles) / sizeof(Styles[0]);
+  double Seconds[NumStyles];
+  int NumProtos[NumStyles];
+  int NumSamples = 0;
+  int NumChars = 0;
+  LABELEDLIST CharSample;
+  CLUSTERER *Clusterer;
+  CLUSTERCONFIG StyleConfig;
+  LIST ProtoList;
+  clock_t StartClock;
+  int s;
+
+  for (s = 0; s < NumStyles; s++) {
+    Seconds[s] = 0.0;
+    NumProtos[s] = 0;
+  }
+  iterate(CharList) {
+    CharSample = (LABELEDLIST) first_node(CharList);
+    NumSamples += CharSample->SampleCount;
+    NumChars++;
+    for (s = 0; s < NumStyles; s++) {
+      Clusterer = SetUpForClustering(CharSample, PROGRAM_FEATURE_TYPE);
+      StyleConfig = Config;
+      StyleConfig.ClusterStyle = Styles[s];
+      StyleConfig.MagicSamples = CharSample->SampleCount;
+      StartClock = clock();
+      ProtoList = ClusterSamples(Clusterer, &StyleConfig);
+      Seconds[s] += (double) (clock() - StartClock) / CLOCKS_PER_SEC;
+      NumProtos[s] += NumberOfProtos(ProtoList, 1, 0);
+      FreeClusterer(Clusterer);
+      FreeProtoList(&ProtoList);
+    }
+  }
+  printf("%d chars, %d samples\n", NumChars, NumSamples);
+  for (s = 0; s < NumStyles; s++)
+    printf("%-10s  %8.2fs  %6d significant protos\n",
+           StyleNames[s], Seconds[s], NumProtos[s]);
+}	// BenchmarkClusterTrees
+
 /*---------------------------------------------------------------------------*/
 int main (
      int	argc,
@@ -154,42 +245,39 @@ int main (
 	CLUSTERER	*Clusterer = NULL;
 	LIST		ProtoList = NIL;
 	LIST		NormProtoList = NIL;
-	LIST pCharList;
-	LABELEDLIST CharSample;
+	CLUSTER_JOB *Jobs;
+	int NumJobs;
+	int i;
 
 	ParseArguments (argc, argv);
 	while ((PageName = GetNextFilename(argc, argv)) != NULL)
 	{
 		printf ("Reading %s ...\n", PageName);
-		TrainingPage = Efopen (PageName, "r");
+		TrainingPage = Efopen (PageName, "rb");
 		ReadTrainingSamples (TrainingPage, &CharList);
 		fclose (TrainingPage);
 		//WriteTrainingSamples (Directory, CharList);
 	}
+	if (BenchmarkClusterStyles) {
+	  BenchmarkClusterTrees(CharList);
+	  FreeTrainingSamples(CharList);
+	  return 0;
+	}
         printf("Clustering ...\n");
-	pCharList = CharList;
-	iterate(pCharList)
+	Jobs = NewClusterJobs(CharList, &NumJobs);
+	RunClusterJobs(Jobs, NumJobs, ClusterChar);
+	for (i = 0; i < NumJobs; i++)
 	{
-          //Cluster
-          CharSample = (LABELEDLIST) first_node (pCharList);
-          //printf ("\nClustering %s ...", CharSample->Label);
-          Clusterer = SetUpForClustering(CharSample, PROGRAM_FEATURE_TYPE);
-          float SavedMinSamples = Config.MinSamples;
-          Config.MagicSamples = CharSample->SampleCount;
-          while (Config.MinSamples > 0.001) {
-            ProtoList = ClusterSamples(Clusterer, &Config);
-            if (NumberOfProtos(ProtoList, 1, 0) > 0)
-              break;
-            else {
-              Config.MinSamples *= 0.95;
-              printf("0 significant protos for %s."
-                     " Retrying clustering with MinSamples = %f%%\n",
-                     CharSample->Label, Config.MinSamples);
-            }
-          }
-          Config.MinSamples = SavedMinSamples;
-          AddToNormProtosList(&NormProtoList, ProtoList, CharSample->Label);
+          // Collect the results in the order of CharList.  Only the
+          // last clusterer is kept, for its parameter descriptions.
+          if (Clusterer != NULL)
+            FreeClusterer(Clusterer);
+          Clusterer = Jobs[i].Clusterer;
+          ProtoList = Jobs[i].ProtoList;
+          AddToNormProtosList(&NormProtoList, ProtoList,
+                              Jobs[i].CharSample->Label);
 	}
+	free(Jobs);
 	FreeTrainingSamples (CharList);
         if (Clusterer == NULL) // To avoid a SIGSEGV
           return 1;
@@ -212,7 +300,7 @@ void ReadTrainingSamples (
 
 /*
 **	Parameters:
-**		File		open text file to read samples from
+**		File		open text or binary file to read samples from
 **	Globals: none
 **	Operation:
 **		This routine reads training samples from a file and
@@ -229,30 +317,23 @@ void ReadTrainingSamples (
 {
 	char		unichar[UNICHAR_LEN + 1];
 	LABELEDLIST	CharSample;
-	FEATURE_SET	FeatureSamples;
-	CHAR_DESC	CharDesc;
-	int		Type, i;
+	FLOAT32		*Params;
+	BOOL8		Binary;
+	int		NumParams;
 
-	while (fscanf (File, "%s %s", CTFontName, unichar) == 2) {
+	Binary = ReadTrainingFileHeader (File);
+	while (ReadSampleLabel (File, Binary, unichar)) {
           CharSample = FindList (*TrainingSamples, unichar);
           if (CharSample == NULL) {
             CharSample = NewLabeledList (unichar);
             *TrainingSamples = push (*TrainingSamples, CharSample);
           }
-          CharDesc = ReadCharDescription (File);
-          Type = ShortNameToFeatureType(PROGRAM_FEATURE_TYPE);
-          FeatureSamples = CharDesc->FeatureSets[Type];
-          for (int feature = 0; feature < FeatureSamples->NumFeatures; ++feature) {
-            FEATURE f = FeatureSamples->Features[feature];
-            for (int dim =0; dim < f->Type->NumParams; ++dim)
-              f->Params[dim] += UniformRandomNumber(-MINSD, MINSD);
-          }
-          CharSample->List = push (CharSample->List, FeatureSamples);
-          CharSample->SampleCount++;
-          for (i = 0; i < CharDesc->NumFeatureSets; i++)
-            if (Type != i)
-              FreeFeatureSet(CharDesc->FeatureSets[i]);
-          free (CharDesc);
+          Params = ReadSampleFeatures (File, Binary, CharSample,
+                                       PROGRAM_FEATURE_TYPE);
+          NumParams = CharSample->SampleFeatures[CharSample->SampleCount - 1] *
+              CharSample->NumParams;
+          for (int param = 0; param < NumParams; ++param)
+            Params[param] += UniformRandomNumber(-MINSD, MINSD);
         }
 }	// ReadTrainingSamples
 
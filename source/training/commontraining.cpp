@@ -26,8 +26,12 @@
 #include "tprintf.h"
 #include "freelist.h"
 #include "unicity_table.h"
+#include "unichar.h"
+#include "ccutil.h"
+#include "ndminx.h"
 
 #include <math.h>
+#include <time.h>
 
 #define round(x,frag)(floor(x/frag+.5)*frag)
 
@@ -52,6 +56,12 @@ const char* test_ch = "";
 // The unicharset used during training
 UNICHARSET unicharset_training;
 
+// Number of threads used to cluster the chars.
+int NumClusterThreads = 1;
+
+// If true, cntraining times the cluster tree styles instead of training.
+BOOL8 BenchmarkClusterStyles = FALSE;
+
 /*---------------------------------------------------------------------------*/
 void ParseArguments(int argc, char **argv)
 /*
@@ -71,6 +81,7 @@ void ParseArguments(int argc, char **argv)
  **			-p		"turn off significant protos"
  **			-n		"turn off insignificant proto"
  **			-S [ spherical | elliptical | mixed | automatic ]
+ **			-T [ best_first | nn_chain ]	"cluster tree style"
  **			-M MinSamples	"min samples per prototype (%)"
  **			-B MaxIllegal	"max illegal chars per cluster (%)"
  **			-I Independence	"0 to 1"
@@ -79,6 +90,8 @@ void ParseArguments(int argc, char **argv)
  **			-R RoundingAccuracy
  **			-U InputUnicharsetFile
  **			-O OutputUnicharsetFile
+ **			-j NumClusterThreads
+ **			-b		"compare cluster tree styles (cntraining)"
 
  **	Return: none
  **	Exceptions: Illegal options terminate the program.
@@ -91,7 +104,7 @@ void ParseArguments(int argc, char **argv)
   BOOL8		Error;
 
   Error = FALSE;
-  while (( Option = tessopt( argc, argv, "F:O:U:R:D:C:I:M:B:S:n:p" )) != EOF )
+  while (( Option = tessopt( argc, argv, "F:O:U:R:D:C:I:M:B:S:T:j:n:pb" )) != EOF )
   {
     switch ( Option )
     {
@@ -143,6 +156,14 @@ void ParseArguments(int argc, char **argv)
           default: Error = TRUE;
         }
         break;
+      case 'T':
+        switch ( tessoptarg[0] )
+        {
+          case 'b': Config.ClusterStyle = best_first; break;
+          case 'n': Config.ClusterStyle = nn_chain; break;
+          default: Error = TRUE;
+        }
+        break;
       case 'D':
         Directory = tessoptarg;
         break;
@@ -155,6 +176,14 @@ void ParseArguments(int argc, char **argv)
       case 'F':
         InputFontInfoFile = tessoptarg;
         break;
+      case 'j':
+        ParametersRead = sscanf( tessoptarg, "%d", &NumClusterThreads );
+        if ( ParametersRead != 1 ) Error = TRUE;
+        else if ( NumClusterThreads < 1 ) NumClusterThreads = 1;
+        break;
+      case 'b':
+        BenchmarkClusterStyles = TRUE;
+        break;
       case '?':
         Error = TRUE;
         break;
@@ -162,11 +191,11 @@ void ParseArguments(int argc, char **argv)
     if ( Error )
     {
       fprintf (stderr, "usage: %s [-d] [-p] [-n]\n", argv[0] );
-      fprintf (stderr, "\t[-S ProtoStyle]\n");
+      fprintf (stderr, "\t[-S ProtoStyle] [-T ClusterStyle]\n");
       fprintf (stderr, "\t[-M MinSamples] [-B MaxBad] [-I Independence]\n");
       fprintf (stderr, "\t[-C Confidence] [-D Directory]\n");
       fprintf (stderr, "\t[-U InputUnicharsetFile] [-O OutputUnicharsetFile]\n");
-      fprintf (stderr, "\t[-F FontInfoFile]\n");
+      fprintf (stderr, "\t[-F FontInfoFile] [-j NumThreads] [-b]\n");
       fprintf (stderr, "\t[ TrainingPage ... ]\n");
       exit (2);
     }
@@ -255,6 +284,12 @@ LABELEDLIST NewLabeledList (
   strcpy (LabeledList->Label, Label);
   LabeledList->List = NIL;
   LabeledList->SampleCount = 0;
+  LabeledList->NumParams = 0;
+  LabeledList->NumFeatures = 0;
+  LabeledList->MaxFeatures = 0;
+  LabeledList->MaxSamples = 0;
+  LabeledList->Params = NULL;
+  LabeledList->SampleFeatures = NULL;
   return (LabeledList);
 
 }	/* NewLabeledList */
@@ -280,11 +315,10 @@ void WriteTrainingSamples (
 
 {
   LABELEDLIST	CharSample;
-  FEATURE_SET	FeatureSet;
-  LIST		FeatureList;
+  FLOAT32	*Params;
   FILE		*File;
   char		Filename[MAXNAMESIZE];
-  int		NumSamples;
+  int		Sample, i, j;
 
   iterate (CharList)		// iterate thru all of the fonts
   {
@@ -321,14 +355,17 @@ void WriteTrainingSamples (
       File = Efopen (Filename, "a");
     }
 
-    // append samples onto the file
-    FeatureList = CharSample->List;
-    NumSamples = 0;
-    iterate (FeatureList)
+    // append samples onto the file, in the format of WriteFeatureSet
+    Params = CharSample->Params;
+    for (Sample = 0; Sample < CharSample->SampleCount; Sample++)
     {
-      FeatureSet = (FEATURE_SET) first_node (FeatureList);
-      WriteFeatureSet (File, FeatureSet);
-      NumSamples++;
+      fprintf (File, "%d\n", CharSample->SampleFeatures[Sample]);
+      for (i = 0; i < CharSample->SampleFeatures[Sample]; i++)
+      {
+        for (j = 0; j < CharSample->NumParams; j++)
+          fprintf (File, " %12g", *Params++);
+        fprintf (File, "\n");
+      }
     }
     fclose (File);
   }
@@ -352,20 +389,12 @@ void FreeTrainingSamples (
 
 {
   LABELEDLIST	CharSample;
-  FEATURE_SET	FeatureSet;
-  LIST		FeatureList;
 
 
   // 	printf ("FreeTrainingSamples...\n");
   iterate (CharList) 		/* iterate thru all of the fonts */
   {
     CharSample = (LABELEDLIST) first_node (CharList);
-    FeatureList = CharSample->List;
-    iterate (FeatureList)	/* iterate thru all of the classes */
-    {
-      FeatureSet = (FEATURE_SET) first_node (FeatureList);
-      FreeFeatureSet (FeatureSet);
-    }
     FreeLabeledList (CharSample);
   }
   destroy (CharList);
@@ -382,8 +411,9 @@ void FreeLabeledList (
  **	Globals: none
  **	Operation:
  **		This routine deallocates all of the memory consumed by
- **		a labeled list.  It does not free any memory which may be
- **		consumed by the items in the list.
+ **		a labeled list, including its packed sample features.  It
+ **		does not free any memory which may be consumed by the
+ **		items in the list.
  **	Return: none
  **	Exceptions: none
  **	History: Fri Aug 18 17:52:45 1989, DSJ, Created.
@@ -391,11 +421,283 @@ void FreeLabeledList (
 
 {
   destroy (LabeledList->List);
+  if (LabeledList->Params != NULL)
+    free (LabeledList->Params);
+  if (LabeledList->SampleFeatures != NULL)
+    free (LabeledList->SampleFeatures);
   free (LabeledList->Label);
   free (LabeledList);
 
 }	/* FreeLabeledList */
 
+/*---------------------------------------------------------------------------*/
+BOOL8 ReadTrainingFileHeader (
+    FILE	*File)
+
+/*
+ **	Parameters:
+ **		File		training file which has just been opened
+ **	Globals: none
+ **	Operation:
+ **		This routine checks whether File is a binary training
+ **		file, and if so skips its header.  Text files are rewound
+ **		to their start.
+ **	Return: TRUE if File is a binary training file.
+ **	Exceptions: A binary file with the wrong byte order is fatal.
+ */
+
+{
+  char		Magic[BINARY_TR_MAGIC_LEN];
+  inT32		ByteOrder;
+
+  if (fread (Magic, 1, BINARY_TR_MAGIC_LEN, File) == BINARY_TR_MAGIC_LEN &&
+      memcmp (Magic, BINARY_TR_MAGIC, BINARY_TR_MAGIC_LEN) == 0)
+  {
+    if (fread (&ByteOrder, sizeof (ByteOrder), 1, File) != 1 ||
+        ByteOrder != 1)
+    {
+      cprintf ("Error: Binary training file has the wrong byte order\n");
+      exit (1);
+    }
+    return (TRUE);
+  }
+  rewind (File);
+  return (FALSE);
+
+}	/* ReadTrainingFileHeader */
+
+/*---------------------------------------------------------------------------*/
+// Reads a string of at most MaxLength chars preceded by its length.
+static BOOL8 ReadBinaryString (FILE *File, char *String, int MaxLength) {
+  uinT8 Length;
+
+  if (fread (&Length, sizeof (Length), 1, File) != 1 ||
+      Length > MaxLength ||
+      fread (String, 1, Length, File) != Length)
+    return (FALSE);
+  String[Length] = '\0';
+  return (TRUE);
+}
+
+// Writes a string preceded by its length.
+static void WriteBinaryString (FILE *File, const char *String) {
+  uinT8 Length = strlen (String);
+
+  fwrite (&Length, sizeof (Length), 1, File);
+  fwrite (String, 1, Length, File);
+}
+
+/*---------------------------------------------------------------------------*/
+BOOL8 ReadSampleLabel (
+    FILE	*File,
+    BOOL8	Binary,
+    char	*Unichar)
+
+/*
+ **	Parameters:
+ **		File		training file to read the next sample from
+ **		Binary		TRUE if File is a binary training file
+ **		Unichar		place to put the unichar of the sample,
+ **				room for UNICHAR_LEN + 1 chars
+ **	Globals:
+ **		CTFontName	set to the font name of the sample
+ **	Operation:
+ **		This routine reads the font name and unichar which start
+ **		the next sample in File.  ReadSampleFeatures must then be
+ **		called to read the rest of the sample.
+ **	Return: FALSE at the end of File.
+ **	Exceptions: none
+ */
+
+{
+  if (!Binary)
+    return (fscanf (File, "%s %s", CTFontName, Unichar) == 2);
+  return (ReadBinaryString (File, CTFontName, MAXNAMESIZE - 1) &&
+          ReadBinaryString (File, Unichar, UNICHAR_LEN));
+
+}	/* ReadSampleLabel */
+
+/*---------------------------------------------------------------------------*/
+// Makes room in CharSample for one more sample of NumFeatures features
+// and returns a pointer to the params of its features.
+static FLOAT32 *AddSample (LABELEDLIST CharSample, int NumFeatures) {
+  FLOAT32 *Params;
+
+  if (CharSample->SampleCount == CharSample->MaxSamples) {
+    CharSample->MaxSamples = MAX (2 * CharSample->MaxSamples, 16);
+    CharSample->SampleFeatures = (int *) Erealloc (
+        CharSample->SampleFeatures, CharSample->MaxSamples * sizeof (int));
+  }
+  if (CharSample->NumFeatures + NumFeatures > CharSample->MaxFeatures) {
+    CharSample->MaxFeatures = MAX (2 * CharSample->MaxFeatures,
+                                   CharSample->NumFeatures + NumFeatures);
+    CharSample->Params = (FLOAT32 *) Erealloc (
+        CharSample->Params,
+        CharSample->MaxFeatures * CharSample->NumParams * sizeof (FLOAT32));
+  }
+  Params = CharSample->Params + CharSample->NumFeatures * CharSample->NumParams;
+  CharSample->SampleFeatures[CharSample->SampleCount++] = NumFeatures;
+  CharSample->NumFeatures += NumFeatures;
+  return (Params);
+}
+
+/*---------------------------------------------------------------------------*/
+FLOAT32 *ReadSampleFeatures (
+    FILE	*File,
+    BOOL8	Binary,
+    LABELEDLIST	CharSample,
+    const char	*program_feature_type)
+
+/*
+ **	Parameters:
+ **		File		training file to read the sample from
+ **		Binary		TRUE if File is a binary training file
+ **		CharSample	samples of the char read by ReadSampleLabel
+ **		program_feature_type	short name of the features to keep
+ **	Globals: none
+ **	Operation:
+ **		This routine reads the feature sets of the sample whose
+ **		label was just read, and appends the features of type
+ **		program_feature_type to the packed features of
+ **		CharSample.  The other feature sets are skipped.  In a
+ **		binary file the features are read straight into place.
+ **	Return: Params of the features of the new sample, which are
+ **		CharSample->SampleFeatures[CharSample->SampleCount - 1]
+ **		features of CharSample->NumParams params each.
+ **	Exceptions: An incomplete binary sample is fatal.
+ */
+
+{
+  FEATURE_SET	FeatureSet;
+  CHAR_DESC	CharDesc;
+  FLOAT32	*Params;
+  char		ShortName[FEAT_NAME_SIZE];
+  uinT8		NumSets;
+  inT32		NumFeatures;
+  inT32		NumParams;
+  int		Type, i;
+
+  Type = ShortNameToFeatureType (program_feature_type);
+  CharSample->NumParams = FeatureDefs.FeatureDesc[Type]->NumParams;
+  Params = NULL;
+  if (!Binary)
+  {
+    CharDesc = ReadCharDescription (File);
+    FeatureSet = CharDesc->FeatureSets[Type];
+    Params = AddSample (CharSample, FeatureSet->NumFeatures);
+    for (i = 0; i < FeatureSet->NumFeatures; i++)
+      memcpy (Params + i * CharSample->NumParams,
+              FeatureSet->Features[i]->Params,
+              CharSample->NumParams * sizeof (FLOAT32));
+    FreeCharDescription (CharDesc);
+    return (Params);
+  }
+
+  if (fread (&NumSets, sizeof (NumSets), 1, File) != 1)
+    NumSets = 0;
+  for (; NumSets > 0; NumSets--)
+  {
+    if (!ReadBinaryString (File, ShortName, FEAT_NAME_SIZE - 1) ||
+        fread (&NumFeatures, sizeof (NumFeatures), 1, File) != 1 ||
+        fread (&NumParams, sizeof (NumParams), 1, File) != 1 ||
+        NumFeatures < 0 || NumFeatures > BINARY_TR_MAX_FEATURES ||
+        NumParams <= 0 || NumParams > BINARY_TR_MAX_PARAMS)
+      break;
+    if (strcmp (ShortName, program_feature_type) != 0)
+    {
+      fseek (File, NumFeatures * NumParams * sizeof (FLOAT32), SEEK_CUR);
+      continue;
+    }
+    if (NumParams != CharSample->NumParams)
+      break;
+    Params = AddSample (CharSample, NumFeatures);
+    if (fread (Params, sizeof (FLOAT32), NumFeatures * NumParams, File) !=
+        (size_t) (NumFeatures * NumParams))
+      break;
+  }
+  if (NumSets > 0 || Params == NULL)
+  {
+    cprintf ("Error: Bad sample of %s in binary training file\n",
+             CharSample->Label);
+    exit (1);
+  }
+  return (Params);
+
+}	/* ReadSampleFeatures */
+
+/*---------------------------------------------------------------------------*/
+void WriteTrainingFileHeader (
+    FILE	*File)
+
+/*
+ **	Parameters:
+ **		File		binary training file to be written
+ **	Globals: none
+ **	Operation:
+ **		This routine writes the header of a binary training file.
+ **	Return: none
+ **	Exceptions: none
+ */
+
+{
+  inT32		ByteOrder = 1;
+
+  fwrite (BINARY_TR_MAGIC, 1, BINARY_TR_MAGIC_LEN, File);
+  fwrite (&ByteOrder, sizeof (ByteOrder), 1, File);
+
+}	/* WriteTrainingFileHeader */
+
+/*---------------------------------------------------------------------------*/
+void WriteBinarySample (
+    FILE	*File,
+    const char	*FontName,
+    const char	*Unichar,
+    CHAR_DESC	CharDesc)
+
+/*
+ **	Parameters:
+ **		File		binary training file to be written
+ **		FontName	font of the sample
+ **		Unichar		unichar of the sample
+ **		CharDesc	feature sets of the sample
+ **	Globals: none
+ **	Operation:
+ **		This routine appends one sample to a binary training file.
+ **	Return: none
+ **	Exceptions: none
+ */
+
+{
+  FEATURE_SET	FeatureSet;
+  uinT8		NumSets;
+  inT32		NumFeatures;
+  inT32		NumParams;
+  int		Type, i;
+
+  WriteBinaryString (File, FontName);
+  WriteBinaryString (File, Unichar);
+  NumSets = 0;
+  for (Type = 0; Type < (int) CharDesc->NumFeatureSets; Type++)
+    if (CharDesc->FeatureSets[Type] != NULL)
+      NumSets++;
+  fwrite (&NumSets, sizeof (NumSets), 1, File);
+  for (Type = 0; Type < (int) CharDesc->NumFeatureSets; Type++)
+  {
+    FeatureSet = CharDesc->FeatureSets[Type];
+    if (FeatureSet == NULL)
+      continue;
+    NumFeatures = FeatureSet->NumFeatures;
+    NumParams = FeatureDefs.FeatureDesc[Type]->NumParams;
+    WriteBinaryString (File, FeatureDefs.FeatureDesc[Type]->ShortName);
+    fwrite (&NumFeatures, sizeof (NumFeatures), 1, File);
+    fwrite (&NumParams, sizeof (NumParams), 1, File);
+    for (i = 0; i < NumFeatures; i++)
+      fwrite (FeatureSet->Features[i]->Params, sizeof (FLOAT32), NumParams,
+              File);
+  }
+
+}	/* WriteBinarySample */
+
 /*---------------------------------------------------------------------------*/
 CLUSTERER *SetUpForClustering(
     LABELEDLIST	CharSample,
@@ -410,7 +712,9 @@ CLUSTERER *SetUpForClustering(
  **	Operation:
  **		This routine reads samples from a LABELEDLIST and enters
  **		those samples into a clusterer data structure.  This
- **		data structure is then returned to the caller.
+ **		data structure is then returned to the caller.  The
+ **		samples are entered last read first, as they were when
+ **		they were kept on a LIST.
  **	Return:
  **		Pointer to new clusterer data structure.
  **	Exceptions:
@@ -425,8 +729,8 @@ CLUSTERER *SetUpForClustering(
   FLOAT32	*Sample = NULL;
   CLUSTERER	*Clusterer;
   inT32		CharID;
-  LIST FeatureList = NULL;
-  FEATURE_SET FeatureSet = NULL;
+  int		SampleIndex;
+  FLOAT32	*Params;
   FEATURE_DESC FeatureDesc = NULL;
   //	PARAM_DESC* ParamDesc;
 
@@ -437,20 +741,21 @@ CLUSTERER *SetUpForClustering(
   Clusterer = MakeClusterer(N,FeatureDesc->ParamDesc);
   //	free(ParamDesc);
 
-  FeatureList = CharSample->List;
+  Params = CharSample->Params + CharSample->NumFeatures * N;
   CharID = 0;
-  iterate(FeatureList)
+  for (SampleIndex = CharSample->SampleCount - 1; SampleIndex >= 0;
+       SampleIndex--)
   {
-    FeatureSet = (FEATURE_SET) first_node (FeatureList);
-    for (i=0; i < FeatureSet->MaxNumFeatures; i++)
+    Params -= CharSample->SampleFeatures[SampleIndex] * N;
+    for (i=0; i < CharSample->SampleFeatures[SampleIndex]; i++)
     {
       if (Sample == NULL)
         Sample = (FLOAT32 *)Emalloc(N * sizeof(FLOAT32));
       for (j=0; j < N; j++)
         if (RoundingAccuracy != 0.0f)
-          Sample[j] = round(FeatureSet->Features[i]->Params[j], RoundingAccuracy);
+          Sample[j] = round(Params[i * N + j], RoundingAccuracy);
         else
-          Sample[j] = FeatureSet->Features[i]->Params[j];
+          Sample[j] = Params[i * N + j];
       MakeSample (Clusterer, Sample, CharID);
     }
     CharID++;
@@ -813,3 +1118,108 @@ int NumberOfProtos(
   }
   return(N);
 }
+
+/*---------------------------------------------------------------------------*/
+CLUSTER_JOB *NewClusterJobs(
+    LIST CharList,
+    int *NumJobs)
+/*
+ **	Parameters:
+ **		CharList	list of LABELEDLISTs, one for each char
+ **		NumJobs		place to return the number of jobs
+ **	Globals:
+ **		Config		current clustering parameters
+ **	Operation:
+ **		This routine makes one clustering job for each char in
+ **		CharList, in the same order as CharList.  Each job gets
+ **		its own copy of Config.  The jobs are freed with free().
+ **	Return: array of new jobs
+ **	Exceptions: none
+ */
+{
+  CLUSTER_JOB *Jobs;
+  int i;
+
+  *NumJobs = count(CharList);
+  Jobs = (CLUSTER_JOB *) Emalloc((*NumJobs + 1) * sizeof(CLUSTER_JOB));
+  i = 0;
+  iterate(CharList)
+  {
+    Jobs[i].CharSample = (LABELEDLIST) first_node (CharList);
+    Jobs[i].Config = Config;
+    Jobs[i].Clusterer = NULL;
+    Jobs[i].ProtoList = NIL;
+    Jobs[i].DebugProtoList = NIL;
+    i++;
+  }
+  return Jobs;
+}	/* NewClusterJobs */
+
+// Shared state of the threads running a set of clustering jobs.
+typedef struct
+{
+  CLUSTER_JOB *Jobs;
+  int NumJobs;
+  CLUSTER_JOB_FUNC Func;
+  int NumDone;                // number of jobs finished so far
+  int NextReport;             // NumDone at which progress is reported next
+  tesseract::CCUtilMutex Mutex;  // guards NumDone and NextReport
+} CLUSTER_POOL;
+
+// Runs job Job of the pool, on any thread, and reports progress.
+static void RunClusterPoolJob(void *Data, int Job, int Thread) {
+  CLUSTER_POOL *Pool = (CLUSTER_POOL *) Data;
+
+  (*Pool->Func)(&Pool->Jobs[Job]);
+  Pool->Mutex.Lock();
+  if (++Pool->NumDone >= Pool->NextReport) {
+    printf ("Clustered %d of %d chars\n", Pool->NumDone, Pool->NumJobs);
+    fflush(stdout);
+    Pool->NextReport = Pool->NumDone + (Pool->NumJobs + 9) / 10;
+  }
+  Pool->Mutex.Unlock();
+}
+
+/*---------------------------------------------------------------------------*/
+void RunClusterJobs(
+    CLUSTER_JOB *Jobs,
+    int NumJobs,
+    CLUSTER_JOB_FUNC Func)
+/*
+ **	Parameters:
+ **		Jobs		clustering jobs to be run
+ **		NumJobs		number of jobs
+ **		Func		routine which runs a single job
+ **	Globals:
+ **		NumClusterThreads	number of threads to run the jobs on
+ **	Operation:
+ **		This routine runs Func on each of Jobs, using up to
+ **		NumClusterThreads threads, and returns when all of them
+ **		are done.  The results are left in the jobs themselves, so
+ **		they can be used in the same order regardless of the
+ **		number of threads.  Progress is reported as the jobs
+ **		finish, followed by the time taken.  Func must not touch
+ **		any global state which is not protected by a lock.
+ **	Return: none
+ **	Exceptions: none
+ */
+{
+  CLUSTER_POOL Pool;
+  time_t StartTime;
+  clock_t StartClock;
+  int NumThreads;
+
+  StartTime = time(NULL);
+  StartClock = clock();
+  Pool.Jobs = Jobs;
+  Pool.NumJobs = NumJobs;
+  Pool.Func = Func;
+  Pool.NumDone = 0;
+  Pool.NextReport = (NumJobs + 9) / 10;
+  NumThreads = tesseract::RunJobsOnThreads(RunClusterPoolJob, &Pool, NumJobs,
+                                           NumClusterThreads);
+  printf ("Clustered %d chars on %d thread%s in %.0f sec (%.1f sec cpu)\n",
+          NumJobs, NumThreads, NumThreads > 1 ? "s" : "",
+          difftime(time(NULL), StartTime),
+          (double) (clock() - StartClock) / CLOCKS_PER_SEC);
+}	/* RunClusterJobs */
@@ -17,6 +17,9 @@
 #include "oldlist.h"
 #include "cluster.h"
 #include "intproto.h"
+#include "featdefs.h"
+
+#include <stdio.h>
 
 
 //////////////////////////////////////////////////////////////////////////////
@@ -25,6 +28,21 @@
 #define MAXNAMESIZE     80
 #define MINSD_ANGLE     (1.0f / 64.0f)
 
+// Binary training files (converted from the text .tr files by trconvert)
+// start with this magic string, followed by the inT32 1 to check the
+// byte order.  Each sample is then stored as:
+//   uinT8 length, font name, uinT8 length, unichar, uinT8 NumSets,
+// and for each feature set:
+//   uinT8 length, short name, inT32 NumFeatures, inT32 NumParams,
+//   NumFeatures * NumParams FLOAT32 params.
+// None of the strings are terminated.
+#define BINARY_TR_MAGIC "tr\001b"
+#define BINARY_TR_MAGIC_LEN 4
+// Upper bounds on NumFeatures and NumParams of a binary feature set, far
+// above those of any real feature type, to reject corrupt files early.
+#define BINARY_TR_MAX_FEATURES 100000
+#define BINARY_TR_MAX_PARAMS 100
+
 
 //////////////////////////////////////////////////////////////////////////////
 // Globals ///////////////////////////////////////////////////////////////////
@@ -51,6 +69,12 @@ extern const char *InputFontInfoFile;
 // The unicharset used during training
 extern UNICHARSET unicharset_training;
 
+// Number of threads used to cluster the chars.
+extern int NumClusterThreads;
+
+// If true, cntraining times the cluster tree styles instead of training.
+extern BOOL8 BenchmarkClusterStyles;
+
 //////////////////////////////////////////////////////////////////////////////
 // Structs ///////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////
@@ -59,6 +83,14 @@ typedef struct
   char  *Label;
   int   SampleCount;
   LIST  List;
+  // The features of the training samples of a char are packed together
+  // rather than kept as a LIST of FEATURE_SETs.
+  int   NumParams;            // params per feature
+  int   NumFeatures;          // features of all the samples
+  int   MaxFeatures;          // room for features in Params
+  int   MaxSamples;           // room for samples in SampleFeatures
+  FLOAT32 *Params;            // params of each feature, in reading order
+  int   *SampleFeatures;      // number of features of each sample
 }
 LABELEDLISTNODE, *LABELEDLIST;
 
@@ -70,6 +102,18 @@ typedef struct
 }MERGE_CLASS_NODE;
 typedef MERGE_CLASS_NODE* MERGE_CLASS;
 
+// The clustering of one char, which can run on any thread.
+typedef struct
+{
+  LABELEDLIST CharSample;     // samples of the char to be clustered
+  CLUSTERCONFIG Config;       // private copy of the clustering parameters
+  CLUSTERER *Clusterer;       // clusterer holding the samples
+  LIST ProtoList;             // prototypes found for the char
+  LIST DebugProtoList;        // all prototypes of test_ch, before pruning
+} CLUSTER_JOB;
+
+typedef void (*CLUSTER_JOB_FUNC)(CLUSTER_JOB *Job);
+
 
 //////////////////////////////////////////////////////////////////////////////
 // Functions /////////////////////////////////////////////////////////////////
@@ -95,6 +139,29 @@ void WriteTrainingSamples(
 void FreeTrainingSamples(
     LIST        CharList);
 
+BOOL8 ReadTrainingFileHeader(
+    FILE        *File);
+
+BOOL8 ReadSampleLabel(
+    FILE        *File,
+    BOOL8       Binary,
+    char        *Unichar);
+
+FLOAT32 *ReadSampleFeatures(
+    FILE        *File,
+    BOOL8       Binary,
+    LABELEDLIST CharSample,
+    const char  *program_feature_type);
+
+void WriteTrainingFileHeader(
+    FILE        *File);
+
+void WriteBinarySample(
+    FILE        *File,
+    const char  *FontName,
+    const char  *Unichar,
+    CHAR_DESC   CharDesc);
+
 void FreeLabeledList(
     LABELEDLIST LabeledList);
 
@@ -151,4 +218,13 @@ int NumberOfProtos(
 
 
 void allocNormProtos();
+
+CLUSTER_JOB *NewClusterJobs(
+    LIST        CharList,
+    int         *NumJobs);
+
+void RunClusterJobs(
+    CLUSTER_JOB *Jobs,
+    int         NumJobs,
+    CLUSTER_JOB_FUNC Func);
 #endif  // TESSERACT_TRAINING_COMMONTRAINING_H__
@@ -80,6 +80,8 @@ int main (
 LIST ReadTrainingSamples (
      FILE	*File);
 
+void ClusterChar(CLUSTER_JOB *Job);
+
 void WriteClusteredTrainingSamples (
      char	*Directory,
      LIST	ProtoList,
@@ -113,7 +115,7 @@ void WritePFFMTable(INT_TEMPLATES Templates, const char* filename);
 // global variable to hold configuration parameters to control clustering
 // -M 0.40   -B 0.05   -I 1.0   -C 1e-6.
 CLUSTERCONFIG Config =
-{ elliptical, 0.625, 0.05, 1.0, 1e-6, 0 };
+{ elliptical, 0.625, 0.05, 1.0, 1e-6, 0, best_first };
 
 
 /*----------------------------------------------------------------------------
@@ -157,6 +159,45 @@ char* new_dup(const char* str) {
   return new_str;
 }
 
+/*---------------------------------------------------------------------------*/
+void ClusterChar(CLUSTER_JOB *Job) {
+/*
+**	Parameters:
+**		Job	clustering job for one char of a training page
+**	Globals:
+**		test_ch			char whose protos are to be displayed
+**	Operation:
+**		This routine clusters the samples of one char into protos,
+**		merges the insignificant protos and leaves the ones to be
+**		kept in Job->ProtoList.  It only touches the job, so it can
+**		run on any thread.  For test_ch, the clusterer is kept in
+**		Job->Clusterer along with its unpruned protos, to be
+**		displayed and freed by the caller.
+**	Return: none
+**	Exceptions: none
+*/
+  CLUSTERER *Clusterer;
+  LIST ProtoList;
+
+  Clusterer = SetUpForClustering(Job->CharSample, PROGRAM_FEATURE_TYPE);
+  Job->Config.MagicSamples = Job->CharSample->SampleCount;
+  ProtoList = ClusterSamples(Clusterer, &Job->Config);
+  CleanUpUnusedData(ProtoList);
+
+  //Merge
+  MergeInsignificantProtos(ProtoList, Job->CharSample->Label,
+                           Clusterer, &Job->Config);
+  Job->ProtoList = RemoveInsignificantProtos(ProtoList, ShowSignificantProtos,
+                                             ShowInsignificantProtos,
+                                             Clusterer->SampleSize);
+  if (strcmp(test_ch, Job->CharSample->Label) == 0) {
+    Job->Clusterer = Clusterer;
+    Job->DebugProtoList = ProtoList;
+  } else {
+    FreeClusterer(Clusterer);
+  }
+}	/* ClusterChar */
+
 /*---------------------------------------------------------------------------*/
 int main (int argc, char **argv) {
 /*
@@ -195,7 +236,6 @@ int main (int argc, char **argv) {
   FILE	*TrainingPage;
   FILE	*OutFile;
   LIST	CharList;
-  CLUSTERER	*Clusterer = NULL;
   LIST		ProtoList = NIL;
   LABELEDLIST CharSample;
   PROTOTYPE	*Prototype;
@@ -206,11 +246,17 @@ int main (int argc, char **argv) {
   BIT_VECTOR	Config2;
   MERGE_CLASS	MergeClass;
   INT_TEMPLATES	IntTemplates;
-  LIST pCharList, pProtoList;
+  LIST pProtoList;
+  CLUSTER_JOB *Jobs;
+  int NumJobs;
   char Filename[MAXNAMESIZE];
   tesseract::Classify classify;
 
   ParseArguments (argc, argv);
+  if (BenchmarkClusterStyles) {
+    fprintf(stderr, "%s: -b is only supported by cntraining\n", argv[0]);
+    exit(2);
+  }
   if (InputUnicharsetFile == NULL) {
     InputUnicharsetFile = kInputUnicharsetFile;
   }
@@ -292,29 +338,20 @@ int main (int argc, char **argv) {
       fontinfo = classify.get_fontinfo_table().get(fontinfo_id);
       delete[] short_name;
     }
-    TrainingPage = Efopen (PageName, "r");
+    TrainingPage = Efopen (PageName, "rb");
     CharList = ReadTrainingSamples (TrainingPage);
     fclose (TrainingPage);
     //WriteTrainingSamples (Directory, CharList);
-    pCharList = CharList;
-    iterate(pCharList) {
-      //Cluster
-      CharSample = (LABELEDLIST) first_node (pCharList);
-//    printf ("\nClustering %s ...", CharSample->Label);
-      Clusterer = SetUpForClustering(CharSample, PROGRAM_FEATURE_TYPE);
-      Config.MagicSamples = CharSample->SampleCount;
-      ProtoList = ClusterSamples(Clusterer, &Config);
-      CleanUpUnusedData(ProtoList);
-
-      //Merge
-      MergeInsignificantProtos(ProtoList, CharSample->Label,
-                               Clusterer, &Config);
-      if (strcmp(test_ch, CharSample->Label) == 0)
-        DisplayProtoList(test_ch, ProtoList);
-      ProtoList = RemoveInsignificantProtos(ProtoList, ShowSignificantProtos,
-                                            ShowInsignificantProtos,
-                                            Clusterer->SampleSize);
-      FreeClusterer(Clusterer);
+    Jobs = NewClusterJobs(CharList, &NumJobs);
+    RunClusterJobs(Jobs, NumJobs, ClusterChar);
+    for (int j = 0; j < NumJobs; j++) {
+      // Merge the results in the order of CharList.
+      CharSample = Jobs[j].CharSample;
+      ProtoList = Jobs[j].ProtoList;
+      if (Jobs[j].Clusterer != NULL) {
+        DisplayProtoList(test_ch, Jobs[j].DebugProtoList);
+        FreeClusterer(Jobs[j].Clusterer);
+      }
       MergeClass = FindClass (ClassList, CharSample->Label);
       if (MergeClass == NULL) {
         MergeClass = NewLabeledClass (CharSample->Label);
@@ -347,6 +384,7 @@ int main (int argc, char **argv) {
       }
       FreeProtoList (&ProtoList);
     }
+    free(Jobs);
     FreeTrainingSamples (CharList);
   }
   //WriteMergedTrainingSamples(Directory,ClassList);
@@ -396,7 +434,7 @@ LIST ReadTrainingSamples (
 
 /*
 **	Parameters:
-**		File		open text file to read samples from
+**		File		open text or binary file to read samples from
 **	Globals: none
 **	Operation:
 **		This routine reads training samples from a file and
@@ -413,12 +451,13 @@ LIST ReadTrainingSamples (
 {
 	char			unichar[UNICHAR_LEN + 1];
 	LABELEDLIST             CharSample;
-        FEATURE_SET             FeatureSamples;
 	LIST			TrainingSamples = NIL;
-	CHAR_DESC		CharDesc;
-	int			Type, i;
+	FLOAT32			*Params;
+	BOOL8			Binary;
+	int			NumFeatures, N;
 
-	while (fscanf (File, "%s %s", CTFontName, unichar) == 2) {
+	Binary = ReadTrainingFileHeader (File);
+	while (ReadSampleLabel (File, Binary, unichar)) {
           if (!unicharset_training.contains_unichar(unichar)) {
             unicharset_training.unichar_insert(unichar);
             if (unicharset_training.size() > MAX_NUM_CLASSES) {
@@ -432,22 +471,17 @@ LIST ReadTrainingSamples (
 			CharSample = NewLabeledList (unichar);
 			TrainingSamples = push (TrainingSamples, CharSample);
 		}
-		CharDesc = ReadCharDescription (File);
-		Type = ShortNameToFeatureType(PROGRAM_FEATURE_TYPE);
-		FeatureSamples = CharDesc->FeatureSets[Type];
-                for (int feature = 0; feature < FeatureSamples->NumFeatures; ++feature) {
-                  FEATURE f = FeatureSamples->Features[feature];
-                  for (int dim =0; dim < f->Type->NumParams; ++dim)
-                    f->Params[dim] += dim == MFDirection ?
+		Params = ReadSampleFeatures (File, Binary, CharSample,
+                                             PROGRAM_FEATURE_TYPE);
+		NumFeatures =
+                    CharSample->SampleFeatures[CharSample->SampleCount - 1];
+		N = CharSample->NumParams;
+                for (int feature = 0; feature < NumFeatures; ++feature) {
+                  for (int dim =0; dim < N; ++dim)
+                    Params[feature * N + dim] += dim == MFDirection ?
                                     UniformRandomNumber(-MINSD_ANGLE, MINSD_ANGLE) :
                                     UniformRandomNumber(-MINSD, MINSD);
                 }
-		CharSample->List = push (CharSample->List, FeatureSamples);
-        CharSample->SampleCount++;
-		for (i = 0; i < CharDesc->NumFeatureSets; i++)
-                  if (Type != i)
-                    FreeFeatureSet(CharDesc->FeatureSets[i]);
-		free (CharDesc);
         }
 	return (TrainingSamples);
 
@@ -0,0 +1,71 @@
+///////////////////////////////////////////////////////////////////////
+// File:        trconvert.cpp
+// Description: Converts text .tr training files to the binary format
+//              read by mftraining and cntraining.
+//
+// (C) Copyright 2010, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "commontraining.h"
+#include "efio.h"
+#include "featdefs.h"
+#include "unichar.h"
+
+// Not used, but commontraining needs it to be defined.
+CLUSTERCONFIG Config = { elliptical, 0.625, 0.05, 1.0, 1e-6, 0,
+                         best_first };
+
+// Main program to convert text .tr files, as written by tesseract in
+// training mode, to binary .tr files.  The binary files hold the same
+// samples, are smaller, and are read much faster since no text needs to
+// be parsed.  mftraining and cntraining read either kind of file.
+//
+// Usage:
+//   trconvert TextTrainingFile BinaryTrainingFile
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    fprintf(stderr, "Usage: %s TextTrainingFile BinaryTrainingFile\n",
+            argv[0]);
+    return 1;
+  }
+  FILE *in_file = Efopen(argv[1], "rb");
+  if (ReadTrainingFileHeader(in_file)) {
+    fprintf(stderr, "%s is already a binary training file\n", argv[1]);
+    return 1;
+  }
+  FILE *out_file = Efopen(argv[2], "wb");
+  WriteTrainingFileHeader(out_file);
+
+  char font_name[MAXNAMESIZE];
+  char unichar[UNICHAR_LEN + 1];
+  int num_samples = 0;
+  while (fscanf(in_file, "%79s %24s", font_name, unichar) == 2) {
+    CHAR_DESC char_desc = ReadCharDescription(in_file);
+    WriteBinarySample(out_file, font_name, unichar, char_desc);
+    FreeCharDescription(char_desc);
+    ++num_samples;
+  }
+  long in_size = ftell(in_file);
+  long out_size = ftell(out_file);
+  fclose(in_file);
+  if (fclose(out_file) != 0) {
+    fprintf(stderr, "Error writing %s\n", argv[2]);
+    return 1;
+  }
+  printf("Converted %d samples (%ld bytes to %ld bytes)\n",
+         num_samples, in_size, out_size);
+  return 0;
+}
@@ -18,22 +18,120 @@
 ///////////////////////////////////////////////////////////////////////
 
 // Given a file that contains a list of words (one word per line) this program
-// generates the corresponding squished DAWG file.
+// generates the corresponding squished DAWG file. Sorted word lists are
+// converted directly into a minimal dawg, unsorted ones go through a Trie.
+// With -t it checks that all the words of the list are in the given dawg,
+// with -b it compares the lookup speed of the squished dawg with that of
+// the equivalent double-array dawg.
 
 #include <stdio.h>
+#include <time.h>
 
 #include "classify.h"
+#include "cutil.h"
 #include "dawg.h"
 #include "emalloc.h"
 #include "freelist.h"
+#include "helpers.h"
 #include "trie.h"
 #include "unicharset.h"
 
 static const int kMaxNumEdges =  10000000;
+static const int kNumBenchmarkPasses = 20;
+
+// Looks up all the given words (and their reversals, which are mostly
+// misses) kNumBenchmarkPasses times in the given dawg. Returns the time
+// taken in seconds and the number of words found in *num_found.
+static double time_dawg_lookups(const tesseract::Dawg &dawg,
+                                const GenericVector<WERD_CHOICE *> &words,
+                                int *num_found) {
+  clock_t start = clock();
+  *num_found = 0;
+  for (int pass = 0; pass < kNumBenchmarkPasses; ++pass) {
+    for (int i = 0; i < words.size(); ++i) {
+      if (dawg.word_in_dawg(*words[i])) ++(*num_found);
+    }
+  }
+  *num_found /= kNumBenchmarkPasses;
+  return static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+}
+
+// Compares the squished dawg in dawg_filename with the double-array
+// dawg built from it on the words in wordlist_filename.
+static int benchmark_dawg(const char* wordlist_filename,
+                          const char* dawg_filename,
+                          const UNICHARSET &unicharset) {
+  printf("Loading dawg DAWG from '%s'\n", dawg_filename);
+  tesseract::SquishedDawg words(
+      dawg_filename,
+      // these 3 arguments are not used in this case
+      tesseract::DAWG_TYPE_WORD, "", SYSTEM_DAWG_PERM);
+  tesseract::DoubleArrayDawg *da_words =
+      tesseract::DoubleArrayDawg::FromSquishedDawg(words);
+  if (da_words == NULL) {
+    printf("Failed to convert '%s' to a double-array dawg\n", dawg_filename);
+    return 1;
+  }
+  printf("Squished dawg: %d edges (%d bytes)\n", words.num_edges(),
+         words.num_edges() * static_cast<int>(sizeof(EDGE_RECORD)));
+  printf("Double-array dawg: %d nodes, %d slots (%d bytes)\n",
+         da_words->num_nodes(), da_words->num_slots(),
+         da_words->num_slots() * 2 * static_cast<int>(sizeof(inT32)));
+
+  GenericVector<WERD_CHOICE *> word_choices;
+  FILE *word_file = fopen(wordlist_filename, "r");
+  if (word_file == NULL) {
+    printf("Failed to open '%s'\n", wordlist_filename);
+    delete da_words;
+    return 1;
+  }
+  char string[CHARS_PER_LINE];
+  while (fgets(string, CHARS_PER_LINE, word_file) != NULL) {
+    chomp_string(string);
+    WERD_CHOICE *word = new WERD_CHOICE(string, unicharset);
+    if (word->length() == 0 || word->contains_unichar_id(INVALID_UNICHAR_ID)) {
+      delete word;
+      continue;
+    }
+    WERD_CHOICE *reversed = new WERD_CHOICE(*word);
+    for (int i = 0; i < word->length(); ++i) {
+      reversed->set_unichar_id(word->unichar_id(word->length() - 1 - i), i);
+    }
+    word_choices.push_back(word);
+    word_choices.push_back(reversed);
+  }
+  fclose(word_file);
+
+  int squished_found, da_found, mismatches = 0;
+  for (int i = 0; i < word_choices.size(); ++i) {
+    if (words.word_in_dawg(*word_choices[i]) !=
+        da_words->word_in_dawg(*word_choices[i])) {
+      printf("Lookup mismatch for word %s\n",
+             word_choices[i]->debug_string(unicharset).string());
+      ++mismatches;
+    }
+  }
+  double squished_time = time_dawg_lookups(words, word_choices,
+                                           &squished_found);
+  double da_time = time_dawg_lookups(*da_words, word_choices, &da_found);
+  int num_lookups = word_choices.size() * kNumBenchmarkPasses;
+  printf("%d lookups (%d of %d words found)\n", num_lookups,
+         squished_found, word_choices.size());
+  printf("Squished dawg: %.3fs (%.0f lookups/s)\n", squished_time,
+         squished_time > 0 ? num_lookups / squished_time : 0.0);
+  printf("Double-array dawg: %.3fs (%.0f lookups/s)\n", da_time,
+         da_time > 0 ? num_lookups / da_time : 0.0);
+  printf("%d mismatches\n", mismatches);
+  word_choices.delete_data_pointers();
+  delete da_words;
+  return mismatches > 0 ? 1 : 0;
+}
 
 int main(int argc, char** argv) {
-  if (!(argc == 4 || (argc == 5 && strcmp(argv[1], "-t") == 0))) {
-    printf("Usage: %s [-t] word_list_file dawg_file unicharset_file\n", argv[0]);
+  if (!(argc == 4 || (argc == 5 && (strcmp(argv[1], "-t") == 0 ||
+                                     strcmp(argv[1], "-b") == 0)))) {
+    printf("Usage: %s [-t | -b] word_list_file dawg_file unicharset_file\n",
+           argv[0]);
     return 1;
   }
   tesseract::Classify classify;
@@ -52,16 +150,24 @@ int main(int argc, char** argv) {
         // the first 3 arguments are not used in this case
         tesseract::DAWG_TYPE_WORD, "", SYSTEM_DAWG_PERM,
         kMaxNumEdges, unicharset.size());
-    printf("Reading word list from '%s'\n", wordlist_filename);
-    if (!trie.read_word_list(wordlist_filename, unicharset)) {
-      printf("Failed to read word list from '%s'\n", wordlist_filename);
-      exit(1);
+    printf("Building SquishedDawg from sorted word list '%s'\n",
+           wordlist_filename);
+    tesseract::SquishedDawg *dawg =
+        trie.sorted_word_list_to_dawg(wordlist_filename, unicharset);
+    if (dawg == NULL) {
+      printf("Reading word list from '%s'\n", wordlist_filename);
+      if (!trie.read_word_list(wordlist_filename, unicharset)) {
+        printf("Failed to read word list from '%s'\n", wordlist_filename);
+        exit(1);
+      }
+      printf("Reducing Trie to SquishedDawg\n");
+      dawg = trie.trie_to_dawg();
     }
-    printf("Reducing Trie to SquishedDawg\n");
-    tesseract::SquishedDawg *dawg = trie.trie_to_dawg();
     printf("Writing squished DAWG to '%s'\n", dawg_filename);
     dawg->write_squished_dawg(dawg_filename);
     delete dawg;
+  } else if (strcmp(argv[1], "-b") == 0) {
+    return benchmark_dawg(wordlist_filename, dawg_filename, unicharset);
   } else {
     printf("Loading dawg DAWG from '%s'\n", dawg_filename);
     tesseract::SquishedDawg words(
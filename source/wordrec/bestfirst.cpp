@@ -37,7 +37,9 @@
 #include "freelist.h"
 #include "globals.h"
 #include "heuristic.h"
+#include "matchtab.h"
 #include "metrics.h"
+#include "ocrclass.h"
 #include "permute.h"
 #include "pieces.h"
 #include "plotseg.h"
@@ -64,10 +66,16 @@ int num_joints;                  /* Number of chunks - 1 */
 int num_pushed = 0;
 int num_popped = 0;
 
+extern ETEXT_DESC *global_monitor;  // progress monitor
+extern int global_monitor_words;     // user words found so far
+
 INT_VAR(wordrec_num_seg_states, 30, "Segmentation states");
 
 double_VAR(wordrec_worst_state, 1, "Worst segmentation state");
 
+BOOL_VAR(wordrec_batch_classify, 1,
+         "Classify the new pieces of a segmentation as one batch");
+
 /**/
 /*----------------------------------------------------------------------
           F u n c t i o n s
@@ -129,10 +137,13 @@ void Wordrec::best_first_search(CHUNKS_RECORD *chunks_record,
       guided_state = *(the_search->this_state);
       keep_going = evaluate_state(chunks_record, the_search, fixpt);
       hash_add (the_search->closed_states, the_search->this_state);
+      word_budget_states++;
 
       if (!keep_going ||
           (the_search->num_states > wordrec_num_seg_states) ||
-          (tord_blob_skip)) {
+          (tord_blob_skip) ||
+          word_budget_exhausted() ||
+          ocr_deadline_passed(global_monitor, global_monitor_words)) {
         if (segment_debug)
           tprintf("Breaking best_first_search on keep_going %s numstates %d\n",
                   ((keep_going) ? "T" :"F"), the_search->num_states);
@@ -245,6 +256,7 @@ BLOB_CHOICE_LIST_VECTOR *Wordrec::evaluate_chunks(CHUNKS_RECORD *chunks_record,
   int x = 0;
   int y;
 
+  prefetch_chunk_ratings(chunks_record, search_state);
   /* Iterate sub-paths */
   for (i = 1; i <= search_state[0] + 1; i++) {
     if (i > search_state[0])
@@ -283,6 +295,82 @@ BLOB_CHOICE_LIST_VECTOR *Wordrec::evaluate_chunks(CHUNKS_RECORD *chunks_record,
   return (char_choices);
 }
 
+/**
+ * prefetch_chunk_ratings
+ *
+ * Classify all the pieces of this segmentation that are in neither the
+ * ratings matrix nor the match table with a single call to the batch
+ * matcher, and store the results where get_piece_rating and
+ * classify_blob would have put them.  Does nothing if the current
+ * matcher has no batch version or there are fewer than two such pieces.
+ */
+void Wordrec::prefetch_chunk_ratings(CHUNKS_RECORD *chunks_record,
+                                     SEARCH_STATE search_state) {
+  if (tess_batch_matcher == NULL || !wordrec_batch_classify || tord_blob_skip)
+    return;
+  int num_pieces = search_state[0] + 1;
+  int last_chunk = count_blobs(chunks_record->chunks) - 1;
+  inT16 *starts = new inT16[num_pieces];
+  inT16 *ends = new inT16[num_pieces];
+  PBLOB **blobs = new PBLOB *[num_pieces];
+  int num_blobs = 0;
+  TBLOB *blob;
+  int i;
+  int n;
+  int x = 0;
+  int y;
+
+  for (i = 1; i <= num_pieces; i++, x = y + 1) {
+    y = i > search_state[0] ? last_chunk : x + search_state[i];
+    if (chunks_record->ratings->get(x, y) != NOT_CLASSIFIED)
+      continue;
+    join_pieces(chunks_record->chunks, chunks_record->splits, x, y);
+    for (blob = chunks_record->chunks, n = x; n > 0; n--)
+      blob = blob->next;
+    BLOB_CHOICE_LIST *choices = get_match(blob);
+    if (choices != NULL) {
+      delete choices;  // get_piece_rating will find it in the match table.
+    } else {
+      PBLOB *ed_blob = make_ed_blob(blob);
+      if (ed_blob != NULL) {
+        starts[num_blobs] = x;
+        ends[num_blobs] = y;
+        blobs[num_blobs++] = ed_blob;
+      }
+    }
+    break_pieces(blob, chunks_record->splits, x, y);
+  }
+
+  if (num_blobs > 1) {
+    BLOB_CHOICE_LIST **ratings = new BLOB_CHOICE_LIST *[num_blobs];
+    for (i = 0; i < num_blobs; i++)
+      ratings[i] = new BLOB_CHOICE_LIST();
+    // See call_matcher for why the matcher is called on a Tesseract*.
+    (reinterpret_cast<Tesseract*>(this)->*tess_batch_matcher)
+        (blobs, num_blobs, tess_word, tess_denorm, ratings);
+    for (i = 0; i < num_blobs; i++) {
+      join_pieces(chunks_record->chunks, chunks_record->splits,
+                  starts[i], ends[i]);
+      for (blob = chunks_record->chunks, n = starts[i]; n > 0; n--)
+        blob = blob->next;
+      chars_classified++;
+      put_match(blob, ratings[i]);
+#ifndef GRAPHICS_DISABLED
+      if (tord_display_ratings)
+        print_ratings_list("pieces:", ratings[i], getDict().getUnicharset());
+#endif
+      break_pieces(blob, chunks_record->splits, starts[i], ends[i]);
+      chunks_record->ratings->put(starts[i], ends[i], ratings[i]);
+    }
+    delete [] ratings;
+  }
+  for (i = 0; i < num_blobs; i++)
+    delete blobs[i];
+  delete [] blobs;
+  delete [] ends;
+  delete [] starts;
+}
+
 /**
  * @name evaluate_state
  *
@@ -65,6 +65,9 @@ extern INT_VAR_H(wordrec_num_seg_states, 30, "Segmentation states");
 
 extern double_VAR_H(wordrec_worst_state, 1, "Worst segmentation state");
 
+extern BOOL_VAR_H(wordrec_batch_classify, 1,
+                  "Classify the new pieces of a segmentation as one batch");
+
 
 /*----------------------------------------------------------------------
               F u n c t i o n s
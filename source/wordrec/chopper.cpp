@@ -41,6 +41,7 @@
 #include "globals.h"
 #include "makechop.h"
 #include "metrics.h"
+#include "ocrclass.h"
 #include "render.h"
 #include "permute.h"
 #include "pieces.h"
@@ -65,6 +66,20 @@ double_VAR(tessedit_certainty_threshold, -2.25, "Good blob limit");
 BOOL_VAR(fragments_guide_chopper, FALSE,
          "Use information from fragments to guide chopping process");
 
+INT_VAR(wordrec_word_state_budget, 0,
+        "Chops and segmentation states allowed per word, 0 for no limit");
+
+double_VAR(wordrec_word_time_budget, 0.0,
+           "Seconds of chopping and segmentation allowed per word,"
+           " 0 for no limit");
+
+double_VAR(wordrec_page_time_budget, 0.0,
+           "Seconds of chopping and segmentation allowed per page,"
+           " 0 for no limit");
+
+extern ETEXT_DESC *global_monitor;  // progress monitor
+extern int global_monitor_words;     // user words found so far
+
 /*----------------------------------------------------------------------
           M a c r o s
 ----------------------------------------------------------------------*/
@@ -519,6 +534,7 @@ BLOB_CHOICE_LIST_VECTOR *Wordrec::chop_word_main(register TWERD *word,
   state_count = 0;
   best_choice->make_bad();
   raw_choice->make_bad();
+  start_word_budget();
 
   BLOB_CHOICE_LIST_VECTOR *char_choices = new BLOB_CHOICE_LIST_VECTOR();
 
@@ -542,8 +558,16 @@ BLOB_CHOICE_LIST_VECTOR *Wordrec::chop_word_main(register TWERD *word,
     state_count++;
   }
   bool replaced = false;
-  if (!getDict().AcceptableChoice(char_choices, best_choice, *raw_choice,
-                                  &fixpt, CHOPPER_CALLER, &replaced) ||
+  // In fast mode a word that is confident without chopping is not chopped
+  // or associated, even if the stopper does not accept it.  The stopper
+  // still runs, so its ambiguity checks and replacements apply.
+  bool confident = tord_fast_mode && best_choice->length() > 0 &&
+      !best_choice->fragment_mark() &&
+      best_choice->certainty() >= tord_fast_mode_certainty;
+  bool acceptable =
+      getDict().AcceptableChoice(char_choices, best_choice, *raw_choice,
+                                 &fixpt, CHOPPER_CALLER, &replaced);
+  if ((!acceptable && !confident) ||
       ((tester || trainer) &&
        strcmp(word->correct, best_choice->unichar_string().string()))) {
     if (replaced) update_blob_classifications(word, *char_choices);
@@ -553,7 +577,7 @@ BLOB_CHOICE_LIST_VECTOR *Wordrec::chop_word_main(register TWERD *word,
     else
       words_chopped2++;
 
-    if (chop_enable)
+    if (chop_enable && !word_budget_exhausted())
       improve_by_chopping(word,
                           char_choices,
                           fx,
@@ -571,12 +595,14 @@ BLOB_CHOICE_LIST_VECTOR *Wordrec::chop_word_main(register TWERD *word,
     // it is not conditioned on the dict behavior.  For CJK, we need to force
     // the associator to be invoked.  When we figure out the exact behavior
     // of dict on CJK, we can remove the flag if it turns out to be redundant.
-    if ((wordrec_enable_assoc &&
-         !getDict().AcceptableChoice(char_choices, best_choice, *raw_choice,
-                                     NULL, CHOPPER_CALLER, &replaced)) ||
-        force_word_assoc ||
-        ((tester || trainer) &&
-         strcmp(word->correct, best_choice->unichar_string().string()))) {
+    // A word that is out of budget keeps the best answer from chopping.
+    if (((wordrec_enable_assoc &&
+          !getDict().AcceptableChoice(char_choices, best_choice, *raw_choice,
+                                      NULL, CHOPPER_CALLER, &replaced)) ||
+         force_word_assoc ||
+         ((tester || trainer) &&
+          strcmp(word->correct, best_choice->unichar_string().string()))) &&
+        !word_budget_exhausted()) {
       ratings = word_associator (word->blobs, seam_list, &state, fx,
         best_choice, raw_choice, word->correct,
         /*0, */ &fixpt, &best_state);
@@ -600,6 +626,7 @@ BLOB_CHOICE_LIST_VECTOR *Wordrec::chop_word_main(register TWERD *word,
     best_state = state;
   }
   getDict().FilterWordChoices();
+  end_word_budget();
   return char_choices;
 }
 
@@ -667,12 +694,15 @@ void Wordrec::improve_by_chopping(register TWERD *word,
         chops_performed1++;
       else
         chops_performed2++;
+      word_budget_states++;
     } else {
       break;
     }
   } while (!getDict().AcceptableChoice(char_choices, best_choice, *raw_choice,
                                        fixpt, CHOPPER_CALLER, &replaced) &&
-           !tord_blob_skip && char_choices->length() < MAX_NUM_CHUNKS);
+           !tord_blob_skip && char_choices->length() < MAX_NUM_CHUNKS &&
+           !word_budget_exhausted() &&
+           !ocr_deadline_passed(global_monitor, global_monitor_words));
   if (replaced) update_blob_classifications(word, *char_choices);
   old_count = *state_count;
   if (!fixpt_valid)
@@ -680,6 +710,79 @@ void Wordrec::improve_by_chopping(register TWERD *word,
 }
 
 
+/**
+ * @name reset_page_budget
+ *
+ * Start a new page: none of the page time budget has been used, and no
+ * word has run out of budget yet.
+ */
+void Wordrec::reset_page_budget() {
+  page_budget_used = 0.0;
+  page_budget_words = 0;
+}
+
+
+/**
+ * @name start_word_budget
+ *
+ * Start timing and counting the chops and segmentation states of a new
+ * word against wordrec_word_state_budget, wordrec_word_time_budget and
+ * what is left of wordrec_page_time_budget.
+ */
+void Wordrec::start_word_budget() {
+  word_budget_start = clock();
+  word_budget_states = 0;
+  word_budget_spent = false;
+}
+
+
+/**
+ * @name word_budget_exhausted
+ *
+ * Return true if the current word has used up its share of the effort,
+ * in which case the chopper and the segmentation search stop and keep
+ * the best answer they have found so far.
+ */
+bool Wordrec::word_budget_exhausted() {
+  if (word_budget_spent)
+    return true;
+  if (wordrec_word_state_budget > 0 &&
+      word_budget_states >= wordrec_word_state_budget)
+    word_budget_spent = true;
+  if (wordrec_word_time_budget > 0.0 || wordrec_page_time_budget > 0.0) {
+    double word_time = (double) (clock() - word_budget_start) / CLOCKS_PER_SEC;
+    if (wordrec_word_time_budget > 0.0 &&
+        word_time >= wordrec_word_time_budget)
+      word_budget_spent = true;
+    if (wordrec_page_time_budget > 0.0 &&
+        page_budget_used + word_time >= wordrec_page_time_budget)
+      word_budget_spent = true;
+  }
+  return word_budget_spent;
+}
+
+
+/**
+ * @name end_word_budget
+ *
+ * Charge the time taken by the current word to the page and count the
+ * word if it ran out of budget.
+ */
+void Wordrec::end_word_budget() {
+  page_budget_used += (double) (clock() - word_budget_start) / CLOCKS_PER_SEC;
+  if (word_budget_spent) {
+    page_budget_words++;
+    if (first_pass)
+      words_over_budget1++;
+    else
+      words_over_budget2++;
+    if (chop_debug)
+      cprintf("Word ran out of budget after %d chops/states\n",
+              word_budget_states);
+  }
+}
+
+
 /**********************************************************************
  * select_blob_to_split
  *
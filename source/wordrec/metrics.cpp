@@ -60,6 +60,8 @@ int chops_attempted1;
 int chops_performed1;
 int chops_attempted2;
 int chops_performed2;
+int words_over_budget1;
+int words_over_budget2;
 
 int character_count;
 int word_count;
@@ -103,6 +105,8 @@ void init_metrics() {
   chops_performed2 = 0;
   chops_attempted1 = 0;
   chops_attempted2 = 0;
+  words_over_budget1 = 0;
+  words_over_budget2 = 0;
 
   words_segmented1 = 0;
   words_segmented2 = 0;
@@ -217,6 +221,7 @@ void Wordrec::save_summary(inT32 elapsed_time) {
   fprintf (f, " (%0.0f%%)\n", (float) words_chopped1 / word_count * 100);
   fprintf (f, "%d chops performed\n", chops_performed1);
   fprintf (f, "%d chops attempted\n", chops_attempted1);
+  fprintf (f, "%d words out of budget\n", words_over_budget1);
   fprintf (f, "\n");
 
   fprintf (f, "%d words joined (pass 1)", words_segmented1);
@@ -229,6 +234,7 @@ void Wordrec::save_summary(inT32 elapsed_time) {
   fprintf (f, " (%0.0f%%)\n", (float) words_chopped2 / word_count * 100);
   fprintf (f, "%d chops performed\n", chops_performed2);
   fprintf (f, "%d chops attempted\n", chops_attempted2);
+  fprintf (f, "%d words out of budget\n", words_over_budget2);
   fprintf (f, "\n");
 
   fprintf (f, "%d words joined (pass 2)", words_segmented2);
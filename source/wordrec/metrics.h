@@ -41,6 +41,8 @@ extern int chops_attempted1;
 extern int chops_performed1;
 extern int chops_attempted2;
 extern int chops_performed2;
+extern int words_over_budget1;
+extern int words_over_budget2;
 extern int permutation_count;
 
 extern int character_count;
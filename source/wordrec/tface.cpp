@@ -238,6 +238,7 @@ BLOB_CHOICE_LIST_VECTOR *Wordrec::cc_recog(TWERD *tessword,
   }
   getDict().InitChoiceAccum();
   getDict().reset_hyphen_vars(last_word_on_line);
+  getDict().reset_dawg_edge_cache();
   init_match_table();
   for (fx = 0; fx < MAX_FX && (acts[OCR] & (FXSELECT << fx)) == 0; fx++);
   results =
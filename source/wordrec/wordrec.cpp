@@ -19,6 +19,9 @@
 #include "wordrec.h"
 
 namespace tesseract {
-Wordrec::Wordrec() {}
+Wordrec::Wordrec() : tess_batch_matcher(NULL) {
+  reset_page_budget();
+  start_word_budget();
+}
 Wordrec::~Wordrec() {}
 }
@@ -19,6 +19,7 @@
 #ifndef TESSERACT_WORDREC_WORDREC_H__
 #define TESSERACT_WORDREC_WORDREC_H__
 
+#include <time.h>
 #include "classify.h"
 #include "ratngs.h"
 #include "matrix.h"
@@ -70,6 +71,8 @@ class Wordrec : public Classify {
   /* bestfirst.cpp ***********************************************************/
   BLOB_CHOICE_LIST_VECTOR *evaluate_chunks(CHUNKS_RECORD *chunks_record,
                                            SEARCH_STATE search_state);
+  void prefetch_chunk_ratings(CHUNKS_RECORD *chunks_record,
+                              SEARCH_STATE search_state);
   void update_ratings(const BLOB_CHOICE_LIST_VECTOR &new_choices,
                       const CHUNKS_RECORD *chunks_record,
                       const SEARCH_STATE search_state);
@@ -142,6 +145,10 @@ class Wordrec : public Classify {
   inT16 select_blob_to_split(const BLOB_CHOICE_LIST_VECTOR &char_choices,
                              float rating_ceiling,
                              bool split_next_to_fragment);
+  void reset_page_budget();
+  void start_word_budget();
+  bool word_budget_exhausted();
+  void end_word_budget();
   /* mfvars.cpp **************************************************************/
   void mfeature_init();
   /* pieces.cpp **************************************************************/
@@ -180,11 +187,18 @@ class Wordrec : public Classify {
   /* member variables *********************************************************/
   /* tface.cpp ****************************************************************/
   POLY_MATCHER tess_matcher;//current matcher
+  POLY_BATCH_MATCHER tess_batch_matcher;  //batch version, may be NULL
   POLY_TESTER tess_tester;  //current tester
   POLY_TESTER tess_trainer; //current trainer
   DENORM *tess_denorm;      //current denorm
   WERD *tess_word;          //current word
   int dict_word(const WERD_CHOICE &word);
+  /* chopper.cpp **************************************************************/
+  clock_t word_budget_start;  //when work on the current word began
+  inT32 word_budget_states;   //chops and segmentations tried on it
+  bool word_budget_spent;     //the word ran out of budget
+  double page_budget_used;    //seconds of word effort on this page
+  inT32 page_budget_words;    //words on this page that ran out of budget
 };
 
 